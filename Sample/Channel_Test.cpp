@@ -0,0 +1,167 @@
+#include <stdio.h>
+#include <time.h>
+#include <deque>
+#include <string>
+#include <vector>
+#include "Channel.h"
+#include "ByteBuffer.h"
+#include "Mutex.h"
+#include "MutexLock.h"
+#include "ConditionVariable.h"
+#include "Thread.h"
+#include "SampleClock.h"
+
+using namespace PicoIPC;
+
+enum { PRODUCERS = 4, COUNT = 200000, PAYLOAD = 256 };
+
+// Mutex + 条件変数によるキュー(比較用)
+class LockedQueue
+{
+public:
+	LockedQueue() : mNotEmpty(mMutex) {}
+
+	void SendSwap(ByteBuffer &value)
+	{
+		MutexLock lock(&mMutex);
+		mQueue.push_back(ByteBuffer());
+		mQueue.back().Swap(value);
+		mNotEmpty.Signal();
+	}
+
+	size_t TimedReceiveBatch(std::vector<ByteBuffer> &values, size_t maxCount, unsigned long millisec)
+	{
+		MutexLock lock(&mMutex);
+		if (mQueue.empty() && !mNotEmpty.TimedWait(millisec)) {
+			return 0;
+		}
+		size_t count = 0;
+		for (; count < maxCount && !mQueue.empty(); count++) {
+			values.push_back(ByteBuffer());
+			values.back().Swap(mQueue.front());
+			mQueue.pop_front();
+		}
+		return count;
+	}
+
+private:
+	Mutex                  mMutex;
+	ConditionVariable      mNotEmpty;
+	std::deque<ByteBuffer> mQueue;
+};
+
+template <class Queue>
+class Producer : public IRunnable
+{
+public:
+	Producer(Queue *queue) : mQueue(queue) {}
+
+	void Run()
+	{
+		int id = static_cast<int>(reinterpret_cast<long>(Thread::CurrentThread()->Parameter()));
+		std::string payload(PAYLOAD, 'x');
+		for (int i = 0; i < COUNT; i++) {
+			ByteBuffer bb(PAYLOAD + 16);
+			bb.Append(id);
+			bb.Append(i);
+			bb.Append(payload);
+			mQueue->SendSwap(bb);
+		}
+	}
+
+private:
+	Queue *mQueue;
+};
+
+// 送信スレッドごとに順序どおり届いたか確認しながら受信する
+template <class Queue>
+static void run(const char *name, Queue &queue)
+{
+	Producer<Queue> producer(&queue);
+	std::vector<Thread *> threads;
+	for (long i = 0; i < PRODUCERS; i++) {
+		threads.push_back(new Thread(&producer, reinterpret_cast<void *>(i)));
+	}
+	double start = now();
+	for (size_t i = 0; i < threads.size(); i++) {
+		threads[i]->Start();
+	}
+
+	int next[PRODUCERS] = {0};
+	int received = 0;
+	int disorder = 0;
+	int batches = 0;
+	std::vector<ByteBuffer> values;
+	while (received < PRODUCERS * COUNT) {
+		values.clear();
+		size_t count = queue.TimedReceiveBatch(values, 64, 1000);
+		if (count == 0) {
+			break;
+		}
+		batches++;
+		for (size_t i = 0; i < count; i++) {
+			int id = 0;
+			int seq = 0;
+			values[i].Value(id);
+			values[i].Value(seq);
+			if (seq != next[id]) {
+				disorder++;
+			}
+			next[id] = seq + 1;
+		}
+		received += static_cast<int>(count);
+	}
+	double elapsed = now() - start;
+	for (size_t i = 0; i < threads.size(); i++) {
+		threads[i]->Join();
+		delete threads[i];
+	}
+	::printf("  %-24s %7.1f ms %6.0f ns/msg received:%d disorder:%d avg batch:%.1f\n",
+		name, elapsed * 1e3, elapsed * 1e9 / received, received, disorder,
+		batches ? static_cast<double>(received) / batches : 0.0);
+}
+
+void test1()
+{
+	::printf("\nbasic\n");
+	Channel<int> channel;
+	int value = 0;
+	::printf("  try receive:%d\n", channel.TryReceive(value));
+	channel.Send(1);
+	channel.Send(2);
+	channel.Send(3);
+	::printf("  empty:%d\n", channel.IsEmpty());
+	std::vector<int> values;
+	size_t count = channel.ReceiveBatch(values, 10);
+	::printf("  batch:%lu [%d %d %d] empty:%d\n", static_cast<unsigned long>(count), values[0], values[1], values[2], channel.IsEmpty());
+
+	double start = now();
+	bool isReceived = channel.TimedReceive(value, 30);
+	::printf("  timed receive:%d %.0f ms\n", isReceived, (now() - start) * 1e3);
+
+	ByteBuffer bb;
+	bb.Append(std::string("swap"));
+	Channel<ByteBuffer> buffers;
+	buffers.SendSwap(bb);
+	ByteBuffer out;
+	buffers.Receive(out);
+	std::string text;
+	out.Value(text);
+	::printf("  send swap: sent size:%lu received:%s\n", static_cast<unsigned long>(bb.Size()), text.c_str());
+}
+
+void test2()
+{
+	::printf("\n%d producers x %d ByteBuffer(%d bytes)\n", PRODUCERS, COUNT, PAYLOAD);
+	LockedQueue locked;
+	run("Mutex + deque", locked);
+	Channel<ByteBuffer> channel;
+	run("Channel", channel);
+}
+
+int main(int argc, char *argv[]) {
+	test1();
+	test2();
+
+	return 0;
+}
@@ -0,0 +1,156 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "ColumnarBatch.h"
+
+using namespace PicoIPC;
+
+const int AXIS_COUNT = 33;
+
+void make_messages(std::vector<ByteBuffer> &list, int count)
+{
+	for (int i = 0; i < count; i++) {
+		ByteBuffer bb;
+		bb.Append(i);
+		for (int j = 0; j < AXIS_COUNT; j++) {
+			double axis = i + j * 0.01;
+			bb.Append(axis);
+		}
+		list.push_back(bb);
+	}
+}
+
+double elapsed(const timespec &start)
+{
+	timespec now;
+	::clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start.tv_sec) * 1000.0 + (now.tv_nsec - start.tv_nsec) / 1000000.0;
+}
+
+void test1()
+{
+	::printf("\ndecode int + double x %d\n", AXIS_COUNT);
+
+	std::vector<ByteBuffer> list;
+	make_messages(list, 1001);
+
+	ColumnSchema schema;
+	schema.Add<int>().Add<double>(AXIS_COUNT);
+	ColumnarBatch batch(schema);
+	Error err = batch.Decode(list);
+	if (err) {
+		::printf("err:%s\n", err.Message().c_str());
+		::exit(1);
+	}
+
+	const int *counter = batch.Column<int>(0);
+	for (size_t i = 0; i < batch.Rows(); i++) {
+		ByteBuffer &bb = list[i];
+		int c;
+		bb.Value(c);
+		if (c != counter[i]) {
+			::printf("err: counter[%lu] %d != %d\n", static_cast<unsigned long>(i), counter[i], c);
+			::exit(1);
+		}
+		for (int j = 0; j < AXIS_COUNT; j++) {
+			double axis;
+			bb.Value(axis);
+			if (axis != batch.Column<double>(j + 1)[i]) {
+				::printf("err: axis[%d][%lu]\n", j, static_cast<unsigned long>(i));
+				::exit(1);
+			}
+		}
+	}
+
+	// 列ごとの統計
+	const double *axis32 = batch.Column<double>(AXIS_COUNT);
+	double sum = 0.0;
+	for (size_t i = 0; i < batch.Rows(); i++) {
+		sum += axis32[i];
+	}
+	::printf("rows:%lu axis32 mean:%f\n", static_cast<unsigned long>(batch.Rows()), sum / batch.Rows());
+}
+
+void test2()
+{
+	::printf("\ndecode float x 4 + short\n");
+
+	std::vector<ByteBuffer> list;
+	for (int i = 0; i < 7; i++) {
+		ByteBuffer bb;
+		for (int j = 0; j < 4; j++) {
+			bb.Append(static_cast<float>(i * 10 + j));
+		}
+		bb.Append(static_cast<short>(i));
+		list.push_back(bb);
+	}
+
+	ColumnSchema schema;
+	schema.Add<float>(4).Add<short>();
+	ColumnarBatch batch(schema);
+	batch.Decode(list);
+	for (int j = 0; j < 4; j++) {
+		const float *c = batch.Column<float>(j);
+		for (size_t i = 0; i < batch.Rows(); i++) {
+			::printf("%.0f ", c[i]);
+		}
+		::printf("\n");
+	}
+	const short *s = batch.Column<short>(4);
+	::printf("short: %d .. %d\n", s[0], s[batch.Rows() - 1]);
+
+	ByteBuffer shortMessage;
+	shortMessage.Append(1);
+	list.push_back(shortMessage);
+	Error err = batch.Decode(list);
+	::printf("short message:%s\n", err ? err.Message().c_str() : "no error");
+}
+
+void test3()
+{
+	::printf("\nbenchmark\n");
+
+	std::vector<ByteBuffer> list;
+	make_messages(list, 1000);
+
+	timespec start;
+	::clock_gettime(CLOCK_MONOTONIC, &start);
+	double sum = 0.0;
+	for (int n = 0; n < 100; n++) {
+		for (size_t i = 0; i < list.size(); i++) {
+			ByteBuffer &bb = list[i];
+			bb.SetPosition(0);
+			int c;
+			bb.Value(c);
+			for (int j = 0; j < AXIS_COUNT; j++) {
+				double axis;
+				bb.Value(axis);
+				sum += axis;
+			}
+		}
+	}
+	::printf("Value()       : %.2f ms (%f)\n", elapsed(start), sum);
+
+	ColumnSchema schema;
+	schema.Add<int>().Add<double>(AXIS_COUNT);
+	ColumnarBatch batch(schema);
+	::clock_gettime(CLOCK_MONOTONIC, &start);
+	sum = 0.0;
+	for (int n = 0; n < 100; n++) {
+		batch.Decode(list);
+		for (int j = 0; j < AXIS_COUNT; j++) {
+			const double *axis = batch.Column<double>(j + 1);
+			for (size_t i = 0; i < batch.Rows(); i++) {
+				sum += axis[i];
+			}
+		}
+	}
+	::printf("ColumnarBatch : %.2f ms (%f)\n", elapsed(start), sum);
+}
+
+int main(int argc, char *argv[]) {
+	test1();
+	test2();
+	test3();
+	return 0;
+}
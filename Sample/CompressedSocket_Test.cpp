@@ -0,0 +1,221 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+#include <algorithm>
+#include "CompressedSocket.h"
+#include "Thread.h"
+#include "SampleClock.h"
+
+using namespace PicoIPC;
+
+// プログラムのアップロードを想定したテキスト
+static std::string program(size_t lines)
+{
+	std::string text;
+	char line[128];
+	for (size_t i = 0; i < lines; i++) {
+		::snprintf(line, sizeof(line), "N%05lu G01 X%.3f Y%.3f Z%.3f F%d ; move axis\n",
+			static_cast<unsigned long>(i), i * 0.125, i * 0.5, 10.0 - i * 0.01, 1200 + static_cast<int>(i % 7) * 100);
+		text += line;
+	}
+	return text;
+}
+
+static bool roundTrip(const std::string &data)
+{
+	std::vector<char> compressed(Lz4Codec::CompressBound(data.size()));
+	size_t size = Lz4Codec::Compress(data.data(), data.size(), &compressed[0], compressed.size());
+	if (size == 0) {
+		return false;
+	}
+	std::string out(data.size(), '\0');
+	if (!Lz4Codec::Decompress(&compressed[0], size, data.empty() ? NULL : &out[0], out.size())) {
+		return false;
+	}
+	return out == data;
+}
+
+void test1()
+{
+	::printf("\nlz4 round trip\n");
+
+	bool ok = true;
+	std::string data;
+	srand(1);
+	for (size_t size = 0; size < 300; size++) {
+		data.assign(size, 'a');
+		ok = ok && roundTrip(data);
+		for (size_t i = 0; i < size; i++) {
+			data[i] = static_cast<char>(rand() % 4);
+		}
+		ok = ok && roundTrip(data);
+		for (size_t i = 0; i < size; i++) {
+			data[i] = static_cast<char>(rand());
+		}
+		ok = ok && roundTrip(data);
+	}
+	ok = ok && roundTrip(program(1000));
+	data.assign(200000, 'x');
+	ok = ok && roundTrip(data);
+	::printf("round trip:%s\n", ok ? "ok" : "NG");
+
+	// 壊れたデータは伸張しない
+	std::string text = program(100);
+	std::vector<char> compressed(Lz4Codec::CompressBound(text.size()));
+	size_t size = Lz4Codec::Compress(text.data(), text.size(), &compressed[0], compressed.size());
+	std::string out(text.size(), '\0');
+	int rejected = 0;
+	for (size_t i = 0; i < size; i += 7) {
+		std::vector<char> broken(compressed.begin(), compressed.begin() + size);
+		broken[i] ^= 0x5a;
+		if (!Lz4Codec::Decompress(&broken[0], broken.size(), &out[0], out.size()) || out != text) {
+			rejected++;
+		}
+	}
+	::printf("broken:%d/%lu detected or different\n", rejected, static_cast<unsigned long>((size + 6) / 7));
+	::printf("truncated:%d\n", Lz4Codec::Decompress(&compressed[0], size - 1, &out[0], out.size()));
+	::printf("short output:%d\n", Lz4Codec::Decompress(&compressed[0], size, &out[0], out.size() - 1));
+}
+
+void test2()
+{
+	::printf("\nbody compression\n");
+
+	BodyCompression compression(4096);
+
+	// 閾値未満はヘッダーのみ付与する。先頭がマジックと同じ値でも内容から判定しない
+	ByteBuffer small;
+	small.Append(static_cast<int>(BodyCompression::COMPRESSED_BODY_MAGIC));
+	small.Append(std::string("small"));
+	std::string smallOriginal = small.Data();
+	bool smallCompressed = compression.Compress(small);
+	::printf("small compressed:%d %lu -> %lu\n", smallCompressed,
+		static_cast<unsigned long>(smallOriginal.size()), static_cast<unsigned long>(small.Size()));
+	Error smallErr = compression.Decompress(small);
+	::printf("small decompress:%s same:%d\n", smallErr ? smallErr.Message().c_str() : "no error",
+		small.Data() == smallOriginal);
+
+	ByteBuffer body;
+	body.Append(1);
+	body.Append(program(2000));
+	std::string original = body.Data();
+	bool compressed = compression.Compress(body);
+	::printf("compressed:%d %lu -> %lu\n", compressed,
+		static_cast<unsigned long>(original.size()), static_cast<unsigned long>(body.Size()));
+
+	Error err = compression.Decompress(body);
+	int id;
+	std::string text;
+	body.Value(id);
+	body.Value(text);
+	::printf("decompress:%s same:%d id:%d lines:%lu\n", err ? err.Message().c_str() : "no error",
+		body.Data() == original, id, static_cast<unsigned long>(std::count(text.begin(), text.end(), '\n')));
+
+	// ヘッダーのないボディーはエラー(双方で圧縮を有効にすること)
+	ByteBuffer plain(original);
+	err = compression.Decompress(plain);
+	::printf("no header:%s\n", err ? err.Message().c_str() : "no error");
+
+	// 伸張結果の破損はCRCで検出する
+	compression.Compress(body);
+	std::string broken = body.Data();
+	broken[broken.size() - 1] ^= 0x01;
+	ByteBuffer bad(broken);
+	err = compression.Decompress(bad);
+	::printf("broken:%s\n", err ? err.Message().c_str() : "no error");
+}
+
+void test3()
+{
+	::printf("\nbenchmark\n");
+
+	std::string text = program(200000);
+	std::vector<char> compressed(Lz4Codec::CompressBound(text.size()));
+	std::string out(text.size(), '\0');
+	const int loop = 10;
+
+	size_t size = 0;
+	double start = now();
+	for (int i = 0; i < loop; i++) {
+		size = Lz4Codec::Compress(text.data(), text.size(), &compressed[0], compressed.size());
+	}
+	double compressTime = now() - start;
+
+	start = now();
+	for (int i = 0; i < loop; i++) {
+		Lz4Codec::Decompress(&compressed[0], size, &out[0], out.size());
+	}
+	double decompressTime = now() - start;
+
+	double total = static_cast<double>(text.size()) * loop;
+	::printf("size:%lu -> %lu (%.1f%%)\n", static_cast<unsigned long>(text.size()),
+		static_cast<unsigned long>(size), size * 100.0 / text.size());
+	::printf("compress:   %8.1f MB/s\n", total / compressTime / 1e6);
+	::printf("decompress: %8.1f MB/s\n", total / decompressTime / 1e6);
+}
+
+class RequestReceiverImpl : public IRequestReceiver
+{
+public:
+	void Received(ByteBuffer &request, ByteBuffer &response)
+	{
+		std::string text;
+		request.Value(text);
+		::printf("request size:%lu\n", static_cast<unsigned long>(text.size()));
+		// アップロードしたプログラムをそのまま返す
+		response.Append(text);
+	}
+
+	void ReceiveError(const Error &error)
+	{
+		::printf("receive error # %s\n", error.Message().c_str());
+	}
+};
+
+void server()
+{
+	UnixDomainSocketServer server("/tmp/PicoIPC_uds_compressed");
+	RequestReceiverImpl impl;
+	CompressedRequestReceiver receiver(&impl, 4096);
+	server.SetReceiver(&receiver);
+	server.Start(true);
+}
+
+void client()
+{
+	UnixDomainSocketClient client("/tmp/PicoIPC_uds_compressed");
+	CompressedSocketClient compressed(client, 4096);
+	for (size_t lines = 10; lines <= 100000; lines *= 10) {
+		ByteBuffer request;
+		ByteBuffer response;
+		std::string text = program(lines);
+		request.Append(text);
+		Error err = compressed.SendReceive(request, response);
+		if (err) {
+			::printf("error # %s\n", err.Message().c_str());
+			continue;
+		}
+		std::string echo;
+		response.Value(echo);
+		::printf("lines:%lu size:%lu same:%d\n", static_cast<unsigned long>(lines),
+			static_cast<unsigned long>(text.size()), echo == text);
+	}
+}
+
+int main(int argc, char *argv[]) {
+	if (argc > 1) {
+		// UnixDomainSocket: 引数 server または client
+		if (::strcmp(argv[1], "server") == 0) {
+			server();
+		} else {
+			client();
+		}
+		return 0;
+	}
+	test1();
+	test2();
+	test3();
+	return 0;
+}
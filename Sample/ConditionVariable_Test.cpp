@@ -0,0 +1,276 @@
+#include <stdio.h>
+#include <time.h>
+#include <deque>
+#include <vector>
+#include "Mutex.h"
+#include "MutexLock.h"
+#include "ConditionVariable.h"
+#include "StopToken.h"
+#include "Thread.h"
+#include "SampleClock.h"
+
+using namespace PicoIPC;
+
+// 容量制限付きキュー
+// useConditionVariable: falseのときMutexの条件変数1つをConditionBroadcast()で共有する
+class BoundedQueue
+{
+public:
+	BoundedQueue(size_t capacity, bool useConditionVariable)
+		: mCapacity(capacity)
+		, mUseConditionVariable(useConditionVariable)
+		, mNotEmpty(mMutex)
+		, mNotFull(mMutex)
+		, mWakeups(0)
+		, mSpuriousWakeups(0)
+	{
+	}
+
+	void Push(int value)
+	{
+		MutexLock lock(&mMutex);
+		while (mQueue.size() >= mCapacity) {
+			Wait(mNotFull);
+			mWakeups++;
+			if (mQueue.size() >= mCapacity) {
+				mSpuriousWakeups++;
+			}
+		}
+		mQueue.push_back(value);
+		Notify(mNotEmpty);
+	}
+
+	int Pop()
+	{
+		MutexLock lock(&mMutex);
+		while (mQueue.empty()) {
+			Wait(mNotEmpty);
+			mWakeups++;
+			if (mQueue.empty()) {
+				mSpuriousWakeups++;
+			}
+		}
+		int value = mQueue.front();
+		mQueue.pop_front();
+		Notify(mNotFull);
+		return value;
+	}
+
+	int Wakeups() const { return mWakeups; }
+	int SpuriousWakeups() const { return mSpuriousWakeups; }
+
+private:
+	size_t            mCapacity;
+	bool              mUseConditionVariable;
+	Mutex             mMutex;
+	ConditionVariable mNotEmpty;
+	ConditionVariable mNotFull;
+	std::deque<int>   mQueue;
+	int               mWakeups;
+	int               mSpuriousWakeups;
+
+	void Wait(ConditionVariable &condition)
+	{
+		if (mUseConditionVariable) {
+			condition.Wait();
+		} else {
+			mMutex.ConditionWait();
+		}
+	}
+
+	void Notify(ConditionVariable &condition)
+	{
+		if (mUseConditionVariable) {
+			condition.Signal();
+		} else {
+			// 送信側と受信側が同じ条件変数で待つため、全員起こす必要がある
+			mMutex.ConditionBroadcast();
+		}
+	}
+};
+
+// 1ms間隔で送信し、最後に受信スレッドの数だけ終了(-1)を送る
+class Producer : public IRunnable
+{
+public:
+	void Run()
+	{
+		BoundedQueue *queue = static_cast<BoundedQueue *>(Thread::CurrentThread()->Parameter());
+		for (int i = 0; i < COUNT; i++) {
+			queue->Push(i);
+			Thread::MilliSleep(1);
+		}
+		for (int i = 0; i < CONSUMERS; i++) {
+			queue->Push(-1);
+		}
+	}
+
+	enum { COUNT = 500, CONSUMERS = 8 };
+};
+
+class Consumer : public IRunnable
+{
+public:
+	void Run()
+	{
+		BoundedQueue *queue = static_cast<BoundedQueue *>(Thread::CurrentThread()->Parameter());
+		while (queue->Pop() >= 0) {
+		}
+	}
+};
+
+// 停止要求まで条件変数で待機する
+class ActivatedWorker : public IRunnable
+{
+public:
+	ActivatedWorker() : mActivated(mMutex), mIsActive(false), mRuns(0) {}
+
+	void Run()
+	{
+		StopToken token = StoppableThread::CurrentToken();
+		MutexLock lock(&mMutex);
+		while (true) {
+			if (!mIsActive && !token.ConditionWait(mActivated)) {
+				break;
+			}
+			if (mIsActive) {
+				mRuns++;
+				mIsActive = false;
+			}
+		}
+	}
+
+	Mutex             mMutex;
+	ConditionVariable mActivated;
+	bool              mIsActive;
+	int               mRuns;
+};
+
+struct IsReady
+{
+	IsReady(const bool &ready) : mReady(ready) {}
+	bool operator()() const { return mReady; }
+	const bool &mReady;
+};
+
+class ReadyNotifier : public IRunnable
+{
+public:
+	ReadyNotifier(ConditionVariable *condition, bool *ready) : mCondition(condition), mReady(ready) {}
+
+	void Run()
+	{
+		Thread::MilliSleep(30);
+		{
+			MutexLock lock(&mCondition->GetMutex());
+			mCondition->Signal();        // 条件を満たさない通知
+		}
+		Thread::MilliSleep(30);
+		MutexLock lock(&mCondition->GetMutex());
+		*mReady = true;
+		mCondition->Signal();
+	}
+
+private:
+	ConditionVariable *mCondition;
+	bool              *mReady;
+};
+
+void test1()
+{
+	::printf("\ntimed wait\n");
+	Mutex mutex;
+	ConditionVariable condition(mutex);
+
+	mutex.Lock();
+	double start = now();
+	bool isSignaled = mutex.ConditionTimedWait(50);
+	::printf("  Mutex::ConditionTimedWait signaled:%d %.0f ms\n", isSignaled, (now() - start) * 1e3);
+	mutex.Unlock();
+
+	MutexLock lock(&mutex);
+	start = now();
+	isSignaled = lock.TimedWait(50);
+	::printf("  MutexLock::TimedWait signaled:%d %.0f ms\n", isSignaled, (now() - start) * 1e3);
+
+	start = now();
+	isSignaled = condition.TimedWait(50);
+	::printf("  ConditionVariable::TimedWait signaled:%d %.0f ms\n", isSignaled, (now() - start) * 1e3);
+}
+
+void test2()
+{
+	::printf("\npredicate wait\n");
+	Mutex mutex;
+	ConditionVariable condition(mutex);
+	bool ready = false;
+	ReadyNotifier notifier(&condition, &ready);
+	Thread t(&notifier, NULL);
+
+	mutex.Lock();
+	t.Start();
+	double start = now();
+	bool isReady = condition.TimedWait(1000, IsReady(ready));
+	::printf("  ready:%d %.0f ms (ignored the first signal)\n", isReady, (now() - start) * 1e3);
+	mutex.Unlock();
+	t.Join();
+
+	mutex.Lock();
+	ready = false;
+	start = now();
+	isReady = condition.TimedWait(40, IsReady(ready));
+	::printf("  ready:%d %.0f ms (timeout)\n", isReady, (now() - start) * 1e3);
+	mutex.Unlock();
+}
+
+void test3(bool useConditionVariable)
+{
+	BoundedQueue queue(4, useConditionVariable);
+	Producer producer;
+	Consumer consumer;
+	std::vector<Thread *> threads;
+	for (int i = 0; i < Producer::CONSUMERS; i++) {
+		threads.push_back(new Thread(&consumer, &queue));
+	}
+	threads.push_back(new Thread(&producer, &queue));
+	double start = now();
+	for (size_t i = 0; i < threads.size(); i++) {
+		threads[i]->Start();
+	}
+	for (size_t i = 0; i < threads.size(); i++) {
+		threads[i]->Join();
+		delete threads[i];
+	}
+	::printf("  %-32s %7.1f ms wakeups:%6d wasted:%6d\n",
+		useConditionVariable ? "ConditionVariable x2 + Signal" : "Mutex + ConditionBroadcast",
+		(now() - start) * 1e3, queue.Wakeups(), queue.SpuriousWakeups());
+}
+
+void test4()
+{
+	::printf("\nstop token\n");
+	ActivatedWorker worker;
+	StoppableThread t(&worker, NULL);
+	t.Start();
+	for (int i = 0; i < 3; i++) {
+		Thread::MilliSleep(10);
+		MutexLock lock(&worker.mMutex);
+		worker.mIsActive = true;
+		worker.mActivated.Signal();
+	}
+	Thread::MilliSleep(10);
+	double start = now();
+	t.Stop();
+	::printf("  runs:%d stop:%.2f ms\n", worker.mRuns, (now() - start) * 1e3);
+}
+
+int main(int argc, char *argv[]) {
+	test1();
+	test2();
+	::printf("\nbounded queue (1 producer, 8 consumers)\n");
+	test3(false);
+	test3(true);
+	test4();
+
+	return 0;
+}
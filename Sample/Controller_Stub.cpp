@@ -2,13 +2,17 @@
 #include <string>
 #include <cmath>
 #include <stdlib.h>
+#include <unistd.h>
 
 #include "SharedMemoryContext.h"
 #include "SharedLock.h"
 #include "MySharedData.h"
+#include "MyMessages.h"
 #include "UnixDomainSocketClient.h"
 #include "Thread.h"
+#include "PeriodicThread.h"
 #include "MessageQueue.h"
+#include "StaticByteBuffer.h"
 
 using namespace PicoIPC;
 
@@ -32,30 +36,37 @@ public:
     }
 };
 
-class AxisAngleWoker : public IRunnable
+class AxisAngleWoker : public IPeriodicRunnable
 {
 public:
-    void Run()
+    AxisAngleWoker(MessageQueue *mq)
+        : mMQ(mq)
+        , mCounter(0)
     {
-        Thread *t = Thread::CurrentThread();
-        MessageQueue *mq = static_cast<MessageQueue*>(t->Parameter());
         ::srand(::time(NULL));
-        int counter = 0; 
-        while (true) {
-            if (!axis_on) {
-                Thread::MilliSleep(100);
-                continue;
-            }
+    }
 
-            ByteBuffer bb;
-            bb.Append(counter++%100);
-            for (int j = 0; j < 33; j++) {
-                bb.Append(static_cast<double>(rand())/RAND_MAX*2.0-1.0);
-            }
-            mq->TimedSend(bb, 10);
-            Thread::MilliSleep(10);
+    // 10ms周期で呼び出される(処理時間が周期に加算されない)
+    bool RunCycle(unsigned long long cycle)
+    {
+        if (!axis_on) {
+            return true;
         }
+
+        AxisFrame frame;
+        frame.counter = mCounter++%100;
+        for (int j = 0; j < 33; j++) {
+            frame.axis[j] = static_cast<double>(rand())/RAND_MAX*2.0-1.0;
+        }
+        StaticByteBuffer<400> bb;
+        frame.AppendTo(bb);
+        mMQ->TimedSend(bb, 10);
+        return true;
     }
+
+private:
+    MessageQueue *mMQ;
+    int           mCounter;
 };
 
 void help()
@@ -84,8 +95,7 @@ void request_upload(UnixDomainSocketClient &client)
 {
     ByteBuffer req;
     ByteBuffer res;
-    int id = 10;
-    req.Append(id);
+    ProgramUploadRequest().AppendTo(req);
 
     Error err = client.SendReceive(req,res);
     if (err) {
@@ -101,8 +111,7 @@ void request_download(UnixDomainSocketClient &client)
 {
     ByteBuffer req;
     ByteBuffer res;
-    int id = 11;
-    req.Append(id);
+    ProgramDownloadRequest().AppendTo(req);
 
     Error err = client.SendReceive(req,res);
     if (err) {
@@ -118,8 +127,7 @@ void request_programlist(UnixDomainSocketClient &client)
 {
     ByteBuffer req;
     ByteBuffer res;
-    int id = 12;
-    req.Append(id);
+    ProgramListRequest().AppendTo(req);
 
     Error err = client.SendReceive(req,res);
     if (err) {
@@ -160,9 +168,15 @@ int main(int argc, char *argv[])
         }
     }
     
-    AxisAngleWoker worker;
-    Thread t(&worker, &mq);
+    AxisAngleWoker worker(&mq);
+    PeriodicThread t(&worker, 10000);
+    // 制御周期のジッタを抑えるため最後のCPUに固定してリアルタイム優先度で動作させる
+    t.SetAffinity(static_cast<int>(::sysconf(_SC_NPROCESSORS_ONLN)) - 1);
+    t.SetSchedPolicy(SCHED_FIFO, 50);
     t.Start();
+    if (t.AttributeError()) {
+        printf("axis worker: %s\n", t.AttributeError().Message().c_str());
+    }
 
     // main loop
     {
@@ -0,0 +1,167 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+#include "Crc32c.h"
+#include "ByteBuffer.h"
+#include "ByteBufferView.h"
+#include "StaticByteBuffer.h"
+#include "MessageQueue.h"
+#include "SharedMemory.h"
+#include "SampleClock.h"
+
+using namespace PicoIPC;
+
+struct AxisArea
+{
+	int    counter;
+	double axis[33];
+};
+
+void test1()
+{
+	::printf("\nknown values\n");
+
+	const char *check = "123456789";
+	::printf("crc32c(\"123456789\"):%08x (expected e3069283)\n", Crc32c(check, ::strlen(check)));
+
+	char zeros[32];
+	::memset(zeros, 0, sizeof(zeros));
+	::printf("crc32c(32 x 0x00):%08x (expected 8a9136aa)\n", Crc32c(zeros, sizeof(zeros)));
+
+	// 分割して計算しても同じ値
+	unsigned int crc = Crc32c(check, 4);
+	crc = Crc32c(check + 4, 5, crc);
+	::printf("continued:%08x\n", crc);
+
+	// スライスバイ8の結果とハードウェア命令の結果が一致すること
+	std::vector<unsigned char> data(1000);
+	for (size_t i = 0; i < data.size(); i++) {
+		data[i] = static_cast<unsigned char>(i * 31 + 7);
+	}
+	bool same = true;
+	for (size_t size = 0; size < data.size(); size += 13) {
+		unsigned int table = ~Crc32cTable::Instance().Update(~0u, &data[0] + 1, size);
+		if (table != Crc32c(&data[0] + 1, size)) {
+			same = false;
+		}
+	}
+	::printf("table and hardware:%s\n", same ? "same" : "different");
+}
+
+void test2()
+{
+	::printf("\nbyte buffer checksum\n");
+
+	ByteBuffer bb;
+	bb.Append(123);
+	bb.Append(std::string("abc"));
+	bb.AppendChecksum();
+
+	ByteBuffer ok(bb.Data());
+	bool okValid = ok.VerifyChecksum();
+	::printf("verify:%d size:%lu\n", okValid, static_cast<unsigned long>(ok.Size()));
+	int i;
+	std::string s;
+	ok.Value(i);
+	ok.Value(s);
+	::printf("%d %s\n", i, s.c_str());
+
+	// 1ビット反転
+	std::string broken = bb.Data();
+	broken[2] ^= 0x10;
+	ByteBuffer ng(broken);
+	bool ngValid = ng.VerifyChecksum();
+	::printf("broken verify:%d size:%lu\n", ngValid, static_cast<unsigned long>(ng.Size()));
+
+	ByteBufferView view(bb.Data().data(), bb.Size());
+	bool viewValid = view.VerifyChecksum();
+	::printf("view verify:%d size:%lu\n", viewValid, static_cast<unsigned long>(view.Size()));
+}
+
+void test3()
+{
+	::printf("\nmessage queue\n");
+
+	MessageQueue mq("/mq_crc32c", 10, 400);
+	StaticByteBuffer<400> bb;
+	bb.Append(1);
+	for (int j = 0; j < 33; j++) {
+		bb.Append(j * 0.01);
+	}
+	bb.AppendChecksum();
+	Error err = mq.TimedSend(bb, 10);
+	if (err) {
+		::printf("err:%s\n", err.Message().c_str());
+		::exit(1);
+	}
+
+	ByteBuffer rcv;
+	mq.Receive(rcv);
+	if (!rcv.VerifyChecksum()) {
+		::printf("checksum error\n");
+		::exit(1);
+	}
+	int n;
+	rcv.Value(n);
+	::printf("verified n:%d size:%lu\n", n, static_cast<unsigned long>(rcv.Size()));
+}
+
+void test4()
+{
+	::printf("\nshared memory\n");
+
+	SharedMemory shm("/shm_crc32c", sizeof(ChecksummedData<AxisArea>), true);
+	ChecksummedData<AxisArea> *area = shm.Data<ChecksummedData<AxisArea> >();
+
+	shm.Wait();
+	area->data.counter = 1;
+	for (int j = 0; j < 33; j++) {
+		area->data.axis[j] = j * 0.5;
+	}
+	area->Seal();
+	shm.Post();
+	::printf("sealed valid:%d\n", area->IsValid());
+
+	// 書き込み途中で異常終了した状態
+	area->data.axis[10] = -1.0;
+	::printf("torn valid:%d\n", area->IsValid());
+}
+
+void test5()
+{
+	::printf("\nbenchmark\n");
+
+	std::vector<char> data(64 * 1024);
+	for (size_t i = 0; i < data.size(); i++) {
+		data[i] = static_cast<char>(i);
+	}
+	const int loop = 2000;
+	double total = static_cast<double>(data.size()) * loop;
+
+	unsigned int crc = 0;
+	double start = now();
+	for (int i = 0; i < loop; i++) {
+		crc = Crc32c(&data[0], data.size(), crc);
+	}
+	double elapsed = now() - start;
+	::printf("crc32c:      %8.1f MB/s (%08x)\n", total / elapsed / 1e6, crc);
+
+	crc = ~0u;
+	start = now();
+	for (int i = 0; i < loop; i++) {
+		crc = Crc32cTable::Instance().Update(crc, reinterpret_cast<unsigned char *>(&data[0]), data.size());
+	}
+	elapsed = now() - start;
+	::printf("slice-by-8:  %8.1f MB/s (%08x)\n", total / elapsed / 1e6, ~crc);
+}
+
+int main(int argc, char *argv[]) {
+	test1();
+	test2();
+	test3();
+	test4();
+	test5();
+	return 0;
+}
@@ -0,0 +1,183 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <math.h>
+#include <vector>
+#include "DoubleFrameCodec.h"
+#include "DoubleFrameJournal.h"
+#include "ByteBuffer.h"
+#include "StaticByteBuffer.h"
+
+using namespace PicoIPC;
+
+const size_t WIDTH = 33;
+const char *PATH = "/tmp/double_frame_test";
+
+// 10ms周期の軸角度を想定したフレーム
+static void makeFrame(int n, double *frame)
+{
+	for (size_t j = 0; j < WIDTH; j++) {
+		if (j % 4 != 0) {
+			// 停止している軸
+			frame[j] = 15.0 * j;
+		} else if ((n / 50) % 2 == 0) {
+			// 0.5度/秒で動く軸
+			frame[j] = 15.0 * j + (n % 100) * 0.005;
+		} else {
+			frame[j] = 15.0 * j + 0.25;
+		}
+	}
+}
+
+void cleanup()
+{
+	for (unsigned int i = 0; JournalSegment::Exist(PATH, i); i++) {
+		::unlink(JournalSegment::SegmentPath(PATH, i).c_str());
+	}
+}
+
+void test1()
+{
+	::printf("\nround trip\n");
+
+	DoubleFrameEncoder encoder(WIDTH);
+	DoubleFrameDecoder decoder(WIDTH);
+	double frame[WIDTH];
+	double decoded[WIDTH];
+	size_t total = 0;
+	bool same = true;
+	const int count = 1000;
+	for (int n = 0; n < count; n++) {
+		makeFrame(n, frame);
+		const std::string &data = encoder.Encode(frame);
+		total += data.size();
+		if (!decoder.Decode(data.data(), data.size(), decoded) || ::memcmp(frame, decoded, sizeof(frame)) != 0) {
+			same = false;
+		}
+	}
+	size_t raw = sizeof(frame) * count;
+	::printf("same:%d raw:%lu encoded:%lu ratio:%.1f\n", same,
+		static_cast<unsigned long>(raw), static_cast<unsigned long>(total), static_cast<double>(raw) / total);
+}
+
+void test2()
+{
+	::printf("\nspecial values\n");
+
+	DoubleFrameEncoder encoder(8);
+	DoubleFrameDecoder decoder(8);
+	double frame[8] = { 0.0, -0.0, NAN, INFINITY, -INFINITY, 5e-324, 1.7976931348623157e308, -1.0 };
+	double decoded[8];
+	bool same = true;
+	srand(1);
+	for (int n = 0; n < 1000; n++) {
+		const std::string &data = encoder.Encode(frame);
+		if (!decoder.Decode(data.data(), data.size(), decoded) || ::memcmp(frame, decoded, sizeof(frame)) != 0) {
+			same = false;
+		}
+		// ランダムなビット列
+		int j = rand() % 8;
+		unsigned long long bits = (static_cast<unsigned long long>(rand()) << 33) ^ (static_cast<unsigned long long>(rand()) << 11) ^ rand();
+		::memcpy(&frame[j], &bits, sizeof(bits));
+	}
+	::printf("same:%d\n", same);
+}
+
+void test3()
+{
+	::printf("\nbyte buffer\n");
+
+	// エンコーダーは直前のフレームを保持するため出力先ごとに用意する
+	DoubleFrameEncoder encoder(WIDTH, 4);
+	DoubleFrameEncoder staticEncoder(WIDTH, 4);
+	ByteBuffer bb;
+	StaticByteBuffer<4096> sbb;
+	double frame[WIDTH];
+	for (int n = 0; n < 10; n++) {
+		makeFrame(n, frame);
+		encoder.Encode(frame, bb);
+		staticEncoder.Encode(frame, sbb);
+	}
+	::printf("10 frames size:%lu static:%lu raw:%lu\n", static_cast<unsigned long>(bb.Size()),
+		static_cast<unsigned long>(sbb.Size()), static_cast<unsigned long>(sizeof(frame) * 10));
+
+	DoubleFrameDecoder decoder(WIDTH);
+	std::vector<double> decoded;
+	int ok = 0;
+	for (int n = 0; n < 10; n++) {
+		makeFrame(n, frame);
+		if (decoder.Decode(bb, decoded) && ::memcmp(frame, &decoded[0], sizeof(frame)) == 0) {
+			ok++;
+		}
+	}
+	::printf("decoded:%d/10\n", ok);
+
+	// 途中から復号するときはキーフレーム(4フレームごと)まで復号できない
+	DoubleFrameDecoder late(WIDTH);
+	ByteBuffer copy(sbb.Data(), sbb.Size());
+	::printf("from head:");
+	for (int n = 0; n < 10; n++) {
+		if (n == 0) {
+			// 最初のキーフレームを読み飛ばす
+			std::string skip;
+			copy.Value(skip);
+			::printf(" -");
+			continue;
+		}
+		::printf(" %d", late.Decode(copy, &decoded[0]));
+	}
+	::printf("\n");
+}
+
+void test4()
+{
+	::printf("\njournal\n");
+
+	cleanup();
+	const int count = 1000;
+	{
+		DoubleFrameJournal journal(PATH, WIDTH, 50, 16 * 1024);
+		double frame[WIDTH];
+		for (int n = 0; n < count; n++) {
+			makeFrame(n, frame);
+			Error err = journal.Append(frame, 1000000000ULL + n * 10000000ULL);
+			if (err) {
+				::printf("err:%s\n", err.Message().c_str());
+				::exit(1);
+			}
+		}
+		::printf("segments:");
+		for (unsigned int i = 0; JournalSegment::Exist(PATH, i); i++) {
+			::printf(" %u", i);
+		}
+		::printf(" (16Kbyte each, raw frames need %lu Kbyte)\n",
+			static_cast<unsigned long>(sizeof(frame) * count / 1024));
+	}
+
+	DoubleFrameJournalReader reader(PATH, WIDTH);
+	double frame[WIDTH];
+	double expected[WIDTH];
+	int read = 0;
+	bool same = true;
+	while (reader.TryRead(frame)) {
+		makeFrame(static_cast<int>(reader.Index()), expected);
+		same = same && ::memcmp(frame, expected, sizeof(frame)) == 0;
+		read++;
+	}
+	::printf("read:%d same:%d\n", read, same);
+
+	reader.SeekIndex(525);
+	if (reader.TryRead(frame)) {
+		makeFrame(static_cast<int>(reader.Index()), expected);
+		::printf("seek 525 -> index:%llu same:%d\n", reader.Index(), ::memcmp(frame, expected, sizeof(frame)) == 0);
+	}
+	cleanup();
+}
+
+int main(int argc, char *argv[]) {
+	test1();
+	test2();
+	test3();
+	test4();
+	return 0;
+}
@@ -0,0 +1,66 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "DropOldestQueue.h"
+#include "Thread.h"
+
+using namespace PicoIPC;
+
+void test1(MessageQueue &mq)
+{
+	::printf("\ntest1 drop oldest send\n");
+
+	DropOldestQueue q(&mq);
+	mq.Clear();
+	// MaxMessageCount(3)を超えて送信してもブロックしない
+	for (int i = 0; i < 10; i++) {
+		ByteBuffer bb;
+		bb.Append(i);
+		Error err = q.Send(bb);
+		if (err) {
+			::printf("err:%s\n", err.Message().c_str());
+			::exit(1);
+		}
+	}
+	::printf("CurrentMessageCount %ld\n", mq.CurrentMessageCount());
+	::printf("DropCount %lu\n", q.DropCount());
+
+	// 残っているのは最新の3件(7,8,9)
+	long count = mq.CurrentMessageCount();
+	for (int i = 0; i < count; i++) {
+		ByteBuffer bb;
+		Error err = mq.TimedReceive(bb, 100);
+		if (err) {
+			::printf("err:%s\n", err.Message().c_str());
+			::exit(1);
+		}
+		int v;
+		bb.Value(v);
+		::printf("recv:%d\n", v);
+	}
+}
+
+void test2(MessageQueue &mq)
+{
+	::printf("\ntest2 drop count shared with receiver\n");
+
+	DropOldestQueue sender(&mq);
+	MessageQueue rq(mq.Name());
+	DropOldestQueue receiver(&rq);
+
+	unsigned long pre = receiver.DropCount();
+	for (int i = 0; i < 5; i++) {
+		ByteBuffer bb;
+		bb.Append(i);
+		sender.Send(bb);
+	}
+	::printf("lost %lu\n", receiver.DropCount() - pre);
+	mq.Clear();
+}
+
+int main(int argc, char *argv[]) {
+	MessageQueue mq("/mq_drop", 3, 64);
+
+	test1(mq);
+	test2(mq);
+	return 0;
+}
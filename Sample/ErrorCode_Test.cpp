@@ -0,0 +1,156 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <new>
+#include "ErrorCode.h"
+#include "MessageQueue.h"
+#include "StaticByteBuffer.h"
+#include "SampleClock.h"
+
+using namespace PicoIPC;
+
+// ヒープの確保回数を数える
+static int allocations = 0;
+
+__attribute__((noinline)) void *operator new(size_t size) throw(std::bad_alloc)
+{
+	allocations++;
+	void *p = ::malloc(size);
+	if (p == NULL) {
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+__attribute__((noinline)) void operator delete(void *p) throw()
+{
+	::free(p);
+}
+
+void test1()
+{
+	::printf("\nerror code\n");
+
+	ErrorCode ok = ErrorCode::createNoError();
+	ErrorCode timeout = ErrorCode::createError(ErrorCode::MESSAGE_QUEUE, ErrorCode::RECEIVE, ETIMEDOUT);
+	ErrorCode open = ErrorCode::createError(ErrorCode::SHARED_MEMORY, ErrorCode::OPEN, ENOENT);
+
+	::printf("sizeof:%lu\n", static_cast<unsigned long>(sizeof(ErrorCode)));
+	::printf("ok:%d [%s]\n", static_cast<bool>(ok), ok.Message().c_str());
+	::printf("timeout:%d is timeout:%d code:%08x [%s]\n", static_cast<bool>(timeout), timeout.IsTimeout(),
+		timeout.Code(), timeout.Message().c_str());
+	::printf("open:%d is timeout:%d errno:%d [%s]\n", static_cast<bool>(open), open.IsTimeout(),
+		open.Number(), open.Message().c_str());
+
+	Error err = timeout.ToError();
+	::printf("to error:%d [%s]\n", static_cast<bool>(err), err.Message().c_str());
+	::printf("==:%d !=:%d\n", timeout == ErrorCode(ErrorCode::MESSAGE_QUEUE, ErrorCode::RECEIVE, ETIMEDOUT), timeout != open);
+}
+
+void test2()
+{
+	::printf("\nsend/receive\n");
+
+	MessageQueue mq("/error_code_test", 2, 256);
+	ByteBuffer bb;
+	bb.Append(std::string("axis"));
+	bb.Append(123);
+
+	ErrorCode code = mq.TimedSendCode(bb, 10);
+	::printf("send:%d [%s]\n", static_cast<bool>(code), code.Message().c_str());
+
+	ByteBuffer received;
+	code = mq.TimedReceiveCode(received, 10);
+	std::string name;
+	int value = 0;
+	received.Value(name);
+	received.Value(value);
+	::printf("receive:%d size:%lu name:%s value:%d\n", static_cast<bool>(code),
+		static_cast<unsigned long>(received.Size()), name.c_str(), value);
+
+	code = mq.TimedReceiveCode(received, 10);
+	::printf("empty:%d is timeout:%d size:%lu [%s]\n", static_cast<bool>(code), code.IsTimeout(),
+		static_cast<unsigned long>(received.Size()), code.Message().c_str());
+
+	StaticByteBuffer<4> overflow;
+	overflow.Append(std::string("overflow"));
+	code = mq.TimedSendCode(overflow, 10);
+	::printf("overflow:%d [%s]\n", static_cast<bool>(code), code.Message().c_str());
+	Error err = mq.TimedSend(overflow, 10);
+	::printf("overflow error:[%s]\n", err.Message().c_str());
+}
+
+void test3()
+{
+	::printf("\nallocations\n");
+
+	MessageQueue mq("/error_code_test", 2, 256);
+	ByteBuffer bb;
+	bb.Append(1.5);
+	ByteBuffer received;
+	mq.TimedSendCode(bb, 1);
+	mq.TimedReceiveCode(received, 1);
+
+	// 成功時とタイムアウト時(ノンブロッキングに近い1msで空のキューを読む)
+	const int count = 100;
+	int before = allocations;
+	int timeouts = 0;
+	for (int i = 0; i < count; i++) {
+		mq.TimedSendCode(bb, 1);
+		mq.TimedReceiveCode(received, 1);
+		if (mq.TimedReceiveCode(received, 1).IsTimeout()) {
+			timeouts++;
+		}
+	}
+	::printf("ErrorCode: timeouts:%d allocations:%d\n", timeouts, allocations - before);
+
+	before = allocations;
+	timeouts = 0;
+	for (int i = 0; i < count; i++) {
+		mq.TimedSend(bb, 1);
+		mq.TimedReceive(received, 1);
+		if (mq.TimedReceive(received, 1)) {
+			timeouts++;
+		}
+	}
+	::printf("Error    : timeouts:%d allocations:%d\n", timeouts, allocations - before);
+}
+
+void test4()
+{
+	::printf("\nbenchmark (create and check)\n");
+
+	const int count = 1000000;
+	volatile int number = ETIMEDOUT;
+	int errors = 0;
+
+	double start = now();
+	for (int i = 0; i < count; i++) {
+		ErrorCode code = ErrorCode::createError(ErrorCode::MESSAGE_QUEUE, ErrorCode::RECEIVE, number);
+		if (code.IsTimeout()) {
+			errors++;
+		}
+	}
+	double codeTime = now() - start;
+
+	start = now();
+	for (int i = 0; i < count; i++) {
+		Error err = Error::createError("message queue receive error [%s]", ::strerror(number));
+		if (err) {
+			errors++;
+		}
+	}
+	double errorTime = now() - start;
+
+	::printf("errors:%d\n", errors);
+	::printf("ErrorCode:%.1f ns Error:%.1f ns\n", codeTime * 1e9 / count, errorTime * 1e9 / count);
+}
+
+int main(int argc, char *argv[]) {
+	test1();
+	test2();
+	test3();
+	test4();
+
+	return 0;
+}
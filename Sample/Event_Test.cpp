@@ -0,0 +1,237 @@
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <vector>
+#include "Event.h"
+#include "CountDownLatch.h"
+#include "Barrier.h"
+#include "Mutex.h"
+#include "MutexLock.h"
+#include "Thread.h"
+#include "SampleClock.h"
+
+using namespace PicoIPC;
+
+// 共有メモリ上に配置する構造体(POD)
+struct SharedSync
+{
+	SharedEvent          started;
+	SharedCountDownLatch done;
+	SharedBarrier        barrier;
+	int                  values[4];
+};
+
+// Mutex + 条件変数 + bool による従来の通知
+class MutexEvent
+{
+public:
+	MutexEvent() : mIsSet(false) {}
+
+	void Set()
+	{
+		MutexLock lock(&mMutex);
+		mIsSet = true;
+		lock.Broadcast();
+	}
+
+	void Reset()
+	{
+		MutexLock lock(&mMutex);
+		mIsSet = false;
+	}
+
+	void Wait()
+	{
+		MutexLock lock(&mMutex);
+		while (!mIsSet) {
+			lock.Wait();
+		}
+	}
+
+private:
+	Mutex mMutex;
+	bool  mIsSet;
+};
+
+class Responder : public IRunnable
+{
+public:
+	Responder(Event *request, Event *response, int count) : mRequest(request), mResponse(response), mCount(count) {}
+
+	void Run()
+	{
+		for (int i = 0; i < mCount; i++) {
+			mRequest->Wait();
+			mRequest->Reset();
+			mResponse->Set();
+		}
+	}
+
+private:
+	Event *mRequest;
+	Event *mResponse;
+	int    mCount;
+};
+
+class BarrierWorker : public IRunnable
+{
+public:
+	BarrierWorker(Barrier *barrier, int rounds) : mBarrier(barrier), mRounds(rounds), mSerialCount(0) {}
+
+	void Run()
+	{
+		for (int i = 0; i < mRounds; i++) {
+			if (mBarrier->Arrive()) {
+				__sync_fetch_and_add(&mSerialCount, 1);
+			}
+		}
+	}
+
+	Barrier *mBarrier;
+	int      mRounds;
+	int      mSerialCount;
+};
+
+class LatchWorker : public IRunnable
+{
+public:
+	void Run()
+	{
+		CountDownLatch *latch = static_cast<CountDownLatch *>(Thread::CurrentThread()->Parameter());
+		Thread::MilliSleep(10);
+		latch->CountDown();
+	}
+};
+
+void test1()
+{
+	::printf("\nuncontended (ns/op)\n");
+	const int count = 10000000;
+	Event event;
+	double start = now();
+	for (int i = 0; i < count; i++) {
+		event.Set();
+		event.Wait();
+		event.Reset();
+	}
+	::printf("  Event Set+Wait+Reset        %6.1f\n", (now() - start) * 1e9 / count);
+
+	MutexEvent mutexEvent;
+	start = now();
+	for (int i = 0; i < count; i++) {
+		mutexEvent.Set();
+		mutexEvent.Wait();
+		mutexEvent.Reset();
+	}
+	::printf("  Mutex+cond+bool             %6.1f\n", (now() - start) * 1e9 / count);
+
+	CountDownLatch latch(count);
+	start = now();
+	for (int i = 0; i < count; i++) {
+		latch.CountDown();
+	}
+	latch.Wait();
+	::printf("  CountDownLatch CountDown    %6.1f\n", (now() - start) * 1e9 / count);
+}
+
+void test2()
+{
+	::printf("\nping-pong between 2 threads\n");
+	const int count = 20000;
+	Event request;
+	Event response;
+	Responder responder(&request, &response, count);
+	Thread t(&responder, NULL);
+	t.Start();
+	double start = now();
+	for (int i = 0; i < count; i++) {
+		request.Set();
+		response.Wait();
+		response.Reset();
+	}
+	::printf("  round trip %.2f us\n", (now() - start) * 1e6 / count);
+	t.Join();
+
+	start = now();
+	bool isSet = response.TimedWait(30);
+	::printf("  timed wait set:%d %.0f ms\n", isSet, (now() - start) * 1e3);
+}
+
+void test3()
+{
+	::printf("\nlatch and barrier\n");
+	CountDownLatch latch(4);
+	LatchWorker worker;
+	std::vector<Thread *> threads;
+	for (int i = 0; i < 4; i++) {
+		threads.push_back(new Thread(&worker, &latch));
+		threads.back()->Start();
+	}
+	double start = now();
+	latch.Wait();
+	::printf("  latch released count:%d %.0f ms\n", latch.Count(), (now() - start) * 1e3);
+	for (size_t i = 0; i < threads.size(); i++) {
+		threads[i]->Join();
+		delete threads[i];
+	}
+	threads.clear();
+
+	const int rounds = 10000;
+	Barrier barrier(4);
+	BarrierWorker barrierWorker(&barrier, rounds);
+	start = now();
+	for (int i = 0; i < 4; i++) {
+		threads.push_back(new Thread(&barrierWorker, NULL));
+		threads.back()->Start();
+	}
+	for (size_t i = 0; i < threads.size(); i++) {
+		threads[i]->Join();
+		delete threads[i];
+	}
+	::printf("  barrier rounds:%d serial:%d %.2f us/round\n", rounds, barrierWorker.mSerialCount,
+		(now() - start) * 1e6 / rounds);
+}
+
+void test4()
+{
+	::printf("\nprocess shared\n");
+	SharedSync *sync = static_cast<SharedSync *>(::mmap(NULL, sizeof(SharedSync),
+		PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0));
+	// mmapした領域は0で初期化されているため、SharedEventは未設定の状態
+	sync->done.Init(3);
+	sync->barrier.Init(4);
+
+	std::vector<pid_t> children;
+	for (int i = 0; i < 3; i++) {
+		pid_t pid = ::fork();
+		if (pid == 0) {
+			sync->started.Wait();
+			sync->values[i + 1] = (i + 1) * 10;
+			sync->barrier.Arrive();
+			sync->done.CountDown();
+			::_exit(0);
+		}
+		children.push_back(pid);
+	}
+	Thread::MilliSleep(10);
+	sync->started.Set();
+	sync->values[0] = 0;
+	sync->barrier.Arrive();
+	bool isDone = sync->done.TimedWait(1000);
+	::printf("  done:%d values:%d,%d,%d,%d\n", isDone, sync->values[0], sync->values[1], sync->values[2], sync->values[3]);
+	for (size_t i = 0; i < children.size(); i++) {
+		::waitpid(children[i], NULL, 0);
+	}
+	::munmap(sync, sizeof(SharedSync));
+}
+
+int main(int argc, char *argv[]) {
+	test1();
+	test2();
+	test3();
+	test4();
+
+	return 0;
+}
@@ -0,0 +1,178 @@
+#include <stdio.h>
+#include <time.h>
+#include <vector>
+#include "Executor.h"
+#include "SampleClock.h"
+
+using namespace PicoIPC;
+
+static int answer()
+{
+	return 42;
+}
+
+// result_typeを定義した関数オブジェクト
+struct Square
+{
+	typedef long result_type;
+
+	Square(long v) : value(v) {}
+
+	long operator()() const
+	{
+		return value * value;
+	}
+
+	long value;
+};
+
+class Counter : public IRunnable
+{
+public:
+	Counter() : mCount(0) {}
+
+	void Run()
+	{
+		__sync_fetch_and_add(&mCount, 1);
+	}
+
+	long Count() const
+	{
+		return mCount;
+	}
+
+private:
+	volatile long mCount;
+};
+
+// ワーカーの中から子タスクを投入する(自分の両端キューに入り、他のワーカーがスティールする)
+struct Spawn
+{
+	typedef void result_type;
+
+	Spawn(Executor *e, Counter *c, int d) : executor(e), counter(c), depth(d) {}
+
+	void operator()() const
+	{
+		counter->Run();
+		if (depth > 0) {
+			executor->Submit(Spawn(executor, counter, depth - 1));
+			executor->Submit(Spawn(executor, counter, depth - 1));
+		}
+	}
+
+	Executor *executor;
+	Counter  *counter;
+	int       depth;
+};
+
+// CPUを使う処理
+struct Work
+{
+	typedef unsigned int result_type;
+
+	Work(unsigned int s) : seed(s) {}
+
+	unsigned int operator()() const
+	{
+		unsigned int x = seed;
+		for (int i = 0; i < 200000; i++) {
+			x = x * 1103515245 + 12345;
+		}
+		return x;
+	}
+
+	unsigned int seed;
+};
+
+void test1()
+{
+	::printf("\nsubmit\n");
+
+	Executor executor(4);
+	::printf("workers:%u cores:%u\n", executor.WorkerCount(), Executor::HardwareConcurrency());
+
+	Future<int> f = executor.Submit(&answer);
+	::printf("answer:%d\n", f.Get());
+
+	std::vector< Future<long> > squares;
+	for (long i = 0; i < 100; i++) {
+		squares.push_back(executor.Submit(Square(i)));
+	}
+	long sum = 0;
+	for (size_t i = 0; i < squares.size(); i++) {
+		sum += squares[i].Get();
+	}
+	::printf("sum of squares:%ld (expected %ld)\n", sum, 99L * 100 * 199 / 6);
+
+	Counter counter;
+	Future<void> done;
+	for (int i = 0; i < 1000; i++) {
+		done = executor.Submit(&counter);
+	}
+	executor.WaitIdle();
+	::printf("runnable:%ld ready:%d\n", counter.Count(), done.IsReady());
+}
+
+void test2()
+{
+	::printf("\nnested submit\n");
+
+	Executor executor(4);
+	Counter counter;
+	executor.Submit(Spawn(&executor, &counter, 14));
+	executor.WaitIdle();
+	::printf("tasks:%ld (expected %d)\n", counter.Count(), (1 << 15) - 1);
+}
+
+void test3()
+{
+	::printf("\nscaling\n");
+
+	const unsigned int count = 256;
+	unsigned int expected = 0;
+	for (unsigned int i = 0; i < count; i++) {
+		expected ^= Work(i)();
+	}
+
+	unsigned int workers[] = { 1, 2, 4 };
+	for (size_t w = 0; w < sizeof(workers) / sizeof(workers[0]); w++) {
+		Executor executor(workers[w]);
+		double start = now();
+		std::vector< Future<unsigned int> > results;
+		for (unsigned int i = 0; i < count; i++) {
+			results.push_back(executor.Submit(Work(i)));
+		}
+		unsigned int actual = 0;
+		for (size_t i = 0; i < results.size(); i++) {
+			actual ^= results[i].Get();
+		}
+		::printf("workers:%u %.1f ms match:%d\n", workers[w], (now() - start) * 1e3, actual == expected);
+	}
+}
+
+void test4()
+{
+	::printf("\nsubmit after shutdown\n");
+
+	Executor executor(4);
+	Counter counter;
+	executor.Submit(Spawn(&executor, &counter, 10));
+	executor.Shutdown();
+	::printf("tasks:%ld (expected %d)\n", counter.Count(), (1 << 11) - 1);
+
+	Future<int> f = executor.Submit(&answer);
+	Future<void> r = executor.Submit(&counter);
+	::printf("cancelled:%d %d ready:%d %d value:%d\n", f.IsCancelled(), r.IsCancelled(), f.IsReady(), r.IsReady(), f.Get());
+	r.Get();
+	::printf("tasks:%ld (not run)\n", counter.Count());
+}
+
+int main(int argc, char *argv[]) {
+	test1();
+	test2();
+	test3();
+	test4();
+
+	return 0;
+}
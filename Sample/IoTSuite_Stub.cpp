@@ -1,13 +1,16 @@
 #include <iostream>
-#include <fstream>
 #include <string>
 
 #include "SharedMemoryContext.h"
 #include "SharedLock.h"
 #include "MySharedData.h"
+#include "MyMessages.h"
 #include "UnixDomainSocketServer.h"
 #include "Thread.h"
+#include "StopToken.h"
+#include "ConditionVariable.h"
 #include "MessageQueue.h"
+#include "DoubleFrameJournal.h"
 
 using namespace PicoIPC;
 
@@ -17,19 +20,19 @@ public:
 	void Received(ByteBuffer &request, ByteBuffer &response)
 	{
 		::printf("receive data\n");
-		int id;
-		request.Value(id);
-		if (id == 10) {
+		switch (PeekMessageId(request)) {
+		case ProgramUploadRequest::MESSAGE_ID:
 			response.Append("program upload response");
-		}
-		else if (id == 11) {
+			break;
+		case ProgramDownloadRequest::MESSAGE_ID:
 			response.Append("program download response");
-		}
-		else if (id == 12) {
+			break;
+		case ProgramListRequest::MESSAGE_ID:
 			response.Append("program list response");
-		}
-		else {
+			break;
+		default:
 			response.Append("???");
+			break;
 		}
 	}
 
@@ -84,27 +87,22 @@ public:
 	AxisLogger(MessageQueue *mq)
 		: mMQ(mq)
 		, mIsActive(false)
+		, mJournal("axis_list", AXIS_LOG_WIDTH)
+		, mActivated(mMutex)
 	{
-		mFile.open("axis_list.dat", std::fstream::out | std::fstream::app);
 	}
 
 	void Run()
 	{
-		int counter;
-		double axis;
+		// Cancel()ではなく停止要求で抜ける(待機中も停止要求ですぐに起きる)
+		StopToken token = StoppableThread::CurrentToken();
 		ByteBuffer bb;
-		while (true) {
+		while (!token.IsStopRequested()) {
 			if (mIsActive) {
 #if 0
 				Error e = mMQ->TimedReceive(bb, 500);
 				if (!e) {
-					bb.Value(counter);
-					mFile << counter;
-					for (int j = 0; j < 33; j++) {
-						bb.Value(axis);
-						mFile << " " << axis;
-					}
-					mFile << std::endl;
+					Append(bb);
 				} else {
 					printf("err:%s\n",e.Message().c_str());
 				}
@@ -114,23 +112,18 @@ public:
 				Error e = mMQ->Receive(list);
 				if (!e) {
 					for (size_t i = 0; i < list.size(); i++) {
-						ByteBuffer &b = list[i];
-						b.Value(counter);
-						mFile << counter;
-						for (int j = 0; j < 33; j++) {
-							b.Value(axis);
-							mFile << " " << axis;
-						}
-						mFile << std::endl;
+						Append(list[i]);
 					}
 				} else {
 					printf("err:%s\n",e.Message().c_str());
 				}
-				Thread::MilliSleep(100);
+				token.SleepFor(100);
 #endif
 			} else {
 				mMutex.Lock();
-				mMutex.ConditionWait();
+				if (!mIsActive) {
+					token.ConditionWait(mActivated);
+				}
 				mMutex.Unlock();
 			}
 		}
@@ -138,16 +131,16 @@ public:
 
 	void Cleanup()
 	{
-		mFile.close();
+		mJournal.Sync();
 	}
 
 	void on()
 	{
-		printf("write to axis_list.dat\n");
+		printf("write to axis_list.000000.jnl\n");
 
 		mMutex.Lock();
 		mIsActive = true;
-        mMutex.ConditionSignal();
+        mActivated.Signal();
         mMutex.Unlock();
 	}
 
@@ -159,10 +152,25 @@ public:
 	}
 
 private:
+	// counter + axis[33]
+	static const size_t AXIS_LOG_WIDTH = 34;
+
 	MessageQueue *mMQ;
 	bool mIsActive;
-	std::fstream mFile;
+	DoubleFrameJournal mJournal;
 	Mutex  mMutex;
+	ConditionVariable mActivated; // mIsActiveがtrueになった
+
+	// 前回からの差分をXOR圧縮して記録する
+	void Append(ByteBuffer &bb)
+	{
+		AxisFrame frame;
+		frame.ValueFrom(bb);
+		double values[AXIS_LOG_WIDTH];
+		values[0] = frame.counter;
+		::memcpy(values + 1, frame.axis, sizeof(frame.axis));
+		mJournal.Append(values);
+	}
 };
 
 
@@ -203,7 +211,7 @@ int main(int argc, char *argv[])
 	SharedMemory *shm;
 	MessageQueue mq("/mq1");
 	AxisLogger logger(&mq);
-	Thread t(&logger, NULL);
+	StoppableThread t(&logger, NULL);
 
 
 	// initialize
@@ -250,8 +258,7 @@ int main(int argc, char *argv[])
 
 	// finalize
 	{
-		t.Cancel();
-		t.Join();
+		t.Stop();
 	}
 
 	return 0;
@@ -0,0 +1,167 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "JournalQueue.h"
+
+using namespace PicoIPC;
+
+const char *PATH = "/tmp/journal_test";
+
+void cleanup()
+{
+	for (unsigned int i = 0; JournalSegment::Exist(PATH, i); i++) {
+		::unlink(JournalSegment::SegmentPath(PATH, i).c_str());
+	}
+}
+
+void test1()
+{
+	::printf("\nappend and replay\n");
+
+	unsigned long long middle = 0;
+	{
+		// 1セグメントに約100レコード
+		JournalQueue journal(PATH, 4096);
+		if (!journal.IsOpen()) {
+			::printf("err:%s\n", journal.LastError().Message().c_str());
+			::exit(1);
+		}
+		for (int i = 0; i < 1000; i++) {
+			ByteBuffer bb;
+			bb.Append(i);
+			bb.Append(i * 0.5);
+			unsigned long long timestamp = 1000000000ULL + i * 10000000ULL;
+			if (i == 500) {
+				middle = timestamp;
+			}
+			Error err = journal.Append(bb, timestamp);
+			if (err) {
+				::printf("err:%s\n", err.Message().c_str());
+				::exit(1);
+			}
+		}
+		::printf("next index:%llu\n", journal.NextIndex());
+	}
+
+	JournalReader reader(PATH);
+	int count = 0;
+	int last = -1;
+	ByteBuffer bb;
+	while (reader.TryRead(bb)) {
+		int v;
+		bb.Value(v);
+		if (v != last + 1) {
+			::printf("err: %d -> %d\n", last, v);
+			::exit(1);
+		}
+		last = v;
+		count++;
+	}
+	::printf("replay count:%d last:%d index:%llu\n", count, last, reader.Index());
+
+	reader.SeekIndex(123);
+	reader.TryRead(bb);
+	int v;
+	bb.Value(v);
+	::printf("seek index 123 -> value:%d index:%llu\n", v, reader.Index());
+
+	reader.SeekTime(middle);
+	ByteBufferView view;
+	reader.TryRead(view);
+	view.Value(v);
+	::printf("seek time -> value:%d index:%llu\n", v, reader.Index());
+}
+
+void test2()
+{
+	::printf("\nresume and tail\n");
+
+	JournalReader reader(PATH);
+	reader.SeekEnd();
+
+	JournalQueue journal(PATH, 4096);
+	::printf("resume next index:%llu\n", journal.NextIndex());
+	for (int i = 1000; i < 1300; i++) {
+		ByteBuffer bb;
+		bb.Append(i);
+		journal.Append(bb);
+	}
+
+	int count = 0;
+	ByteBuffer bb;
+	while (!reader.TimedRead(bb, 10)) {
+		count++;
+	}
+	int v;
+	bb.Value(v);
+	::printf("tail count:%d last:%d index:%llu\n", count, v, reader.Index());
+}
+
+// 最後から2番目のセグメントの終端レコードを消して、Roll()の途中で終了した状態にする
+static void dropEnd(bool truncateLast)
+{
+	unsigned int last = 0;
+	while (JournalSegment::Exist(PATH, last + 1)) {
+		last++;
+	}
+	JournalSegment segment;
+	segment.Open(PATH, last - 1, true);
+	size_t offset = sizeof(JournalSegmentHeader);
+	while (segment.Record(offset)->state == JournalSegment::RECORD_COMMITTED) {
+		offset += JournalSegment::RecordSize(segment.Record(offset)->length);
+	}
+	segment.Record(offset)->state = JournalSegment::RECORD_EMPTY;
+	segment.Close();
+	if (truncateLast) {
+		// 次のセグメントの作成中に終了していた
+		::truncate(JournalSegment::SegmentPath(PATH, last).c_str(), 0);
+	}
+}
+
+void test3()
+{
+	::printf("\nrecover from crash while rolling\n");
+
+	for (int truncateLast = 0; truncateLast < 2; truncateLast++) {
+		cleanup();
+		int written = 0;
+		{
+			JournalQueue journal(PATH, 4096);
+			while (!JournalSegment::Exist(PATH, 2)) {
+				ByteBuffer bb;
+				bb.Append(written++);
+				journal.Append(bb);
+			}
+		}
+		dropEnd(truncateLast != 0);
+		// 切り詰めたセグメントの最初のレコードは失われる
+		int lost = truncateLast;
+		{
+			JournalQueue journal(PATH, 4096);
+			for (int i = 0; i < 200; i++) {
+				ByteBuffer bb;
+				bb.Append(written++);
+				journal.Append(bb);
+			}
+		}
+		JournalReader reader(PATH);
+		ByteBuffer bb;
+		int count = 0;
+		int v = -1;
+		while (reader.TryRead(bb)) {
+			bb.Value(v);
+			count++;
+		}
+		::printf("%s: read:%d (expected %d) last:%d\n", truncateLast ? "next segment empty" : "next segment created",
+			count, written - lost, v);
+	}
+}
+
+int main(int argc, char *argv[]) {
+	cleanup();
+	test1();
+	test2();
+	test3();
+	cleanup();
+	return 0;
+}
@@ -0,0 +1,136 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "ByteBufferView.h"
+#include "StaticByteBuffer.h"
+#include "MessageSchema.h"
+#include "MyMessages.h"
+
+using namespace PicoIPC;
+
+struct Point
+{
+	short x;
+	short y;
+};
+
+#define SET_AXIS_REQUEST_FIELDS(FIELD, ARRAY) \
+	FIELD(char, axis) \
+	FIELD(double, angle) \
+	FIELD(Point, position) \
+	ARRAY(float, gains, 3)
+
+PICO_MESSAGE_ID(SetAxisRequest, 20, SET_AXIS_REQUEST_FIELDS);
+
+// 以下はコンパイルエラーとなる
+// #define BAD_FIELDS(FIELD, ARRAY) FIELD(std::string, name)
+// PICO_MESSAGE(BadMessage, BAD_FIELDS);
+// PICO_MESSAGE_ASSERT_SIZE(AxisFrame, 100);
+
+double elapsed(const timespec &start)
+{
+	timespec now;
+	::clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start.tv_sec) * 1000.0 + (now.tv_nsec - start.tv_nsec) / 1000000.0;
+}
+
+void test1()
+{
+	::printf("\nsame layout as Append()\n");
+
+	AxisFrame frame;
+	frame.counter = 7;
+	for (int j = 0; j < 33; j++) {
+		frame.axis[j] = j * 0.5;
+	}
+	ByteBuffer bb;
+	frame.AppendTo(bb);
+
+	ByteBuffer manual;
+	manual.Append(7);
+	for (int j = 0; j < 33; j++) {
+		manual.Append(j * 0.5);
+	}
+	::printf("wire size:%d size:%lu same:%d\n", static_cast<int>(AxisFrame::WIRE_SIZE),
+		static_cast<unsigned long>(bb.Size()), bb.Data() == manual.Data());
+
+	AxisFrame decoded;
+	decoded.ValueFrom(manual);
+	::printf("counter:%d axis[32]:%.1f\n", decoded.counter, decoded.axis[32]);
+}
+
+void test2()
+{
+	::printf("\nmessage id\n");
+
+	SetAxisRequest req;
+	req.axis = 'x';
+	req.angle = 1.5;
+	req.position.x = 10;
+	req.position.y = -10;
+	req.gains[0] = 0.1f;
+	req.gains[1] = 0.2f;
+	req.gains[2] = 0.3f;
+
+	StaticByteBuffer<64> sb;
+	req.AppendTo(sb);
+	::printf("wire size:%d size:%lu\n", static_cast<int>(SetAxisRequest::WIRE_SIZE), static_cast<unsigned long>(sb.Size()));
+
+	ByteBufferView view(sb.Data(), sb.Size());
+	switch (PeekMessageId(view)) {
+	case ProgramListRequest::MESSAGE_ID:
+		::printf("program list\n");
+		break;
+	case SetAxisRequest::MESSAGE_ID: {
+		SetAxisRequest r;
+		r.ValueFrom(view);
+		::printf("set axis %c %.1f (%d,%d) %.1f\n", r.axis, r.angle, r.position.x, r.position.y, r.gains[2]);
+		break;
+	}
+	default:
+		::printf("???\n");
+	}
+
+	view.SetPosition(0);
+	ProgramListRequest list;
+	::printf("decode as other message:%d\n", list.ValueFrom(view));
+}
+
+void test3()
+{
+	::printf("\nbenchmark\n");
+
+	timespec start;
+	::clock_gettime(CLOCK_MONOTONIC, &start);
+	size_t total = 0;
+	for (int n = 0; n < 100000; n++) {
+		ByteBuffer bb;
+		bb.Append(n);
+		for (int j = 0; j < 33; j++) {
+			bb.Append(j * 0.5);
+		}
+		total += bb.Size();
+	}
+	::printf("Append() x 34 : %.2f ms (%lu)\n", elapsed(start), static_cast<unsigned long>(total));
+
+	::clock_gettime(CLOCK_MONOTONIC, &start);
+	total = 0;
+	AxisFrame frame;
+	for (int j = 0; j < 33; j++) {
+		frame.axis[j] = j * 0.5;
+	}
+	for (int n = 0; n < 100000; n++) {
+		StaticByteBuffer<400> bb;
+		frame.counter = n;
+		frame.AppendTo(bb);
+		total += bb.Size();
+	}
+	::printf("AppendTo()    : %.2f ms (%lu)\n", elapsed(start), static_cast<unsigned long>(total));
+}
+
+int main(int argc, char *argv[]) {
+	test1();
+	test2();
+	test3();
+	return 0;
+}
@@ -0,0 +1,255 @@
+#include <stdio.h>
+#include <time.h>
+#include <vector>
+#include "Mutex.h"
+#include "MutexLock.h"
+#include "Thread.h"
+#include "ScheduledThread.h"
+#include "SampleClock.h"
+
+using namespace PicoIPC;
+
+struct Mode
+{
+	const char  *name;
+	unsigned int attributes;
+};
+
+static const Mode MODES[] = {
+	{ "default",        Mutex::ATTRIBUTE_DEFAULT },
+	{ "adaptive spin",  Mutex::ATTRIBUTE_ADAPTIVE_SPIN },
+	{ "prio inherit",   Mutex::ATTRIBUTE_PRIO_INHERIT },
+	{ "process shared", Mutex::ATTRIBUTE_PROCESS_SHARED },
+	{ "robust",         Mutex::ATTRIBUTE_ROBUST },
+	{ "robust + prio inherit", Mutex::ATTRIBUTE_ROBUST | Mutex::ATTRIBUTE_PRIO_INHERIT },
+};
+
+// 短いクリティカルセクションを繰り返す
+class Incrementer : public IRunnable
+{
+public:
+	Incrementer(Mutex *mutex, int count) : mMutex(mutex), mCount(count), mValue(0) {}
+
+	void Run()
+	{
+		for (int i = 0; i < mCount; i++) {
+			mMutex->Lock();
+			mValue++;
+			mMutex->Unlock();
+		}
+	}
+
+	Mutex *mMutex;
+	int    mCount;
+	int    mValue;
+};
+
+void test1()
+{
+	::printf("\nlock + unlock latency (ns/op)\n");
+	::printf("  %-24s %9s %12s\n", "mode", "single", "contended x4");
+	const int count = 2000000;
+	const int threads = 4;
+	for (size_t m = 0; m < sizeof(MODES) / sizeof(MODES[0]); m++) {
+		if (!Mutex::IsSupported(MODES[m].attributes)) {
+			::printf("  %-24s not supported\n", MODES[m].name);
+			continue;
+		}
+		Mutex mutex(MODES[m].attributes);
+		for (int i = 0; i < count / 10; i++) {
+			mutex.Lock();
+			mutex.Unlock();
+		}
+
+		double start = now();
+		for (int i = 0; i < count; i++) {
+			mutex.Lock();
+			mutex.Unlock();
+		}
+		double single = (now() - start) * 1e9 / count;
+
+		Incrementer incrementer(&mutex, count / threads);
+		std::vector<Thread *> list;
+		for (int i = 0; i < threads; i++) {
+			list.push_back(new Thread(&incrementer, NULL));
+		}
+		start = now();
+		for (int i = 0; i < threads; i++) {
+			list[i]->Start();
+		}
+		for (int i = 0; i < threads; i++) {
+			list[i]->Join();
+			delete list[i];
+		}
+		double contended = (now() - start) * 1e9 / count;
+		::printf("  %-24s %9.1f %12.1f\n", MODES[m].name, single, contended);
+	}
+}
+
+// ロックしたまま終了する
+class Abandoner : public IRunnable
+{
+public:
+	void Run()
+	{
+		Mutex *mutex = static_cast<Mutex *>(Thread::CurrentThread()->Parameter());
+		mutex->Lock();
+	}
+};
+
+void test2()
+{
+	::printf("\nrobust\n");
+	// 対応していない環境でATTRIBUTE_ROBUSTを指定するとabort()する
+	if (!Mutex::IsSupported(Mutex::ATTRIBUTE_ROBUST)) {
+		::printf("  not supported\n");
+		return;
+	}
+	Mutex mutex(Mutex::ATTRIBUTE_ROBUST);
+	Abandoner abandoner;
+	Thread t(&abandoner, &mutex);
+	t.Start();
+	t.Join();
+
+	Mutex::LockState state;
+	{
+		MutexLock lock(&mutex, &state);
+		::printf("  owner dead:%d\n", state == Mutex::LOCK_OWNER_DEAD);
+	}
+	{
+		MutexLock lock(&mutex, &state);
+		::printf("  owner dead:%d (recovered)\n", state == Mutex::LOCK_OWNER_DEAD);
+	}
+
+	// 回復せずにUnlock()すると以後ロックできない
+	Mutex unrecoverable(Mutex::ATTRIBUTE_ROBUST);
+	Thread t2(&abandoner, &unrecoverable);
+	t2.Start();
+	t2.Join();
+	unrecoverable.Lock();
+	unrecoverable.Unlock();
+	{
+		MutexLock lock(&unrecoverable, &state);
+		::printf("  not recoverable failed:%d\n", state == Mutex::LOCK_FAILED);
+	}
+
+	// 二重ロック(EDEADLK)ではロックを解除しない
+	Mutex checked(Mutex::ATTRIBUTE_ROBUST | Mutex::ATTRIBUTE_ERROR_CHECK);
+	checked.Lock();
+	{
+		MutexLock lock(&checked, &state);
+		::printf("  relock failed:%d\n", state == Mutex::LOCK_FAILED);
+	}
+	// 最初のロックは残っている(もう一度EDEADLKとなる)
+	::printf("  still locked:%d\n", checked.LockConsistent() == Mutex::LOCK_FAILED);
+	checked.Unlock();
+}
+
+// 優先度逆転: 低優先度がロック中に中優先度が CPU を占有すると、高優先度がロックを待ち続ける
+class InversionTask : public IRunnable
+{
+public:
+	enum Role { LOW, MIDDLE, HIGH };
+
+	InversionTask(Mutex *mutex, Role role, volatile bool *isLocked, double *waited)
+		: mMutex(mutex), mRole(role), mIsLocked(isLocked), mWaited(waited) {}
+
+	void Run()
+	{
+		if (mRole == LOW) {
+			mMutex->Lock();
+			*mIsLocked = true;
+			Spin(0.02);
+			mMutex->Unlock();
+		} else if (mRole == MIDDLE) {
+			Spin(0.2);
+		} else {
+			double start = now();
+			mMutex->Lock();
+			*mWaited = now() - start;
+			mMutex->Unlock();
+		}
+	}
+
+private:
+	Mutex         *mMutex;
+	Role           mRole;
+	volatile bool *mIsLocked;
+	double        *mWaited;
+
+	static void Spin(double sec)
+	{
+		double end = now() + sec;
+		while (now() < end) {
+		}
+	}
+};
+
+static bool run_inversion(unsigned int attributes, double *waited)
+{
+	Mutex mutex(attributes);
+	volatile bool isLocked = false;
+	InversionTask low(&mutex, InversionTask::LOW, &isLocked, waited);
+	InversionTask middle(&mutex, InversionTask::MIDDLE, &isLocked, waited);
+	InversionTask high(&mutex, InversionTask::HIGH, &isLocked, waited);
+	ScheduledThread tl(&low, NULL);
+	ScheduledThread tm(&middle, NULL);
+	ScheduledThread th(&high, NULL);
+	ScheduledThread *threads[] = { &tl, &tm, &th };
+	int priorities[] = { 10, 20, 30 };
+	for (int i = 0; i < 3; i++) {
+		threads[i]->SetAffinity(0);
+		threads[i]->SetSchedPolicy(SCHED_FIFO, priorities[i]);
+	}
+	tl.Start();
+	if (tl.AttributeError()) {
+		tl.Join();
+		return false;
+	}
+	while (!isLocked) {
+		Thread::MilliSleep(1);
+	}
+	th.Start();
+	tm.Start();
+	th.Join();
+	tm.Join();
+	tl.Join();
+	return true;
+}
+
+void test3()
+{
+	::printf("\npriority inversion (SCHED_FIFO on CPU0, low holds 20 ms, middle spins 200 ms)\n");
+	// メインスレッドが各スレッドを開始できるように最も高い優先度にする
+	cpu_set_t savedAffinity;
+	::pthread_getaffinity_np(::pthread_self(), sizeof(savedAffinity), &savedAffinity);
+	cpu_set_t cpu0;
+	CPU_ZERO(&cpu0);
+	CPU_SET(0, &cpu0);
+	sched_param param;
+	param.sched_priority = 40;
+	if (::pthread_setschedparam(::pthread_self(), SCHED_FIFO, &param) != 0) {
+		::printf("  skipped (SCHED_FIFO is not permitted)\n");
+		return;
+	}
+	::pthread_setaffinity_np(::pthread_self(), sizeof(cpu0), &cpu0);
+
+	double waited = 0;
+	if (run_inversion(Mutex::ATTRIBUTE_DEFAULT, &waited)) {
+		::printf("  default      high waited %6.1f ms\n", waited * 1e3);
+		run_inversion(Mutex::ATTRIBUTE_PRIO_INHERIT, &waited);
+		::printf("  prio inherit high waited %6.1f ms\n", waited * 1e3);
+	}
+
+	param.sched_priority = 0;
+	::pthread_setschedparam(::pthread_self(), SCHED_OTHER, &param);
+	::pthread_setaffinity_np(::pthread_self(), sizeof(savedAffinity), &savedAffinity);
+}
+
+int main(int argc, char *argv[]) {
+	test1();
+	test2();
+	test3();
+
+	return 0;
+}
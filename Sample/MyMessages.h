@@ -0,0 +1,27 @@
+#ifndef MY_MESSAGES
+#define MY_MESSAGES
+
+#include "MessageSchema.h"
+
+// プロセス間で送受信するメッセージ
+// フィールドはByteBuffer::Append()する順に定義する
+// 固定長の型(プリミティブ型、プリミティブ型のみで構成された構造体)とその配列のみ利用できる
+
+// /mq1で送信する軸角度
+#define AXIS_FRAME_FIELDS(FIELD, ARRAY) \
+	FIELD(int, counter) \
+	ARRAY(double, axis, 33)
+
+PICO_MESSAGE(AxisFrame, AXIS_FRAME_FIELDS);
+
+// /mq1の最大メッセージ長に収まること
+PICO_MESSAGE_ASSERT_SIZE(AxisFrame, 400);
+
+// UnixDomainSocketの要求(メッセージIDのみ)
+#define PROGRAM_REQUEST_FIELDS(FIELD, ARRAY)
+
+PICO_MESSAGE_ID(ProgramUploadRequest, 10, PROGRAM_REQUEST_FIELDS);
+PICO_MESSAGE_ID(ProgramDownloadRequest, 11, PROGRAM_REQUEST_FIELDS);
+PICO_MESSAGE_ID(ProgramListRequest, 12, PROGRAM_REQUEST_FIELDS);
+
+#endif
@@ -0,0 +1,137 @@
+#include <stdio.h>
+#include <time.h>
+#include "PeriodicThread.h"
+
+using namespace PicoIPC;
+
+static unsigned long long now()
+{
+	timespec ts;
+	::clock_gettime(CLOCK_MONOTONIC, &ts);
+	return static_cast<unsigned long long>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+static void busy(unsigned long microsec)
+{
+	unsigned long long end = now() + microsec * 1000ULL;
+	while (now() < end) {
+	}
+}
+
+// 2msの処理を行い、overrunEvery周期ごとに5msかかる
+class Worker : public IPeriodicRunnable
+{
+public:
+	Worker(unsigned long long cycles, int overrunEvery)
+		: mCycles(cycles)
+		, mOverrunEvery(overrunEvery)
+		, mCalls(0)
+		, mMissed(0)
+		, mStart(0)
+		, mEnd(0)
+	{
+	}
+
+	bool RunCycle(unsigned long long cycle)
+	{
+		if (mCalls == 0) {
+			mStart = now();
+		}
+		mCalls++;
+		busy((mOverrunEvery > 0 && mCalls % mOverrunEvery == 0) ? 25000 : 2000);
+		if (cycle + 1 >= mCycles) {
+			mEnd = now();
+			return false;
+		}
+		return true;
+	}
+
+	void Overrun(unsigned long long missed)
+	{
+		mMissed += missed;
+	}
+
+	unsigned long long mCycles;
+	int                mOverrunEvery;
+	unsigned long long mCalls;
+	unsigned long long mMissed;
+	unsigned long long mStart;
+	unsigned long long mEnd;
+};
+
+static const char *PolicyName(PeriodicThread::CatchUpPolicy policy)
+{
+	switch (policy) {
+	case PeriodicThread::CATCH_UP_SKIP:    return "skip";
+	case PeriodicThread::CATCH_UP_RUN_ALL: return "run all";
+	default:                               return "restart";
+	}
+}
+
+void test1()
+{
+	::printf("\ndrift: 100 cycles of 10ms (2ms work)\n");
+
+	// MilliSleep(10)で待つループ
+	unsigned long long start = now();
+	for (int i = 0; i < 100; i++) {
+		busy(2000);
+		struct timespec ts = { 0, 10000000 };
+		::nanosleep(&ts, NULL);
+	}
+	::printf("sleep loop     : %.1f ms\n", (now() - start) / 1e6);
+
+	Worker worker(100, 0);
+	PeriodicThread t(&worker, 10000);
+	t.Start();
+	t.Join();
+	::printf("PeriodicThread : %.1f ms (first to last cycle, expected 990 ms)\n", (worker.mEnd - worker.mStart) / 1e6);
+	t.WakeJitter().Print("  jitter   ");
+	t.ExecutionTime().Print("  execution");
+}
+
+void test2()
+{
+	PeriodicThread::CatchUpPolicy policies[] = {
+		PeriodicThread::CATCH_UP_SKIP, PeriodicThread::CATCH_UP_RUN_ALL, PeriodicThread::CATCH_UP_RESTART
+	};
+	for (size_t i = 0; i < sizeof(policies) / sizeof(policies[0]); i++) {
+		::printf("\noverrun: 50 cycles of 10ms, 25ms every 10 calls, policy:%s\n", PolicyName(policies[i]));
+		Worker worker(50, 10);
+		PeriodicThread t(&worker, 10000, policies[i]);
+		t.Start();
+		t.Join();
+		::printf("calls:%llu cycles:%lu overruns:%lu skipped:%lu missed:%llu elapsed:%.1f ms\n",
+			worker.mCalls, t.CycleCount(), t.OverrunCount(), t.SkippedCount(), worker.mMissed,
+			(worker.mEnd - worker.mStart) / 1e6);
+	}
+}
+
+void test3()
+{
+	::printf("\nstop\n");
+	Worker worker(1000000, 0);
+	PeriodicThread t(&worker, 5000);
+	t.Start();
+	struct timespec ts = { 0, 100000000 };
+	::nanosleep(&ts, NULL);
+	::printf("running cycles:%lu\n", t.CycleCount());
+	t.Stop();
+	t.Join();
+	::printf("stopped cycles:%lu period:%lu us\n", t.CycleCount(), t.PeriodMicrosec());
+
+	// 周期0は1マイクロ秒として扱う
+	Worker zeroWorker(5, 0);
+	PeriodicThread zero(&zeroWorker, 0);
+	zero.Start();
+	zero.Join();
+	::printf("zero period calls:%llu period:%lu us\n", zeroWorker.mCalls, zero.PeriodMicrosec());
+}
+
+int main(int argc, char *argv[]) {
+	test1();
+	test2();
+	test3();
+
+	return 0;
+}
@@ -0,0 +1,14 @@
+#ifndef SAMPLE_CLOCK
+#define SAMPLE_CLOCK
+
+#include <time.h>
+
+// サンプルの計測に使う現在時刻(CLOCK_MONOTONIC, 秒)
+inline double now()
+{
+	timespec ts;
+	::clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+#endif
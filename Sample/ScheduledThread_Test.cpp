@@ -0,0 +1,109 @@
+#include <stdio.h>
+#include <unistd.h>
+#include "ScheduledThread.h"
+
+using namespace PicoIPC;
+
+class Worker : public IRunnable
+{
+public:
+	void Run()
+	{
+		int policy;
+		sched_param param;
+		::pthread_getschedparam(::pthread_self(), &policy, &param);
+		size_t stackSize = 0;
+		pthread_attr_t attr;
+		if (::pthread_getattr_np(::pthread_self(), &attr) == 0) {
+			::pthread_attr_getstacksize(&attr, &stackSize);
+			::pthread_attr_destroy(&attr);
+		}
+		::printf("  run: cpu:%d policy:%s priority:%d stack:%lu\n", ::sched_getcpu(), PolicyName(policy),
+			param.sched_priority, static_cast<unsigned long>(stackSize));
+	}
+
+	static const char *PolicyName(int policy)
+	{
+		switch (policy) {
+		case SCHED_FIFO:  return "SCHED_FIFO";
+		case SCHED_RR:    return "SCHED_RR";
+		case SCHED_OTHER: return "SCHED_OTHER";
+		default:          return "?";
+		}
+	}
+};
+
+static void print(ScheduledThread &t)
+{
+	::printf("  applied: cpus:");
+	for (int i = 0; i < CPU_SETSIZE; i++) {
+		if (CPU_ISSET(i, &t.AppliedAffinity())) {
+			::printf("%d ", i);
+		}
+	}
+	::printf("policy:%s priority:%d stack:%lu\n", Worker::PolicyName(t.AppliedSchedPolicy()),
+		t.AppliedSchedPriority(), static_cast<unsigned long>(t.AppliedStackSize()));
+	if (t.AttributeError()) {
+		::printf("  fallback: %s\n", t.AttributeError().Message().c_str());
+	}
+}
+
+void test1()
+{
+	::printf("\ndefault\n");
+	Worker worker;
+	ScheduledThread t(&worker, NULL);
+	t.Start();
+	print(t);
+	t.Join();
+}
+
+void test2()
+{
+	long cpus = ::sysconf(_SC_NPROCESSORS_ONLN);
+	::printf("\naffinity (cpu %ld) and stack size\n", cpus - 1);
+	Worker worker;
+	ScheduledThread t(&worker, NULL);
+	t.SetAffinity(static_cast<int>(cpus - 1));
+	t.SetStackSize(512 * 1024);
+	t.Start();
+	print(t);
+	t.Join();
+}
+
+void test3()
+{
+	::printf("\nSCHED_FIFO 50 (needs CAP_SYS_NICE)\n");
+	Worker worker;
+	ScheduledThread t(&worker, NULL);
+	t.SetSchedPolicy(SCHED_FIFO, 50);
+	t.Start();
+	print(t);
+	t.Join();
+
+	::printf("restart with SCHED_OTHER\n");
+	t.SetSchedPolicy(SCHED_OTHER, 0);
+	t.Start();
+	print(t);
+	t.Join();
+}
+
+void test4()
+{
+	::printf("\nstack size larger than the default\n");
+	Worker worker;
+	ScheduledThread t(&worker, NULL);
+	t.SetStackSize(1024 * 1024 * 1024);
+	t.Start();
+	print(t);
+	t.Join();
+}
+
+int main(int argc, char *argv[]) {
+	test1();
+	test2();
+	test3();
+	test4();
+
+	return 0;
+}
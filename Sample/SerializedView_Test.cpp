@@ -0,0 +1,145 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "ByteBufferView.h"
+
+using namespace PicoIPC;
+
+double elapsed(const timespec &start)
+{
+	timespec now;
+	::clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start.tv_sec) * 1000.0 + (now.tv_nsec - start.tv_nsec) / 1000000.0;
+}
+
+void test1()
+{
+	::printf("\nvector view\n");
+
+	std::vector<double> axes;
+	for (int i = 0; i < 33; i++) {
+		axes.push_back(i * 0.5);
+	}
+	std::vector<std::string> names;
+	names.push_back("x");
+	names.push_back("y");
+	names.push_back("z");
+
+	ByteBuffer bb;
+	bb.Append(axes);
+	bb.Append(names);
+	bb.Append(123);
+
+	VectorView<double> axesView;
+	bb.Value(axesView);
+	VectorView<std::string> namesView;
+	bb.Value(namesView);
+	int tail;
+	bb.Value(tail);
+	::printf("axes:%lu names:%lu tail:%d\n",
+		static_cast<unsigned long>(axesView.Size()), static_cast<unsigned long>(namesView.Size()), tail);
+
+	double axis = 0.0;
+	axesView.At(32, axis);
+	::printf("axes[32]:%.1f\n", axis);
+	axesView.At(3, axis);
+	::printf("axes[3]:%.1f\n", axis);
+	axesView.Skip(10);
+	axesView.Next(axis);
+	::printf("skip 10 -> axes[14]:%.1f\n", axis);
+
+	std::string name;
+	while (namesView.Next(name)) {
+		::printf("%s ", name.c_str());
+	}
+	::printf("\n");
+}
+
+void test2()
+{
+	::printf("\nmap view\n");
+
+	std::map<std::string, int> params;
+	params["timeout"] = 500;
+	params["retry"] = 3;
+	params["interval"] = 100;
+	std::map<int, double> gains;
+	for (int i = 0; i < 100; i++) {
+		gains[i * 2] = i * 0.1;
+	}
+
+	ByteBuffer bb;
+	bb.Append(params);
+	bb.Append(gains);
+	bb.Append(456);
+
+	ByteBufferView view(bb);
+	MapView<std::string, int> paramsView;
+	view.Value(paramsView);
+	view.Skip<std::map<int, double> >();
+	int tail;
+	view.Value(tail);
+	::printf("params:%lu tail:%d\n", static_cast<unsigned long>(paramsView.Size()), tail);
+
+	int v = 0;
+	::printf("timeout:%s", paramsView.Find("timeout", v) ? "" : "not found");
+	::printf("%d\n", v);
+	::printf("unknown:%s\n", paramsView.Contains("unknown") ? "found" : "not found");
+
+	std::string key;
+	while (paramsView.Next(key, v)) {
+		::printf("%s=%d ", key.c_str(), v);
+	}
+	::printf("\n");
+
+	bb.SetPosition(0);
+	bb.Skip<std::map<std::string, int> >();
+	MapView<int, double> gainsView;
+	bb.Value(gainsView);
+	double g = 0.0;
+	::printf("gains[198]:%s", gainsView.Find(198, g) ? "" : "not found");
+	::printf("%.1f\n", g);
+	::printf("gains[7]:%s\n", gainsView.Contains(7) ? "found" : "not found");
+}
+
+void test3()
+{
+	::printf("\nbenchmark (find one key in 1000 entries)\n");
+
+	std::map<int, double> gains;
+	for (int i = 0; i < 1000; i++) {
+		gains[i] = i * 0.1;
+	}
+	ByteBuffer bb;
+	bb.Append(gains);
+
+	timespec start;
+	::clock_gettime(CLOCK_MONOTONIC, &start);
+	double sum = 0.0;
+	for (int n = 0; n < 1000; n++) {
+		bb.SetPosition(0);
+		std::map<int, double> m;
+		bb.Value(m);
+		sum += m[n];
+	}
+	::printf("std::map : %.2f ms (%.1f)\n", elapsed(start), sum);
+
+	::clock_gettime(CLOCK_MONOTONIC, &start);
+	sum = 0.0;
+	for (int n = 0; n < 1000; n++) {
+		bb.SetPosition(0);
+		MapView<int, double> m;
+		bb.Value(m);
+		double g = 0.0;
+		m.Find(n, g);
+		sum += g;
+	}
+	::printf("MapView  : %.2f ms (%.1f)\n", elapsed(start), sum);
+}
+
+int main(int argc, char *argv[]) {
+	test1();
+	test2();
+	test3();
+	return 0;
+}
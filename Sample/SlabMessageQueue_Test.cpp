@@ -0,0 +1,194 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <vector>
+#include "SlabMessageQueue.h"
+
+using namespace PicoIPC;
+
+void test1(SlabMessageQueue &sender, SlabMessageQueue &receiver)
+{
+	::printf("\ntest1 small message (through message queue)\n");
+
+	ByteBuffer bb;
+	bb.Append("hello");
+	Error err = sender.Send(bb);
+	if (err) {
+		::printf("err:%s\n", err.Message().c_str());
+		::exit(1);
+	}
+
+	ByteBufferView view;
+	err = receiver.TimedReceive(view, 100);
+	if (err) {
+		::printf("err:%s\n", err.Message().c_str());
+		::exit(1);
+	}
+	std::string recv;
+	view.Value(recv);
+	::printf("recv:%s size:%lu\n", recv.c_str(), static_cast<unsigned long>(view.Size()));
+}
+
+void test2(SlabMessageQueue &sender, SlabMessageQueue &receiver)
+{
+	::printf("\ntest2 large message (through slab)\n");
+
+	// point cloud 4096 points (x,y,z)
+	ByteBuffer bb(4096 * 3 * sizeof(double) + 64);
+	std::vector<double> cloud;
+	for (int i = 0; i < 4096 * 3; i++) {
+		cloud.push_back(i * 0.5);
+	}
+	bb.Append(cloud);
+	Error err = sender.Send(bb);
+	if (err) {
+		::printf("err:%s\n", err.Message().c_str());
+		::exit(1);
+	}
+	::printf("send size:%lu\n", static_cast<unsigned long>(bb.Size()));
+
+	ByteBufferView view;
+	err = receiver.TimedReceive(view, 100);
+	if (err) {
+		::printf("err:%s\n", err.Message().c_str());
+		::exit(1);
+	}
+	std::vector<double> recv;
+	view.Value(recv);
+	::printf("recv size:%lu points:%lu last:%f\n", static_cast<unsigned long>(view.Size()),
+		static_cast<unsigned long>(recv.size() / 3), recv[recv.size() - 1]);
+	receiver.Release();
+}
+
+void test3(SlabMessageQueue &sender, SlabMessageQueue &receiver)
+{
+	::printf("\ntest3 slot exhausted\n");
+
+	ByteBuffer bb;
+	for (int i = 0; i < 100; i++) {
+		bb.Append(static_cast<double>(i));
+	}
+	for (int i = 0; i < 5; i++) {
+		Error err = sender.Send(bb);
+		if (err) {
+			::printf("send %d err:%s\n", i, err.Message().c_str());
+		} else {
+			::printf("send %d ok\n", i);
+		}
+	}
+	for (int i = 0; i < 4; i++) {
+		ByteBufferView view;
+		Error err = receiver.TimedReceive(view, 100);
+		if (err) {
+			::printf("recv %d err:%s\n", i, err.Message().c_str());
+		} else {
+			::printf("recv %d size:%lu\n", i, static_cast<unsigned long>(view.Size()));
+		}
+	}
+	receiver.Release();
+}
+
+void test4(MessageQueue &mq, SlabMessageQueue &receiver)
+{
+	::printf("\ntest4 forged handle\n");
+
+	// スロットの途中、ヘッダー、スラブの外を指すハンドル
+	unsigned int offsets[] = { 8, 128 * 1024 + 100, 0x7fffffff };
+	for (size_t i = 0; i < sizeof(offsets) / sizeof(offsets[0]); i++) {
+		SlabHandle handle;
+		handle.magic = SlabMessageQueue::HANDLE_MAGIC;
+		handle.offset = offsets[i];
+		handle.length = 64;
+		handle.generation = 0;
+		ByteBuffer bb(0);
+		bb.Append(handle);
+		mq.Send(bb);
+
+		ByteBufferView view;
+		Error err = receiver.TimedReceive(view, 100);
+		::printf("offset:%u err:%s\n", offsets[i], err ? err.Message().c_str() : "none");
+	}
+}
+
+void test5(SlabMessageQueue &sender, SlabMessageQueue &receiver)
+{
+	::printf("\ntest5 plain message with the size of a handle\n");
+
+	// 先頭がHANDLE_MAGICと同じ値でもハンドルとして扱われない
+	ByteBuffer bb(0);
+	bb.Append(SlabMessageQueue::HANDLE_MAGIC);
+	bb.Append(1);
+	bb.Append(2);
+	bb.Append(3);
+	Error err = sender.Send(bb);
+	if (err) {
+		::printf("err:%s\n", err.Message().c_str());
+		::exit(1);
+	}
+	ByteBufferView view;
+	err = receiver.TimedReceive(view, 100);
+	if (err) {
+		::printf("err:%s\n", err.Message().c_str());
+		::exit(1);
+	}
+	unsigned int magic = 0;
+	int v1 = 0, v2 = 0, v3 = 0;
+	view.Value(magic);
+	view.Value(v1);
+	view.Value(v2);
+	view.Value(v3);
+	::printf("recv size:%lu magic:%x values:%d,%d,%d\n", static_cast<unsigned long>(view.Size()), magic, v1, v2, v3);
+	receiver.Release();
+}
+
+void test6(SlabMessageQueue &sender, SlabMessageQueue &receiver)
+{
+	::printf("\ntest6 reclaim slots\n");
+
+	ByteBuffer bb;
+	for (int i = 0; i < 100; i++) {
+		bb.Append(static_cast<double>(i));
+	}
+	// 受信されずに破棄されるハンドル
+	for (int i = 0; i < 4; i++) {
+		sender.Send(bb);
+	}
+	Error err = sender.Send(bb);
+	::printf("before clear:%s\n", err ? err.Message().c_str() : "ok");
+	sender.Clear();
+	err = sender.Send(bb);
+	::printf("after clear:%s\n", err ? err.Message().c_str() : "ok");
+
+	// 受信したプロセスが開放せずに終了する
+	pid_t pid = ::fork();
+	if (pid == 0) {
+		MessageQueue mq("/mq_slab");
+		SlabMessageQueue child(&mq, 128 * 1024, 4, 256);
+		ByteBufferView view;
+		child.TimedReceive(view, 100);
+		::_exit(0);
+	}
+	::waitpid(pid, NULL, 0);
+	::printf("reclaimed:%lu\n", static_cast<unsigned long>(sender.Reclaim()));
+	for (int i = 0; i < 4; i++) {
+		err = sender.Send(bb);
+		::printf("send %d %s\n", i, err ? err.Message().c_str() : "ok");
+	}
+	sender.Clear();
+}
+
+int main(int argc, char *argv[]) {
+	MessageQueue mq("/mq_slab", 10, 256);
+	MessageQueue rq("/mq_slab");
+	SlabMessageQueue sender(&mq, 128 * 1024, 4, 256);
+	SlabMessageQueue receiver(&rq, 128 * 1024, 4, 256);
+
+	test1(sender, receiver);
+	test2(sender, receiver);
+	test3(sender, receiver);
+	test4(mq, receiver);
+	test5(sender, receiver);
+	test6(sender, receiver);
+	return 0;
+}
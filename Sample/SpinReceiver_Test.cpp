@@ -0,0 +1,72 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "SpinReceiver.h"
+#include "Thread.h"
+
+using namespace PicoIPC;
+
+class Producer : public IRunnable
+{
+public:
+	void Run()
+	{
+		Thread *t = Thread::CurrentThread();
+		MessageQueue *mq = static_cast<MessageQueue*>(t->Parameter());
+		for (int i = 0; i < 1000; i++) {
+			ByteBuffer bb;
+			bb.Append(i);
+			mq->Send(bb);
+			Thread::MicroSleep(50);
+		}
+	}
+};
+
+void test(MessageQueue &mq, unsigned long spinMicrosec)
+{
+	::printf("\nspin budget %lu usec\n", spinMicrosec);
+
+	MessageQueue rq(mq.Name());
+	SpinReceiver receiver(&rq, spinMicrosec);
+	Producer producer;
+	Thread t(&producer, &mq);
+	t.Start();
+
+	int last = -1;
+	for (int i = 0; i < 1000; i++) {
+		ByteBuffer bb;
+		Error err = receiver.TimedReceive(bb, 1000);
+		if (err) {
+			::printf("err:%s\n", err.Message().c_str());
+			::exit(1);
+		}
+		bb.Value(last);
+	}
+	t.Join();
+
+	const SpinPolicy &spin = receiver.Spin();
+	::printf("last:%d spin hit:%lu block:%lu\n", last, spin.SpinHitCount(), spin.BlockCount());
+	::printf("spin hit ratio:%.2f\n", spin.SpinHitRatio());
+}
+
+void test_timeout(MessageQueue &mq)
+{
+	::printf("\nspin then timeout\n");
+
+	SpinReceiver receiver(&mq, 100);
+	ByteBuffer bb;
+	Error err = receiver.TimedReceive(bb, 100);
+	if (err) {
+		::printf("timeout:%s\n", err.Message().c_str());
+	} else {
+		::exit(1);
+	}
+}
+
+int main(int argc, char *argv[]) {
+	MessageQueue mq("/mq_spin", 10, 64);
+
+	test(mq, 0);
+	test(mq, 200);
+	test_timeout(mq);
+	return 0;
+}
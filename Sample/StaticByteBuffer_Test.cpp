@@ -0,0 +1,98 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "StaticByteBuffer.h"
+#include "MessageQueue.h"
+#include "UnixDomainSocket.h"
+
+using namespace PicoIPC;
+
+void test1()
+{
+	::printf("\nappend and value\n");
+
+	StaticByteBuffer<256> bb;
+	std::vector<int> v;
+	v.push_back(1);
+	v.push_back(2);
+	std::map<int, double> m;
+	m[10] = 0.5;
+	bb.Append(123);
+	bb.Append(std::string("abc"));
+	bb.Append("[%04d]", 7);
+	bb.Append(v);
+	bb.Append(m);
+	::printf("size:%lu capacity:%lu\n", static_cast<unsigned long>(bb.Size()), static_cast<unsigned long>(bb.Capacity()));
+
+	// ByteBufferと同じ形式
+	ByteBuffer b(bb.Data(), bb.Size());
+	int i;
+	std::string s1, s2;
+	std::vector<int> v2;
+	std::map<int, double> m2;
+	b.Value(i);
+	b.Value(s1);
+	b.Value(s2);
+	b.Value(v2);
+	b.Value(m2);
+	::printf("%d %s %s %lu %.1f\n", i, s1.c_str(), s2.c_str(), static_cast<unsigned long>(v2.size()), m2[10]);
+
+	bb.Value(i);
+	bb.Value(s1);
+	bb.Value(s2);
+	::printf("%d %s %s\n", i, s1.c_str(), s2.c_str());
+}
+
+void test2()
+{
+	::printf("\noverflow\n");
+
+	StaticByteBuffer<16> bb;
+	Error err;
+	for (int i = 0; i < 5 && !err; i++) {
+		err = bb.Append(i);
+	}
+	::printf("err:%s overflow:%d size:%lu\n", err.Message().c_str(), bb.IsOverflow(), static_cast<unsigned long>(bb.Size()));
+
+	MessageQueue mq("/mq_static", 10, 64);
+	err = mq.Send(bb);
+	::printf("send:%s\n", err ? err.Message().c_str() : "no error");
+
+	bb.Clear();
+	err = bb.Append("%s", "0123456789abcdef");
+	::printf("format:%s overflow:%d\n", err.Message().c_str(), bb.IsOverflow());
+}
+
+void test3()
+{
+	::printf("\nmessage queue\n");
+
+	MessageQueue mq("/mq_static", 10, 400);
+	for (int n = 0; n < 3; n++) {
+		StaticByteBuffer<400> bb;
+		bb.Append(n);
+		for (int j = 0; j < 33; j++) {
+			bb.Append(n + j * 0.01);
+		}
+		Error err = mq.TimedSend(bb, 10);
+		if (err) {
+			::printf("err:%s\n", err.Message().c_str());
+			::exit(1);
+		}
+	}
+	std::vector<ByteBuffer> list;
+	mq.Receive(list);
+	for (size_t i = 0; i < list.size(); i++) {
+		int n;
+		double axis;
+		list[i].Value(n);
+		list[i].Value(axis);
+		::printf("size:%lu n:%d axis0:%.2f\n", static_cast<unsigned long>(list[i].Size()), n, axis);
+	}
+}
+
+int main(int argc, char *argv[]) {
+	test1();
+	test2();
+	test3();
+	return 0;
+}
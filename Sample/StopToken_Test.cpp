@@ -0,0 +1,165 @@
+#include <stdio.h>
+#include <time.h>
+#include "StopToken.h"
+#include "MessageQueue.h"
+#include "SampleClock.h"
+
+using namespace PicoIPC;
+
+// 停止要求を確認しながらスリープする
+class SleepWorker : public IRunnable
+{
+public:
+	SleepWorker() : mLoops(0) {}
+
+	void Run()
+	{
+		StopToken token = StoppableThread::CurrentToken();
+		while (!token.IsStopRequested()) {
+			mLoops++;
+			token.SleepFor(10000);
+		}
+	}
+
+	void Cleanup()
+	{
+		::printf("  cleanup (Run() returned normally)\n");
+	}
+
+	int mLoops;
+};
+
+// 条件変数で待機する
+class ConditionWorker : public IRunnable
+{
+public:
+	ConditionWorker() : mWakeups(0) {}
+
+	void Run()
+	{
+		StopToken token = StoppableThread::CurrentToken();
+		mMutex.Lock();
+		while (token.ConditionWait(mMutex)) {
+			mWakeups++;
+		}
+		// 停止要求で戻ってもMutexはロックされている
+		mMutex.Unlock();
+	}
+
+	Mutex mMutex;
+	int   mWakeups;
+};
+
+// メッセージキューから受信する
+class ReceiveWorker : public IRunnable
+{
+public:
+	ReceiveWorker(MessageQueue *mq) : mMQ(mq), mReceived(0) {}
+
+	void Run()
+	{
+		StopToken token = StoppableThread::CurrentToken();
+		ByteBuffer bb;
+		while (true) {
+			ErrorCode code = mMQ->TimedReceiveCode(bb, 0, token);
+			if (code.IsCanceled()) {
+				mLast = code.Message();
+				break;
+			}
+			if (!code) {
+				mReceived++;
+			}
+		}
+	}
+
+	MessageQueue *mMQ;
+	int           mReceived;
+	std::string   mLast;
+};
+
+void test1()
+{
+	::printf("\nsleep\n");
+	SleepWorker worker;
+	StoppableThread t(&worker, NULL);
+	t.Start();
+	Thread::MilliSleep(50);
+	double start = now();
+	t.Stop();
+	::printf("  loops:%d stop:%.2f ms\n", worker.mLoops, (now() - start) * 1e3);
+
+	// 再開すると新しい停止要求の状態になる
+	t.Start();
+	Thread::MilliSleep(20);
+	t.Stop();
+	::printf("  restart loops:%d\n", worker.mLoops);
+}
+
+void test2()
+{
+	::printf("\ncondition wait\n");
+	ConditionWorker worker;
+	StoppableThread t(&worker, NULL);
+	t.Start();
+	Thread::MilliSleep(20);
+	for (int i = 0; i < 3; i++) {
+		worker.mMutex.Lock();
+		worker.mMutex.ConditionSignal();
+		worker.mMutex.Unlock();
+		Thread::MilliSleep(10);
+	}
+	double start = now();
+	t.Stop();
+	::printf("  wakeups:%d stop:%.2f ms\n", worker.mWakeups, (now() - start) * 1e3);
+}
+
+void test3()
+{
+	::printf("\nmessage queue\n");
+	MessageQueue mq("/stop_token_test", 10, 64);
+	ReceiveWorker worker(&mq);
+	StoppableThread t(&worker, NULL);
+	t.Start();
+	ByteBuffer bb;
+	bb.Append(1);
+	for (int i = 0; i < 5; i++) {
+		mq.TimedSendCode(bb, 10);
+	}
+	Thread::MilliSleep(20);
+	double start = now();
+	t.Stop();
+	::printf("  received:%d stop:%.2f ms [%s]\n", worker.mReceived, (now() - start) * 1e3, worker.mLast.c_str());
+
+	// タイムアウトと停止要求済みのStopToken
+	StopSource source;
+	ErrorCode code = mq.TimedReceiveCode(bb, 30, source.Token());
+	::printf("  timeout:%d [%s]\n", code.IsTimeout(), code.Message().c_str());
+	source.RequestStop();
+	code = mq.TimedReceiveCode(bb, 0, source.Token());
+	::printf("  canceled:%d [%s]\n", code.IsCanceled(), code.Message().c_str());
+}
+
+void test4()
+{
+	::printf("\npolling cost\n");
+	StopSource source;
+	StopToken token = source.Token();
+	const int count = 10000000;
+	int loops = 0;
+	double start = now();
+	for (int i = 0; i < count; i++) {
+		if (!token.IsStopRequested()) {
+			loops++;
+		}
+	}
+	::printf("  IsStopRequested:%.2f ns (%d)\n", (now() - start) * 1e9 / count, loops);
+}
+
+int main(int argc, char *argv[]) {
+	test1();
+	test2();
+	test3();
+	test4();
+
+	return 0;
+}
@@ -0,0 +1,145 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <new>
+#include "StringView.h"
+#include "ByteBuffer.h"
+#include "ByteBufferView.h"
+#include "StaticByteBuffer.h"
+
+using namespace PicoIPC;
+
+// ヒープの確保回数を数える
+static int allocations = 0;
+
+__attribute__((noinline)) void *operator new(size_t size) throw(std::bad_alloc)
+{
+	allocations++;
+	void *p = ::malloc(size);
+	if (p == NULL) {
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+__attribute__((noinline)) void operator delete(void *p) throw()
+{
+	::free(p);
+}
+
+void test1()
+{
+	::printf("\nvalue\n");
+
+	ByteBuffer bb;
+	bb.Append(std::string("start"));
+	bb.Append(10);
+	bb.Append(std::string("axis"));
+
+	StringView command;
+	int value;
+	StringView name;
+	int before = allocations;
+	bb.Value(command);
+	bb.Value(value);
+	bb.Value(name);
+	::printf("allocations:%d\n", allocations - before);
+	::printf("command:%s size:%lu value:%d name:%s\n", command.ToString().c_str(),
+		static_cast<unsigned long>(command.Size()), value, name.ToString().c_str());
+	::printf("== \"start\":%d \"start\" ==:%d != \"stop\":%d < \"stop\":%d starts \"st\":%d\n",
+		command == "start", "start" == command, command != "stop", command < "stop", command.StartsWith("st"));
+
+	ByteBufferView view(bb);
+	view.Value(command);
+	StaticByteBuffer<64> sbb;
+	sbb.Append(command);
+	sbb.Append(StringView("stop"));
+	sbb.Value(name);
+	::printf("view:%s static:%s\n", command.ToString().c_str(), name.ToString().c_str());
+
+	// std::stringと同じ形式
+	ByteBuffer copy(sbb.Data(), sbb.Size());
+	std::string s1, s2;
+	copy.Value(s1);
+	copy.Value(s2);
+	::printf("as string:%s %s\n", s1.c_str(), s2.c_str());
+}
+
+void test2()
+{
+	::printf("\ndispatch\n");
+
+	const char *commands[] = { "start", "stop", "reset", "unknown" };
+	std::vector<ByteBuffer> requests;
+	for (int i = 0; i < 4; i++) {
+		ByteBuffer bb;
+		bb.Append(std::string(commands[i]));
+		bb.Append(i);
+		requests.push_back(bb);
+	}
+
+	static const unsigned int START = StringView("start").Hash();
+	static const unsigned int STOP = StringView("stop").Hash();
+	int before = allocations;
+	int handled[4] = { 0, 0, 0, 0 };
+	for (int loop = 0; loop < 1000; loop++) {
+		for (size_t i = 0; i < requests.size(); i++) {
+			ByteBuffer &request = requests[i];
+			request.SetPosition(0);
+			StringView command;
+			int arg;
+			request.Value(command);
+			request.Value(arg);
+			unsigned int hash = command.Hash();
+			if (hash == START && command == "start") {
+				handled[0]++;
+			} else if (hash == STOP && command == "stop") {
+				handled[1]++;
+			} else if (command == "reset") {
+				handled[2]++;
+			} else {
+				handled[3]++;
+			}
+		}
+	}
+	::printf("start:%d stop:%d reset:%d other:%d allocations:%d\n",
+		handled[0], handled[1], handled[2], handled[3], allocations - before);
+}
+
+void test3()
+{
+	::printf("\nserialized map\n");
+
+	std::map<std::string, int> m;
+	m["alpha"] = 1;
+	m["beta"] = 2;
+	m["gamma"] = 3;
+	std::vector<std::string> v;
+	v.push_back("x");
+	v.push_back("yz");
+	ByteBuffer bb;
+	bb.Append(m);
+	bb.Append(v);
+
+	int before = allocations;
+	MapView<StringView, int> map;
+	VectorView<StringView> vec;
+	bb.Value(map);
+	bb.Value(vec);
+	int value = 0;
+	bool found = map.Find(StringView("beta"), value);
+	bool missing = map.Find(StringView("delta"), value);
+	StringView s;
+	size_t total = 0;
+	while (vec.Next(s)) {
+		total += s.Size();
+	}
+	::printf("found:%d value:%d missing:%d total:%lu allocations:%d\n",
+		found, value, missing, static_cast<unsigned long>(total), allocations - before);
+}
+
+int main(int argc, char *argv[]) {
+	test1();
+	test2();
+	test3();
+	return 0;
+}
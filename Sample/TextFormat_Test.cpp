@@ -0,0 +1,185 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include "TextFormat.h"
+#include "ByteBuffer.h"
+#include "StaticByteBuffer.h"
+#include "Error.h"
+#include "SampleClock.h"
+
+using namespace PicoIPC;
+
+static int failures = 0;
+
+static unsigned long long random64()
+{
+	return (static_cast<unsigned long long>(rand()) << 42) ^ (static_cast<unsigned long long>(rand()) << 21) ^ rand();
+}
+
+void test1()
+{
+	::printf("\ncompare with snprintf\n");
+
+	srand(1);
+	char expected[64];
+	char actual[TextFormat::MAX_DIGITS];
+	int mismatch = 0;
+	const int count = 100000;
+	for (int i = 0; i < count; i++) {
+		long long v = static_cast<long long>(random64()) >> (rand() % 64);
+		::snprintf(expected, sizeof(expected), "%lld", v);
+		size_t n = TextFormat::Int(actual, v);
+		if (n != ::strlen(expected) || ::memcmp(actual, expected, n) != 0) {
+			mismatch++;
+		}
+		::snprintf(expected, sizeof(expected), "%llx", static_cast<unsigned long long>(v));
+		n = TextFormat::Hex(actual, static_cast<unsigned long long>(v));
+		if (n != ::strlen(expected) || ::memcmp(actual, expected, n) != 0) {
+			mismatch++;
+		}
+	}
+	::printf("integer mismatch:%d/%d\n", mismatch, count * 2);
+	failures += mismatch;
+
+	mismatch = 0;
+	int shown = 0;
+	for (int i = 0; i < count; i++) {
+		double v = (rand() % 2 ? 1 : -1) * (rand() / static_cast<double>(RAND_MAX)) * ::pow(10.0, rand() % 16 - 6);
+		unsigned int precision = rand() % 10;
+		::snprintf(expected, sizeof(expected), "%.*f", precision, v);
+		size_t n = TextFormat::Double(actual, v, precision);
+		if (n != ::strlen(expected) || ::memcmp(actual, expected, n) != 0) {
+			if (shown++ < 3) {
+				::printf("  %.*s (printf %s)\n", static_cast<int>(n), actual, expected);
+			}
+			mismatch++;
+		}
+	}
+	::printf("double mismatch:%d/%d\n", mismatch, count);
+	failures += mismatch;
+
+	// 丸めの境界(k+0.5)ちょうどと、その前後の値
+	mismatch = 0;
+	int boundary = 0;
+	for (unsigned int precision = 0; precision <= TextFormat::MAX_PRECISION; precision++) {
+		double scale = ::pow(10.0, static_cast<double>(precision));
+		for (int k = 0; k < 20000; k++) {
+			double base = (k + 0.5) / scale;
+			double values[] = { base, ::nextafter(base, 0.0), ::nextafter(base, 1e300), -base };
+			for (size_t j = 0; j < sizeof(values) / sizeof(values[0]); j++) {
+				::snprintf(expected, sizeof(expected), "%.*f", precision, values[j]);
+				size_t n = TextFormat::Double(actual, values[j], precision);
+				if (n != ::strlen(expected) || ::memcmp(actual, expected, n) != 0) {
+					if (shown++ < 3) {
+						::printf("  %.*s (printf %s)\n", static_cast<int>(n), actual, expected);
+					}
+					mismatch++;
+				}
+				boundary++;
+			}
+		}
+	}
+	::printf("boundary mismatch:%d/%d\n", mismatch, boundary);
+	failures += mismatch;
+
+	double special[] = { 0.0, -0.0, 0.5, 1.5, 2.5, 0.125, 1e20, -INFINITY, NAN, 123.456, 1.85, 0.075, 0.005, 2.675 };
+	unsigned int precisions[] = { 0, 2, 0, 0, 0, 2, 0, 2, 0, 2, 1, 2, 2, 2 };
+	for (size_t i = 0; i < sizeof(special) / sizeof(special[0]); i++) {
+		std::string s = Text() << Fixed(special[i], precisions[i]);
+		// 整数部が2^64以上のときは"%.*g"
+		const char *format = (::fabs(special[i]) >= 18446744073709551616.0 && !::isinf(special[i])) ? "%.*g" : "%.*f";
+		::snprintf(expected, sizeof(expected), format, precisions[i], special[i]);
+		::printf("  %s (printf %s)%s\n", s.c_str(), expected, s == expected ? "" : " NG");
+		failures += (s == expected) ? 0 : 1;
+	}
+
+	long long pads[] = { 7, -5, -1234, 12345, 0 };
+	for (size_t i = 0; i < sizeof(pads) / sizeof(pads[0]); i++) {
+		std::string zero = Text() << Pad(pads[i], 4, '0');
+		std::string space = Text() << Pad(pads[i], 4);
+		char zeroExpected[32];
+		::snprintf(zeroExpected, sizeof(zeroExpected), "%04lld", pads[i]);
+		::snprintf(expected, sizeof(expected), "%4lld", pads[i]);
+		::printf("  [%s] [%s] (printf [%s] [%s])%s\n", zero.c_str(), space.c_str(), zeroExpected, expected,
+			(zero == zeroExpected && space == expected) ? "" : " NG");
+		failures += (zero == zeroExpected && space == expected) ? 0 : 1;
+	}
+}
+
+void test2()
+{
+	::printf("\nbyte buffer\n");
+
+	int lineNo = 7;
+	std::string message("axis on");
+	ByteBuffer expected;
+	expected.Append("[%04d] %s %.3f 0x%08x", lineNo, message.c_str(), 12.5, 0xbeef);
+	ByteBuffer bb;
+	ByteBufferText(bb) << "[" << Pad(lineNo, 4, '0') << "] " << message << " " << Fixed(12.5, 3) << " 0x" << Hex(0xbeef, 8);
+	::printf("same as Append(format):%d\n", bb.Data() == expected.Data());
+	failures += (bb.Data() == expected.Data()) ? 0 : 1;
+
+	bb.Append(1);
+	ByteBufferText(bb) << "second " << true;
+	std::string s1, s2;
+	int i;
+	bb.Value(s1);
+	bb.Value(i);
+	bb.Value(s2);
+	::printf("%s | %d | %s\n", s1.c_str(), i, s2.c_str());
+
+	StaticByteBuffer<32> sbb;
+	StaticByteBufferText<32>(sbb) << "axis " << Fixed(1.25, 2);
+	size_t size = sbb.Size();
+	StaticByteBufferText<32>(sbb) << "this text does not fit into the buffer";
+	::printf("static:%lu after overflow:%lu overflow:%d\n", static_cast<unsigned long>(size),
+		static_cast<unsigned long>(sbb.Size()), sbb.IsOverflow());
+	sbb.Value(s1);
+	::printf("%s\n", s1.c_str());
+
+	Error err(Text() << "send header error [" << "header too big size" << ":" << 600UL << "]");
+	::printf("error:%s\n", err.Message().c_str());
+}
+
+void test3()
+{
+	::printf("\nbenchmark\n");
+
+	const int count = 200000;
+	std::string message("program upload");
+	double start = now();
+	for (int i = 0; i < count; i++) {
+		ByteBuffer bb;
+		bb.Append("[%04d] %s axis:%.3f", i, message.c_str(), i * 0.001);
+	}
+	double formatTime = now() - start;
+
+	start = now();
+	for (int i = 0; i < count; i++) {
+		ByteBuffer bb;
+		ByteBufferText(bb) << "[" << Pad(i, 4, '0') << "] " << message << " axis:" << Fixed(i * 0.001, 3);
+	}
+	double textTime = now() - start;
+
+	StaticByteBuffer<128> sbb;
+	start = now();
+	for (int i = 0; i < count; i++) {
+		sbb.Clear();
+		StaticByteBufferText<128>(sbb) << "[" << Pad(i, 4, '0') << "] " << message << " axis:" << Fixed(i * 0.001, 3);
+	}
+	double staticTime = now() - start;
+
+	::printf("Append(format):         %6.0f ns\n", formatTime / count * 1e9);
+	::printf("ByteBufferText:         %6.0f ns\n", textTime / count * 1e9);
+	::printf("StaticByteBufferText:   %6.0f ns\n", staticTime / count * 1e9);
+}
+
+int main(int argc, char *argv[]) {
+	test1();
+	test2();
+	test3();
+	::printf("\nfailures:%d\n", failures);
+	return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,240 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <dirent.h>
+#include <limits.h>
+#include <vector>
+#include "TimerWheel.h"
+#include "MessageQueue.h"
+#include "StopToken.h"
+#include "ByteBuffer.h"
+#include "Thread.h"
+#include "SampleClock.h"
+
+using namespace PicoIPC;
+
+// 期限切れになった時刻を記録する
+class Recorder : public ITimerHandler
+{
+public:
+	Recorder() : mFired(0), mMaxLate(0) {}
+
+	void Expired(Timer &timer)
+	{
+		double *deadline = static_cast<double *>(timer.Parameter());
+		double late = now() - *deadline;
+		*deadline = late;
+		if (late > mMaxLate) {
+			mMaxLate = late;
+		}
+		__sync_fetch_and_add(&mFired, 1);
+	}
+
+	int    mFired;
+	double mMaxLate;
+};
+
+// 期限切れ処理の中で再登録する周期タイマー
+class Periodic : public ITimerHandler
+{
+public:
+	Periodic(TimerWheel *wheel, int count) : mWheel(wheel), mCount(count), mFired(0) {}
+
+	void Expired(Timer &timer)
+	{
+		mFired++;
+		if (mFired < mCount) {
+			mWheel->Schedule(timer, 10);
+		}
+	}
+
+	TimerWheel *mWheel;
+	int         mCount;
+	int         mFired;
+};
+
+// 期限になったら停止要求する
+class Deadline : public ITimerHandler
+{
+public:
+	void Expired(Timer &timer)
+	{
+		static_cast<StopSource *>(timer.Parameter())->RequestStop();
+	}
+};
+
+void test1(TimerWheel &wheel)
+{
+	::printf("\naccuracy (tick %lu us)\n", wheel.TickMicrosec());
+	Recorder recorder;
+	const unsigned long millisecs[] = {1, 10, 50, 200, 300};
+	const int count = sizeof(millisecs) / sizeof(millisecs[0]);
+	double deadlines[count];
+	std::vector<Timer *> timers;
+	for (int i = 0; i < count; i++) {
+		timers.push_back(new Timer(&recorder, &deadlines[i]));
+		deadlines[i] = now() + millisecs[i] / 1e3;
+		wheel.Schedule(*timers[i], millisecs[i]);
+	}
+	Thread::MilliSleep(400);
+	for (int i = 0; i < count; i++) {
+		::printf("  %4lu ms: late %.2f ms\n", millisecs[i], deadlines[i] * 1e3);
+		delete timers[i];
+	}
+	::printf("  fired:%d count:%lu\n", recorder.mFired, static_cast<unsigned long>(wheel.Count()));
+}
+
+void test2(TimerWheel &wheel)
+{
+	::printf("\ncancel and periodic\n");
+	Recorder recorder;
+	double deadline = 0;
+	Timer timer(&recorder, &deadline);
+	wheel.Schedule(timer, 30);
+	Thread::MilliSleep(10);
+	bool isCanceled = wheel.Cancel(timer);
+	Thread::MilliSleep(40);
+	::printf("  canceled:%d fired:%d scheduled:%d\n", isCanceled, recorder.mFired, timer.IsScheduled());
+
+	// 登録し直すと期限が変わる
+	deadline = now() + 0.02;
+	wheel.Schedule(timer, 100);
+	wheel.Schedule(timer, 20);
+	Thread::MilliSleep(50);
+	::printf("  rescheduled fired:%d late %.2f ms\n", recorder.mFired, deadline * 1e3);
+
+	Periodic periodic(&wheel, 5);
+	Timer periodicTimer(&periodic);
+	double start = now();
+	wheel.Schedule(periodicTimer, 10);
+	while (periodic.mFired < 5) {
+		Thread::MilliSleep(1);
+	}
+	::printf("  periodic fired:%d %.0f ms\n", periodic.mFired, (now() - start) * 1e3);
+}
+
+void test3(TimerWheel &wheel)
+{
+	::printf("\nschedule and cancel cost\n");
+	Recorder recorder;
+	const int count = 100000;
+	std::vector<Timer *> timers;
+	for (int i = 0; i < count; i++) {
+		timers.push_back(new Timer(&recorder, NULL));
+	}
+	::srand(1);
+	double start = now();
+	for (int i = 0; i < count; i++) {
+		// 1ms - 約1時間まで散らして全階層を使う
+		wheel.Schedule(*timers[i], 1000 + static_cast<unsigned long>(::rand()) % 3600000);
+	}
+	double scheduled = now() - start;
+	size_t registered = wheel.Count();
+	start = now();
+	int canceled = 0;
+	for (int i = count - 1; i >= 0; i--) {
+		if (wheel.Cancel(*timers[i])) {
+			canceled++;
+		}
+	}
+	double cancelTime = now() - start;
+	::printf("  %d timers schedule:%.0f ns cancel:%.0f ns registered:%lu canceled:%d count:%lu\n",
+		count, scheduled * 1e9 / count, cancelTime * 1e9 / count,
+		static_cast<unsigned long>(registered), canceled, static_cast<unsigned long>(wheel.Count()));
+
+	// 多数のタイマーが期限切れになる
+	const int expiring = 10000;
+	std::vector<double> deadlines(expiring);
+	for (int i = 0; i < expiring; i++) {
+		unsigned long millisec = 1 + static_cast<unsigned long>(::rand()) % 300;
+		delete timers[i];
+		timers[i] = new Timer(&recorder, &deadlines[i]);
+		deadlines[i] = now() + millisec / 1e3;
+		wheel.Schedule(*timers[i], millisec);
+	}
+	Thread::MilliSleep(400);
+	::printf("  %d expiring timers fired:%d max late:%.2f ms count:%lu\n",
+		expiring, recorder.mFired, recorder.mMaxLate * 1e3, static_cast<unsigned long>(wheel.Count()));
+	for (int i = 0; i < count; i++) {
+		delete timers[i];
+	}
+}
+
+void test4(TimerWheel &wheel)
+{
+	::printf("\nmessage queue deadline\n");
+	MessageQueue mq("/timer_wheel_test", 10, 64);
+	Deadline handler;
+	StopSource source;
+	Timer timer(&handler, &source);
+	wheel.Schedule(timer, 50);
+	ByteBuffer bb;
+	double start = now();
+	// タイムアウトなしの受信をTimerWheelの期限で中断する
+	ErrorCode code = mq.TimedReceiveCode(bb, 0, source.Token());
+	::printf("  canceled:%d %.0f ms [%s]\n", code.IsCanceled(), (now() - start) * 1e3, code.Message().c_str());
+}
+
+// プロセスのすべてのスレッドの自発的なコンテキストスイッチ(起床)の回数
+static long wakeups()
+{
+	long total = 0;
+	DIR *dir = ::opendir("/proc/self/task");
+	if (dir == NULL) {
+		return -1;
+	}
+	while (dirent *entry = ::readdir(dir)) {
+		if (entry->d_name[0] == '.') {
+			continue;
+		}
+		char path[PATH_MAX];
+		::snprintf(path, sizeof(path), "/proc/self/task/%s/status", entry->d_name);
+		FILE *fp = ::fopen(path, "r");
+		if (fp == NULL) {
+			continue;
+		}
+		char line[128];
+		long count;
+		while (::fgets(line, sizeof(line), fp) != NULL) {
+			if (::sscanf(line, "voluntary_ctxt_switches: %ld", &count) == 1) {
+				total += count;
+			}
+		}
+		::fclose(fp);
+	}
+	::closedir(dir);
+	return total;
+}
+
+void test5(TimerWheel &wheel)
+{
+	::printf("\nidle wakeups\n");
+	Recorder recorder;
+	double deadline = now() + 1.0;
+	Timer timer(&recorder, &deadline);
+	// 1秒後のタイマーだけがあるとき、ティックごとに起床しない
+	wheel.Schedule(timer, 1000);
+	long before = wakeups();
+	Thread::MilliSleep(500);
+	long after = wakeups();
+	::printf("  wakeups in 500 ms:%ld (1 ms tick)\n", after - before);
+	Thread::MilliSleep(600);
+	::printf("  fired:%d late %.2f ms\n", recorder.mFired, deadline * 1e3);
+}
+
+int main(int argc, char *argv[]) {
+	TimerWheel wheel;
+	Error error = wheel.Start();
+	if (error) {
+		::printf("%s\n", error.Message().c_str());
+		return 1;
+	}
+	test1(wheel);
+	test2(wheel);
+	test3(wheel);
+	test4(wheel);
+	test5(wheel);
+	wheel.Stop();
+
+	return 0;
+}
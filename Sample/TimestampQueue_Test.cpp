@@ -0,0 +1,86 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "TimestampQueue.h"
+#include "Thread.h"
+
+using namespace PicoIPC;
+
+class Producer : public IRunnable
+{
+public:
+	void Run()
+	{
+		Thread *t = Thread::CurrentThread();
+		MessageQueue *mq = static_cast<MessageQueue*>(t->Parameter());
+		TimestampQueue q(mq);
+		for (int i = 0; i < 1000; i++) {
+			ByteBuffer bb;
+			bb.Append(i);
+			q.TimedSend(bb, 100);
+			Thread::MicroSleep(50);
+		}
+	}
+};
+
+void test1(MessageQueue &mq)
+{
+	::printf("\nreceive one by one\n");
+
+	MessageQueue rq(mq.Name());
+	TimestampQueue q(&rq);
+	Producer producer;
+	Thread t(&producer, &mq);
+	t.Start();
+
+	int last = -1;
+	for (int i = 0; i < 1000; i++) {
+		ByteBuffer bb;
+		Error err = q.TimedReceive(bb, 1000);
+		if (err) {
+			::printf("err:%s\n", err.Message().c_str());
+			::exit(1);
+		}
+		bb.Value(last);
+	}
+	t.Join();
+
+	::printf("last:%d\n", last);
+	q.Latency().Print("latency");
+}
+
+void test2(MessageQueue &mq)
+{
+	::printf("\nreceive all\n");
+
+	TimestampQueue q(&mq);
+	for (int i = 0; i < 5; i++) {
+		ByteBuffer bb;
+		bb.Append(i);
+		q.Send(bb);
+	}
+	Thread::MilliSleep(10);
+
+	std::vector<ByteBuffer> list;
+	Error err = q.Receive(list);
+	if (err) {
+		::printf("err:%s\n", err.Message().c_str());
+		::exit(1);
+	}
+	for (size_t i = 0; i < list.size(); i++) {
+		int v;
+		list[i].Value(v);
+		::printf("%d ", v);
+	}
+	::printf("\n");
+	q.Latency().Print("latency");
+	q.Latency().Clear();
+	::printf("count after clear:%llu\n", q.Latency().Count());
+}
+
+int main(int argc, char *argv[]) {
+	MessageQueue mq("/mq_timestamp", 10, 64);
+
+	test1(mq);
+	test2(mq);
+	return 0;
+}
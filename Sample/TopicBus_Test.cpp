@@ -0,0 +1,190 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "TopicBus.h"
+#include "Thread.h"
+#include "SampleClock.h"
+
+using namespace PicoIPC;
+
+typedef TopicBus<8, 512> AxisBus;
+
+void test1(AxisBus &publisher, AxisBus &logger, AxisBus &hmi, AxisBus &diag)
+{
+	::printf("\ntest1 one publish, all subscribers receive\n");
+
+	for (int i = 0; i < 5; i++) {
+		ByteBuffer bb;
+		bb.Append(i);
+		for (int j = 0; j < 33; j++) {
+			bb.Append(j * 0.1);
+		}
+		Error err = publisher.Publish(bb);
+		if (err) {
+			::printf("err:%s\n", err.Message().c_str());
+			::exit(1);
+		}
+	}
+
+	AxisBus *subscribers[] = { &logger, &hmi, &diag };
+	const char *names[] = { "logger", "hmi", "diag" };
+	for (int s = 0; s < 3; s++) {
+		::printf("%s lag:%u :", names[s], subscribers[s]->Lag());
+		ByteBuffer bb;
+		while (subscribers[s]->TryReceive(bb)) {
+			int counter;
+			bb.Value(counter);
+			::printf(" %d", counter);
+		}
+		::printf("\n");
+	}
+}
+
+void test2(AxisBus &publisher, AxisBus &logger)
+{
+	::printf("\ntest2 lag detection\n");
+
+	for (int i = 0; i < 100; i++) {
+		ByteBuffer bb;
+		bb.Append(i);
+		publisher.Publish(bb);
+	}
+	::printf("lag:%u\n", logger.Lag());
+	int received = 0;
+	int first = -1;
+	ByteBuffer bb;
+	while (logger.TryReceive(bb)) {
+		int counter;
+		bb.Value(counter);
+		if (first < 0) {
+			first = counter;
+		}
+		received++;
+	}
+	::printf("received:%d first:%d lost:%lu\n", received, first, logger.LostCount());
+}
+
+void test3(AxisBus &logger)
+{
+	::printf("\ntest3 timed receive (no message: timeout error)\n");
+
+	ByteBuffer bb;
+	double start = now();
+	Error err = logger.TimedReceive(bb, 100);
+	if (err) {
+		::printf("timeout:%s %.0f ms\n", err.Message().c_str(), (now() - start) * 1e3);
+	} else {
+		::exit(1);
+	}
+}
+
+class AxisPublisher : public IRunnable
+{
+public:
+	void Run()
+	{
+		Thread *t = Thread::CurrentThread();
+		AxisBus *bus = static_cast<AxisBus*>(t->Parameter());
+		for (int i = 0; i < 200; i++) {
+			ByteBuffer bb;
+			bb.Append(i);
+			bus->Publish(bb);
+			Thread::MicroSleep(50);
+		}
+	}
+};
+
+void test4(AxisBus &publisher, AxisBus &logger)
+{
+	::printf("\ntest4 spin then block\n");
+
+	logger.SeekLatest();
+	logger.SetSpinBudget(200);
+	AxisPublisher worker;
+	Thread t(&worker, &publisher);
+	t.Start();
+	int last = -1;
+	while (last != 199) {
+		ByteBuffer bb;
+		Error err = logger.TimedReceive(bb, 1000);
+		if (err) {
+			::printf("err:%s\n", err.Message().c_str());
+			::exit(1);
+		}
+		bb.Value(last);
+	}
+	t.Join();
+	::printf("last:%d spin hit ratio:%.2f\n", last, logger.Spin().SpinHitRatio());
+}
+
+class TimestampPublisher : public IRunnable
+{
+public:
+	void Run()
+	{
+		Thread *t = Thread::CurrentThread();
+		AxisBus *bus = static_cast<AxisBus*>(t->Parameter());
+		for (int i = 0; i < 200; i++) {
+			Thread::MilliSleep(1);
+			ByteBuffer bb;
+			bb.Append(i);
+			bb.Append(now());
+			bus->Publish(bb);
+		}
+	}
+};
+
+void test5(AxisBus &publisher, AxisBus &logger)
+{
+	::printf("\ntest5 blocking receive wake-up latency\n");
+
+	logger.SeekLatest();
+	logger.SetSpinBudget(0);
+	TimestampPublisher worker;
+	Thread t(&worker, &publisher);
+	t.Start();
+	int last = -1;
+	double total = 0;
+	double max = 0;
+	while (last != 199) {
+		ByteBuffer bb;
+		Error err = logger.TimedReceive(bb, 1000);
+		if (err) {
+			::printf("err:%s\n", err.Message().c_str());
+			::exit(1);
+		}
+		double published;
+		bb.Value(last);
+		bb.Value(published);
+		double latency = now() - published;
+		total += latency;
+		if (latency > max) {
+			max = latency;
+		}
+	}
+	t.Join();
+	::printf("last:%d latency avg:%.1f us max:%.1f us\n", last, total / 200 * 1e6, max * 1e6);
+}
+
+int main(int argc, char *argv[]) {
+	SharedMemoryContext pubContext;
+	SharedMemoryContext subContext1;
+	SharedMemoryContext subContext2;
+	SharedMemoryContext subContext3;
+
+	AxisBus publisher(&pubContext, "/topic_axis", true);
+	AxisBus logger(&subContext1, "/topic_axis", false);
+	AxisBus hmi(&subContext2, "/topic_axis", false);
+	AxisBus diag(&subContext3, "/topic_axis", false);
+	if (!publisher.IsBound() || !logger.IsBound()) {
+		::printf("shared memory not found\n");
+		return 1;
+	}
+
+	test1(publisher, logger, hmi, diag);
+	test2(publisher, logger);
+	test3(logger);
+	test4(publisher, logger);
+	test5(publisher, logger);
+	return 0;
+}
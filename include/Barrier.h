@@ -0,0 +1,132 @@
+///////////////////////////////////////////////////////////
+/// @file	Barrier.h
+/// @brief	futexによる軽量なバリア
+/// @author	shuji-morimoto
+/// Copyright (C) 2013- Mamezou. All rights reserved.
+///////////////////////////////////////////////////////////
+
+#ifndef __PICO_IPC_BARRIER__
+#define __PICO_IPC_BARRIER__
+
+#include "Futex.h"
+#include "SpinPolicy.h"
+
+namespace PicoIPC {
+
+///////////////////////////////////////////////////////////
+/// @class	BasicBarrier
+/// @brief	指定した数のスレッドがArrive()するまで待ち合わせるバリア(繰り返し利用できる)
+///
+/// - 最後に到着したスレッドが世代を進めて全員を起こす
+/// - 待機側は少しスピンしてからfutexで待機する。全員がスピン中に揃ったときはシステムコールを呼び出さない
+/// - IsSharedがtrueのときはプロセス間で共有できる(SharedBarrier)
+///
+///////////////////////////////////////////////////////////
+template <bool IsShared>
+struct BasicBarrier
+{
+	volatile int mParties;    ///< 待ち合わせる数(直接操作しないこと)
+	volatile int mArrived;    ///< 到着した数(直接操作しないこと)
+	volatile int mGeneration; ///< 世代(直接操作しないこと)
+	volatile int mWaiters;    ///< futexで待機しているスレッドの数(直接操作しないこと)
+
+	///////////////////////////////////////////////////////////
+	/// @brief		待ち合わせる数を設定する
+	/// @param[in]	parties 待ち合わせる数(1以上)
+	/// @note		待機しているスレッドがいないときに呼び出すこと
+	///////////////////////////////////////////////////////////
+	void Init(int parties)
+	{
+		mParties = (parties < 1) ? 1 : parties;
+		mArrived = 0;
+		mGeneration = 0;
+		mWaiters = 0;
+		__sync_synchronize();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		待ち合わせる数を取得する
+	/// @return		待ち合わせる数
+	///////////////////////////////////////////////////////////
+	int Parties() const
+	{
+		return mParties;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		到着して全員が揃うまで待機する
+	/// @return		最後に到着したスレッドのときtrue(揃った後の処理を1つのスレッドで行うときに使う)
+	///////////////////////////////////////////////////////////
+	bool Arrive()
+	{
+		int generation = mGeneration;
+		__sync_synchronize();
+		if (__sync_add_and_fetch(&mArrived, 1) == mParties) {
+			mArrived = 0;
+			// 世代を進めた後に待機したスレッドはmGenerationが異なるためすぐに戻る
+			__sync_fetch_and_add(&mGeneration, 1);
+			if (mWaiters != 0) {
+				Futex::WakeAll(&mGeneration, IsShared);
+			}
+			return true;
+		}
+		for (int i = 0; i < SPIN_COUNT; i++) {
+			if (mGeneration != generation) {
+				__sync_synchronize();
+				return false;
+			}
+			CpuRelax();
+		}
+		while (mGeneration == generation) {
+			__sync_fetch_and_add(&mWaiters, 1);
+			Futex::Wait(&mGeneration, generation, IsShared);
+			__sync_fetch_and_sub(&mWaiters, 1);
+		}
+		__sync_synchronize();
+		return false;
+	}
+
+private:
+	/// futexで待機する前にスピンする回数
+	enum { SPIN_COUNT = 1000 };
+};
+
+///////////////////////////////////////////////////////////
+/// @brief	共有メモリ上に配置するバリア
+/// @note	POD型のため共有メモリの構造体のメンバにできる。所有するプロセスがInit()すること
+///////////////////////////////////////////////////////////
+typedef BasicBarrier<true> SharedBarrier;
+
+///////////////////////////////////////////////////////////
+/// @class	Barrier
+/// @brief	プロセス内のスレッド間で利用するバリア
+///
+/// 使い方
+///   Barrier barrier(threadCount);
+///   // 各スレッド
+///   for (...) {
+///       Compute(step);
+///       barrier.Arrive();   // 全員がstepを終えるまで待つ
+///   }
+///
+///////////////////////////////////////////////////////////
+class Barrier : public BasicBarrier<false>
+{
+public:
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @param[in]	parties 待ち合わせる数(1以上)
+	///////////////////////////////////////////////////////////
+	explicit Barrier(int parties)
+	{
+		Init(parties);
+	}
+
+private:
+	/// コピー禁止
+	Barrier(const Barrier &);
+	/// 代入禁止
+	Barrier &operator=(const Barrier &);
+};
+}
+#endif
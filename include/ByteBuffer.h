@@ -14,6 +14,10 @@
 #include <cstdio>
 #include <cstdarg>
 #include <cstring>
+#include "SerializedView.h"
+#include "StringView.h"
+#include "TextFormat.h"
+#include "Crc32c.h"
 
 namespace PicoIPC {
 ///////////////////////////////////////////////////////////
@@ -80,6 +84,19 @@ public:
 	///////////////////////////////////////////////////////////
 	void Clear();
 
+	///////////////////////////////////////////////////////////
+	/// @brief		内容を交換する
+	/// @param[in,out]	other 交換するByteBuffer
+	/// @note		内部バッファをコピーしないため、スレッド間でByteBufferを受け渡すときに使う
+	///////////////////////////////////////////////////////////
+	void Swap(ByteBuffer &other)
+	{
+		mBuffer.swap(other.mBuffer);
+		unsigned int position = mPosition;
+		mPosition = other.mPosition;
+		other.mPosition = position;
+	}
+
 	///////////////////////////////////////////////////////////
 	/// @brief		バッファ内容を文字列で取得する
 	/// @return		バイトデータ
@@ -102,6 +119,18 @@ public:
 	///////////////////////////////////////////////////////////
 	void Append(const std::string &_data);
 
+	///////////////////////////////////////////////////////////
+	/// @brief		文字列(StringView)を追加する
+	/// @param[in]	_data 書き込むデータ
+	/// @note		std::stringと同じ形式で追加する
+	///////////////////////////////////////////////////////////
+	void Append(const StringView &_data)
+	{
+		int length = static_cast<int>(_data.Size());
+		mBuffer.append(reinterpret_cast<const char*>(&length), sizeof(length));
+		mBuffer.append(_data.Data(), _data.Size());
+	}
+
 	///////////////////////////////////////////////////////////
 	/// @brief		文字列(const char *)を追加する
 	/// @param[in]	_data 書き込むデータ
@@ -198,6 +227,18 @@ public:
 	///////////////////////////////////////////////////////////
 	void Value(char *_out);
 
+	///////////////////////////////////////////////////////////
+	/// @brief		文字列をコピーせずに参照する
+	/// @param[out]	_out バッファ内の文字列の参照
+	/// @note		Append()した順で取り出すこと <br />
+	/// @note		ヒープを確保しない。参照はバッファを変更するまで有効
+	///////////////////////////////////////////////////////////
+	void Value(StringView &_out)
+	{
+		SerializedTraits<StringView>::Read(mBuffer.data() + mPosition, _out);
+		mPosition += sizeof(int) + _out.Size();
+	}
+
 	///////////////////////////////////////////////////////////
 	/// @brief		size_t型で値を取得する
 	/// @param[out]	_out データ
@@ -243,6 +284,43 @@ public:
 		}
 	}
 
+	///////////////////////////////////////////////////////////
+	/// @brief		std::vector<T>を展開せずに参照する
+	/// @param[out]	_out 参照
+	/// @note		Append()した順で取り出すこと <br />
+	/// @note		データポインタはvectorの後ろまで進む。参照はバッファを変更するまで有効
+	///////////////////////////////////////////////////////////
+	template <class T>
+	void Value(VectorView<T> &_out)
+	{
+		_out.Reset(mBuffer.data() + mPosition);
+		mPosition += _out.ByteSize();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		std::map<K,V>を展開せずに参照する
+	/// @param[out]	_out 参照
+	/// @note		Append()した順で取り出すこと <br />
+	/// @note		データポインタはmapの後ろまで進む。参照はバッファを変更するまで有効
+	///////////////////////////////////////////////////////////
+	template <class K, class V>
+	void Value(MapView<K,V> &_out)
+	{
+		_out.Reset(mBuffer.data() + mPosition);
+		mPosition += _out.ByteSize();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		データ型Tを取り出さずに読み飛ばす
+	/// @note		Append()した順で読み飛ばすこと <br />
+	/// @note		ex) buf.Skip<std::map<std::string, int> >();
+	///////////////////////////////////////////////////////////
+	template <class T>
+	void Skip()
+	{
+		mPosition += SerializedTraits<T>::Size(mBuffer.data() + mPosition);
+	}
+
 	///////////////////////////////////////////////////////////
 	/// @brief		データ型Tを取得する
 	/// @param[out]	_out データ
@@ -270,6 +348,39 @@ public:
 	///////////////////////////////////////////////////////////
 	void SetPosition(unsigned int pos);
 
+	///////////////////////////////////////////////////////////
+	/// @brief		バッファ全体のCRC32Cを末尾に追加する
+	/// @note		送信(MessageQueue, UnixDomainSocket)や共有メモリーへの書き込みの直前に呼び出す<br/>
+	/// 			受信側はVerifyChecksum()で確認してから取り出すこと
+	///////////////////////////////////////////////////////////
+	void AppendChecksum()
+	{
+		unsigned int crc = Crc32c(mBuffer.data(), mBuffer.size());
+		mBuffer.append(reinterpret_cast<const char*>(&crc), sizeof(crc));
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		末尾のCRC32Cを確認する
+	/// @return		一致するときtrue
+	/// @note		一致したときは末尾のCRCを取り除く<br/>
+	/// 			一致しないときはバッファを変更しない
+	///////////////////////////////////////////////////////////
+	bool VerifyChecksum()
+	{
+		size_t size = mBuffer.size();
+		if (size < sizeof(unsigned int)) {
+			return false;
+		}
+		size -= sizeof(unsigned int);
+		unsigned int crc;
+		::memcpy(&crc, mBuffer.data() + size, sizeof(crc));
+		if (crc != Crc32c(mBuffer.data(), size)) {
+			return false;
+		}
+		mBuffer.resize(size);
+		return true;
+	}
+
 	///////////////////////////////////////////////////////////
 	/// @brief		16進ダンプを取得する
 	/// @return		16進ダンプ
@@ -291,12 +402,104 @@ public:
 	void Print(const std::string &title) const;
 
 private:
+	friend class ByteBufferText;
+	friend class MessageQueue;
+
 	/// 内部バッファ
 	std::string mBuffer;
 
 	/// データポインタ位置
 	unsigned int mPosition;
 };
+
+///////////////////////////////////////////////////////////
+/// @class	ByteBufferText
+/// @brief	ByteBufferの内部バッファに直接文字列を整形して追加する
+///
+/// - Append(const char *_format, ...)と同じ形式(長さ(int) + 文字列)で追加する
+/// - 一時領域に整形してからコピーしない。vsnprintfのように書式文字列を解析しない
+/// - 長さは一時オブジェクトが破棄されるとき(文の終わり)に確定する
+///
+/// 使い方
+///   ByteBufferText(bb) << "[" << Pad(lineNo, 4, '0') << "] " << message;
+///   bb.Value(str);   // Append("[%04d] %s", lineNo, message.c_str())と同じ
+///
+///////////////////////////////////////////////////////////
+class ByteBufferText : public TextStream<ByteBufferText>
+{
+public:
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @param[in]	buffer 追加先
+	///////////////////////////////////////////////////////////
+	explicit ByteBufferText(ByteBuffer &buffer)
+		: mBuffer(buffer.mBuffer)
+		, mOffset(buffer.mBuffer.size())
+	{
+		int length = 0;
+		mBuffer.append(reinterpret_cast<const char*>(&length), sizeof(length));
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		デストラクタ
+	/// @note		追加した文字列の長さを書き込む
+	///////////////////////////////////////////////////////////
+	~ByteBufferText()
+	{
+		int length = static_cast<int>(mBuffer.size() - mOffset - sizeof(int));
+		::memcpy(&mBuffer[mOffset], &length, sizeof(length));
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		出力先に書き込む
+	/// @param[in]	data データ
+	/// @param[in]	size データサイズ
+	///////////////////////////////////////////////////////////
+	void Write(const char *data, size_t size)
+	{
+		mBuffer.append(data, size);
+	}
+
+private:
+	std::string &mBuffer; ///< 追加先の内部バッファ
+	size_t       mOffset; ///< 長さを書き込む位置
+
+	/// コピー禁止
+	ByteBufferText(const ByteBufferText &);
+	/// 代入禁止
+	ByteBufferText &operator=(const ByteBufferText &);
+};
+
+///////////////////////////////////////////////////////////
+/// @brief		ByteBufferはサイズ(int) + バイト配列で格納されている
+///////////////////////////////////////////////////////////
+template <>
+struct SerializedTraits<ByteBuffer>
+{
+	static const bool FIXED_SIZE = false;
+
+	static size_t Size(const char *p)
+	{
+		int size;
+		::memcpy(&size, p, sizeof(int));
+		return sizeof(int) + size;
+	}
+
+	static void Read(const char *p, ByteBuffer &out)
+	{
+		int size;
+		::memcpy(&size, p, sizeof(int));
+		out = ByteBuffer(p + sizeof(int), static_cast<size_t>(size));
+	}
+};
+
+///////////////////////////////////////////////////////////
+/// @brief		ByteBufferを交換する(swap(a, b)の呼び出しで選択される)
+///////////////////////////////////////////////////////////
+inline void swap(ByteBuffer &a, ByteBuffer &b)
+{
+	a.Swap(b);
+}
 }
 
 #endif
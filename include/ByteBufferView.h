@@ -0,0 +1,307 @@
+///////////////////////////////////////////////////////////
+/// @file	ByteBufferView.h
+/// @brief	Byteバッファの参照
+/// @author	shuji-morimoto
+/// Copyright (C) 2013- Mamezou. All rights reserved.
+///////////////////////////////////////////////////////////
+
+#ifndef __PICO_IPC_BYTE_BUFFER_VIEW_
+#define __PICO_IPC_BYTE_BUFFER_VIEW_
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstring>
+#include "ByteBuffer.h"
+
+namespace PicoIPC {
+///////////////////////////////////////////////////////////
+/// @class ByteBufferView
+/// @brief	Byteバッファの参照
+/// @note ByteBufferと同じ形式でシリアライズされたバイト配列を
+///       コピーせずに参照し、ByteBufferと同じ順でValue()で取り出す<br />
+/// @note 参照先のメモリーはByteBufferViewより長く生存すること<br />
+///////////////////////////////////////////////////////////
+class ByteBufferView {
+public:
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @return		なし
+	/// @note		空の参照
+	///////////////////////////////////////////////////////////
+	ByteBufferView()
+		: mData(NULL)
+		, mSize(0)
+		, mPosition(0)
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @param[in]	_data 参照するデータ
+	/// @param[in]	_size データサイズ
+	/// @return		なし
+	/// @note
+	///////////////////////////////////////////////////////////
+	ByteBufferView(const char *_data, size_t _size)
+		: mData(_data)
+		, mSize(_size)
+		, mPosition(0)
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @param[in]	_buffer 参照するByteBuffer
+	/// @return		なし
+	/// @note		_bufferを変更すると参照は無効になる
+	///////////////////////////////////////////////////////////
+	ByteBufferView(const ByteBuffer &_buffer)
+		: mData(_buffer.Data().data())
+		, mSize(_buffer.Size())
+		, mPosition(0)
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		参照するデータを設定する
+	/// @param[in]	_data 参照するデータ
+	/// @param[in]	_size データサイズ
+	/// @note		データポインタの位置は0に戻る
+	///////////////////////////////////////////////////////////
+	void Reset(const char *_data, size_t _size)
+	{
+		mData = _data;
+		mSize = _size;
+		mPosition = 0;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		参照が空かどうか確認する
+	/// @return		空のときtrue
+	/// @note
+	///////////////////////////////////////////////////////////
+	bool IsEmpty() const
+	{
+		return mSize == 0;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		参照するデータのサイズを取得する
+	/// @return		サイズ
+	/// @note
+	///////////////////////////////////////////////////////////
+	size_t Size() const
+	{
+		return mSize;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		参照するデータの先頭を取得する
+	/// @return		データの先頭
+	/// @note
+	///////////////////////////////////////////////////////////
+	const char *Data() const
+	{
+		return mData;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		ByteBufferを取得する
+	/// @param[out]	_out データ
+	/// @note		Append()した順で取り出すこと <br />
+	/// @note		_outにはデータがコピーされる
+	///////////////////////////////////////////////////////////
+	void Value(ByteBuffer &_out)
+	{
+		int size = 0;
+		Value(size);
+		_out = ByteBuffer(mData + mPosition, static_cast<size_t>(size));
+		mPosition += size;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		文字列(std::string)を取得する
+	/// @param[out]	_out データ
+	/// @note		Append()した順で取り出すこと <br />
+	///////////////////////////////////////////////////////////
+	void Value(std::string &_out)
+	{
+		int size = 0;
+		Value(size);
+		_out.assign(mData + mPosition, size);
+		mPosition += size;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		文字列(char *)を取得する
+	/// @param[out]	_out データ
+	/// @note		Append()した順で取り出すこと <br />
+	///////////////////////////////////////////////////////////
+	void Value(char *_out)
+	{
+		int size = 0;
+		Value(size);
+		::memcpy(_out, mData + mPosition, size);
+		_out[size] = '\0';
+		mPosition += size;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		文字列をコピーせずに参照する
+	/// @param[out]	_out バッファ内の文字列の参照
+	/// @note		Append()した順で取り出すこと <br />
+	/// @note		ヒープを確保しない。参照はバッファを変更するまで有効
+	///////////////////////////////////////////////////////////
+	void Value(StringView &_out)
+	{
+		SerializedTraits<StringView>::Read(mData + mPosition, _out);
+		mPosition += sizeof(int) + _out.Size();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		size_t型で値を取得する
+	/// @param[out]	_out データ
+	/// @note		Append()した順で取り出すこと <br />
+	///////////////////////////////////////////////////////////
+	void Value(size_t &_out)
+	{
+		int v = 0;
+		Value(v);
+		_out = v;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		std::vector<T>を取得する
+	/// @param[out]	_out データ
+	/// @note		Append()した順で取り出すこと <br />
+	///////////////////////////////////////////////////////////
+	template <class T>
+	void Value(std::vector<T> &_out)
+	{
+		int size = 0;
+		Value(size);
+		for (int i = 0; i < size; i++) {
+			T value;
+			Value(value);
+			_out.push_back(value);
+		}
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		std::map<K,V>を取得する
+	/// @param[out]	_out データ
+	/// @note		Append()した順で取り出すこと <br />
+	///////////////////////////////////////////////////////////
+	template <class K, class V>
+	void Value(std::map<K,V> &_out)
+	{
+		int size = 0;
+		Value(size);
+		for (int i = 0; i < size; i++) {
+			K key;
+			Value(key);
+			V val;
+			Value(val);
+			_out.insert(std::make_pair(key,val));
+		}
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		std::vector<T>を展開せずに参照する
+	/// @param[out]	_out 参照
+	/// @note		Append()した順で取り出すこと <br />
+	/// @note		データポインタはvectorの後ろまで進む。参照はバッファを変更するまで有効
+	///////////////////////////////////////////////////////////
+	template <class T>
+	void Value(VectorView<T> &_out)
+	{
+		_out.Reset(mData + mPosition);
+		mPosition += _out.ByteSize();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		std::map<K,V>を展開せずに参照する
+	/// @param[out]	_out 参照
+	/// @note		Append()した順で取り出すこと <br />
+	/// @note		データポインタはmapの後ろまで進む。参照はバッファを変更するまで有効
+	///////////////////////////////////////////////////////////
+	template <class K, class V>
+	void Value(MapView<K,V> &_out)
+	{
+		_out.Reset(mData + mPosition);
+		mPosition += _out.ByteSize();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		データ型Tを取り出さずに読み飛ばす
+	/// @note		Append()した順で読み飛ばすこと <br />
+	/// @note		ex) buf.Skip<std::map<std::string, int> >();
+	///////////////////////////////////////////////////////////
+	template <class T>
+	void Skip()
+	{
+		mPosition += SerializedTraits<T>::Size(mData + mPosition);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		データ型Tを取得する
+	/// @param[out]	_out データ
+	/// @note		Append()した順で取り出すこと <br />
+	///////////////////////////////////////////////////////////
+	template <class T>
+	void Value(T &_out)
+	{
+		int size = sizeof(_out);
+		::memcpy(&_out, mData + mPosition, size);
+		mPosition += size;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		データポインタの位置を取得する
+	/// @return		データポインタの位置
+	/// @note
+	///////////////////////////////////////////////////////////
+	unsigned int Position() const
+	{
+		return mPosition;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		データポインタの位置を指定した位置に移動する
+	/// @param[int]	pos 位置
+	/// @note
+	///////////////////////////////////////////////////////////
+	void SetPosition(unsigned int pos)
+	{
+		mPosition = pos;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		末尾のCRC32Cを確認する
+	/// @return		一致するときtrue
+	/// @note		一致したときは末尾のCRCを参照範囲から外す
+	///////////////////////////////////////////////////////////
+	bool VerifyChecksum()
+	{
+		if (mSize < sizeof(unsigned int)) {
+			return false;
+		}
+		size_t size = mSize - sizeof(unsigned int);
+		unsigned int crc;
+		::memcpy(&crc, mData + size, sizeof(crc));
+		if (crc != Crc32c(mData, size)) {
+			return false;
+		}
+		mSize = size;
+		return true;
+	}
+
+private:
+	const char   *mData;     ///< 参照するデータ
+	size_t        mSize;     ///< データサイズ
+	unsigned int  mPosition; ///< データポインタ位置
+};
+}
+
+#endif
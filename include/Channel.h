@@ -0,0 +1,344 @@
+///////////////////////////////////////////////////////////
+/// @file	Channel.h
+/// @brief	プロセス内のスレッド間で値を受け渡すロックフリーのMPSCキュー
+/// @author	shuji-morimoto
+/// Copyright (C) 2013- Mamezou. All rights reserved.
+///////////////////////////////////////////////////////////
+
+#ifndef __PICO_IPC_CHANNEL__
+#define __PICO_IPC_CHANNEL__
+
+#include <time.h>
+#include <algorithm>
+#include <vector>
+#include "Futex.h"
+#include "Timespec.h"
+#include "SpinPolicy.h"
+#include "Thread.h"
+#include "ByteBuffer.h"
+
+namespace PicoIPC {
+
+///////////////////////////////////////////////////////////
+/// @class	ChannelTraits
+/// @brief	Channelがノードや受信先に用意する空の値
+/// @note	デフォルトコンストラクタが領域を確保する型は特殊化して確保しない値を返す
+///////////////////////////////////////////////////////////
+template <class T>
+struct ChannelTraits
+{
+	static T Empty()
+	{
+		return T();
+	}
+};
+
+///////////////////////////////////////////////////////////
+/// @brief	ByteBuffer()は2048byteを確保するため、確保しないByteBufferを用意する
+///////////////////////////////////////////////////////////
+template <>
+struct ChannelTraits<ByteBuffer>
+{
+	static ByteBuffer Empty()
+	{
+		return ByteBuffer(0);
+	}
+};
+
+///////////////////////////////////////////////////////////
+/// @class	Channel
+/// @brief	複数の送信スレッドから1つの受信スレッドへ値を受け渡すキュー(MPSC)
+///
+/// - Dmitry VyukovのスタブノードつきイントルーシブMPSCキューで、送信はCAS(競合しなければ1回)、
+///   受信はアトミック操作なしで行う。Mutexもシステムコールも使わない
+/// - 受信スレッドが待機しているときのみ、送信側がfutexで起こす(待機していなければシステムコールなし)
+/// - SendSwap()/Receive()はswap()で値を交換するため、ByteBufferやstd::stringの内部バッファを
+///   コピーせずに受け渡せる
+/// - 受信(Receive(), TryReceive(), TimedReceive(), ReceiveBatch())は1つのスレッドからのみ呼び出すこと
+/// - 容量の上限はない。送信ごとにノードを1つnewする
+///
+/// 使い方
+///   Channel<ByteBuffer> channel;
+///   // 送信スレッド(複数可)
+///   ByteBuffer bb;
+///   bb.Append(value);
+///   channel.SendSwap(bb);     // bbは空になる
+///   // 受信スレッド
+///   ByteBuffer out;
+///   if (channel.TimedReceive(out, 100)) { ... }
+///
+///////////////////////////////////////////////////////////
+template <class T>
+class Channel
+{
+public:
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	///////////////////////////////////////////////////////////
+	Channel()
+		: mHead(&mStub)
+		, mTail(&mStub)
+		, mIsSleeping(0)
+	{
+		mStub.next = NULL;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		デストラクタ
+	/// @note		受信されていない値は破棄する
+	///////////////////////////////////////////////////////////
+	virtual ~Channel()
+	{
+		Node *node = mTail;
+		while (node != NULL) {
+			Node *next = node->next;
+			if (node != &mStub) {
+				delete node;
+			}
+			node = next;
+		}
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		値をコピーして送信する
+	/// @param[in]	value 値
+	///////////////////////////////////////////////////////////
+	void Send(const T &value)
+	{
+		Node *node = new Node();
+		node->value = value;
+		Enqueue(node);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		値を交換して送信する
+	/// @param[in,out]	value 値(ChannelTraits<T>::Empty()と交換される)
+	/// @note		ByteBufferは内部バッファをコピーしない
+	///////////////////////////////////////////////////////////
+	void SendSwap(T &value)
+	{
+		Node *node = new Node();
+		using std::swap;
+		swap(node->value, value);
+		Enqueue(node);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		値があれば受信する(待機しない)
+	/// @param[out]	value 受信した値(交換される)
+	/// @return		受信したときtrue
+	///////////////////////////////////////////////////////////
+	bool TryReceive(T &value)
+	{
+		Node *node = Dequeue();
+		if (node == NULL) {
+			return false;
+		}
+		using std::swap;
+		swap(value, node->value);
+		delete node;
+		return true;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		値を受信するまで待機する
+	/// @param[out]	value 受信した値(交換される)
+	///////////////////////////////////////////////////////////
+	void Receive(T &value)
+	{
+		while (!TryReceive(value)) {
+			Sleep(NULL);
+		}
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		値を受信するか指定時間経過するまで待機する
+	/// @param[out]	value 受信した値(交換される)
+	/// @param[in]	millisec ミリ秒
+	/// @return		受信したときtrue、タイムアウトしたときfalse
+	///////////////////////////////////////////////////////////
+	bool TimedReceive(T &value, unsigned long millisec)
+	{
+		if (TryReceive(value)) {
+			return true;
+		}
+		timespec deadline = Timespec::After(CLOCK_MONOTONIC, millisec);
+		timespec remaining;
+		while (Timespec::Remaining(CLOCK_MONOTONIC, deadline, remaining)) {
+			Sleep(&remaining);
+			if (TryReceive(value)) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		届いている値をまとめて受信する(待機しない)
+	/// @param[out]	values 受信した値を末尾に追加する
+	/// @param[in]	maxCount 受信する最大数
+	/// @return		受信した数
+	///////////////////////////////////////////////////////////
+	size_t ReceiveBatch(std::vector<T> &values, size_t maxCount)
+	{
+		size_t count = 0;
+		for (; count < maxCount; count++) {
+			Node *node = Dequeue();
+			if (node == NULL) {
+				break;
+			}
+			values.push_back(ChannelTraits<T>::Empty());
+			using std::swap;
+			swap(values.back(), node->value);
+			delete node;
+		}
+		return count;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		値が届くまで待機してから、届いている値をまとめて受信する
+	/// @param[out]	values 受信した値を末尾に追加する
+	/// @param[in]	maxCount 受信する最大数(1以上)
+	/// @param[in]	millisec ミリ秒
+	/// @return		受信した数(タイムアウトしたとき0)
+	///////////////////////////////////////////////////////////
+	size_t TimedReceiveBatch(std::vector<T> &values, size_t maxCount, unsigned long millisec)
+	{
+		values.push_back(ChannelTraits<T>::Empty());
+		if (!TimedReceive(values.back(), millisec)) {
+			values.pop_back();
+			return 0;
+		}
+		return 1 + ReceiveBatch(values, maxCount - 1);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		受信する値がないか確認する
+	/// @return		ないときtrue
+	/// @note		受信スレッドから呼び出すこと。送信途中の値はないものとして扱う
+	///////////////////////////////////////////////////////////
+	bool IsEmpty() const
+	{
+		Node *tail = mTail;
+		return (tail == &mStub) ? (tail->next == NULL) : false;
+	}
+
+private:
+	struct Node
+	{
+		Node *volatile next; ///< 次に受信するノード
+		T              value; ///< 値
+
+		Node() : next(NULL), value(ChannelTraits<T>::Empty()) {}
+	};
+
+	Node *volatile mHead;       ///< 最後に送信したノード(送信スレッドが交換する)
+	Node          *mTail;       ///< 次に受信するノード(受信スレッドのみ操作する)
+	Node           mStub;       ///< スタブノード
+	volatile int   mIsSleeping; ///< 受信スレッドがfutexで待機するとき1
+
+	void Enqueue(Node *node)
+	{
+		// Push()のCASはフルバリアのため、受信スレッドがmIsSleepingを設定してから
+		// mHeadを確認する順序と対になる
+		Push(node);
+		if (mIsSleeping != 0 && __sync_bool_compare_and_swap(&mIsSleeping, 1, 0)) {
+			Futex::Wake(&mIsSleeping, 1, false);
+		}
+	}
+
+	void Push(Node *node)
+	{
+		node->next = NULL;
+		// CASはフルバリアのため、nodeの内容を書き終えてから公開される
+		// (__sync_lock_test_and_set()はアクワイアバリアのみで、ARMでは別にフェンスが必要になる)
+		Node *prev;
+		do {
+			prev = mHead;
+		} while (!__sync_bool_compare_and_swap(&mHead, prev, node));
+		prev->next = node;
+	}
+
+	// nextを読んでからノードの内容を読む順序を保証する
+	static void AcquireFence()
+	{
+#if defined(__i386__) || defined(__x86_64__)
+		// x86は読み込み同士の順序が入れ替わらない
+		__asm__ __volatile__("" ::: "memory");
+#else
+		__sync_synchronize();
+#endif
+	}
+
+	Node *Dequeue()
+	{
+		Node *tail = mTail;
+		Node *next = tail->next;
+		if (tail == &mStub) {
+			if (next == NULL) {
+				return NULL;
+			}
+			mTail = next;
+			tail = next;
+			next = next->next;
+		}
+		if (next != NULL) {
+			AcquireFence();
+			mTail = next;
+			return tail;
+		}
+		if (tail != mHead) {
+			// 送信スレッドがmHeadを交換してからnextを設定するまでの間
+			return NULL;
+		}
+		// 最後のノードを取り出すため、スタブノードを後ろにつなぐ
+		Push(&mStub);
+		next = tail->next;
+		if (next != NULL) {
+			AcquireFence();
+			mTail = next;
+			return tail;
+		}
+		return NULL;
+	}
+
+	// 空でないか、送信途中のノードがあるときtrue
+	bool HasPending() const
+	{
+		return !IsEmpty() || mTail != mHead;
+	}
+
+	void Sleep(const timespec *timeout)
+	{
+		if (HasPending()) {
+			// 送信スレッドがmHeadを交換してからnextを設定するまでの間は、送信スレッドに譲る
+			Thread::Yield();
+			return;
+		}
+		// 少しスピンしてからfutexで待機する
+		for (int i = 0; i < SPIN_COUNT; i++) {
+			if (HasPending()) {
+				return;
+			}
+			CpuRelax();
+		}
+		mIsSleeping = 1;
+		__sync_synchronize();
+		if (HasPending()) {
+			mIsSleeping = 0;
+			return;
+		}
+		Futex::Wait(&mIsSleeping, 1, false, timeout);
+		mIsSleeping = 0;
+	}
+
+	/// futexで待機する前にスピンする回数
+	enum { SPIN_COUNT = 100 };
+
+	/// コピー禁止
+	Channel(const Channel &);
+	/// 代入禁止
+	Channel &operator=(const Channel &);
+};
+}
+#endif
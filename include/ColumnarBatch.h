@@ -0,0 +1,382 @@
+///////////////////////////////////////////////////////////
+/// @file	ColumnarBatch.h
+/// @brief	固定スキーマのメッセージの列指向一括デコード
+/// @author	shuji-morimoto
+/// Copyright (C) 2013- Mamezou. All rights reserved.
+///////////////////////////////////////////////////////////
+
+#ifndef __PICO_IPC_COLUMNAR_BATCH__
+#define __PICO_IPC_COLUMNAR_BATCH__
+
+#include <vector>
+#include <cstring>
+#include <cassert>
+#include "Error.h"
+#include "ByteBuffer.h"
+#include "ByteBufferView.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace PicoIPC {
+
+///////////////////////////////////////////////////////////
+/// @class	ColumnSchema
+/// @brief	メッセージのスキーマ(フィールドの並び)
+///
+/// - ByteBuffer::Append()した順にフィールドの型を追加する
+/// - フィールドはプリミティブ型(固定長)のみサポートする
+///
+/// 使い方
+///   ColumnSchema schema;
+///   schema.Add<int>().Add<double>(33);  // int + double x 33
+///
+///////////////////////////////////////////////////////////
+class ColumnSchema
+{
+public:
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	///////////////////////////////////////////////////////////
+	ColumnSchema()
+		: mRecordSize(0)
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		デストラクタ
+	///////////////////////////////////////////////////////////
+	virtual ~ColumnSchema()
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		型Tのフィールドを追加する
+	/// @param[in]	count 追加するフィールド数
+	/// @return		ColumnSchema
+	///////////////////////////////////////////////////////////
+	template <class T>
+	ColumnSchema &Add(size_t count = 1)
+	{
+		for (size_t i = 0; i < count; i++) {
+			mOffsets.push_back(mRecordSize);
+			mSizes.push_back(sizeof(T));
+			mRecordSize += sizeof(T);
+		}
+		return *this;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		フィールド数を取得する
+	/// @return		フィールド数
+	///////////////////////////////////////////////////////////
+	size_t FieldCount() const
+	{
+		return mSizes.size();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		フィールドのサイズを取得する
+	/// @param[in]	field フィールド番号
+	/// @return		サイズ
+	///////////////////////////////////////////////////////////
+	size_t FieldSize(size_t field) const
+	{
+		return mSizes[field];
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		メッセージ先頭からのフィールドの位置を取得する
+	/// @param[in]	field フィールド番号
+	/// @return		位置
+	///////////////////////////////////////////////////////////
+	size_t FieldOffset(size_t field) const
+	{
+		return mOffsets[field];
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		1メッセージのサイズを取得する
+	/// @return		サイズ
+	///////////////////////////////////////////////////////////
+	size_t RecordSize() const
+	{
+		return mRecordSize;
+	}
+
+private:
+	std::vector<size_t> mSizes;      ///< フィールドのサイズ
+	std::vector<size_t> mOffsets;    ///< フィールドの位置
+	size_t              mRecordSize; ///< 1メッセージのサイズ
+};
+
+///////////////////////////////////////////////////////////
+/// @class	ColumnarBatch
+/// @brief	N個のメッセージをフィールドごとの配列(SoA)に一括デコードする
+///
+/// - ByteBuffer::Value()で1フィールドずつ取り出す代わりに、スキーマに従って
+///   N個のメッセージの同じフィールドを1つの連続した配列に展開する
+/// - 連続する4byteフィールド4つ、8byteフィールド2つの組をSIMDのレジスタ内で
+///   転置してまとめて展開する(ローカルビルドはSSE2、ターゲットビルドはNEON。
+///   どちらも使えない場合は1フィールドずつコピーする)
+/// - 展開した列は連続した配列のため、フィルタや統計をループで処理すると
+///   コンパイラがベクトル化できる
+///
+/// 使い方
+///   ColumnSchema schema;
+///   schema.Add<int>().Add<double>(33);
+///   ColumnarBatch batch(schema);
+///   batch.Decode(list);                        // std::vector<ByteBuffer>
+///   const double *axis0 = batch.Column<double>(1);
+///   for (size_t i = 0; i < batch.Rows(); i++) { ... axis0[i] ... }
+///
+///////////////////////////////////////////////////////////
+class ColumnarBatch
+{
+public:
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @param[in]	schema メッセージのスキーマ
+	///////////////////////////////////////////////////////////
+	ColumnarBatch(const ColumnSchema &schema)
+		: mSchema(schema)
+		, mColumns(schema.FieldCount())
+		, mRowCount(0)
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		デストラクタ
+	///////////////////////////////////////////////////////////
+	virtual ~ColumnarBatch()
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		メッセージ一覧をデコードする
+	/// @param[in]	messages メッセージ一覧
+	/// @return		Error 失敗したときエラー内容がErrorに設定される
+	/// @note		前回のデコード結果は破棄される
+	///////////////////////////////////////////////////////////
+	Error Decode(const std::vector<ByteBuffer> &messages)
+	{
+		mRows.clear();
+		for (size_t i = 0; i < messages.size(); i++) {
+			if (messages[i].Size() < mSchema.RecordSize()) {
+				return SizeError(i, messages[i].Size());
+			}
+			mRows.push_back(messages[i].Data().data());
+		}
+		DecodeRows();
+		return Error::createNoError();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		メッセージの参照一覧をデコードする
+	/// @param[in]	messages メッセージの参照一覧
+	/// @return		Error 失敗したときエラー内容がErrorに設定される
+	/// @note		前回のデコード結果は破棄される
+	///////////////////////////////////////////////////////////
+	Error Decode(const std::vector<ByteBufferView> &messages)
+	{
+		mRows.clear();
+		for (size_t i = 0; i < messages.size(); i++) {
+			if (messages[i].Size() < mSchema.RecordSize()) {
+				return SizeError(i, messages[i].Size());
+			}
+			mRows.push_back(messages[i].Data());
+		}
+		DecodeRows();
+		return Error::createNoError();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		デコードしたメッセージ数を取得する
+	/// @return		メッセージ数(各列の要素数)
+	///////////////////////////////////////////////////////////
+	size_t Rows() const
+	{
+		return mRowCount;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		フィールドの列を取得する
+	/// @param[in]	field フィールド番号
+	/// @return		Rows()個の要素を持つ配列
+	/// @note		TはスキーマでAdd()した型と同じサイズであること
+	/// @note		次にDecode()するまで有効
+	///////////////////////////////////////////////////////////
+	template <class T>
+	const T *Column(size_t field) const
+	{
+		assert(sizeof(T) == mSchema.FieldSize(field));
+		return reinterpret_cast<const T *>(&mColumns[field][0]);
+	}
+
+private:
+	///////////////////////////////////////////////////////////
+	/// @brief		コピーコンストラクタ
+	/// @note		コピー禁止
+	///////////////////////////////////////////////////////////
+	ColumnarBatch(const ColumnarBatch &src);
+
+	///////////////////////////////////////////////////////////
+	/// @brief		代入オペレータ
+	/// @note		代入禁止
+	///////////////////////////////////////////////////////////
+	ColumnarBatch &operator =(const ColumnarBatch &src);
+
+	/// 列の領域(8byte境界に配置するためunsigned long longで確保する)
+	typedef std::vector<unsigned long long> ColumnStorage;
+
+	ColumnSchema                mSchema;   ///< メッセージのスキーマ
+	std::vector<ColumnStorage>  mColumns;  ///< フィールドごとの列
+	std::vector<const char *>   mRows;     ///< デコード中のメッセージ
+	size_t                      mRowCount; ///< デコードしたメッセージ数
+
+	Error SizeError(size_t row, size_t size)
+	{
+		return Error::createError("columnar decode error [message %lu size %lu < %lu]",
+			static_cast<unsigned long>(row), static_cast<unsigned long>(size),
+			static_cast<unsigned long>(mSchema.RecordSize()));
+	}
+
+	char *ColumnData(size_t field)
+	{
+		return reinterpret_cast<char *>(&mColumns[field][0]);
+	}
+
+	void DecodeRows()
+	{
+		mRowCount = mRows.size();
+		size_t fields = mSchema.FieldCount();
+		for (size_t j = 0; j < fields; j++) {
+			size_t bytes = mRowCount * mSchema.FieldSize(j);
+			mColumns[j].resize(bytes / sizeof(unsigned long long) + 1);
+		}
+		size_t j = 0;
+		while (j < fields) {
+			if (IsRun(j, 4, 4)) {
+				DecodeQuad32(j);
+				j += 4;
+			} else if (IsRun(j, 8, 2)) {
+				DecodePair64(j);
+				j += 2;
+			} else {
+				DecodeScalar(j);
+				j++;
+			}
+		}
+	}
+
+	bool IsRun(size_t field, size_t size, size_t count) const
+	{
+		if (field + count > mSchema.FieldCount()) {
+			return false;
+		}
+		for (size_t k = 0; k < count; k++) {
+			if (mSchema.FieldSize(field + k) != size) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void DecodeScalar(size_t field)
+	{
+		size_t size = mSchema.FieldSize(field);
+		size_t offset = mSchema.FieldOffset(field);
+		char *column = ColumnData(field);
+		for (size_t i = 0; i < mRowCount; i++) {
+			::memcpy(column + i * size, mRows[i] + offset, size);
+		}
+	}
+
+	// 4byteフィールド4つ x 4メッセージを転置する
+	void DecodeQuad32(size_t field)
+	{
+		size_t offset = mSchema.FieldOffset(field);
+		char *c0 = ColumnData(field);
+		char *c1 = ColumnData(field + 1);
+		char *c2 = ColumnData(field + 2);
+		char *c3 = ColumnData(field + 3);
+		size_t i = 0;
+#if defined(__SSE2__)
+		for (; i + 4 <= mRowCount; i += 4) {
+			__m128i r0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(mRows[i] + offset));
+			__m128i r1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(mRows[i + 1] + offset));
+			__m128i r2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(mRows[i + 2] + offset));
+			__m128i r3 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(mRows[i + 3] + offset));
+			__m128i t0 = _mm_unpacklo_epi32(r0, r1);
+			__m128i t1 = _mm_unpacklo_epi32(r2, r3);
+			__m128i t2 = _mm_unpackhi_epi32(r0, r1);
+			__m128i t3 = _mm_unpackhi_epi32(r2, r3);
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(c0 + i * 4), _mm_unpacklo_epi64(t0, t1));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(c1 + i * 4), _mm_unpackhi_epi64(t0, t1));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(c2 + i * 4), _mm_unpacklo_epi64(t2, t3));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(c3 + i * 4), _mm_unpackhi_epi64(t2, t3));
+		}
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+		for (; i + 4 <= mRowCount; i += 4) {
+			uint32x4_t r0 = vreinterpretq_u32_u8(vld1q_u8(reinterpret_cast<const uint8_t *>(mRows[i] + offset)));
+			uint32x4_t r1 = vreinterpretq_u32_u8(vld1q_u8(reinterpret_cast<const uint8_t *>(mRows[i + 1] + offset)));
+			uint32x4_t r2 = vreinterpretq_u32_u8(vld1q_u8(reinterpret_cast<const uint8_t *>(mRows[i + 2] + offset)));
+			uint32x4_t r3 = vreinterpretq_u32_u8(vld1q_u8(reinterpret_cast<const uint8_t *>(mRows[i + 3] + offset)));
+			uint32x4x2_t t0 = vtrnq_u32(r0, r1);
+			uint32x4x2_t t1 = vtrnq_u32(r2, r3);
+			uint32x4_t o0 = vcombine_u32(vget_low_u32(t0.val[0]), vget_low_u32(t1.val[0]));
+			uint32x4_t o1 = vcombine_u32(vget_low_u32(t0.val[1]), vget_low_u32(t1.val[1]));
+			uint32x4_t o2 = vcombine_u32(vget_high_u32(t0.val[0]), vget_high_u32(t1.val[0]));
+			uint32x4_t o3 = vcombine_u32(vget_high_u32(t0.val[1]), vget_high_u32(t1.val[1]));
+			vst1q_u8(reinterpret_cast<uint8_t *>(c0 + i * 4), vreinterpretq_u8_u32(o0));
+			vst1q_u8(reinterpret_cast<uint8_t *>(c1 + i * 4), vreinterpretq_u8_u32(o1));
+			vst1q_u8(reinterpret_cast<uint8_t *>(c2 + i * 4), vreinterpretq_u8_u32(o2));
+			vst1q_u8(reinterpret_cast<uint8_t *>(c3 + i * 4), vreinterpretq_u8_u32(o3));
+		}
+#endif
+		for (; i < mRowCount; i++) {
+			const char *row = mRows[i] + offset;
+			::memcpy(c0 + i * 4, row, 4);
+			::memcpy(c1 + i * 4, row + 4, 4);
+			::memcpy(c2 + i * 4, row + 8, 4);
+			::memcpy(c3 + i * 4, row + 12, 4);
+		}
+	}
+
+	// 8byteフィールド2つ x 2メッセージを転置する
+	// (doubleもビット列として扱うためARMv7のNEONでも処理できる)
+	void DecodePair64(size_t field)
+	{
+		size_t offset = mSchema.FieldOffset(field);
+		char *c0 = ColumnData(field);
+		char *c1 = ColumnData(field + 1);
+		size_t i = 0;
+#if defined(__SSE2__)
+		for (; i + 2 <= mRowCount; i += 2) {
+			__m128i r0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(mRows[i] + offset));
+			__m128i r1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(mRows[i + 1] + offset));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(c0 + i * 8), _mm_unpacklo_epi64(r0, r1));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(c1 + i * 8), _mm_unpackhi_epi64(r0, r1));
+		}
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+		for (; i + 2 <= mRowCount; i += 2) {
+			uint64x2_t r0 = vreinterpretq_u64_u8(vld1q_u8(reinterpret_cast<const uint8_t *>(mRows[i] + offset)));
+			uint64x2_t r1 = vreinterpretq_u64_u8(vld1q_u8(reinterpret_cast<const uint8_t *>(mRows[i + 1] + offset)));
+			uint64x2_t o0 = vcombine_u64(vget_low_u64(r0), vget_low_u64(r1));
+			uint64x2_t o1 = vcombine_u64(vget_high_u64(r0), vget_high_u64(r1));
+			vst1q_u8(reinterpret_cast<uint8_t *>(c0 + i * 8), vreinterpretq_u8_u64(o0));
+			vst1q_u8(reinterpret_cast<uint8_t *>(c1 + i * 8), vreinterpretq_u8_u64(o1));
+		}
+#endif
+		for (; i < mRowCount; i++) {
+			const char *row = mRows[i] + offset;
+			::memcpy(c0 + i * 8, row, 8);
+			::memcpy(c1 + i * 8, row + 8, 8);
+		}
+	}
+};
+}
+#endif
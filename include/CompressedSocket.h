@@ -0,0 +1,398 @@
+///////////////////////////////////////////////////////////
+/// @file	CompressedSocket.h
+/// @brief	UNIXドメインソケットのボディー圧縮
+/// @author	shuji-morimoto
+/// Copyright (C) 2013- Mamezou. All rights reserved.
+///////////////////////////////////////////////////////////
+
+#ifndef __PICO_IPC_COMPRESSED_SOCKET__
+#define __PICO_IPC_COMPRESSED_SOCKET__
+
+#include <string>
+#include <cstring>
+#include "ByteBuffer.h"
+#include "Error.h"
+#include "Crc32c.h"
+#include "Lz4Codec.h"
+#include "UnixDomainSocketClient.h"
+#include "UnixDomainSocketServer.h"
+
+namespace PicoIPC {
+
+///////////////////////////////////////////////////////////
+/// @struct	CompressedBodyHeader
+/// @brief	圧縮を有効にした送信側がすべてのボディーの先頭に付与するヘッダー
+///
+///  [Body]
+///               +-----------------+-------------------------+
+///   Category    |  Compress Header|  LZ4 Block / Raw Body   |
+///               +-----------------+-------------------------+
+///   Data Length |  16 byte        |  compressed / raw size  |
+///               +-----------------+-------------------------+
+///
+/// - formatで圧縮したか(FORMAT_LZ4)、そのままか(FORMAT_RAW)を示す
+///   (ボディーの内容から判定しないため、どのようなボディーも正しく受信できる)
+/// - magicはヘッダーが付与されていることの確認に使う
+/// - crcは圧縮前のボディーのCRC32C。伸張結果を確認する(FORMAT_RAWのときは0)
+///
+///////////////////////////////////////////////////////////
+struct CompressedBodyHeader
+{
+	unsigned int magic;   ///< COMPRESSED_BODY_MAGIC
+	unsigned int format;  ///< FORMAT_RAW, FORMAT_LZ4
+	unsigned int rawSize; ///< 圧縮前のサイズ
+	unsigned int crc;     ///< 圧縮前のCRC32C
+};
+
+///////////////////////////////////////////////////////////
+/// @class	BodyCompression
+/// @brief	ByteBufferのボディーを圧縮/伸張する
+///
+/// - 閾値以上のボディーをLZ4ブロック形式で圧縮する
+/// - 圧縮しても小さくならないときや閾値未満のときは圧縮しない
+/// - Compress()は圧縮しないときもCompressedBodyHeaderを付与し、Decompress()はヘッダーのformatに従う<br/>
+///   通信する双方で圧縮を有効にすること(ヘッダーのないボディーはDecompress()がエラーとする)
+/// - ByteBufferのAPIは変わらない(送信前にCompress()、受信後にDecompress()する)
+///
+///////////////////////////////////////////////////////////
+class BodyCompression
+{
+public:
+	/// CompressedBodyHeaderを示す値 "LZ4B"
+	static const unsigned int COMPRESSED_BODY_MAGIC = 0x42345a4c;
+
+	/// 圧縮していないボディー
+	static const unsigned int FORMAT_RAW = 0;
+	/// LZ4ブロック形式で圧縮したボディー
+	static const unsigned int FORMAT_LZ4 = 1;
+
+	/// デフォルトの圧縮する閾値
+	static const size_t DEFAULT_THRESHOLD = 4096;
+
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @param[in]	threshold 圧縮するボディーの最小サイズ
+	///////////////////////////////////////////////////////////
+	BodyCompression(size_t threshold = DEFAULT_THRESHOLD)
+		: mThreshold(threshold)
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		デストラクタ
+	///////////////////////////////////////////////////////////
+	virtual ~BodyCompression()
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		圧縮する閾値を取得する
+	/// @return		圧縮するボディーの最小サイズ
+	///////////////////////////////////////////////////////////
+	size_t Threshold() const
+	{
+		return mThreshold;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		閾値以上のボディーを圧縮し、CompressedBodyHeaderを付与する
+	/// @param[in,out]	body ボディー
+	/// @return		圧縮したときtrue(falseのときもFORMAT_RAWのヘッダーを付与する)
+	///////////////////////////////////////////////////////////
+	bool Compress(ByteBuffer &body) const
+	{
+		const std::string &raw = body.Data();
+		CompressedBodyHeader header;
+		header.magic = COMPRESSED_BODY_MAGIC;
+		header.format = FORMAT_RAW;
+		header.rawSize = static_cast<unsigned int>(raw.size());
+		header.crc = 0;
+		if (raw.size() >= mThreshold) {
+			std::string compressed(sizeof(CompressedBodyHeader) + Lz4Codec::CompressBound(raw.size()), '\0');
+			size_t size = Lz4Codec::Compress(raw.data(), raw.size(),
+				&compressed[sizeof(CompressedBodyHeader)], compressed.size() - sizeof(CompressedBodyHeader));
+			if (size < raw.size()) {
+				header.format = FORMAT_LZ4;
+				header.crc = Crc32c(raw.data(), raw.size());
+				::memcpy(&compressed[0], &header, sizeof(header));
+				compressed.resize(sizeof(CompressedBodyHeader) + size);
+				body = ByteBuffer(compressed);
+				return true;
+			}
+		}
+		std::string framed;
+		framed.reserve(sizeof(header) + raw.size());
+		framed.append(reinterpret_cast<const char *>(&header), sizeof(header));
+		framed.append(raw);
+		body = ByteBuffer(framed);
+		return false;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		CompressedBodyHeaderを取り除き、圧縮したボディーを伸張する
+	/// @param[in,out]	body ボディー
+	/// @return		Error ヘッダーがないときや伸張に失敗したときエラー内容がErrorに設定される
+	///////////////////////////////////////////////////////////
+	Error Decompress(ByteBuffer &body) const
+	{
+		const std::string &data = body.Data();
+		if (data.size() < sizeof(CompressedBodyHeader)) {
+			return Error::createError("decompress error [no header]");
+		}
+		CompressedBodyHeader header;
+		::memcpy(&header, data.data(), sizeof(header));
+		if (header.magic != COMPRESSED_BODY_MAGIC) {
+			return Error::createError("decompress error [no header]");
+		}
+		size_t size = data.size() - sizeof(header);
+		if (header.format == FORMAT_RAW) {
+			if (header.rawSize != size) {
+				return Error::createError("decompress error [raw size %u]", header.rawSize);
+			}
+			body = ByteBuffer(data.data() + sizeof(header), size);
+			return Error::createNoError();
+		}
+		if (header.format != FORMAT_LZ4) {
+			return Error::createError("decompress error [format %u]", header.format);
+		}
+		// LZ4の最大圧縮率(約255倍)を超えるサイズは壊れている
+		if (header.rawSize / 255 > size) {
+			return Error::createError("decompress error [raw size %u]", header.rawSize);
+		}
+		std::string raw(header.rawSize, '\0');
+		if (!Lz4Codec::Decompress(data.data() + sizeof(header), size, &raw[0], raw.size())) {
+			return Error::createError("decompress error [broken body]");
+		}
+		if (Crc32c(raw.data(), raw.size()) != header.crc) {
+			return Error::createError("decompress error [checksum mismatch]");
+		}
+		body = ByteBuffer(raw);
+		return Error::createNoError();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		圧縮したボディーか確認する
+	/// @param[in]	body Compress()したボディー
+	/// @return		FORMAT_LZ4のヘッダーが付与されているときtrue
+	///////////////////////////////////////////////////////////
+	static bool IsCompressed(const ByteBuffer &body)
+	{
+		const std::string &data = body.Data();
+		if (data.size() < sizeof(CompressedBodyHeader)) {
+			return false;
+		}
+		CompressedBodyHeader header;
+		::memcpy(&header, data.data(), sizeof(header));
+		return header.magic == COMPRESSED_BODY_MAGIC && header.format == FORMAT_LZ4;
+	}
+
+private:
+	size_t mThreshold; ///< 圧縮するボディーの最小サイズ
+};
+
+///////////////////////////////////////////////////////////
+/// @class	CompressedSocketClient
+/// @brief	リクエストを圧縮して送信するUnixDomainSocketClient
+///
+/// - UnixDomainSocketClientに圧縮の設定を追加する(ソケットごとの設定)
+/// - 閾値以上のリクエストを圧縮して送信し、応答を伸張する(すべてのボディーにCompressedBodyHeaderを付与する)
+/// - サーバー側はCompressedRequestReceiverでIRequestReceiverを包むこと
+///
+/// 使い方
+///   UnixDomainSocketClient client("/tmp/uds");
+///   CompressedSocketClient compressed(client, 4096);
+///   compressed.SendReceive(request, response);
+///
+///////////////////////////////////////////////////////////
+class CompressedSocketClient
+{
+public:
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @param[in]	client UnixDomainSocketClient
+	/// @param[in]	threshold 圧縮するリクエストの最小サイズ
+	///////////////////////////////////////////////////////////
+	CompressedSocketClient(UnixDomainSocketClient &client,
+		size_t threshold = BodyCompression::DEFAULT_THRESHOLD)
+		: mClient(client)
+		, mCompression(threshold)
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		デストラクタ
+	///////////////////////////////////////////////////////////
+	virtual ~CompressedSocketClient()
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		接続相手(サーバー)にリクエストを送信し、応答を受信する
+	/// @param[in]	request 送信データ
+	/// @param[out]	response 受信データ
+	/// @return		Error 失敗したときエラー内容がErrorに設定される
+	/// @note		UnixDomainSocketClient::SendReceive()と同じ。requestは変更しない
+	///////////////////////////////////////////////////////////
+	Error SendReceive(ByteBuffer &request, ByteBuffer &response)
+	{
+		ByteBuffer body(request);
+		mCompression.Compress(body);
+		Error err = mClient.SendReceive(body, response);
+		if (err) {
+			return err;
+		}
+		return mCompression.Decompress(response);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		UnixDomainSocketClientを取得する
+	/// @return		UnixDomainSocketClient
+	///////////////////////////////////////////////////////////
+	UnixDomainSocketClient &Client()
+	{
+		return mClient;
+	}
+
+private:
+	UnixDomainSocketClient &mClient;      ///< UnixDomainSocketClient
+	BodyCompression         mCompression; ///< 圧縮の設定
+
+	/// コピー禁止
+	CompressedSocketClient(const CompressedSocketClient &);
+	/// 代入禁止
+	CompressedSocketClient &operator=(const CompressedSocketClient &);
+};
+
+///////////////////////////////////////////////////////////
+/// @class	CompressedRequestReceiver
+/// @brief	圧縮されたリクエストを伸張してIRequestReceiverに渡す
+///
+/// - 伸張したリクエストを包んだIRequestReceiverに渡し、閾値以上の応答を圧縮する(応答には常にヘッダーを付与する)
+/// - 伸張に失敗したときはIRequestReceiver::ReceiveError()をコールし、空の応答を返す
+/// - Notify()するときはNotify()の前に必ずCompress()すること(CompressedNotifyReceiverはヘッダーのない通知を破棄する)
+///
+/// 使い方
+///   UnixDomainSocketServer server("/tmp/uds");
+///   RequestReceiverImpl impl;
+///   CompressedRequestReceiver receiver(&impl, 4096);
+///   server.SetReceiver(&receiver);
+///
+///////////////////////////////////////////////////////////
+class CompressedRequestReceiver : public IRequestReceiver
+{
+public:
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @param[in]	receiver 伸張したリクエストを受け取るIRequestReceiver
+	/// @param[in]	threshold 圧縮する応答の最小サイズ
+	///////////////////////////////////////////////////////////
+	CompressedRequestReceiver(IRequestReceiver *receiver,
+		size_t threshold = BodyCompression::DEFAULT_THRESHOLD)
+		: mReceiver(receiver)
+		, mCompression(threshold)
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		デストラクタ
+	///////////////////////////////////////////////////////////
+	virtual ~CompressedRequestReceiver()
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		閾値以上のボディーを圧縮する
+	/// @param[in,out]	body ボディー
+	/// @return		圧縮したときtrue
+	/// @note		UnixDomainSocketServer::Notify()の前に利用する
+	///////////////////////////////////////////////////////////
+	bool Compress(ByteBuffer &body) const
+	{
+		return mCompression.Compress(body);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		implements IRequestReceiver::Received()
+	///////////////////////////////////////////////////////////
+	void Received(ByteBuffer &request, ByteBuffer &response)
+	{
+		Error err = mCompression.Decompress(request);
+		if (err) {
+			mReceiver->ReceiveError(err);
+			return;
+		}
+		mReceiver->Received(request, response);
+		mCompression.Compress(response);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		implements IRequestReceiver::ReceiveError()
+	///////////////////////////////////////////////////////////
+	void ReceiveError(const Error &error)
+	{
+		mReceiver->ReceiveError(error);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		implements IRequestReceiver::ResponseError()
+	///////////////////////////////////////////////////////////
+	void ResponseError(const Error &error)
+	{
+		mReceiver->ResponseError(error);
+	}
+
+private:
+	IRequestReceiver *mReceiver;    ///< 伸張したリクエストを受け取るIRequestReceiver
+	BodyCompression   mCompression; ///< 圧縮の設定
+
+	/// コピー禁止
+	CompressedRequestReceiver(const CompressedRequestReceiver &);
+	/// 代入禁止
+	CompressedRequestReceiver &operator=(const CompressedRequestReceiver &);
+};
+
+///////////////////////////////////////////////////////////
+/// @class	CompressedNotifyReceiver
+/// @brief	圧縮された通知を伸張してINotifyReceiverに渡す
+/// @note		伸張に失敗した通知は破棄する
+///////////////////////////////////////////////////////////
+class CompressedNotifyReceiver : public INotifyReceiver
+{
+public:
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @param[in]	receiver 伸張した通知を受け取るINotifyReceiver
+	///////////////////////////////////////////////////////////
+	CompressedNotifyReceiver(INotifyReceiver *receiver)
+		: mReceiver(receiver)
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		デストラクタ
+	///////////////////////////////////////////////////////////
+	virtual ~CompressedNotifyReceiver()
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		implements INotifyReceiver::ReceiveNotify()
+	///////////////////////////////////////////////////////////
+	void ReceiveNotify(ByteBuffer &update)
+	{
+		if (!mCompression.Decompress(update)) {
+			mReceiver->ReceiveNotify(update);
+		}
+	}
+
+private:
+	INotifyReceiver *mReceiver;    ///< 伸張した通知を受け取るINotifyReceiver
+	BodyCompression  mCompression; ///< 伸張のみ利用する
+
+	/// コピー禁止
+	CompressedNotifyReceiver(const CompressedNotifyReceiver &);
+	/// 代入禁止
+	CompressedNotifyReceiver &operator=(const CompressedNotifyReceiver &);
+};
+}
+#endif
@@ -0,0 +1,160 @@
+///////////////////////////////////////////////////////////
+/// @file	ConditionVariable.h
+/// @brief	Mutexに対応付けた条件変数
+/// @author	shuji-morimoto
+/// Copyright (C) 2013- Mamezou. All rights reserved.
+///////////////////////////////////////////////////////////
+
+#ifndef __PICO_IPC_CONDITION_VARIABLE__
+#define __PICO_IPC_CONDITION_VARIABLE__
+
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+#include "Mutex.h"
+#include "Timespec.h"
+
+namespace PicoIPC {
+
+///////////////////////////////////////////////////////////
+/// @class	ConditionVariable
+/// @brief	Mutexに対応付けた条件変数(CLOCK_MONOTONIC)
+///
+/// - Mutexが保持する条件変数は1つのため、待つ条件が複数あるとConditionBroadcast()で
+///   関係のないスレッドまで起こすことになる。条件ごとにConditionVariableを作り、
+///   その条件を待つスレッドだけを起こす
+/// - タイムアウトはCLOCK_MONOTONICで計時するため、時刻を変更しても待機時間はずれない
+/// - Wait(), TimedWait(), Signal(), Broadcast()は対応付けたMutexをロックして呼び出すこと
+///
+/// 使い方
+///   Mutex mutex;
+///   ConditionVariable notEmpty(mutex);
+///   ConditionVariable notFull(mutex);
+///
+///   mutex.Lock();
+///   while (queue.empty()) {
+///       if (!notEmpty.TimedWait(100)) { ... }  // タイムアウト
+///   }
+///   queue.pop_front();
+///   notFull.Signal();                          // 送信側のみ起こす
+///   mutex.Unlock();
+///
+///////////////////////////////////////////////////////////
+class ConditionVariable
+{
+public:
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @param[in]	mutex 対応付けるMutex(ConditionVariableより後に破棄すること)
+	///////////////////////////////////////////////////////////
+	explicit ConditionVariable(Mutex &mutex)
+		: mMutex(mutex)
+	{
+		pthread_condattr_t attr;
+		::pthread_condattr_init(&attr);
+		::pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+		::pthread_cond_init(&mCondition, &attr);
+		::pthread_condattr_destroy(&attr);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		デストラクタ
+	///////////////////////////////////////////////////////////
+	virtual ~ConditionVariable()
+	{
+		::pthread_cond_destroy(&mCondition);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		対応付けたMutexを取得する
+	/// @return		Mutex
+	///////////////////////////////////////////////////////////
+	Mutex &GetMutex()
+	{
+		return mMutex;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		起こされるまで待機する
+	/// @note		待機中はMutexのロックは一時的に解除され、戻ったときはロックが獲得された状態となる
+	/// @note		条件を満たさずに起きることがある(spurious wakeup)ため、条件をループで確認すること
+	///////////////////////////////////////////////////////////
+	void Wait()
+	{
+		::pthread_cond_wait(&mCondition, &mMutex.mMutex);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		起こされるか指定時間経過するまで待機する
+	/// @param[in]	millisec ミリ秒
+	/// @return		起こされたときtrue、タイムアウトしたときfalse
+	///////////////////////////////////////////////////////////
+	bool TimedWait(unsigned long millisec)
+	{
+		timespec abs = Timespec::After(CLOCK_MONOTONIC, millisec);
+		return WaitUntil(abs);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		条件を満たすか指定時間経過するまで待機する
+	/// @param[in]	millisec ミリ秒
+	/// @param[in]	predicate 条件(bool operator()() const)
+	/// @return		条件を満たしたときtrue、タイムアウトしたときfalse
+	/// @note		起こされても条件を満たさないときは残り時間だけ待ち直す
+	///////////////////////////////////////////////////////////
+	template <class Predicate>
+	bool TimedWait(unsigned long millisec, Predicate predicate)
+	{
+		timespec abs = Timespec::After(CLOCK_MONOTONIC, millisec);
+		while (!predicate()) {
+			if (!WaitUntil(abs)) {
+				return predicate();
+			}
+		}
+		return true;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		条件を満たすまで待機する
+	/// @param[in]	predicate 条件(bool operator()() const)
+	///////////////////////////////////////////////////////////
+	template <class Predicate>
+	void Wait(Predicate predicate)
+	{
+		while (!predicate()) {
+			Wait();
+		}
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		待機しているスレッドの1つを起こす
+	///////////////////////////////////////////////////////////
+	void Signal()
+	{
+		::pthread_cond_signal(&mCondition);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		待機しているすべてのスレッドを起こす
+	///////////////////////////////////////////////////////////
+	void Broadcast()
+	{
+		::pthread_cond_broadcast(&mCondition);
+	}
+
+private:
+	Mutex           &mMutex;     ///< 対応付けたMutex
+	::pthread_cond_t mCondition; ///< 条件変数(CLOCK_MONOTONIC)
+
+	bool WaitUntil(const timespec &abs)
+	{
+		return ::pthread_cond_timedwait(&mCondition, &mMutex.mMutex, &abs) != ETIMEDOUT;
+	}
+
+	/// コピー禁止
+	ConditionVariable(const ConditionVariable &);
+	/// 代入禁止
+	ConditionVariable &operator=(const ConditionVariable &);
+};
+}
+#endif
@@ -0,0 +1,148 @@
+///////////////////////////////////////////////////////////
+/// @file	CountDownLatch.h
+/// @brief	futexによる軽量なカウントダウンラッチ
+/// @author	shuji-morimoto
+/// Copyright (C) 2013- Mamezou. All rights reserved.
+///////////////////////////////////////////////////////////
+
+#ifndef __PICO_IPC_COUNT_DOWN_LATCH__
+#define __PICO_IPC_COUNT_DOWN_LATCH__
+
+#include "Futex.h"
+#include "Timespec.h"
+
+namespace PicoIPC {
+
+///////////////////////////////////////////////////////////
+/// @class	BasicCountDownLatch
+/// @brief	CountDown()が指定回数呼び出されるまで待機できるラッチ(1回限り)
+///
+/// - N個のスレッドの初期化完了やN個の応答の到着を待つ
+/// - 待機しているスレッドがいないときのCountDown()と、0になった後のWait()はシステムコールを呼び出さない
+/// - IsSharedがtrueのときはプロセス間で共有できる(SharedCountDownLatch)
+///
+///////////////////////////////////////////////////////////
+template <bool IsShared>
+struct BasicCountDownLatch
+{
+	volatile int mCount;   ///< 残りの回数(直接操作しないこと)
+	volatile int mWaiters; ///< 待機しているスレッドの数(直接操作しないこと)
+
+	///////////////////////////////////////////////////////////
+	/// @brief		回数を設定する
+	/// @param[in]	count 回数
+	/// @note		待機しているスレッドがいないときに呼び出すこと
+	///////////////////////////////////////////////////////////
+	void Init(int count)
+	{
+		mCount = (count < 0) ? 0 : count;
+		mWaiters = 0;
+		__sync_synchronize();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		回数を1減らし、0になったときは待機しているスレッドをすべて起こす
+	/// @note		0のときは何もしない
+	///////////////////////////////////////////////////////////
+	void CountDown()
+	{
+		int count;
+		do {
+			count = mCount;
+			if (count <= 0) {
+				return;
+			}
+		} while (!__sync_bool_compare_and_swap(&mCount, count, count - 1));
+		if (count == 1 && mWaiters != 0) {
+			Futex::WakeAll(&mCount, IsShared);
+		}
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		残りの回数を取得する
+	/// @return		回数
+	///////////////////////////////////////////////////////////
+	int Count() const
+	{
+		int count = mCount;
+		__sync_synchronize();
+		return count;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		回数が0になるまで待機する
+	///////////////////////////////////////////////////////////
+	void Wait()
+	{
+		int count;
+		while ((count = Count()) > 0) {
+			__sync_fetch_and_add(&mWaiters, 1);
+			// mWaitersを増やした後に0になっていればmCountが異なるためすぐに戻る
+			Futex::Wait(&mCount, count, IsShared);
+			__sync_fetch_and_sub(&mWaiters, 1);
+		}
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		回数が0になるか指定時間経過するまで待機する
+	/// @param[in]	millisec ミリ秒
+	/// @return		0になったときtrue、タイムアウトしたときfalse
+	///////////////////////////////////////////////////////////
+	bool TimedWait(unsigned long millisec)
+	{
+		int count = Count();
+		if (count <= 0) {
+			return true;
+		}
+		timespec deadline = Timespec::After(CLOCK_MONOTONIC, millisec);
+		timespec remaining;
+		for (; count > 0; count = Count()) {
+			if (!Timespec::Remaining(CLOCK_MONOTONIC, deadline, remaining)) {
+				return false;
+			}
+			__sync_fetch_and_add(&mWaiters, 1);
+			Futex::Wait(&mCount, count, IsShared, &remaining);
+			__sync_fetch_and_sub(&mWaiters, 1);
+		}
+		return true;
+	}
+};
+
+///////////////////////////////////////////////////////////
+/// @brief	共有メモリ上に配置するカウントダウンラッチ
+/// @note	POD型のため共有メモリの構造体のメンバにできる。所有するプロセスがInit()すること
+///////////////////////////////////////////////////////////
+typedef BasicCountDownLatch<true> SharedCountDownLatch;
+
+///////////////////////////////////////////////////////////
+/// @class	CountDownLatch
+/// @brief	プロセス内のスレッド間で利用するカウントダウンラッチ
+///
+/// 使い方
+///   CountDownLatch ready(workerCount);
+///   // 各ワーカー
+///   ready.CountDown();
+///   // 待機するスレッド
+///   ready.Wait();
+///
+///////////////////////////////////////////////////////////
+class CountDownLatch : public BasicCountDownLatch<false>
+{
+public:
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @param[in]	count 回数
+	///////////////////////////////////////////////////////////
+	explicit CountDownLatch(int count)
+	{
+		Init(count);
+	}
+
+private:
+	/// コピー禁止
+	CountDownLatch(const CountDownLatch &);
+	/// 代入禁止
+	CountDownLatch &operator=(const CountDownLatch &);
+};
+}
+#endif
@@ -0,0 +1,233 @@
+///////////////////////////////////////////////////////////
+/// @file	Crc32c.h
+/// @brief	CRC32C(Castagnoli)チェックサム
+/// @author	shuji-morimoto
+/// Copyright (C) 2013- Mamezou. All rights reserved.
+///////////////////////////////////////////////////////////
+
+#ifndef __PICO_IPC_CRC32C__
+#define __PICO_IPC_CRC32C__
+
+#include <cstring>
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <cpuid.h>
+#endif
+#if defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+namespace PicoIPC {
+
+///////////////////////////////////////////////////////////
+/// @class	Crc32cTable
+/// @brief	スライスバイ8方式のCRC32Cテーブル
+/// @note		CRC命令を利用できないCPU(Cortex-A9等)で利用する
+///////////////////////////////////////////////////////////
+class Crc32cTable
+{
+public:
+	/// CRC32C(反転)多項式
+	static const unsigned int POLYNOMIAL = 0x82f63b78;
+
+	unsigned int table[8][256]; ///< テーブル
+
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	///////////////////////////////////////////////////////////
+	Crc32cTable()
+	{
+		for (unsigned int i = 0; i < 256; i++) {
+			unsigned int crc = i;
+			for (int j = 0; j < 8; j++) {
+				crc = (crc & 1) ? (crc >> 1) ^ POLYNOMIAL : crc >> 1;
+			}
+			table[0][i] = crc;
+		}
+		for (unsigned int i = 0; i < 256; i++) {
+			for (int k = 1; k < 8; k++) {
+				table[k][i] = (table[k - 1][i] >> 8) ^ table[0][table[k - 1][i] & 0xff];
+			}
+		}
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		テーブルを取得する
+	/// @return		Crc32cTable
+	/// @note		最初の呼び出しで生成する
+	///////////////////////////////////////////////////////////
+	static const Crc32cTable &Instance()
+	{
+		static const Crc32cTable instance;
+		return instance;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		CRCを更新する
+	/// @param[in]	crc 反転済みのCRC
+	/// @param[in]	data データ
+	/// @param[in]	size データサイズ
+	/// @return		反転済みのCRC
+	///////////////////////////////////////////////////////////
+	unsigned int Update(unsigned int crc, const unsigned char *data, size_t size) const
+	{
+		for (; size >= 8; size -= 8, data += 8) {
+			unsigned int low;
+			unsigned int high;
+			::memcpy(&low, data, 4);
+			::memcpy(&high, data + 4, 4);
+			// リトルエンディアン(x86, ARM)を前提とする
+			low ^= crc;
+			crc = table[7][low & 0xff] ^ table[6][(low >> 8) & 0xff]
+				^ table[5][(low >> 16) & 0xff] ^ table[4][low >> 24]
+				^ table[3][high & 0xff] ^ table[2][(high >> 8) & 0xff]
+				^ table[1][(high >> 16) & 0xff] ^ table[0][high >> 24];
+		}
+		for (; size > 0; size--, data++) {
+			crc = (crc >> 8) ^ table[0][(crc ^ *data) & 0xff];
+		}
+		return crc;
+	}
+};
+
+#if defined(__i386__) || defined(__x86_64__)
+///////////////////////////////////////////////////////////
+/// @brief		SSE4.2のcrc32命令でCRCを更新する
+/// @param[in]	crc 反転済みのCRC
+/// @param[in]	data データ
+/// @param[in]	size データサイズ
+/// @return		反転済みのCRC
+/// @note		-msse4.2なしでビルドしてもこの関数だけSSE4.2の命令で生成する
+///////////////////////////////////////////////////////////
+__attribute__((target("sse4.2")))
+inline unsigned int Crc32cUpdateSse42(unsigned int crc, const unsigned char *data, size_t size)
+{
+	for (; size >= 4; size -= 4, data += 4) {
+		unsigned int v;
+		::memcpy(&v, data, 4);
+		crc = __builtin_ia32_crc32si(crc, v);
+	}
+	for (; size > 0; size--, data++) {
+		crc = __builtin_ia32_crc32qi(crc, *data);
+	}
+	return crc;
+}
+
+///////////////////////////////////////////////////////////
+/// @brief		cpuid命令でSSE4.2のサポートを調べる
+/// @return		サポートしているときtrue
+///////////////////////////////////////////////////////////
+inline bool DetectSse42()
+{
+	unsigned int eax = 0;
+	unsigned int ebx = 0;
+	unsigned int ecx = 0;
+	unsigned int edx = 0;
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+		return false;
+	}
+	return (ecx & bit_SSE4_2) != 0;
+}
+
+///////////////////////////////////////////////////////////
+/// @brief		CPUがSSE4.2をサポートしているか確認する
+/// @return		サポートしているときtrue
+/// @note		判定結果は最初の呼び出しで確定する
+///////////////////////////////////////////////////////////
+inline bool HasSse42()
+{
+	static const bool supported = DetectSse42();
+	return supported;
+}
+#endif
+
+#if defined(__ARM_FEATURE_CRC32)
+///////////////////////////////////////////////////////////
+/// @brief		ARMv8のcrc32c命令でCRCを更新する
+/// @param[in]	crc 反転済みのCRC
+/// @param[in]	data データ
+/// @param[in]	size データサイズ
+/// @return		反転済みのCRC
+///////////////////////////////////////////////////////////
+inline unsigned int Crc32cUpdateArm(unsigned int crc, const unsigned char *data, size_t size)
+{
+	for (; size >= 4; size -= 4, data += 4) {
+		unsigned int v;
+		::memcpy(&v, data, 4);
+		crc = __crc32cw(crc, v);
+	}
+	for (; size > 0; size--, data++) {
+		crc = __crc32cb(crc, *data);
+	}
+	return crc;
+}
+#endif
+
+///////////////////////////////////////////////////////////
+/// @brief		CRC32Cを計算する
+/// @param[in]	data データ
+/// @param[in]	size データサイズ
+/// @param[in]	crc 分割して計算するときは前回の戻り値、最初は0
+/// @return		CRC32C
+/// @note		x86ではSSE4.2のcrc32命令(CPUが対応している場合)、ARMv8ではcrc32c命令、
+///				それ以外(Cortex-A9等)ではスライスバイ8方式で計算する
+/// @note		Crc32c("123456789", 9) == 0xe3069283
+///////////////////////////////////////////////////////////
+inline unsigned int Crc32c(const void *data, size_t size, unsigned int crc = 0)
+{
+	const unsigned char *p = static_cast<const unsigned char *>(data);
+	crc = ~crc;
+#if defined(__ARM_FEATURE_CRC32)
+	crc = Crc32cUpdateArm(crc, p, size);
+#else
+#if defined(__i386__) || defined(__x86_64__)
+	if (HasSse42()) {
+		return ~Crc32cUpdateSse42(crc, p, size);
+	}
+#endif
+	crc = Crc32cTable::Instance().Update(crc, p, size);
+#endif
+	return ~crc;
+}
+
+///////////////////////////////////////////////////////////
+/// @struct	ChecksummedData
+/// @brief	CRC32C付きで共有メモリーに配置するデータ
+///
+/// - 書き込み側はdataを更新した後にSeal()でCRCを記録する
+/// - 読み出し側はIsValid()で書き込み途中の異常終了等による破損を検出できる
+/// - POD型のためSharedMemory/SharedMemoryContextにそのまま配置できる
+///
+/// 使い方
+///   ChecksummedData<SharedArea1> *area = shm->Data<ChecksummedData<SharedArea1> >();
+///   area->data.sys.power_on = 1;   // 書き込み側(ロックして更新する)
+///   area->Seal();
+///
+///   if (!area->IsValid()) { ... }  // 読み出し側
+///
+///////////////////////////////////////////////////////////
+template <class T>
+struct ChecksummedData
+{
+	T            data;     ///< データ
+	unsigned int checksum; ///< dataのCRC32C
+
+	///////////////////////////////////////////////////////////
+	/// @brief		dataのCRCを記録する
+	///////////////////////////////////////////////////////////
+	void Seal()
+	{
+		checksum = Crc32c(&data, sizeof(T));
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		dataが記録したCRCと一致するか確認する
+	/// @return		一致するときtrue
+	///////////////////////////////////////////////////////////
+	bool IsValid() const
+	{
+		return checksum == Crc32c(&data, sizeof(T));
+	}
+};
+}
+#endif
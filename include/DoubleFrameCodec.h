@@ -0,0 +1,529 @@
+///////////////////////////////////////////////////////////
+/// @file	DoubleFrameCodec.h
+/// @brief	連続するdouble配列(フレーム)のXOR圧縮
+/// @author	shuji-morimoto
+/// Copyright (C) 2013- Mamezou. All rights reserved.
+///////////////////////////////////////////////////////////
+
+#ifndef __PICO_IPC_DOUBLE_FRAME_CODEC__
+#define __PICO_IPC_DOUBLE_FRAME_CODEC__
+
+#include <string>
+#include <vector>
+#include <cstring>
+
+namespace PicoIPC {
+
+///////////////////////////////////////////////////////////
+/// @class	BitWriter
+/// @brief	ビット単位でstd::stringに書き込む(上位ビットから詰める)
+///////////////////////////////////////////////////////////
+class BitWriter
+{
+public:
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @param[in]	out 書き込み先
+	///////////////////////////////////////////////////////////
+	BitWriter(std::string &out)
+		: mOut(out)
+		, mBits(0)
+		, mCount(0)
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		値の下位ビットを書き込む
+	/// @param[in]	value 値
+	/// @param[in]	bits ビット数(1～64)
+	///////////////////////////////////////////////////////////
+	void Write(unsigned long long value, unsigned int bits)
+	{
+		if (bits > 32) {
+			Write(value >> 32, bits - 32);
+			bits = 32;
+		}
+		mBits = (mBits << bits) | (value & Mask(bits));
+		mCount += bits;
+		while (mCount >= 8) {
+			mCount -= 8;
+			mOut += static_cast<char>(mBits >> mCount);
+		}
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		残りのビットを0で埋めて書き込む
+	///////////////////////////////////////////////////////////
+	void Flush()
+	{
+		if (mCount > 0) {
+			Write(0, 8 - mCount);
+		}
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		下位ビットのマスクを取得する
+	/// @param[in]	bits ビット数(0～64)
+	/// @return		マスク
+	///////////////////////////////////////////////////////////
+	static unsigned long long Mask(unsigned int bits)
+	{
+		return bits >= 64 ? ~0ULL : (1ULL << bits) - 1;
+	}
+
+private:
+	std::string        &mOut;   ///< 書き込み先
+	unsigned long long  mBits;  ///< 書き込み前のビット
+	unsigned int        mCount; ///< 書き込み前のビット数(8未満)
+};
+
+///////////////////////////////////////////////////////////
+/// @class	BitReader
+/// @brief	BitWriterで書き込んだビット列を読み出す
+///////////////////////////////////////////////////////////
+class BitReader
+{
+public:
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @param[in]	data データ
+	/// @param[in]	size データサイズ
+	///////////////////////////////////////////////////////////
+	BitReader(const char *data, size_t size)
+		: mData(reinterpret_cast<const unsigned char *>(data))
+		, mSize(size)
+		, mPosition(0)
+		, mBits(0)
+		, mCount(0)
+		, mIsOverrun(false)
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		ビットを読み出す
+	/// @param[in]	bits ビット数(1～64)
+	/// @return		値
+	/// @note		データが足りないときは0を返し、IsOverrun()がtrueとなる
+	///////////////////////////////////////////////////////////
+	unsigned long long Read(unsigned int bits)
+	{
+		if (bits > 32) {
+			unsigned long long high = Read(bits - 32);
+			return (high << 32) | Read(32);
+		}
+		while (mCount < bits) {
+			if (mPosition >= mSize) {
+				mIsOverrun = true;
+				return 0;
+			}
+			mBits = (mBits << 8) | mData[mPosition++];
+			mCount += 8;
+		}
+		mCount -= bits;
+		return (mBits >> mCount) & BitWriter::Mask(bits);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		データを超えて読み出そうとしたか確認する
+	/// @return		超えたときtrue
+	///////////////////////////////////////////////////////////
+	bool IsOverrun() const
+	{
+		return mIsOverrun;
+	}
+
+private:
+	const unsigned char *mData;      ///< データ
+	size_t               mSize;      ///< データサイズ
+	size_t               mPosition;  ///< 次に読み出すbyte位置
+	unsigned long long   mBits;      ///< 読み出し済みのビット
+	unsigned int         mCount;     ///< 読み出し済みのビット数
+	bool                 mIsOverrun; ///< データを超えて読み出そうとしたときtrue
+};
+
+///////////////////////////////////////////////////////////
+/// @class	DoubleFrameCodec
+/// @brief	DoubleFrameEncoder/DoubleFrameDecoderの共通定義
+///
+///  [エンコードしたフレーム]
+///   +--------+-------------------------------------------+
+///   | flags  | 列ごとのビット列(byte境界まで0で埋める)      |
+///   | 1 byte |                                           |
+///   +--------+-------------------------------------------+
+///
+///  [列ごとのビット列] 直前のフレームの同じ列とのXOR値を符号化する(Gorilla方式)
+///   '0'                     XOR値が0(値が変わらない)
+///   '10' + 有効ビット       先頭/末尾の0の数が前回の範囲に収まる
+///   '11' + 先頭の0の数(5bit) + 有効ビット数-1(6bit) + 有効ビット
+///
+/// - キーフレーム(FLAG_KEY)は直前の値を0として符号化するため単独で復号できる
+///
+///////////////////////////////////////////////////////////
+class DoubleFrameCodec
+{
+public:
+	/// キーフレームを示すフラグ
+	static const unsigned char FLAG_KEY = 0x01;
+
+protected:
+	///////////////////////////////////////////////////////////
+	/// @struct	Column
+	/// @brief	列ごとの直前の状態
+	///////////////////////////////////////////////////////////
+	struct Column
+	{
+		unsigned long long previous; ///< 直前の値(ビット列)
+		unsigned int       leading;  ///< 直前の先頭の0の数
+		unsigned int       trailing; ///< 直前の末尾の0の数
+		bool               hasWindow;///< leading/trailingが有効なときtrue
+	};
+
+	///////////////////////////////////////////////////////////
+	/// @brief		列の状態をキーフレームの状態に戻す
+	/// @param[in,out]	columns 列の状態
+	///////////////////////////////////////////////////////////
+	static void ResetColumns(std::vector<Column> &columns)
+	{
+		for (size_t i = 0; i < columns.size(); i++) {
+			columns[i].previous = 0;
+			columns[i].leading = 0;
+			columns[i].trailing = 0;
+			columns[i].hasWindow = false;
+		}
+	}
+
+	static unsigned long long ToBits(double value)
+	{
+		unsigned long long bits;
+		::memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	}
+
+	static double ToDouble(unsigned long long bits)
+	{
+		double value;
+		::memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+};
+
+///////////////////////////////////////////////////////////
+/// @class	DoubleFrameEncoder
+/// @brief	連続するdouble配列(フレーム)を直前のフレームとのXORで圧縮する
+///
+/// - 軸角度のように前回からわずかしか変化しない値が多いほど小さくなる
+/// - keyIntervalフレームごとにキーフレームを挿入する(途中から復号できる位置)
+/// - ByteBuffer, StaticByteBufferにはサイズ(int) + バイト配列(std::stringと同じ形式)で追加する
+///
+/// 使い方
+///   DoubleFrameEncoder encoder(33);
+///   encoder.Encode(frame.axis, bb);
+///
+///   DoubleFrameDecoder decoder(33);
+///   decoder.Decode(bb, axis);
+///
+///////////////////////////////////////////////////////////
+class DoubleFrameEncoder : public DoubleFrameCodec
+{
+public:
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @param[in]	width フレームのdoubleの数
+	/// @param[in]	keyInterval キーフレームの間隔(0のときは最初のフレームのみ)
+	///////////////////////////////////////////////////////////
+	DoubleFrameEncoder(size_t width, unsigned int keyInterval = 0)
+		: mColumns(width)
+		, mKeyInterval(keyInterval)
+		, mCount(0)
+	{
+		mData.reserve(1 + width * 10);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		デストラクタ
+	///////////////////////////////////////////////////////////
+	virtual ~DoubleFrameEncoder()
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		フレームのdoubleの数を取得する
+	/// @return		doubleの数
+	///////////////////////////////////////////////////////////
+	size_t Width() const
+	{
+		return mColumns.size();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		次のフレームをキーフレームにする
+	///////////////////////////////////////////////////////////
+	void Reset()
+	{
+		mCount = 0;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		フレームを圧縮する
+	/// @param[in]	frame Width()個のdouble
+	/// @return		圧縮したフレーム(次のEncode()まで有効)
+	///////////////////////////////////////////////////////////
+	const std::string &Encode(const double *frame)
+	{
+		bool isKey = (mCount == 0);
+		if (isKey) {
+			ResetColumns(mColumns);
+		}
+		mCount++;
+		if (mKeyInterval != 0 && mCount >= mKeyInterval) {
+			mCount = 0;
+		}
+
+		mData.clear();
+		mData += static_cast<char>(isKey ? FLAG_KEY : 0);
+		BitWriter writer(mData);
+		for (size_t i = 0; i < mColumns.size(); i++) {
+			EncodeValue(writer, mColumns[i], ToBits(frame[i]));
+		}
+		writer.Flush();
+		return mData;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		フレームを圧縮して追加する
+	/// @param[in]	frame Width()個のdouble
+	/// @param[out]	out ByteBuffer, StaticByteBuffer
+	///////////////////////////////////////////////////////////
+	template <class Buffer>
+	void Encode(const double *frame, Buffer &out)
+	{
+		out.Append(Encode(frame));
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		フレームを圧縮して追加する
+	/// @param[in]	frame Width()個のdouble
+	/// @param[out]	out ByteBuffer, StaticByteBuffer
+	///////////////////////////////////////////////////////////
+	template <class Buffer>
+	void Encode(const std::vector<double> &frame, Buffer &out)
+	{
+		out.Append(Encode(&frame[0]));
+	}
+
+private:
+	std::vector<Column> mColumns;     ///< 列ごとの直前の状態
+	unsigned int        mKeyInterval; ///< キーフレームの間隔
+	unsigned int        mCount;       ///< 直前のキーフレームからのフレーム数
+	std::string         mData;        ///< 圧縮したフレーム
+
+	static void EncodeValue(BitWriter &writer, Column &column, unsigned long long bits)
+	{
+		unsigned long long x = bits ^ column.previous;
+		column.previous = bits;
+		if (x == 0) {
+			writer.Write(0, 1);
+			return;
+		}
+		unsigned int leading = __builtin_clzll(x);
+		unsigned int trailing = __builtin_ctzll(x);
+		if (leading > 31) {
+			leading = 31;
+		}
+		if (column.hasWindow && leading >= column.leading && trailing >= column.trailing) {
+			writer.Write(2, 2);
+			writer.Write(x >> column.trailing, 64 - column.leading - column.trailing);
+			return;
+		}
+		unsigned int meaningful = 64 - leading - trailing;
+		writer.Write(3, 2);
+		writer.Write(leading, 5);
+		writer.Write(meaningful - 1, 6);
+		writer.Write(x >> trailing, meaningful);
+		column.leading = leading;
+		column.trailing = trailing;
+		column.hasWindow = true;
+	}
+
+	/// コピー禁止
+	DoubleFrameEncoder(const DoubleFrameEncoder &);
+	/// 代入禁止
+	DoubleFrameEncoder &operator=(const DoubleFrameEncoder &);
+};
+
+///////////////////////////////////////////////////////////
+/// @class	DoubleFrameDecoder
+/// @brief	DoubleFrameEncoderで圧縮したフレームを復号する
+///
+/// - 圧縮した順に復号すること
+/// - キーフレームを復号するまでは差分のフレームを復号できない(falseを返す)
+///
+///////////////////////////////////////////////////////////
+class DoubleFrameDecoder : public DoubleFrameCodec
+{
+public:
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @param[in]	width フレームのdoubleの数
+	///////////////////////////////////////////////////////////
+	DoubleFrameDecoder(size_t width)
+		: mColumns(width)
+		, mIsSynced(false)
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		デストラクタ
+	///////////////////////////////////////////////////////////
+	virtual ~DoubleFrameDecoder()
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		フレームのdoubleの数を取得する
+	/// @return		doubleの数
+	///////////////////////////////////////////////////////////
+	size_t Width() const
+	{
+		return mColumns.size();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		次のキーフレームまで復号しない状態に戻す
+	/// @note		読み出し位置を移動したときに呼び出す
+	///////////////////////////////////////////////////////////
+	void Reset()
+	{
+		mIsSynced = false;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		キーフレームを復号済みか確認する
+	/// @return		差分のフレームを復号できるときtrue
+	///////////////////////////////////////////////////////////
+	bool IsSynced() const
+	{
+		return mIsSynced;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		圧縮したフレームを復号する
+	/// @param[in]	data 圧縮したフレーム
+	/// @param[in]	size 圧縮したフレームのサイズ
+	/// @param[out]	frame Width()個のdouble
+	/// @return		復号したときtrue
+	/// @note		キーフレームを復号する前の差分のフレーム、壊れたフレームはfalseを返す
+	///////////////////////////////////////////////////////////
+	bool Decode(const char *data, size_t size, double *frame)
+	{
+		if (size < 1) {
+			return false;
+		}
+		bool isKey = (static_cast<unsigned char>(data[0]) & FLAG_KEY) != 0;
+		if (isKey) {
+			ResetColumns(mColumns);
+			mIsSynced = true;
+		} else if (!mIsSynced) {
+			return false;
+		}
+		BitReader reader(data + 1, size - 1);
+		for (size_t i = 0; i < mColumns.size(); i++) {
+			if (!DecodeValue(reader, mColumns[i])) {
+				mIsSynced = false;
+				return false;
+			}
+		}
+		for (size_t i = 0; i < mColumns.size(); i++) {
+			frame[i] = ToDouble(mColumns[i].previous);
+		}
+		return true;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		DoubleFrameEncoder::Encode()で追加したフレームを取り出して復号する
+	/// @param[in]	in ByteBuffer, ByteBufferView, StaticByteBuffer
+	/// @param[out]	frame Width()個のdouble
+	/// @return		復号したときtrue
+	/// @note		復号できないときもフレームは読み飛ばす
+	///////////////////////////////////////////////////////////
+	template <class Buffer>
+	bool Decode(Buffer &in, double *frame)
+	{
+		size_t remain = in.Size() - in.Position();
+		int length = 0;
+		if (remain < sizeof(length)) {
+			return false;
+		}
+		in.Value(length);
+		if (length < 0 || static_cast<size_t>(length) > remain - sizeof(length)) {
+			return false;
+		}
+		unsigned int position = in.Position();
+		in.SetPosition(position + length);
+		return Decode(Pointer(in.Data()) + position, static_cast<size_t>(length), frame);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		DoubleFrameEncoder::Encode()で追加したフレームを取り出して復号する
+	/// @param[in]	in ByteBuffer, ByteBufferView, StaticByteBuffer
+	/// @param[out]	frame Width()個のdouble
+	/// @return		復号したときtrue
+	///////////////////////////////////////////////////////////
+	template <class Buffer>
+	bool Decode(Buffer &in, std::vector<double> &frame)
+	{
+		frame.resize(mColumns.size());
+		return Decode(in, &frame[0]);
+	}
+
+private:
+	std::vector<Column> mColumns;  ///< 列ごとの直前の状態
+	bool                mIsSynced; ///< キーフレームを復号済みのときtrue
+
+	static const char *Pointer(const std::string &data)
+	{
+		return data.data();
+	}
+
+	static const char *Pointer(const char *data)
+	{
+		return data;
+	}
+
+	static bool DecodeValue(BitReader &reader, Column &column)
+	{
+		if (reader.Read(1) == 0) {
+			return !reader.IsOverrun();
+		}
+		unsigned long long x;
+		if (reader.Read(1) == 0) {
+			if (!column.hasWindow) {
+				return false;
+			}
+			x = reader.Read(64 - column.leading - column.trailing) << column.trailing;
+		} else {
+			unsigned int leading = static_cast<unsigned int>(reader.Read(5));
+			unsigned int meaningful = static_cast<unsigned int>(reader.Read(6)) + 1;
+			if (leading + meaningful > 64) {
+				return false;
+			}
+			unsigned int trailing = 64 - leading - meaningful;
+			x = reader.Read(meaningful) << trailing;
+			column.leading = leading;
+			column.trailing = trailing;
+			column.hasWindow = true;
+		}
+		if (reader.IsOverrun()) {
+			return false;
+		}
+		column.previous ^= x;
+		return true;
+	}
+
+	/// コピー禁止
+	DoubleFrameDecoder(const DoubleFrameDecoder &);
+	/// 代入禁止
+	DoubleFrameDecoder &operator=(const DoubleFrameDecoder &);
+};
+}
+#endif
@@ -0,0 +1,233 @@
+///////////////////////////////////////////////////////////
+/// @file	DoubleFrameJournal.h
+/// @brief	double配列(フレーム)をXOR圧縮して記録するジャーナル
+/// @author	shuji-morimoto
+/// Copyright (C) 2013- Mamezou. All rights reserved.
+///////////////////////////////////////////////////////////
+
+#ifndef __PICO_IPC_DOUBLE_FRAME_JOURNAL__
+#define __PICO_IPC_DOUBLE_FRAME_JOURNAL__
+
+#include <string>
+#include "Error.h"
+#include "ByteBufferView.h"
+#include "JournalQueue.h"
+#include "DoubleFrameCodec.h"
+
+namespace PicoIPC {
+
+///////////////////////////////////////////////////////////
+/// @class	DoubleFrameJournal
+/// @brief	フレームをDoubleFrameEncoderで圧縮してJournalQueueに記録する
+///
+/// - 1レコードが1フレーム(DoubleFrameEncoder::Encode()の戻り値)となる
+/// - keyIntervalレコードごとにキーフレームを記録するため、
+///   DoubleFrameJournalReaderは移動した位置から最大keyIntervalレコードで復号を再開できる
+/// - 再オープンしたときは最初のフレームがキーフレームとなる
+///
+///////////////////////////////////////////////////////////
+class DoubleFrameJournal
+{
+public:
+	/// デフォルトのキーフレームの間隔
+	static const unsigned int DEFAULT_KEY_INTERVAL = 100;
+
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @param[in]	path ジャーナルのパス(セグメントファイル名の接頭辞)
+	/// @param[in]	width フレームのdoubleの数
+	/// @param[in]	keyInterval キーフレームの間隔
+	/// @param[in]	segmentSize セグメントファイルのサイズ
+	///////////////////////////////////////////////////////////
+	DoubleFrameJournal(const std::string &path, size_t width,
+		unsigned int keyInterval = DEFAULT_KEY_INTERVAL,
+		size_t segmentSize = JournalQueue::DEFAULT_SEGMENT_SIZE)
+		: mJournal(path, segmentSize)
+		, mEncoder(width, keyInterval)
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		デストラクタ
+	///////////////////////////////////////////////////////////
+	virtual ~DoubleFrameJournal()
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		ジャーナルを利用できるか確認する
+	/// @return		利用できるときtrue
+	///////////////////////////////////////////////////////////
+	bool IsOpen() const
+	{
+		return mJournal.IsOpen();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		フレームを記録する
+	/// @param[in]	frame Width()個のdouble
+	/// @return		Error 失敗したときエラー内容がErrorに設定される
+	/// @note		時刻は現在時刻(CLOCK_REALTIME)
+	///////////////////////////////////////////////////////////
+	Error Append(const double *frame)
+	{
+		return Append(frame, JournalQueue::Now());
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		時刻を指定してフレームを記録する
+	/// @param[in]	frame Width()個のdouble
+	/// @param[in]	timestamp 時刻(CLOCK_REALTIMEのナノ秒)
+	/// @return		Error 失敗したときエラー内容がErrorに設定される
+	///////////////////////////////////////////////////////////
+	Error Append(const double *frame, unsigned long long timestamp)
+	{
+		const std::string &data = mEncoder.Encode(frame);
+		Error err = mJournal.Append(data.data(), data.size(), timestamp);
+		if (err) {
+			// 記録できなかったフレームを前提に差分を作らない
+			mEncoder.Reset();
+		}
+		return err;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		記録した内容をファイルに書き込む
+	/// @return		Error 失敗したときエラー内容がErrorに設定される
+	///////////////////////////////////////////////////////////
+	Error Sync()
+	{
+		return mJournal.Sync();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		JournalQueueを取得する
+	/// @return		JournalQueue
+	///////////////////////////////////////////////////////////
+	JournalQueue &Journal()
+	{
+		return mJournal;
+	}
+
+private:
+	JournalQueue       mJournal; ///< 記録先
+	DoubleFrameEncoder mEncoder; ///< フレームの圧縮
+
+	/// コピー禁止
+	DoubleFrameJournal(const DoubleFrameJournal &);
+	/// 代入禁止
+	DoubleFrameJournal &operator=(const DoubleFrameJournal &);
+};
+
+///////////////////////////////////////////////////////////
+/// @class	DoubleFrameJournalReader
+/// @brief	DoubleFrameJournalで記録したフレームを読み出す
+/// @note		移動した直後はキーフレームまでのレコードを読み飛ばす
+///////////////////////////////////////////////////////////
+class DoubleFrameJournalReader
+{
+public:
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @param[in]	path ジャーナルのパス(セグメントファイル名の接頭辞)
+	/// @param[in]	width フレームのdoubleの数
+	///////////////////////////////////////////////////////////
+	DoubleFrameJournalReader(const std::string &path, size_t width)
+		: mReader(path)
+		, mDecoder(width)
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		デストラクタ
+	///////////////////////////////////////////////////////////
+	virtual ~DoubleFrameJournalReader()
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		最後に読み出したフレームのインデックスを取得する
+	/// @return		インデックス
+	///////////////////////////////////////////////////////////
+	unsigned long long Index() const
+	{
+		return mReader.Index();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		最後に読み出したフレームの時刻を取得する
+	/// @return		時刻(CLOCK_REALTIMEのナノ秒)
+	///////////////////////////////////////////////////////////
+	unsigned long long Timestamp() const
+	{
+		return mReader.Timestamp();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		最初のフレームの位置に移動する
+	///////////////////////////////////////////////////////////
+	void SeekBegin()
+	{
+		mReader.SeekBegin();
+		mDecoder.Reset();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		最後のフレームの次の位置に移動する
+	///////////////////////////////////////////////////////////
+	void SeekEnd()
+	{
+		mReader.SeekEnd();
+		mDecoder.Reset();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		指定したインデックスのフレームの位置に移動する
+	/// @param[in]	index インデックス
+	/// @note		indexより後の最初のキーフレームから読み出す
+	///////////////////////////////////////////////////////////
+	void SeekIndex(unsigned long long index)
+	{
+		mReader.SeekIndex(index);
+		mDecoder.Reset();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		指定した時刻以降の最初のフレームの位置に移動する
+	/// @param[in]	timestamp 時刻(CLOCK_REALTIMEのナノ秒)
+	/// @note		timestampより後の最初のキーフレームから読み出す
+	///////////////////////////////////////////////////////////
+	void SeekTime(unsigned long long timestamp)
+	{
+		mReader.SeekTime(timestamp);
+		mDecoder.Reset();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		次のフレームがあれば読み出す
+	/// @param[out]	frame Width()個のdouble
+	/// @return		読み出したときtrue
+	/// @note		ブロックしない
+	///////////////////////////////////////////////////////////
+	bool TryRead(double *frame)
+	{
+		ByteBufferView view;
+		while (mReader.TryRead(view)) {
+			if (mDecoder.Decode(view.Data(), view.Size(), frame)) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+private:
+	JournalReader      mReader;  ///< 読み出し元
+	DoubleFrameDecoder mDecoder; ///< フレームの復号
+
+	/// コピー禁止
+	DoubleFrameJournalReader(const DoubleFrameJournalReader &);
+	/// 代入禁止
+	DoubleFrameJournalReader &operator=(const DoubleFrameJournalReader &);
+};
+}
+#endif
@@ -0,0 +1,164 @@
+///////////////////////////////////////////////////////////
+/// @file	DropOldestQueue.h
+/// @brief	古いメッセージを破棄して送信するメッセージキュー
+/// @author	shuji-morimoto
+/// Copyright (C) 2013- Mamezou. All rights reserved.
+///////////////////////////////////////////////////////////
+
+#ifndef __PICO_IPC_DROP_OLDEST_QUEUE__
+#define __PICO_IPC_DROP_OLDEST_QUEUE__
+
+#include <mqueue.h>
+#include <time.h>
+#include <errno.h>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "Error.h"
+#include "ByteBuffer.h"
+#include "MessageQueue.h"
+#include "SharedMemory.h"
+
+namespace PicoIPC {
+
+///////////////////////////////////////////////////////////
+/// @struct	MessageQueueHeader
+/// @brief	メッセージキューのヘッダー情報
+///
+/// メッセージキュー名 + "_header" の共有メモリーに配置され、
+/// 送信側と受信側のプロセスで共有される
+///
+///////////////////////////////////////////////////////////
+struct MessageQueueHeader
+{
+	unsigned long dropCount; ///< 送信時に破棄した(古い)メッセージ数の累計
+};
+
+///////////////////////////////////////////////////////////
+/// @class	DropOldestQueue
+/// @brief	キューが満杯のとき最も古いメッセージを破棄して送信する
+///
+/// - MessageQueue::Send()は満杯のときブロックし、TimedSend()はタイムアウトで
+///   失敗するが、DropOldestQueue::Send()はブロックせずに最も古いメッセージを
+///   取り除いてから最新のメッセージを登録する
+/// - 破棄したメッセージ数はMessageQueueHeaderに記録されるため、受信側は
+///   DropCount()で取りこぼしたメッセージ数を確認できる
+/// - ヘッダーの共有メモリーはMessageQueueの所有者が作成/削除する
+///   所有者でない場合に共有メモリーが存在しないときはプロセス内でのみ計数する
+///
+/// 使い方
+///   MessageQueue mq("/mq1", 10, 400);
+///   DropOldestQueue q(&mq);
+///   q.Send(bb);                 // 送信側: ブロックしない
+///
+///   MessageQueue mq("/mq1");
+///   DropOldestQueue q(&mq);
+///   unsigned long lost = q.DropCount(); // 受信側: 取りこぼした数
+///
+///////////////////////////////////////////////////////////
+class DropOldestQueue
+{
+public:
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @param[in]	mq 対象のMessageQueue
+	/// @note		mqはDropOldestQueueより長く生存すること
+	///////////////////////////////////////////////////////////
+	DropOldestQueue(MessageQueue *mq)
+		: mQueue(mq)
+		, mHeaderMemory(NULL)
+		, mHeader(&mLocalHeader)
+		, mEvicted(mq->MaxMessageSize() > 0 ? mq->MaxMessageSize() : 1)
+	{
+		mLocalHeader.dropCount = 0;
+		std::string name = mq->Name() + "_header";
+		if (mq->mIsOwner) {
+			mHeaderMemory = new SharedMemory(name, sizeof(MessageQueueHeader), true);
+		} else if (!SharedMemory::Exist(name)) {
+			mHeaderMemory = new SharedMemory(name, sizeof(MessageQueueHeader), false);
+		}
+		if (mHeaderMemory != NULL) {
+			mHeader = mHeaderMemory->Data<MessageQueueHeader>();
+		}
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		デストラクタ
+	///////////////////////////////////////////////////////////
+	virtual ~DropOldestQueue()
+	{
+		delete mHeaderMemory;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		対象のMessageQueueを取得する
+	/// @return		MessageQueue
+	///////////////////////////////////////////////////////////
+	MessageQueue *Queue()
+	{
+		return mQueue;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		メッセージキューにメッセージを送信する
+	/// @param[in]	message メッセージ
+	/// @return		Error 失敗したときエラー内容がErrorに設定される
+	/// @note		ブロックしない。キューに空きがないときは最も古いメッセージを
+	/// 			破棄し、DropCount()を加算してから送信する
+	/// @note		メッセージサイズが0のメッセージも可能
+	///////////////////////////////////////////////////////////
+	Error Send(const ByteBuffer &message)
+	{
+		// 期限切れのタイムアウトを指定して非ブロックで送受信する
+		const timespec expired = {0, 0};
+		const std::string &data = message.Data();
+		long retry = mQueue->MaxMessageCount() + 1;
+		for (long i = 0; i <= retry; i++) {
+			if (::mq_timedsend(mQueue->mMessageQueue, data.data(), data.size(), 0, &expired) == 0) {
+				return Error::createNoError();
+			}
+			if (errno != ETIMEDOUT && errno != EAGAIN) {
+				return Error::createError("message queue send error [%s]", ::strerror(errno));
+			}
+			ssize_t size = ::mq_timedreceive(mQueue->mMessageQueue, &mEvicted[0], mEvicted.size(), NULL, &expired);
+			if (size >= 0) {
+				__sync_fetch_and_add(&mHeader->dropCount, 1);
+			} else if (errno != ETIMEDOUT && errno != EAGAIN) {
+				return Error::createError("message queue receive error [%s]", ::strerror(errno));
+			}
+			// 受信側が先に取り出して空になった場合はそのまま再送する
+		}
+		return Error::createError("message queue send error [%s]", "drop oldest retry over");
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		破棄したメッセージ数の累計を取得する
+	/// @return		破棄したメッセージ数
+	/// @note		受信側は前回値との差分で取りこぼした数を判断できる
+	///////////////////////////////////////////////////////////
+	unsigned long DropCount()
+	{
+		return __sync_fetch_and_add(&mHeader->dropCount, 0);
+	}
+
+private:
+	///////////////////////////////////////////////////////////
+	/// @brief		コピーコンストラクタ
+	/// @note		コピー禁止
+	///////////////////////////////////////////////////////////
+	DropOldestQueue(const DropOldestQueue &src);
+
+	///////////////////////////////////////////////////////////
+	/// @brief		代入オペレータ
+	/// @note		代入禁止
+	///////////////////////////////////////////////////////////
+	DropOldestQueue &operator =(const DropOldestQueue &src);
+
+	MessageQueue       *mQueue;        ///< 対象のMessageQueue
+	SharedMemory       *mHeaderMemory; ///< ヘッダーの共有メモリー
+	MessageQueueHeader *mHeader;       ///< ヘッダー(共有メモリーまたはmLocalHeader)
+	MessageQueueHeader  mLocalHeader;  ///< 共有メモリーがないときのヘッダー
+	std::vector<char>   mEvicted;      ///< 破棄するメッセージの受信領域
+};
+}
+#endif
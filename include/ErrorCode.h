@@ -0,0 +1,268 @@
+///////////////////////////////////////////////////////////
+/// @file	ErrorCode.h
+/// @brief	ヒープを確保しないエラーコード
+/// @author	shuji-morimoto
+/// Copyright (C) 2013- Mamezou. All rights reserved.
+///////////////////////////////////////////////////////////
+
+#ifndef __PICO_IPC_ERROR_CODE__
+#define __PICO_IPC_ERROR_CODE__
+
+#include <errno.h>
+#include <cstring>
+#include <string>
+#include "Error.h"
+#include "TextFormat.h"
+
+namespace PicoIPC {
+
+///////////////////////////////////////////////////////////
+/// @class	ErrorCode
+/// @brief	errno, サブシステム, 発生箇所を32bitで保持するエラー
+///
+/// - Errorはエラー発生時にvsnprintfでメッセージを生成してstd::stringに保持するが、
+///   ErrorCodeは整数のみを保持し、Message()を呼び出したときにメッセージを生成する
+/// - 戻り値はレジスタで返る(ヒープを確保しない、デストラクタもない)ため、
+///   タイムアウトのように頻繁に発生する想定内のエラーをループで確認するのに向く
+/// - メッセージはライブラリのErrorと同じ形式 ex) "message queue receive error [Connection timed out]"
+///
+/// 使い方
+///   ErrorCode code = mq.TimedReceiveCode(bb, 500);
+///   if (code.IsTimeout()) {
+///       continue;
+///   } else if (code) {
+///       printf("err:%s\n", code.Message().c_str());
+///   }
+///
+///////////////////////////////////////////////////////////
+class ErrorCode
+{
+public:
+	/// エラーが発生したサブシステム
+	enum SubsystemType {
+		SUBSYSTEM_NONE = 0,
+		MESSAGE_QUEUE,
+		SEMAPHORE,
+		SHARED_MEMORY,
+		UNIX_DOMAIN_SOCKET,
+		JOURNAL,
+		THREAD,
+		MUTEX
+	};
+
+	/// エラーが発生した処理
+	enum SourceType {
+		SOURCE_NONE = 0,
+		OPEN,
+		CREATION,
+		ATTRIBUTE,
+		SEND,
+		RECEIVE,
+		WAIT,
+		LOCK
+	};
+
+	///////////////////////////////////////////////////////////
+	/// @brief		エラーオブジェクト(エラーなし)を生成する
+	///////////////////////////////////////////////////////////
+	static ErrorCode createNoError()
+	{
+		return ErrorCode();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		エラーオブジェクト(エラー発生)を生成する
+	/// @param[in]	subsystem サブシステム
+	/// @param[in]	source 処理
+	/// @param[in]	number errno(0以外)
+	///////////////////////////////////////////////////////////
+	static ErrorCode createError(SubsystemType subsystem, SourceType source, int number)
+	{
+		return ErrorCode(subsystem, source, number);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @note		エラーなし
+	///////////////////////////////////////////////////////////
+	ErrorCode()
+		: mCode(0)
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @param[in]	subsystem サブシステム
+	/// @param[in]	source 処理
+	/// @param[in]	number errno(0のときエラーなし)
+	///////////////////////////////////////////////////////////
+	ErrorCode(SubsystemType subsystem, SourceType source, int number)
+		: mCode((static_cast<unsigned int>(number) & NUMBER_MASK)
+			| ((static_cast<unsigned int>(subsystem) & 0xff) << SUBSYSTEM_SHIFT)
+			| ((static_cast<unsigned int>(source) & 0xff) << SOURCE_SHIFT))
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		エラーかどうか確認する
+	/// @note		エラーのときtrue
+	///////////////////////////////////////////////////////////
+	operator bool() const
+	{
+		return (mCode & NUMBER_MASK) != 0;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		タイムアウトか確認する
+	/// @return		ETIMEDOUT, EAGAIN(ノンブロッキングで対象がない)のときtrue
+	///////////////////////////////////////////////////////////
+	bool IsTimeout() const
+	{
+		int number = Number();
+		return number == ETIMEDOUT || number == EAGAIN;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		停止要求で中断されたか確認する
+	/// @return		ECANCELED(StopTokenで停止要求された)のときtrue
+	///////////////////////////////////////////////////////////
+	bool IsCanceled() const
+	{
+		return Number() == ECANCELED;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		errnoを取得する
+	/// @return		errno(エラーなしのとき0)
+	///////////////////////////////////////////////////////////
+	int Number() const
+	{
+		return static_cast<int>(mCode & NUMBER_MASK);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		サブシステムを取得する
+	/// @return		サブシステム
+	///////////////////////////////////////////////////////////
+	SubsystemType Subsystem() const
+	{
+		return static_cast<SubsystemType>((mCode >> SUBSYSTEM_SHIFT) & 0xff);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		処理を取得する
+	/// @return		処理
+	///////////////////////////////////////////////////////////
+	SourceType Source() const
+	{
+		return static_cast<SourceType>((mCode >> SOURCE_SHIFT) & 0xff);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		32bitの値を取得する
+	/// @return		errno(下位16bit), サブシステム(8bit), 処理(上位8bit)
+	/// @note		ログやメッセージにそのまま格納できる
+	///////////////////////////////////////////////////////////
+	unsigned int Code() const
+	{
+		return mCode;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		メッセージを生成する
+	/// @return		メッセージ(エラーなしのとき空文字列)
+	/// @note		呼び出すたびに生成する
+	///////////////////////////////////////////////////////////
+	std::string Message() const
+	{
+		if (!*this) {
+			return std::string();
+		}
+		Text text;
+		const char *subsystem = SubsystemName(Subsystem());
+		if (*subsystem != '\0') {
+			text << subsystem << ' ';
+		}
+		const char *source = SourceName(Source());
+		if (*source != '\0') {
+			text << source << ' ';
+		}
+		text << "error [" << ::strerror(Number()) << "]";
+		return text.Str();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		Errorに変換する
+	/// @return		Error
+	/// @note		エラーのときのみメッセージを生成する
+	///////////////////////////////////////////////////////////
+	Error ToError() const
+	{
+		if (!*this) {
+			return Error::createNoError();
+		}
+		return Error(Message());
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		サブシステムの名前を取得する
+	/// @param[in]	subsystem サブシステム
+	/// @return		名前
+	///////////////////////////////////////////////////////////
+	static const char *SubsystemName(SubsystemType subsystem)
+	{
+		switch (subsystem) {
+		case MESSAGE_QUEUE:      return "message queue";
+		case SEMAPHORE:          return "semaphore";
+		case SHARED_MEMORY:      return "shared memory";
+		case UNIX_DOMAIN_SOCKET: return "socket";
+		case JOURNAL:            return "journal";
+		case THREAD:             return "thread";
+		case MUTEX:              return "mutex";
+		default:                 return "";
+		}
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		処理の名前を取得する
+	/// @param[in]	source 処理
+	/// @return		名前
+	///////////////////////////////////////////////////////////
+	static const char *SourceName(SourceType source)
+	{
+		switch (source) {
+		case OPEN:      return "open";
+		case CREATION:  return "creation";
+		case ATTRIBUTE: return "attribute";
+		case SEND:      return "send";
+		case RECEIVE:   return "receive";
+		case WAIT:      return "wait";
+		case LOCK:      return "lock";
+		default:        return "";
+		}
+	}
+
+private:
+	enum {
+		NUMBER_MASK     = 0xffff,
+		SUBSYSTEM_SHIFT = 16,
+		SOURCE_SHIFT    = 24
+	};
+
+	unsigned int mCode; ///< errno(下位16bit), サブシステム(8bit), 処理(上位8bit)
+};
+
+///////////////////////////////////////////////////////////
+/// @brief		ErrorCodeを比較する
+///////////////////////////////////////////////////////////
+inline bool operator==(const ErrorCode &a, const ErrorCode &b)
+{
+	return a.Code() == b.Code();
+}
+
+inline bool operator!=(const ErrorCode &a, const ErrorCode &b)
+{
+	return !(a == b);
+}
+}
+#endif
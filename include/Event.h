@@ -0,0 +1,151 @@
+///////////////////////////////////////////////////////////
+/// @file	Event.h
+/// @brief	futexによる軽量なイベント
+/// @author	shuji-morimoto
+/// Copyright (C) 2013- Mamezou. All rights reserved.
+///////////////////////////////////////////////////////////
+
+#ifndef __PICO_IPC_EVENT__
+#define __PICO_IPC_EVENT__
+
+#include "Futex.h"
+#include "Timespec.h"
+
+namespace PicoIPC {
+
+///////////////////////////////////////////////////////////
+/// @class	BasicEvent
+/// @brief	Set()されるまで待機できるイベント(手動リセット)
+///
+/// - 「サーバーが起動した」「応答が届いた」のような通知をMutex, 条件変数, boolの組み合わせなしで待つ
+/// - 待機しているスレッドがいないときのSet()と、Set()済みのときのWait()はシステムコールを呼び出さない
+/// - Set()すると待機中のすべてのスレッドが起き、Reset()するまで以後のWait()はすぐに戻る
+/// - IsSharedがtrueのときはプロセス間で共有できる(SharedEvent)
+///
+/// 状態(mState)
+///   0 未設定, 1 設定済み, 2 未設定で待機しているスレッドがいる
+///
+///////////////////////////////////////////////////////////
+template <bool IsShared>
+struct BasicEvent
+{
+	volatile int mState; ///< 状態(直接操作しないこと)
+
+	///////////////////////////////////////////////////////////
+	/// @brief		イベントを設定し、待機しているスレッドをすべて起こす
+	///////////////////////////////////////////////////////////
+	void Set()
+	{
+		int state;
+		do {
+			state = mState;
+		} while (!__sync_bool_compare_and_swap(&mState, state, 1));
+		if (state == 2) {
+			Futex::WakeAll(&mState, IsShared);
+		}
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		イベントを未設定に戻す
+	///////////////////////////////////////////////////////////
+	void Reset()
+	{
+		__sync_bool_compare_and_swap(&mState, 1, 0);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		イベントが設定されているか確認する
+	/// @return		設定されているときtrue
+	///////////////////////////////////////////////////////////
+	bool IsSet() const
+	{
+		bool isSet = (mState == 1);
+		__sync_synchronize();
+		return isSet;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		イベントが設定されるまで待機する
+	///////////////////////////////////////////////////////////
+	void Wait()
+	{
+		while (!Prepare()) {
+			Futex::Wait(&mState, 2, IsShared);
+		}
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		イベントが設定されるか指定時間経過するまで待機する
+	/// @param[in]	millisec ミリ秒
+	/// @return		設定されたときtrue、タイムアウトしたときfalse
+	///////////////////////////////////////////////////////////
+	bool TimedWait(unsigned long millisec)
+	{
+		if (IsSet()) {
+			return true;
+		}
+		timespec deadline = Timespec::After(CLOCK_MONOTONIC, millisec);
+		timespec remaining;
+		while (!Prepare()) {
+			if (!Timespec::Remaining(CLOCK_MONOTONIC, deadline, remaining)) {
+				return IsSet();
+			}
+			Futex::Wait(&mState, 2, IsShared, &remaining);
+		}
+		return true;
+	}
+
+private:
+	// 設定済みのときtrue。未設定のときは待機しているスレッドがいることを記録する
+	bool Prepare()
+	{
+		int state = mState;
+		if (state == 1) {
+			__sync_synchronize();
+			return true;
+		}
+		if (state == 0) {
+			__sync_bool_compare_and_swap(&mState, 0, 2);
+		}
+		return false;
+	}
+};
+
+///////////////////////////////////////////////////////////
+/// @brief	共有メモリ上に配置するイベント
+/// @note	POD型のため共有メモリの構造体のメンバにできる。0で初期化された状態が未設定となる
+///////////////////////////////////////////////////////////
+typedef BasicEvent<true> SharedEvent;
+
+///////////////////////////////////////////////////////////
+/// @class	Event
+/// @brief	プロセス内のスレッド間で利用するイベント
+///
+/// 使い方
+///   Event started;
+///   // 起動するスレッド
+///   started.Set();
+///   // 待機するスレッド
+///   if (!started.TimedWait(1000)) { ... }  // タイムアウト
+///
+///////////////////////////////////////////////////////////
+class Event : public BasicEvent<false>
+{
+public:
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @param[in]	isSet 設定済みで生成するときtrue
+	///////////////////////////////////////////////////////////
+	explicit Event(bool isSet = false)
+	{
+		mState = isSet ? 1 : 0;
+	}
+
+private:
+	/// コピー禁止
+	Event(const Event &);
+	/// 代入禁止
+	Event &operator=(const Event &);
+};
+}
+#endif
@@ -0,0 +1,819 @@
+///////////////////////////////////////////////////////////
+/// @file	Executor.h
+/// @brief	ワークスティーリングのスレッドプール
+/// @author	shuji-morimoto
+/// Copyright (C) 2013- Mamezou. All rights reserved.
+///////////////////////////////////////////////////////////
+
+#ifndef __PICO_IPC_EXECUTOR__
+#define __PICO_IPC_EXECUTOR__
+
+#include <unistd.h>
+#include <cstdio>
+#include <deque>
+#include <vector>
+#include "Thread.h"
+#include "Mutex.h"
+#include "MutexLock.h"
+#include "SpinPolicy.h"
+
+namespace PicoIPC {
+
+class Executor;
+
+///////////////////////////////////////////////////////////
+/// @class	FutureStateBase
+/// @brief	Futureの完了状態(参照カウントで共有する)
+///////////////////////////////////////////////////////////
+class FutureStateBase
+{
+public:
+	FutureStateBase()
+		: mRefCount(1)
+		, mIsDone(false)
+		, mIsCancelled(false)
+	{
+	}
+
+	virtual ~FutureStateBase()
+	{
+	}
+
+	void AddRef()
+	{
+		__sync_fetch_and_add(&mRefCount, 1);
+	}
+
+	void Release()
+	{
+		if (__sync_sub_and_fetch(&mRefCount, 1) == 0) {
+			delete this;
+		}
+	}
+
+	bool IsDone() const
+	{
+		bool done = mIsDone;
+		__sync_synchronize();
+		return done;
+	}
+
+	void Wait()
+	{
+		if (IsDone()) {
+			return;
+		}
+		MutexLock lock(&mMutex);
+		while (!mIsDone) {
+			lock.Wait();
+		}
+	}
+
+	void Complete()
+	{
+		MutexLock lock(&mMutex);
+		__sync_synchronize();
+		mIsDone = true;
+		lock.Broadcast();
+	}
+
+	bool IsCancelled() const
+	{
+		return IsDone() && mIsCancelled;
+	}
+
+	void Cancel()
+	{
+		mIsCancelled = true;
+		Complete();
+	}
+
+private:
+	volatile int  mRefCount;    ///< 参照カウント
+	volatile bool mIsDone;      ///< 完了したときtrue
+	volatile bool mIsCancelled; ///< 実行せずに完了したときtrue
+	Mutex         mMutex;       ///< 完了の待機
+
+	FutureStateBase(const FutureStateBase &);
+	FutureStateBase &operator=(const FutureStateBase &);
+};
+
+///////////////////////////////////////////////////////////
+/// @class	FutureState
+/// @brief	Futureの完了状態と結果
+///////////////////////////////////////////////////////////
+template <class R>
+class FutureState : public FutureStateBase
+{
+public:
+	void SetValue(const R &value)
+	{
+		mValue = value;
+		Complete();
+	}
+
+	const R &Value() const
+	{
+		return mValue;
+	}
+
+private:
+	R mValue; ///< 結果
+};
+
+template <>
+class FutureState<void> : public FutureStateBase
+{
+public:
+	void SetValue()
+	{
+		Complete();
+	}
+};
+
+///////////////////////////////////////////////////////////
+/// @class	FutureBase
+/// @brief	FutureStateの参照を管理する
+///////////////////////////////////////////////////////////
+template <class R>
+class FutureBase
+{
+public:
+	///////////////////////////////////////////////////////////
+	/// @brief		完了したか確認する
+	/// @return		完了したときtrue
+	/// @note		ブロックしない。無効なFutureのときはtrue
+	///////////////////////////////////////////////////////////
+	bool IsReady() const
+	{
+		return mState == NULL || mState->IsDone();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		完了するまで待機する
+	///////////////////////////////////////////////////////////
+	void Wait() const
+	{
+		if (mState != NULL) {
+			mState->Wait();
+		}
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		有効なFutureか確認する
+	/// @return		Submit()で生成されたときtrue
+	///////////////////////////////////////////////////////////
+	bool IsValid() const
+	{
+		return mState != NULL;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		タスクが実行されなかったか確認する
+	/// @return		Shutdown()後に投入されて実行されなかったときtrue
+	///////////////////////////////////////////////////////////
+	bool IsCancelled() const
+	{
+		return mState != NULL && mState->IsCancelled();
+	}
+
+protected:
+	FutureBase(FutureState<R> *state)
+		: mState(state)
+	{
+	}
+
+	FutureBase(const FutureBase &other)
+		: mState(other.mState)
+	{
+		if (mState != NULL) {
+			mState->AddRef();
+		}
+	}
+
+	~FutureBase()
+	{
+		if (mState != NULL) {
+			mState->Release();
+		}
+	}
+
+	FutureBase &operator=(const FutureBase &other)
+	{
+		if (other.mState != NULL) {
+			other.mState->AddRef();
+		}
+		if (mState != NULL) {
+			mState->Release();
+		}
+		mState = other.mState;
+		return *this;
+	}
+
+	FutureState<R> *mState; ///< 完了状態
+};
+
+///////////////////////////////////////////////////////////
+/// @class	Future
+/// @brief	Executor::Submit()したタスクの結果を受け取る
+///
+/// - コピーできる(同じ結果を参照する)
+/// - Get()は完了するまでブロックする
+///
+///////////////////////////////////////////////////////////
+template <class R>
+class Future : public FutureBase<R>
+{
+public:
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @note		無効なFuture
+	///////////////////////////////////////////////////////////
+	Future()
+		: FutureBase<R>(NULL)
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @param[in]	state 完了状態(所有権を受け取る)
+	///////////////////////////////////////////////////////////
+	explicit Future(FutureState<R> *state)
+		: FutureBase<R>(state)
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		完了するまで待機して結果を取得する
+	/// @return		タスクの戻り値(IsCancelled()のときRのデフォルト値)
+	/// @note		有効なFutureであること
+	///////////////////////////////////////////////////////////
+	const R &Get() const
+	{
+		this->Wait();
+		return this->mState->Value();
+	}
+};
+
+template <>
+class Future<void> : public FutureBase<void>
+{
+public:
+	Future()
+		: FutureBase<void>(NULL)
+	{
+	}
+
+	explicit Future(FutureState<void> *state)
+		: FutureBase<void>(state)
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		完了するまで待機する
+	///////////////////////////////////////////////////////////
+	void Get() const
+	{
+		Wait();
+	}
+};
+
+///////////////////////////////////////////////////////////
+/// @brief		関数オブジェクトの戻り値の型
+/// @note		関数ポインタR (*)()またはresult_typeを定義した関数オブジェクト
+///////////////////////////////////////////////////////////
+template <class F>
+struct ResultOf
+{
+	typedef typename F::result_type Type;
+};
+
+/// 関数ポインタ以外のポインタ(IRunnableの派生クラス)はSubmit(IRunnable *)を選択させる
+template <class T>
+struct ResultOf<T *>
+{
+};
+
+template <class R>
+struct ResultOf<R (*)()>
+{
+	typedef R Type;
+};
+
+///////////////////////////////////////////////////////////
+/// @class	ExecutorTask
+/// @brief	Executorが実行するタスク
+/// @note		実行後にExecutorが破棄する
+///////////////////////////////////////////////////////////
+class ExecutorTask
+{
+public:
+	virtual ~ExecutorTask()
+	{
+	}
+
+	virtual void Execute() = 0;
+};
+
+///////////////////////////////////////////////////////////
+/// @class	FunctionTask
+/// @brief	関数オブジェクトを実行して結果をFutureStateに設定する
+///////////////////////////////////////////////////////////
+template <class F, class R>
+class FunctionTask : public ExecutorTask
+{
+public:
+	FunctionTask(F function, FutureState<R> *state)
+		: mFunction(function)
+		, mState(state)
+	{
+	}
+
+	virtual ~FunctionTask()
+	{
+		mState->Release();
+	}
+
+	virtual void Execute()
+	{
+		mState->SetValue(mFunction());
+	}
+
+private:
+	F               mFunction; ///< 関数オブジェクト
+	FutureState<R> *mState;    ///< 結果の設定先
+};
+
+template <class F>
+class FunctionTask<F, void> : public ExecutorTask
+{
+public:
+	FunctionTask(F function, FutureState<void> *state)
+		: mFunction(function)
+		, mState(state)
+	{
+	}
+
+	virtual ~FunctionTask()
+	{
+		mState->Release();
+	}
+
+	virtual void Execute()
+	{
+		mFunction();
+		mState->SetValue();
+	}
+
+private:
+	F                  mFunction; ///< 関数オブジェクト
+	FutureState<void> *mState;    ///< 結果の設定先
+};
+
+///////////////////////////////////////////////////////////
+/// @class	RunnableTask
+/// @brief	IRunnable::Run()を実行する
+/// @note		IRunnableは破棄しない(Cleanup()も呼び出さない)
+///////////////////////////////////////////////////////////
+class RunnableTask : public ExecutorTask
+{
+public:
+	RunnableTask(IRunnable *runnable, FutureState<void> *state)
+		: mRunnable(runnable)
+		, mState(state)
+	{
+	}
+
+	virtual ~RunnableTask()
+	{
+		mState->Release();
+	}
+
+	virtual void Execute()
+	{
+		mRunnable->Run();
+		mState->SetValue();
+	}
+
+private:
+	IRunnable         *mRunnable; ///< 実行するIRunnable
+	FutureState<void> *mState;    ///< 完了の設定先
+};
+
+///////////////////////////////////////////////////////////
+/// @class	WorkStealingDeque
+/// @brief	Chase-Levの両端キュー(固定長)
+///
+/// - 所有スレッドのみがPush()/Pop()し、底(bottom)をLIFOで操作する
+/// - 他のスレッドはSteal()で先頭(top)からFIFOで奪う
+/// - 満杯のときPush()はfalseを返す(呼び出し側で共有キューに入れる)
+///
+///////////////////////////////////////////////////////////
+class WorkStealingDeque
+{
+public:
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @param[in]	capacity 容量(2のべき乗に切り上げる)
+	///////////////////////////////////////////////////////////
+	explicit WorkStealingDeque(size_t capacity)
+		: mTop(0)
+		, mBottom(0)
+		, mMask(0)
+		, mBuffer(NULL)
+	{
+		size_t size = 2;
+		while (size < capacity) {
+			size <<= 1;
+		}
+		mMask = size - 1;
+		mBuffer = new ExecutorTask *volatile[size];
+	}
+
+	virtual ~WorkStealingDeque()
+	{
+		delete[] mBuffer;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		底に追加する(所有スレッドのみ)
+	/// @param[in]	task タスク
+	/// @return		満杯のときfalse
+	///////////////////////////////////////////////////////////
+	bool Push(ExecutorTask *task)
+	{
+		long bottom = mBottom;
+		long top = mTop;
+		if (bottom - top > static_cast<long>(mMask)) {
+			return false;
+		}
+		mBuffer[bottom & mMask] = task;
+		__sync_synchronize();
+		mBottom = bottom + 1;
+		return true;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		底から取り出す(所有スレッドのみ)
+	/// @return		タスク(空のときNULL)
+	///////////////////////////////////////////////////////////
+	ExecutorTask *Pop()
+	{
+		long bottom = mBottom - 1;
+		mBottom = bottom;
+		__sync_synchronize();
+		long top = mTop;
+		if (top > bottom) {
+			mBottom = bottom + 1;
+			return NULL;
+		}
+		ExecutorTask *task = mBuffer[bottom & mMask];
+		if (top == bottom) {
+			// 最後の1つはSteal()と競合するためCASで取り合う
+			if (!__sync_bool_compare_and_swap(&mTop, top, top + 1)) {
+				task = NULL;
+			}
+			mBottom = bottom + 1;
+		}
+		return task;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		先頭から奪う(任意のスレッド)
+	/// @return		タスク(空または競合に負けたときNULL)
+	///////////////////////////////////////////////////////////
+	ExecutorTask *Steal()
+	{
+		long top = mTop;
+		__sync_synchronize();
+		long bottom = mBottom;
+		if (top >= bottom) {
+			return NULL;
+		}
+		// Push()が書き込んだスロットをmBottomより後に読む(制御依存だけではARMで順序を保証しない)
+		__sync_synchronize();
+		ExecutorTask *task = mBuffer[top & mMask];
+		if (!__sync_bool_compare_and_swap(&mTop, top, top + 1)) {
+			return NULL;
+		}
+		return task;
+	}
+
+private:
+	volatile long          mTop;    ///< 先頭(Steal()で進む)
+	volatile long          mBottom; ///< 底(所有スレッドのみ更新)
+	size_t                 mMask;   ///< 容量 - 1
+	ExecutorTask *volatile *mBuffer; ///< リングバッファ
+
+	WorkStealingDeque(const WorkStealingDeque &);
+	WorkStealingDeque &operator=(const WorkStealingDeque &);
+};
+
+///////////////////////////////////////////////////////////
+/// @class	Executor
+/// @brief	ワーカースレッドごとの両端キューとワークスティーリングによるスレッドプール
+///
+/// - ワーカーから投入したタスクは自分の両端キューに入り(LIFO)、
+///   外部スレッドから投入したタスクは共有キューに入る
+/// - 手の空いたワーカーは自分のキュー、共有キュー、他のワーカーのキューの順に探す
+/// - タスクがなければConditionWait()で待機する(スピンしない)
+/// - WaitIdle()は投入したすべてのタスクが完了するまで待機する
+///   (ワーカーのタスク内から呼び出すとデッドロックするため呼び出さないこと)
+///
+/// 使い方
+///   Executor executor;                          // CPUコア数のワーカー
+///   Future<int> f = executor.Submit(&compute);  // int compute()
+///   executor.Submit(&runnable);                 // IRunnable::Run()
+///   executor.WaitIdle();
+///   printf("%d\n", f.Get());
+///
+///////////////////////////////////////////////////////////
+class Executor
+{
+public:
+	/// デフォルトの両端キューの容量
+	enum { DEFAULT_DEQUE_CAPACITY = 1024 };
+
+	///////////////////////////////////////////////////////////
+	/// @brief		オンラインのCPUコア数を取得する
+	/// @return		CPUコア数(取得できないとき1)
+	///////////////////////////////////////////////////////////
+	static unsigned int HardwareConcurrency()
+	{
+		long count = ::sysconf(_SC_NPROCESSORS_ONLN);
+		return (count > 0) ? static_cast<unsigned int>(count) : 1;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @param[in]	workerCount ワーカースレッド数(0のときCPUコア数)
+	/// @param[in]	dequeCapacity ワーカーごとの両端キューの容量
+	/// @note		ワーカースレッドはすぐに起動する
+	///////////////////////////////////////////////////////////
+	Executor(unsigned int workerCount = 0, size_t dequeCapacity = DEFAULT_DEQUE_CAPACITY)
+		: mSharedCount(0)
+		, mQueuedCount(0)
+		, mPendingCount(0)
+		, mSleepingCount(0)
+		, mIsShutdown(false)
+		, mIsStopped(false)
+	{
+		if (workerCount == 0) {
+			workerCount = HardwareConcurrency();
+		}
+		for (unsigned int i = 0; i < workerCount; i++) {
+			mWorkers.push_back(new Worker(this, i, dequeCapacity));
+		}
+		for (unsigned int i = 0; i < workerCount; i++) {
+			Thread *thread = new Thread(mWorkers[i], NULL);
+			char name[32];
+			::snprintf(name, sizeof(name), "executor-%u", i);
+			thread->SetName(name);
+			mThreads.push_back(thread);
+			thread->Start();
+		}
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		デストラクタ
+	/// @note		投入済みのタスクを完了してからワーカースレッドを終了する
+	///////////////////////////////////////////////////////////
+	virtual ~Executor()
+	{
+		Shutdown();
+		for (size_t i = 0; i < mWorkers.size(); i++) {
+			delete mThreads[i];
+			delete mWorkers[i];
+		}
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		ワーカースレッド数を取得する
+	/// @return		ワーカースレッド数
+	///////////////////////////////////////////////////////////
+	unsigned int WorkerCount() const
+	{
+		return static_cast<unsigned int>(mWorkers.size());
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		IRunnable::Run()を実行するタスクを投入する
+	/// @param[in]	runnable 実行するIRunnable(完了するまで破棄しないこと)
+	/// @return		完了を待機するFuture
+	/// @note		Shutdown()後は実行せずにIsCancelled()のFutureを返す
+	///////////////////////////////////////////////////////////
+	Future<void> Submit(IRunnable *runnable)
+	{
+		FutureState<void> *state = new FutureState<void>();
+		state->AddRef();
+		Enqueue(new RunnableTask(runnable, state), state);
+		return Future<void>(state);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		関数オブジェクトを実行するタスクを投入する
+	/// @param[in]	function 関数ポインタR (*)()またはresult_typeを定義した関数オブジェクト(コピーされる)
+	/// @return		戻り値を受け取るFuture
+	/// @note		Shutdown()後は実行せずにIsCancelled()のFutureを返す
+	///////////////////////////////////////////////////////////
+	template <class F>
+	Future<typename ResultOf<F>::Type> Submit(F function)
+	{
+		typedef typename ResultOf<F>::Type R;
+		FutureState<R> *state = new FutureState<R>();
+		state->AddRef();
+		Enqueue(new FunctionTask<F, R>(function, state), state);
+		return Future<R>(state);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		投入したすべてのタスクが完了するまで待機する
+	/// @note		タスク内から呼び出さないこと
+	///////////////////////////////////////////////////////////
+	void WaitIdle()
+	{
+		MutexLock lock(&mIdleMutex);
+		while (mPendingCount > 0) {
+			lock.Wait();
+		}
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		投入済みのタスクを完了してからワーカースレッドを終了する
+	/// @note		開始後にタスク外から投入したタスクは実行されない(実行中のタスクから投入したタスクは完了する)
+	///////////////////////////////////////////////////////////
+	void Shutdown()
+	{
+		if (mIsStopped) {
+			return;
+		}
+		mIsShutdown = true;
+		__sync_synchronize();
+		WaitIdle();
+		{
+			MutexLock lock(&mSleepMutex);
+			mIsStopped = true;
+			lock.Broadcast();
+		}
+		for (size_t i = 0; i < mThreads.size(); i++) {
+			mThreads[i]->Join();
+		}
+	}
+
+private:
+	///////////////////////////////////////////////////////////
+	/// @class	Worker
+	/// @brief	ワーカースレッドで実行するループと両端キュー
+	///////////////////////////////////////////////////////////
+	class Worker : public IRunnable
+	{
+	public:
+		Worker(Executor *executor, unsigned int index, size_t capacity)
+			: mExecutor(executor)
+			, mIndex(index)
+			, mDeque(capacity)
+			, mRandom(index * 2654435761U + 1)
+		{
+		}
+
+		void Run()
+		{
+			Current() = this;
+			mExecutor->WorkerLoop(*this);
+			Current() = NULL;
+		}
+
+		///////////////////////////////////////////////////////////
+		/// @brief		呼び出したスレッドのWorkerを取得する
+		/// @return		Worker(ワーカースレッドでないときNULL)
+		///////////////////////////////////////////////////////////
+		static Worker *&Current()
+		{
+			static __thread Worker *current = NULL;
+			return current;
+		}
+
+		unsigned int NextRandom()
+		{
+			// xorshift32
+			mRandom ^= mRandom << 13;
+			mRandom ^= mRandom >> 17;
+			mRandom ^= mRandom << 5;
+			return mRandom;
+		}
+
+		Executor         *mExecutor; ///< 所属するExecutor
+		unsigned int      mIndex;    ///< ワーカー番号
+		WorkStealingDeque mDeque;    ///< タスクの両端キュー
+		unsigned int      mRandom;   ///< スティール先の選択に使う乱数
+	};
+
+	void Enqueue(ExecutorTask *task, FutureStateBase *state)
+	{
+		__sync_fetch_and_add(&mPendingCount, 1);
+		Worker *worker = Worker::Current();
+		// mPendingCountの加算後に確認する(Shutdown()はmIsShutdownの設定後にWaitIdle()する)
+		if (mIsShutdown && (worker == NULL || worker->mExecutor != this)) {
+			state->Cancel();
+			delete task;
+			Done();
+			return;
+		}
+		if (worker == NULL || worker->mExecutor != this || !worker->mDeque.Push(task)) {
+			MutexLock lock(&mQueueMutex);
+			mQueue.push_back(task);
+			__sync_fetch_and_add(&mSharedCount, 1);
+		}
+		__sync_fetch_and_add(&mQueuedCount, 1);
+		// 待機中のワーカーがいるときのみ起こす(mSleepingCountとmQueuedCountはWorkerLoopと逆順に確認する)
+		if (mSleepingCount > 0) {
+			MutexLock lock(&mSleepMutex);
+			lock.Signal();
+		}
+	}
+
+	ExecutorTask *Take(Worker &worker)
+	{
+		ExecutorTask *task = worker.mDeque.Pop();
+		if (task != NULL) {
+			return task;
+		}
+		if (mSharedCount > 0) {
+			MutexLock lock(&mQueueMutex);
+			if (!mQueue.empty()) {
+				task = mQueue.front();
+				mQueue.pop_front();
+				__sync_fetch_and_sub(&mSharedCount, 1);
+				return task;
+			}
+		}
+		size_t count = mWorkers.size();
+		if (count > 1) {
+			size_t start = worker.NextRandom() % count;
+			for (size_t i = 0; i < count; i++) {
+				Worker *victim = mWorkers[(start + i) % count];
+				if (victim != &worker) {
+					task = victim->mDeque.Steal();
+					if (task != NULL) {
+						return task;
+					}
+				}
+			}
+		}
+		return NULL;
+	}
+
+	void Done()
+	{
+		if (__sync_sub_and_fetch(&mPendingCount, 1) == 0) {
+			MutexLock lock(&mIdleMutex);
+			lock.Broadcast();
+		}
+	}
+
+	void WorkerLoop(Worker &worker)
+	{
+		while (true) {
+			ExecutorTask *task = Take(worker);
+			if (task != NULL) {
+				__sync_fetch_and_sub(&mQueuedCount, 1);
+				task->Execute();
+				delete task;
+				Done();
+				continue;
+			}
+			if (mQueuedCount > 0) {
+				// 他のワーカーが投入中またはスティールの競合に負けた
+				CpuRelax();
+				continue;
+			}
+			MutexLock lock(&mSleepMutex);
+			__sync_fetch_and_add(&mSleepingCount, 1);
+			while (mQueuedCount == 0 && !mIsStopped) {
+				lock.Wait();
+			}
+			__sync_fetch_and_sub(&mSleepingCount, 1);
+			if (mIsStopped && mQueuedCount == 0) {
+				return;
+			}
+		}
+	}
+
+	std::vector<Worker *>      mWorkers;       ///< ワーカー
+	std::vector<Thread *>      mThreads;       ///< ワーカースレッド
+	std::deque<ExecutorTask *> mQueue;         ///< 外部スレッドから投入したタスク
+	Mutex                      mQueueMutex;    ///< mQueueの排他
+	Mutex                      mSleepMutex;    ///< タスク待ちの待機
+	Mutex                      mIdleMutex;     ///< WaitIdle()の待機
+	volatile long              mSharedCount;   ///< mQueueのタスク数
+	volatile long              mQueuedCount;   ///< キューにあるタスク数
+	volatile long              mPendingCount;  ///< 完了していないタスク数
+	volatile long              mSleepingCount; ///< 待機中のワーカー数
+	volatile bool              mIsShutdown;    ///< Shutdown()を開始したときtrue
+	volatile bool              mIsStopped;     ///< ワーカースレッドに終了を指示したときtrue
+
+	Executor(const Executor &);
+	Executor &operator=(const Executor &);
+};
+}
+#endif
@@ -0,0 +1,73 @@
+///////////////////////////////////////////////////////////
+/// @file	Futex.h
+/// @brief	futexシステムコール
+/// @author	shuji-morimoto
+/// Copyright (C) 2013- Mamezou. All rights reserved.
+///////////////////////////////////////////////////////////
+
+#ifndef __PICO_IPC_FUTEX__
+#define __PICO_IPC_FUTEX__
+
+#include <unistd.h>
+#include <limits.h>
+#include <time.h>
+#include <errno.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+namespace PicoIPC {
+
+///////////////////////////////////////////////////////////
+/// @class	Futex
+/// @brief	32bit整数を待機/起床に使うfutexのラッパー
+///
+/// - Event, CountDownLatch, Barrierの待機に利用する
+/// - isSharedがfalseのときはFUTEX_PRIVATE_FLAGを指定する(プロセス内のみ、カーネル内の検索が速い)<br/>
+///   共有メモリ上の値を複数プロセスで待つときはtrueとすること
+///
+///////////////////////////////////////////////////////////
+class Futex
+{
+public:
+	///////////////////////////////////////////////////////////
+	/// @brief		値がexpectedの間、起こされるまで待機する
+	/// @param[in]	address 値のアドレス
+	/// @param[in]	expected 待機する値(異なるときはすぐに戻る)
+	/// @param[in]	isShared プロセス間で共有するときtrue
+	/// @param[in]	timeout 待機時間(NULLのとき無制限, CLOCK_MONOTONICの相対時間。Timespec::Remaining()で計算する)
+	/// @return		0 起こされたか値が異なる、ETIMEDOUT タイムアウト、EINTR シグナル
+	/// @note		条件を満たさずに戻ることがあるため、呼び出し側で値を確認し直すこと
+	///////////////////////////////////////////////////////////
+	static int Wait(volatile int *address, int expected, bool isShared, const timespec *timeout = NULL)
+	{
+		int op = isShared ? FUTEX_WAIT : (FUTEX_WAIT | FUTEX_PRIVATE_FLAG);
+		if (::syscall(SYS_futex, address, op, expected, timeout, NULL, 0) == 0) {
+			return 0;
+		}
+		return (errno == EAGAIN) ? 0 : errno;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		待機しているスレッドを起こす
+	/// @param[in]	address 値のアドレス
+	/// @param[in]	count 起こす数(INT_MAXのときすべて)
+	/// @param[in]	isShared プロセス間で共有するときtrue
+	///////////////////////////////////////////////////////////
+	static void Wake(volatile int *address, int count, bool isShared)
+	{
+		int op = isShared ? FUTEX_WAKE : (FUTEX_WAKE | FUTEX_PRIVATE_FLAG);
+		::syscall(SYS_futex, address, op, count, NULL, NULL, 0);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		待機しているすべてのスレッドを起こす
+	/// @param[in]	address 値のアドレス
+	/// @param[in]	isShared プロセス間で共有するときtrue
+	///////////////////////////////////////////////////////////
+	static void WakeAll(volatile int *address, bool isShared)
+	{
+		Wake(address, INT_MAX, isShared);
+	}
+};
+}
+#endif
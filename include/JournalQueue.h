@@ -0,0 +1,828 @@
+///////////////////////////////////////////////////////////
+/// @file	JournalQueue.h
+/// @brief	メモリーマップトファイルによるジャーナルキュー
+/// @author	shuji-morimoto
+/// Copyright (C) 2013- Mamezou. All rights reserved.
+///////////////////////////////////////////////////////////
+
+#ifndef __PICO_IPC_JOURNAL_QUEUE__
+#define __PICO_IPC_JOURNAL_QUEUE__
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <errno.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "Error.h"
+#include "ByteBuffer.h"
+#include "ByteBufferView.h"
+#include "Thread.h"
+
+namespace PicoIPC {
+
+///////////////////////////////////////////////////////////
+/// @struct	JournalSegmentHeader
+/// @brief	セグメントファイルの先頭に配置するヘッダー(64byte)
+///////////////////////////////////////////////////////////
+struct JournalSegmentHeader
+{
+	unsigned int       magic;          ///< 初期化済みのときJournalSegment::MAGIC
+	unsigned int       version;        ///< フォーマットのバージョン
+	unsigned int       segmentNumber;  ///< セグメント番号
+	unsigned int       segmentSize;    ///< セグメントファイルのサイズ
+	unsigned long long firstIndex;     ///< セグメントの最初のレコードのインデックス
+	unsigned long long firstTimestamp; ///< セグメントの最初のレコードの時刻(記録前は0)
+	char               reserved[32];   ///< 予約
+};
+
+///////////////////////////////////////////////////////////
+/// @struct	JournalRecordHeader
+/// @brief	レコードの先頭に配置するヘッダー(24byte)
+/// @note		レコードはヘッダー + メッセージで8byte境界に配置される
+///////////////////////////////////////////////////////////
+struct JournalRecordHeader
+{
+	unsigned int       state;     ///< レコードの状態(JournalSegment::RECORD_xxx)
+	unsigned int       length;    ///< メッセージ長
+	unsigned long long index;     ///< インデックス(0から連番)
+	unsigned long long timestamp; ///< 時刻(CLOCK_REALTIMEのナノ秒)
+};
+
+///////////////////////////////////////////////////////////
+/// @class	JournalSegment
+/// @brief	メモリーマップトしたセグメントファイル
+/// @note		JournalQueueとJournalReaderの内部で利用する
+///////////////////////////////////////////////////////////
+class JournalSegment
+{
+public:
+	/// ヘッダーの識別子 "JNL1"
+	static const unsigned int MAGIC = 0x4a4e4c31;
+	/// フォーマットのバージョン
+	static const unsigned int VERSION = 1;
+
+	/// 未書き込み
+	static const unsigned int RECORD_EMPTY = 0;
+	/// 書き込み済み
+	static const unsigned int RECORD_COMMITTED = 1;
+	/// セグメントの終端(次のセグメントに続く)
+	static const unsigned int RECORD_END = 2;
+
+	///////////////////////////////////////////////////////////
+	/// @brief		セグメントファイルのパスを取得する
+	/// @param[in]	path ジャーナルのパス
+	/// @param[in]	number セグメント番号
+	/// @return		"path.000000.jnl"
+	///////////////////////////////////////////////////////////
+	static std::string SegmentPath(const std::string &path, unsigned int number)
+	{
+		char buf[32];
+		::snprintf(buf, sizeof(buf), ".%06u.jnl", number);
+		return path + buf;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		セグメントファイルが存在するか確認する
+	/// @param[in]	path ジャーナルのパス
+	/// @param[in]	number セグメント番号
+	/// @return		存在するときtrue
+	///////////////////////////////////////////////////////////
+	static bool Exist(const std::string &path, unsigned int number)
+	{
+		return ::access(SegmentPath(path, number).c_str(), F_OK) == 0;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		レコードのサイズを取得する
+	/// @param[in]	length メッセージ長
+	/// @return		ヘッダーを含み8byte境界に切り上げたサイズ
+	///////////////////////////////////////////////////////////
+	static size_t RecordSize(size_t length)
+	{
+		return (sizeof(JournalRecordHeader) + length + 7) & ~static_cast<size_t>(7);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	///////////////////////////////////////////////////////////
+	JournalSegment()
+		: mFd(-1)
+		, mData(NULL)
+		, mSize(0)
+		, mNumber(0)
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		デストラクタ
+	///////////////////////////////////////////////////////////
+	virtual ~JournalSegment()
+	{
+		Close();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		セグメントファイルを作成してマップする
+	/// @param[in]	path ジャーナルのパス
+	/// @param[in]	number セグメント番号
+	/// @param[in]	size セグメントファイルのサイズ
+	/// @param[in]	firstIndex 最初のレコードのインデックス
+	/// @return		Error 失敗したときエラー内容がErrorに設定される
+	/// @note		ファイルの領域は作成時に確保する
+	///////////////////////////////////////////////////////////
+	Error Create(const std::string &path, unsigned int number, size_t size, unsigned long long firstIndex)
+	{
+		Close();
+		std::string name = SegmentPath(path, number);
+		mFd = ::open(name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+		if (mFd < 0) {
+			return Error::createError("journal open error [%s] [%s]", name.c_str(), ::strerror(errno));
+		}
+		int ret = ::posix_fallocate(mFd, 0, size);
+		if (ret != 0 && ::ftruncate(mFd, size) != 0) {
+			// posix_fallocateをサポートしないファイルシステムではftruncateで拡張する
+			Close();
+			return Error::createError("journal allocate error [%s] [%s]", name.c_str(), ::strerror(errno));
+		}
+		Error err = Map(name, size, PROT_READ | PROT_WRITE);
+		if (err) {
+			return err;
+		}
+		mNumber = number;
+		JournalSegmentHeader *header = Header();
+		header->version = VERSION;
+		header->segmentNumber = number;
+		header->segmentSize = size;
+		header->firstIndex = firstIndex;
+		header->firstTimestamp = 0;
+		__sync_synchronize();
+		header->magic = MAGIC;
+		return Error::createNoError();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		既存のセグメントファイルをマップする
+	/// @param[in]	path ジャーナルのパス
+	/// @param[in]	number セグメント番号
+	/// @param[in]	writable 書き込み可能にするときtrue
+	/// @return		Error 失敗したときエラー内容がErrorに設定される
+	/// @note		ヘッダーが初期化されていないときはエラーとなる
+	///////////////////////////////////////////////////////////
+	Error Open(const std::string &path, unsigned int number, bool writable)
+	{
+		Close();
+		std::string name = SegmentPath(path, number);
+		mFd = ::open(name.c_str(), writable ? O_RDWR : O_RDONLY);
+		if (mFd < 0) {
+			return Error::createError("journal open error [%s] [%s]", name.c_str(), ::strerror(errno));
+		}
+		struct stat st;
+		if (::fstat(mFd, &st) != 0) {
+			Close();
+			return Error::createError("journal stat error [%s] [%s]", name.c_str(), ::strerror(errno));
+		}
+		if (static_cast<size_t>(st.st_size) < sizeof(JournalSegmentHeader)) {
+			Close();
+			return Error::createError("journal open error [%s] [%s]", name.c_str(), "not initialized");
+		}
+		Error err = Map(name, st.st_size, writable ? PROT_READ | PROT_WRITE : PROT_READ);
+		if (err) {
+			return err;
+		}
+		if (Load(&Header()->magic) != MAGIC || Header()->segmentSize != mSize) {
+			Close();
+			return Error::createError("journal open error [%s] [%s]", name.c_str(), "not initialized");
+		}
+		mNumber = number;
+		return Error::createNoError();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		マップを解除してファイルを閉じる
+	///////////////////////////////////////////////////////////
+	void Close()
+	{
+		if (mData != NULL) {
+			::munmap(mData, mSize);
+			mData = NULL;
+		}
+		if (mFd >= 0) {
+			::close(mFd);
+			mFd = -1;
+		}
+		mSize = 0;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		マップした内容をファイルに書き出す
+	/// @return		Error 失敗したときエラー内容がErrorに設定される
+	/// @note		書き出しが完了するまでブロックする
+	///////////////////////////////////////////////////////////
+	Error Sync()
+	{
+		if (mData != NULL && ::msync(mData, mSize, MS_SYNC) != 0) {
+			return Error::createError("journal sync error [%s]", ::strerror(errno));
+		}
+		return Error::createNoError();
+	}
+
+	bool IsOpen() const
+	{
+		return mData != NULL;
+	}
+
+	unsigned int Number() const
+	{
+		return mNumber;
+	}
+
+	size_t Size() const
+	{
+		return mSize;
+	}
+
+	JournalSegmentHeader *Header()
+	{
+		return reinterpret_cast<JournalSegmentHeader *>(mData);
+	}
+
+	JournalRecordHeader *Record(size_t offset)
+	{
+		return reinterpret_cast<JournalRecordHeader *>(mData + offset);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		他のプロセスが書き込んだ値を読み出す
+	/// @param[in]	value 読み出す値
+	/// @return		値
+	///////////////////////////////////////////////////////////
+	static unsigned int Load(unsigned int *value)
+	{
+		unsigned int v = *const_cast<volatile unsigned int *>(value);
+		__sync_synchronize();
+		return v;
+	}
+
+private:
+	///////////////////////////////////////////////////////////
+	/// @brief		コピーコンストラクタ
+	/// @note		コピー禁止
+	///////////////////////////////////////////////////////////
+	JournalSegment(const JournalSegment &src);
+
+	///////////////////////////////////////////////////////////
+	/// @brief		代入オペレータ
+	/// @note		代入禁止
+	///////////////////////////////////////////////////////////
+	JournalSegment &operator =(const JournalSegment &src);
+
+	int           mFd;     ///< ファイルディスクリプタ
+	char         *mData;   ///< マップした領域
+	size_t        mSize;   ///< サイズ
+	unsigned int  mNumber; ///< セグメント番号
+
+	Error Map(const std::string &name, size_t size, int prot)
+	{
+		void *data = ::mmap(NULL, size, prot, MAP_SHARED, mFd, 0);
+		if (data == MAP_FAILED) {
+			Close();
+			return Error::createError("journal mmap error [%s] [%s]", name.c_str(), ::strerror(errno));
+		}
+		mData = static_cast<char *>(data);
+		mSize = size;
+		return Error::createNoError();
+	}
+};
+
+///////////////////////////////////////////////////////////
+/// @class	JournalQueue
+/// @brief	メモリーマップトファイルにバイナリーのレコードを追記するジャーナル
+///
+/// - レコードは事前に領域を確保してマップしたセグメントファイルに追記する
+///   (追記はページキャッシュへのmemcpyのみで、書式変換やwrite()を行わない)
+/// - セグメントファイルが一杯になると次のセグメントファイルを作成する
+///   "path.000000.jnl", "path.000001.jnl", ...
+/// - 各レコードにはインデックス(0からの連番)と時刻を記録する
+/// - 既存のジャーナルを指定したときは最後のレコードの次から追記する
+/// - 書き込み済みのレコードはJournalReaderで別のプロセスからも
+///   追従(tail)したり、インデックスや時刻を指定して再生できる
+/// - 書き込むのは1つのJournalQueue(1スレッド)であること
+///
+/// 使い方
+///   JournalQueue journal("/tmp/axis");
+///   journal.Append(bb);
+///
+///   JournalReader reader("/tmp/axis");
+///   reader.SeekTime(from);
+///   while (reader.TryRead(bb)) { ... }
+///
+///////////////////////////////////////////////////////////
+class JournalQueue
+{
+public:
+	/// デフォルトのセグメントファイルのサイズ
+	static const size_t DEFAULT_SEGMENT_SIZE = 16 * 1024 * 1024;
+
+	///////////////////////////////////////////////////////////
+	/// @brief		現在の時刻を取得する
+	/// @return		CLOCK_REALTIMEの時刻(ナノ秒)
+	///////////////////////////////////////////////////////////
+	static unsigned long long Now()
+	{
+		timespec now;
+		::clock_gettime(CLOCK_REALTIME, &now);
+		return static_cast<unsigned long long>(now.tv_sec) * 1000000000ULL + now.tv_nsec;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @param[in]	path ジャーナルのパス(セグメントファイル名の接頭辞)
+	/// @param[in]	segmentSize セグメントファイルのサイズ
+	/// @note		ジャーナルが存在しないときは作成する
+	/// @note		開けなかったときはIsOpen()がfalseとなり、LastError()に理由が設定される
+	///////////////////////////////////////////////////////////
+	JournalQueue(const std::string &path, size_t segmentSize = DEFAULT_SEGMENT_SIZE)
+		: mPath(path)
+		, mSegmentSize(segmentSize)
+		, mOffset(0)
+		, mNextIndex(0)
+		, mLastError(Error::createNoError())
+	{
+		mLastError = Open();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		デストラクタ
+	/// @note		ファイルの書き出しはOSに任せる(Sync()で明示的に書き出せる)
+	///////////////////////////////////////////////////////////
+	virtual ~JournalQueue()
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		ジャーナルを開けたか確認する
+	/// @return		開けたときtrue
+	///////////////////////////////////////////////////////////
+	bool IsOpen() const
+	{
+		return mSegment.IsOpen();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタで開けなかった理由を取得する
+	/// @return		Error
+	///////////////////////////////////////////////////////////
+	const Error &LastError() const
+	{
+		return mLastError;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		次に追記するレコードのインデックスを取得する
+	/// @return		インデックス
+	///////////////////////////////////////////////////////////
+	unsigned long long NextIndex() const
+	{
+		return mNextIndex;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		現在の時刻でメッセージを追記する
+	/// @param[in]	message メッセージ
+	/// @return		Error 失敗したときエラー内容がErrorに設定される
+	///////////////////////////////////////////////////////////
+	Error Append(const ByteBuffer &message)
+	{
+		return Append(message.Data().data(), message.Size(), Now());
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		時刻を指定してメッセージを追記する
+	/// @param[in]	message メッセージ
+	/// @param[in]	timestamp 時刻(CLOCK_REALTIMEのナノ秒)
+	/// @return		Error 失敗したときエラー内容がErrorに設定される
+	/// @note		SeekTime()で検索するため時刻は単調増加であること
+	///////////////////////////////////////////////////////////
+	Error Append(const ByteBuffer &message, unsigned long long timestamp)
+	{
+		return Append(message.Data().data(), message.Size(), timestamp);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		時刻を指定してデータを追記する
+	/// @param[in]	data データ
+	/// @param[in]	size データサイズ
+	/// @param[in]	timestamp 時刻(CLOCK_REALTIMEのナノ秒)
+	/// @return		Error 失敗したときエラー内容がErrorに設定される
+	///////////////////////////////////////////////////////////
+	Error Append(const char *data, size_t size, unsigned long long timestamp)
+	{
+		if (!mSegment.IsOpen()) {
+			return Error::createError("journal append error [%s]", "not open");
+		}
+		size_t recordSize = JournalSegment::RecordSize(size);
+		// 終端レコードの領域を常に残しておく
+		size_t capacity = mSegmentSize - sizeof(JournalSegmentHeader) - sizeof(JournalRecordHeader);
+		if (recordSize > capacity) {
+			return Error::createError("journal append error [size over %lu > %lu]",
+				static_cast<unsigned long>(recordSize), static_cast<unsigned long>(capacity));
+		}
+		if (mOffset + recordSize + sizeof(JournalRecordHeader) > mSegment.Size()) {
+			Error err = Roll();
+			if (err) {
+				return err;
+			}
+		}
+		if (mOffset == sizeof(JournalSegmentHeader)) {
+			mSegment.Header()->firstTimestamp = timestamp;
+		}
+		JournalRecordHeader *record = mSegment.Record(mOffset);
+		record->length = size;
+		record->index = mNextIndex;
+		record->timestamp = timestamp;
+		::memcpy(record + 1, data, size);
+		__sync_synchronize();
+		record->state = JournalSegment::RECORD_COMMITTED;
+
+		mOffset += recordSize;
+		mNextIndex++;
+		return Error::createNoError();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		現在のセグメントファイルをディスクに書き出す
+	/// @return		Error 失敗したときエラー内容がErrorに設定される
+	/// @note		書き出しが完了するまでブロックするため周期処理からは呼び出さないこと
+	///////////////////////////////////////////////////////////
+	Error Sync()
+	{
+		return mSegment.Sync();
+	}
+
+private:
+	///////////////////////////////////////////////////////////
+	/// @brief		コピーコンストラクタ
+	/// @note		コピー禁止
+	///////////////////////////////////////////////////////////
+	JournalQueue(const JournalQueue &src);
+
+	///////////////////////////////////////////////////////////
+	/// @brief		代入オペレータ
+	/// @note		代入禁止
+	///////////////////////////////////////////////////////////
+	JournalQueue &operator =(const JournalQueue &src);
+
+	std::string         mPath;        ///< ジャーナルのパス
+	size_t              mSegmentSize; ///< セグメントファイルのサイズ
+	JournalSegment      mSegment;     ///< 書き込み中のセグメント
+	size_t              mOffset;      ///< 次に書き込む位置
+	unsigned long long  mNextIndex;   ///< 次に書き込むインデックス
+	Error               mLastError;   ///< コンストラクタで開けなかった理由
+
+	Error Open()
+	{
+		if (mSegmentSize < sizeof(JournalSegmentHeader) + sizeof(JournalRecordHeader) * 3) {
+			return Error::createError("journal open error [segment size too small %lu]",
+				static_cast<unsigned long>(mSegmentSize));
+		}
+		if (!JournalSegment::Exist(mPath, 0)) {
+			return Create(0, 0);
+		}
+		unsigned int last = 0;
+		while (JournalSegment::Exist(mPath, last + 1)) {
+			last++;
+		}
+		if (last > 0) {
+			// Roll()は次のセグメントを作成してから終端を書き込むため、その間に終了していたときは
+			// 前のセグメントに終端を書き込む(書き込まないと読み出し側が次のセグメントに進めない)
+			Error err = mSegment.Open(mPath, last - 1, true);
+			if (err) {
+				return err;
+			}
+			mSegmentSize = mSegment.Size();
+			Walk();
+			if (mSegment.Record(mOffset)->state != JournalSegment::RECORD_END) {
+				WriteEnd();
+			}
+		}
+		// 最後のセグメントの終端まで読み進めて追記位置を求める
+		Error err = mSegment.Open(mPath, last, true);
+		if (!err) {
+			mSegmentSize = mSegment.Size();
+			Walk();
+			return Error::createNoError();
+		}
+		// セグメントの作成中に終了していたので作成し直す
+		return Create(last, mNextIndex);
+	}
+
+	Error Create(unsigned int number, unsigned long long firstIndex)
+	{
+		Error err = mSegment.Create(mPath, number, mSegmentSize, firstIndex);
+		if (err) {
+			return err;
+		}
+		mOffset = sizeof(JournalSegmentHeader);
+		mNextIndex = firstIndex;
+		return Error::createNoError();
+	}
+
+	void Walk()
+	{
+		mOffset = sizeof(JournalSegmentHeader);
+		mNextIndex = mSegment.Header()->firstIndex;
+		while (mOffset + sizeof(JournalRecordHeader) <= mSegment.Size()) {
+			JournalRecordHeader *record = mSegment.Record(mOffset);
+			if (record->state != JournalSegment::RECORD_COMMITTED) {
+				break;
+			}
+			mOffset += JournalSegment::RecordSize(record->length);
+			mNextIndex = record->index + 1;
+		}
+	}
+
+	// 追記位置に終端レコードを書き込む(Append()は終端レコードの領域を常に残している)
+	void WriteEnd()
+	{
+		JournalRecordHeader *end = mSegment.Record(mOffset);
+		end->length = 0;
+		end->index = mNextIndex;
+		end->timestamp = 0;
+		__sync_synchronize();
+		end->state = JournalSegment::RECORD_END;
+	}
+
+	Error Roll()
+	{
+		// 次のセグメントを作成してから終端を書き込むため、読み出し側は終端を
+		// 読んだ時点で次のセグメントを開ける
+		JournalSegment next;
+		unsigned int number = mSegment.Number() + 1;
+		Error err = next.Create(mPath, number, mSegmentSize, mNextIndex);
+		if (err) {
+			return err;
+		}
+		next.Close();
+
+		WriteEnd();
+
+		err = mSegment.Open(mPath, number, true);
+		if (err) {
+			return err;
+		}
+		mOffset = sizeof(JournalSegmentHeader);
+		return Error::createNoError();
+	}
+};
+
+///////////////////////////////////////////////////////////
+/// @class	JournalReader
+/// @brief	JournalQueueで記録したジャーナルの読み出し
+///
+/// - 生成時は最初のレコードの位置から読み出す(SeekEnd()で追従のみにできる)
+/// - TryRead()は書き込み済みのレコードがなければすぐにfalseを返すため、
+///   書き込み中のジャーナルに追従できる
+/// - SeekIndex()/SeekTime()で指定したインデックス/時刻のレコードから再生できる
+///
+///////////////////////////////////////////////////////////
+class JournalReader
+{
+public:
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @param[in]	path ジャーナルのパス(セグメントファイル名の接頭辞)
+	/// @note		ジャーナルがまだ存在しなくてもよい
+	///////////////////////////////////////////////////////////
+	JournalReader(const std::string &path)
+		: mPath(path)
+		, mNumber(0)
+		, mOffset(0)
+		, mIndex(0)
+		, mTimestamp(0)
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		デストラクタ
+	///////////////////////////////////////////////////////////
+	virtual ~JournalReader()
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		最後に読み出したレコードのインデックスを取得する
+	/// @return		インデックス
+	///////////////////////////////////////////////////////////
+	unsigned long long Index() const
+	{
+		return mIndex;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		最後に読み出したレコードの時刻を取得する
+	/// @return		時刻(CLOCK_REALTIMEのナノ秒)
+	///////////////////////////////////////////////////////////
+	unsigned long long Timestamp() const
+	{
+		return mTimestamp;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		最初のレコードの位置に移動する
+	///////////////////////////////////////////////////////////
+	void SeekBegin()
+	{
+		mSegment.Close();
+		mNumber = 0;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		最後のレコードの次の位置に移動する
+	/// @note		以降は新しく追記されたレコードのみを読み出す
+	///////////////////////////////////////////////////////////
+	void SeekEnd()
+	{
+		mSegment.Close();
+		mNumber = 0;
+		while (JournalSegment::Exist(mPath, mNumber + 1)) {
+			mNumber++;
+		}
+		JournalRecordHeader *record;
+		while (Peek(record)) {
+			Consume(record);
+		}
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		指定したインデックスのレコードの位置に移動する
+	/// @param[in]	index インデックス
+	/// @note		indexのレコードがまだないときは最後のレコードの次の位置となる
+	///////////////////////////////////////////////////////////
+	void SeekIndex(unsigned long long index)
+	{
+		mSegment.Close();
+		mNumber = 0;
+		JournalSegmentHeader header;
+		while (ReadHeader(mNumber + 1, header) && header.firstIndex <= index) {
+			mNumber++;
+		}
+		JournalRecordHeader *record;
+		while (Peek(record) && record->index < index) {
+			Consume(record);
+		}
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		指定した時刻以降の最初のレコードの位置に移動する
+	/// @param[in]	timestamp 時刻(CLOCK_REALTIMEのナノ秒)
+	/// @note		該当するレコードがないときは最後のレコードの次の位置となる
+	///////////////////////////////////////////////////////////
+	void SeekTime(unsigned long long timestamp)
+	{
+		mSegment.Close();
+		mNumber = 0;
+		JournalSegmentHeader header;
+		while (ReadHeader(mNumber + 1, header)
+			&& header.firstTimestamp != 0 && header.firstTimestamp <= timestamp) {
+			mNumber++;
+		}
+		JournalRecordHeader *record;
+		while (Peek(record) && record->timestamp < timestamp) {
+			Consume(record);
+		}
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		次のレコードがあれば読み出す
+	/// @param[out]	outMessage メッセージ
+	/// @return		読み出したときtrue
+	/// @note		ブロックしない
+	///////////////////////////////////////////////////////////
+	bool TryRead(ByteBuffer &outMessage)
+	{
+		JournalRecordHeader *record;
+		if (!Peek(record)) {
+			return false;
+		}
+		outMessage = ByteBuffer(reinterpret_cast<const char *>(record + 1), static_cast<size_t>(record->length));
+		Consume(record);
+		return true;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		次のレコードがあればコピーせずに参照する
+	/// @param[out]	outMessage メッセージの参照
+	/// @return		読み出したときtrue
+	/// @note		参照は次にセグメントが切り替わるかJournalReaderを破棄するまで有効
+	///////////////////////////////////////////////////////////
+	bool TryRead(ByteBufferView &outMessage)
+	{
+		JournalRecordHeader *record;
+		if (!Peek(record)) {
+			return false;
+		}
+		outMessage.Reset(reinterpret_cast<const char *>(record + 1), record->length);
+		Consume(record);
+		return true;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		タイムアウト付きで次のレコードを読み出す
+	/// @param[out]	outMessage メッセージ
+	/// @param[in]	millisec ミリ秒
+	/// @return		Error 失敗したときエラー内容がErrorに設定される
+	/// @note		millisecが0のときは読み出せるまで待機する
+	/// @note		追記されるまでスリープを挟んでポーリングする
+	///////////////////////////////////////////////////////////
+	Error TimedRead(ByteBuffer &outMessage, unsigned long millisec)
+	{
+		timespec start;
+		::clock_gettime(CLOCK_MONOTONIC, &start);
+		while (!TryRead(outMessage)) {
+			if (millisec != 0) {
+				timespec now;
+				::clock_gettime(CLOCK_MONOTONIC, &now);
+				unsigned long elapsed = (now.tv_sec - start.tv_sec) * 1000 + (now.tv_nsec - start.tv_nsec) / 1000000;
+				if (elapsed >= millisec) {
+					return Error::createError("journal read error [%s]", "timeout");
+				}
+			}
+			Thread::MilliSleep(POLLING_INTERVAL_MILLISEC);
+		}
+		return Error::createNoError();
+	}
+
+private:
+	///////////////////////////////////////////////////////////
+	/// @brief		コピーコンストラクタ
+	/// @note		コピー禁止
+	///////////////////////////////////////////////////////////
+	JournalReader(const JournalReader &src);
+
+	///////////////////////////////////////////////////////////
+	/// @brief		代入オペレータ
+	/// @note		代入禁止
+	///////////////////////////////////////////////////////////
+	JournalReader &operator =(const JournalReader &src);
+
+	/// TimedRead()のポーリング間隔
+	static const unsigned int POLLING_INTERVAL_MILLISEC = 1;
+
+	std::string         mPath;      ///< ジャーナルのパス
+	JournalSegment      mSegment;   ///< 読み出し中のセグメント
+	unsigned int        mNumber;    ///< 読み出し中のセグメント番号
+	size_t              mOffset;    ///< 次に読み出す位置
+	unsigned long long  mIndex;     ///< 最後に読み出したインデックス
+	unsigned long long  mTimestamp; ///< 最後に読み出した時刻
+
+	bool ReadHeader(unsigned int number, JournalSegmentHeader &outHeader)
+	{
+		int fd = ::open(JournalSegment::SegmentPath(mPath, number).c_str(), O_RDONLY);
+		if (fd < 0) {
+			return false;
+		}
+		ssize_t size = ::pread(fd, &outHeader, sizeof(outHeader), 0);
+		::close(fd);
+		return size == static_cast<ssize_t>(sizeof(outHeader)) && outHeader.magic == JournalSegment::MAGIC;
+	}
+
+	bool Peek(JournalRecordHeader *&outRecord)
+	{
+		while (true) {
+			if (!mSegment.IsOpen()) {
+				if (mSegment.Open(mPath, mNumber, false)) {
+					return false;
+				}
+				mOffset = sizeof(JournalSegmentHeader);
+			}
+			if (mOffset + sizeof(JournalRecordHeader) > mSegment.Size()) {
+				return false;
+			}
+			JournalRecordHeader *record = mSegment.Record(mOffset);
+			unsigned int state = JournalSegment::Load(&record->state);
+			if (state == JournalSegment::RECORD_COMMITTED) {
+				outRecord = record;
+				return true;
+			}
+			if (state != JournalSegment::RECORD_END) {
+				return false;
+			}
+			mSegment.Close();
+			mNumber++;
+		}
+	}
+
+	void Consume(JournalRecordHeader *record)
+	{
+		mIndex = record->index;
+		mTimestamp = record->timestamp;
+		mOffset += JournalSegment::RecordSize(record->length);
+	}
+};
+}
+#endif
@@ -0,0 +1,257 @@
+///////////////////////////////////////////////////////////
+/// @file	LatencyHistogram.h
+/// @brief	遅延時間のヒストグラム
+/// @author	shuji-morimoto
+/// Copyright (C) 2013- Mamezou. All rights reserved.
+///////////////////////////////////////////////////////////
+
+#ifndef __PICO_IPC_LATENCY_HISTOGRAM__
+#define __PICO_IPC_LATENCY_HISTOGRAM__
+
+#include <cstdio>
+#include <string>
+#include "SpinPolicy.h"
+
+namespace PicoIPC {
+
+///////////////////////////////////////////////////////////
+/// @class	LatencyHistogram
+/// @brief	ロックフリーの遅延時間ヒストグラム(ナノ秒)
+///
+/// - HDRヒストグラムと同様に2のべき乗ごとの区間を32分割したバケットで計数する
+///   (相対誤差は約3%以内、最大約1100秒まで記録できる)
+/// - Record()はアトミック加算のみでロックしないため、複数スレッドから
+///   同時に記録できる<br/>
+///   64bitのアトミック操作がないターゲット(ARMv7でGCC 4.7未満など)では、記録数・合計値・最大値のみ
+///   スピンロックで保護する(バケットは32bitのアトミック加算のまま)
+/// - Percentile()等の集計は記録中に呼び出してもよい(近似値となる)
+///
+/// 使い方
+///   LatencyHistogram h;
+///   h.Record(elapsedNanosec);
+///   printf("p99 %llu ns\n", h.Percentile(99.0));
+///
+///////////////////////////////////////////////////////////
+class LatencyHistogram
+{
+public:
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	///////////////////////////////////////////////////////////
+	LatencyHistogram()
+		: mLock(0)
+	{
+		Clear();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		デストラクタ
+	///////////////////////////////////////////////////////////
+	virtual ~LatencyHistogram()
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		遅延時間を記録する
+	/// @param[in]	nanosec 遅延時間(ナノ秒)
+	/// @note		記録できる範囲を超える値は最大のバケットに計数する
+	///////////////////////////////////////////////////////////
+	void Record(unsigned long long nanosec)
+	{
+		__sync_fetch_and_add(&mCounts[BucketIndex(nanosec)], 1);
+#if defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_8)
+		__sync_fetch_and_add(&mCount, 1);
+		__sync_fetch_and_add(&mSum, nanosec);
+		unsigned long long max = mMax;
+		while (nanosec > max) {
+			if (__sync_bool_compare_and_swap(&mMax, max, nanosec)) {
+				break;
+			}
+			max = mMax;
+		}
+#else
+		Lock();
+		mCount++;
+		mSum += nanosec;
+		if (nanosec > mMax) {
+			mMax = nanosec;
+		}
+		Unlock();
+#endif
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		記録した数を取得する
+	/// @return		記録数
+	///////////////////////////////////////////////////////////
+	unsigned long long Count() const
+	{
+		return Load(&mCount);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		最大値を取得する
+	/// @return		最大値(ナノ秒)
+	///////////////////////////////////////////////////////////
+	unsigned long long Max() const
+	{
+		return Load(&mMax);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		平均値を取得する
+	/// @return		平均値(ナノ秒)、記録がないときは0
+	///////////////////////////////////////////////////////////
+	unsigned long long Mean() const
+	{
+		unsigned long long count = Load(&mCount);
+		return (count == 0) ? 0 : Load(&mSum) / count;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		パーセンタイル値を取得する
+	/// @param[in]	percentile パーセンタイル(0.0〜100.0) 例) 99.9
+	/// @return		パーセンタイル値(ナノ秒)、記録がないときは0
+	/// @note		バケットの上限値を返すため最大約3%大きい値となる(Max()は超えない)
+	///////////////////////////////////////////////////////////
+	unsigned long long Percentile(double percentile) const
+	{
+		unsigned long long total = 0;
+		for (int i = 0; i < BUCKET_COUNT; i++) {
+			total += mCounts[i];
+		}
+		if (total == 0) {
+			return 0;
+		}
+		unsigned long long rank = static_cast<unsigned long long>(percentile / 100.0 * total + 0.5);
+		if (rank < 1) {
+			rank = 1;
+		}
+		if (rank > total) {
+			rank = total;
+		}
+		unsigned long long sum = 0;
+		for (int i = 0; i < BUCKET_COUNT; i++) {
+			sum += mCounts[i];
+			if (sum >= rank) {
+				unsigned long long upper = BucketUpperBound(i);
+				unsigned long long max = Load(&mMax);
+				return (upper < max) ? upper : max;
+			}
+		}
+		return Load(&mMax);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		記録をクリアする
+	/// @note		記録中に呼び出すとクリア直後の記録が失われることがある
+	///////////////////////////////////////////////////////////
+	void Clear()
+	{
+		for (int i = 0; i < BUCKET_COUNT; i++) {
+			mCounts[i] = 0;
+		}
+		Lock();
+		mCount = 0;
+		mSum = 0;
+		mMax = 0;
+		Unlock();
+		__sync_synchronize();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		集計結果を文字列で取得する
+	/// @return		"count:n mean:n p50:n p99:n p999:n max:n (ns)"
+	///////////////////////////////////////////////////////////
+	std::string Summary() const
+	{
+		char buf[256];
+		::snprintf(buf, sizeof(buf), "count:%llu mean:%llu p50:%llu p99:%llu p999:%llu max:%llu (ns)",
+			Count(), Mean(), Percentile(50.0), Percentile(99.0), Percentile(99.9), Max());
+		return std::string(buf);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		標準出力に集計結果を出力する
+	/// @param[int]	title タイトル
+	///////////////////////////////////////////////////////////
+	void Print(const std::string &title) const
+	{
+		::printf("%s %s\n", title.c_str(), Summary().c_str());
+	}
+
+private:
+	/// 2のべき乗ごとの区間の分割数(2^SUB_BUCKET_BITS)
+	static const int SUB_BUCKET_BITS = 5;
+	static const int SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+	/// 記録できる最大値のビット数(2^40ns = 約1100秒)
+	static const int MAX_VALUE_BITS = 40;
+	static const int BUCKET_COUNT = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+	unsigned int       mCounts[BUCKET_COUNT]; ///< バケットごとの記録数
+	unsigned long long mCount;                ///< 記録数
+	unsigned long long mSum;                  ///< 合計値
+	unsigned long long mMax;                  ///< 最大値
+	mutable volatile int mLock;               ///< 64bitのアトミック操作がないときのmCount, mSum, mMaxの保護
+
+#if defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_8)
+	void Lock() const
+	{
+	}
+
+	void Unlock() const
+	{
+	}
+
+	// 32bitのターゲット(i386など)でも分断されずに読み出す
+	static unsigned long long Load(const unsigned long long *value)
+	{
+		return __sync_fetch_and_add(const_cast<unsigned long long *>(value), 0);
+	}
+#else
+	void Lock() const
+	{
+		while (__sync_lock_test_and_set(&mLock, 1) != 0) {
+			while (mLock != 0) {
+				CpuRelax();
+			}
+		}
+	}
+
+	void Unlock() const
+	{
+		__sync_lock_release(&mLock);
+	}
+
+	unsigned long long Load(const unsigned long long *value) const
+	{
+		Lock();
+		unsigned long long v = *value;
+		Unlock();
+		return v;
+	}
+#endif
+
+	static int BucketIndex(unsigned long long value)
+	{
+		if (value < static_cast<unsigned long long>(SUB_BUCKET_COUNT * 2)) {
+			return static_cast<int>(value);
+		}
+		// 最上位ビットからSUB_BUCKET_BITS+1ビットを残す(value >> shiftは32以上64未満)
+		int shift = 63 - __builtin_clzll(value) - SUB_BUCKET_BITS;
+		int index = shift * SUB_BUCKET_COUNT + static_cast<int>(value >> shift);
+		return (index < BUCKET_COUNT) ? index : BUCKET_COUNT - 1;
+	}
+
+	static unsigned long long BucketUpperBound(int index)
+	{
+		if (index < SUB_BUCKET_COUNT * 2) {
+			return index;
+		}
+		int shift = index / SUB_BUCKET_COUNT - 1;
+		unsigned long long top = index - shift * SUB_BUCKET_COUNT;
+		return ((top + 1) << shift) - 1;
+	}
+};
+}
+#endif
@@ -0,0 +1,267 @@
+///////////////////////////////////////////////////////////
+/// @file	Lz4Codec.h
+/// @brief	LZ4ブロック形式の圧縮/伸張
+/// @author	shuji-morimoto
+/// Copyright (C) 2013- Mamezou. All rights reserved.
+///////////////////////////////////////////////////////////
+
+#ifndef __PICO_IPC_LZ4_CODEC__
+#define __PICO_IPC_LZ4_CODEC__
+
+#include <cstring>
+
+namespace PicoIPC {
+
+///////////////////////////////////////////////////////////
+/// @class	Lz4Codec
+/// @brief	LZ4ブロック形式の圧縮/伸張
+///
+/// - 外部ライブラリに依存しないLZ4ブロック形式(フレーム形式ではない)の実装
+/// - 圧縮データはliblz4のLZ4_decompress_safe()で伸張できる
+/// - 圧縮はハッシュテーブル(16Kbyte)をスタックに確保する。ヒープは確保しない
+/// - 伸張は入力を検査するため、壊れたデータでも出力バッファを越えて書き込まない
+///
+///////////////////////////////////////////////////////////
+class Lz4Codec
+{
+public:
+	///////////////////////////////////////////////////////////
+	/// @brief		圧縮後の最大サイズを取得する
+	/// @param[in]	size 圧縮前のサイズ
+	/// @return		圧縮後の最大サイズ
+	///////////////////////////////////////////////////////////
+	static size_t CompressBound(size_t size)
+	{
+		return size + size / 255 + 16;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		圧縮する
+	/// @param[in]	src 圧縮前のデータ
+	/// @param[in]	srcSize 圧縮前のサイズ
+	/// @param[out]	dst 圧縮データの出力先
+	/// @param[in]	dstCapacity 出力先のサイズ
+	/// @return		圧縮後のサイズ。出力先に収まらないとき0
+	/// @note		dstCapacity >= CompressBound(srcSize)なら必ず収まる
+	///////////////////////////////////////////////////////////
+	static size_t Compress(const char *src, size_t srcSize, char *dst, size_t dstCapacity)
+	{
+		const unsigned char *in = reinterpret_cast<const unsigned char *>(src);
+		unsigned char *out = reinterpret_cast<unsigned char *>(dst);
+		size_t op = 0;
+		size_t anchor = 0;
+
+		if (srcSize >= MF_LIMIT + 1) {
+			unsigned int table[HASH_SIZE];
+			::memset(table, 0, sizeof(table));
+			const size_t matchLimit = srcSize - LAST_LITERALS;
+			const size_t inputLimit = srcSize - MF_LIMIT;
+			size_t ip = 1;
+			unsigned int searched = 0;
+			table[Hash(Read32(in))] = 0;
+
+			while (ip < inputLimit) {
+				unsigned int sequence = Read32(in + ip);
+				unsigned int h = Hash(sequence);
+				size_t ref = table[h];
+				table[h] = static_cast<unsigned int>(ip);
+				if (ref >= ip || ip - ref > MAX_DISTANCE || Read32(in + ref) != sequence) {
+					// 一致しない区間が続くほど探索間隔を広げる(圧縮できないデータの高速化)
+					ip += 1 + (searched++ >> SKIP_TRIGGER);
+					continue;
+				}
+				searched = 0;
+
+				while (ip > anchor && ref > 0 && in[ip - 1] == in[ref - 1]) {
+					ip--;
+					ref--;
+				}
+				size_t length = MIN_MATCH;
+				while (ip + length < matchLimit && in[ref + length] == in[ip + length]) {
+					length++;
+				}
+
+				op = WriteSequence(out, op, dstCapacity, in + anchor, ip - anchor, ip - ref, length);
+				if (op == 0) {
+					return 0;
+				}
+				ip += length;
+				anchor = ip;
+				if (ip < inputLimit) {
+					table[Hash(Read32(in + ip - 2))] = static_cast<unsigned int>(ip - 2);
+				}
+			}
+		}
+		return WriteLastLiterals(out, op, dstCapacity, in + anchor, srcSize - anchor);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		伸張する
+	/// @param[in]	src 圧縮データ
+	/// @param[in]	srcSize 圧縮データのサイズ
+	/// @param[out]	dst 伸張データの出力先
+	/// @param[in]	dstSize 伸張後のサイズ(圧縮前のサイズ)
+	/// @return		伸張後のサイズがdstSizeと一致したときtrue
+	/// @note		壊れた圧縮データのときはfalseを返す
+	///////////////////////////////////////////////////////////
+	static bool Decompress(const char *src, size_t srcSize, char *dst, size_t dstSize)
+	{
+		const unsigned char *in = reinterpret_cast<const unsigned char *>(src);
+		unsigned char *out = reinterpret_cast<unsigned char *>(dst);
+		size_t ip = 0;
+		size_t op = 0;
+
+		while (ip < srcSize) {
+			unsigned int token = in[ip++];
+
+			size_t literals = token >> 4;
+			if (literals == RUN_MASK && !ReadLength(in, srcSize, ip, literals)) {
+				return false;
+			}
+			if (literals > srcSize - ip || literals > dstSize - op) {
+				return false;
+			}
+			if (literals <= WILD_COPY && srcSize - ip >= WILD_COPY + 2 && dstSize - op >= WILD_COPY) {
+				// 短いリテラルは余裕があれば固定長でコピーする(関数呼び出しを避ける)
+				::memcpy(out + op, in + ip, WILD_COPY);
+			} else {
+				::memcpy(out + op, in + ip, literals);
+			}
+			ip += literals;
+			op += literals;
+			if (ip == srcSize) {
+				// 最後のシーケンスはリテラルのみ
+				return op == dstSize;
+			}
+
+			if (srcSize - ip < 2) {
+				return false;
+			}
+			size_t offset = in[ip] | (in[ip + 1] << 8);
+			ip += 2;
+			if (offset == 0 || offset > op) {
+				return false;
+			}
+			size_t length = token & ML_MASK;
+			if (length == ML_MASK && !ReadLength(in, srcSize, ip, length)) {
+				return false;
+			}
+			length += MIN_MATCH;
+			if (length > dstSize - op) {
+				return false;
+			}
+			const unsigned char *match = out + op - offset;
+			if (offset >= 8 && dstSize - op >= length + 8) {
+				// 8byte単位でコピーする(末尾の超過分は次のシーケンスで上書きされる)
+				for (size_t i = 0; i < length; i += 8) {
+					::memcpy(out + op + i, match + i, 8);
+				}
+			} else if (offset >= length) {
+				::memcpy(out + op, match, length);
+			} else {
+				// 重なりがあるときは1byteずつ複製する(繰り返しパターン)
+				for (size_t i = 0; i < length; i++) {
+					out[op + i] = match[i];
+				}
+			}
+			op += length;
+		}
+		return false;
+	}
+
+private:
+	enum {
+		MIN_MATCH     = 4,     ///< 最小一致長
+		MF_LIMIT      = 12,    ///< 末尾から一致探索しない範囲
+		LAST_LITERALS = 5,     ///< 末尾のリテラルの最小長
+		MAX_DISTANCE  = 65535, ///< 最大オフセット
+		RUN_MASK      = 15,    ///< リテラル長のマスク
+		ML_MASK       = 15,    ///< 一致長のマスク
+		HASH_LOG      = 12,    ///< ハッシュテーブルのビット数
+		HASH_SIZE     = 1 << HASH_LOG,
+		SKIP_TRIGGER  = 6,     ///< 探索間隔を広げる一致しない回数(2^n)
+		WILD_COPY     = 16     ///< 固定長でコピーするリテラルの最大長
+	};
+
+	Lz4Codec();
+
+	static unsigned int Read32(const unsigned char *p)
+	{
+		unsigned int v;
+		::memcpy(&v, p, sizeof(v));
+		return v;
+	}
+
+	static unsigned int Hash(unsigned int sequence)
+	{
+		return (sequence * 2654435761U) >> (32 - HASH_LOG);
+	}
+
+	static bool ReadLength(const unsigned char *in, size_t srcSize, size_t &ip, size_t &length)
+	{
+		unsigned int b;
+		do {
+			if (ip >= srcSize) {
+				return false;
+			}
+			b = in[ip++];
+			length += b;
+		} while (b == 255);
+		return true;
+	}
+
+	static size_t LengthBytes(size_t length)
+	{
+		return length >= 15 ? (length - 15) / 255 + 1 : 0;
+	}
+
+	static size_t WriteLength(unsigned char *out, size_t op, size_t length)
+	{
+		for (length -= 15; length >= 255; length -= 255) {
+			out[op++] = 255;
+		}
+		out[op++] = static_cast<unsigned char>(length);
+		return op;
+	}
+
+	static size_t WriteSequence(unsigned char *out, size_t op, size_t capacity,
+		const unsigned char *literal, size_t literals, size_t offset, size_t length)
+	{
+		size_t matchLength = length - MIN_MATCH;
+		size_t need = 1 + LengthBytes(literals) + literals + 2 + LengthBytes(matchLength);
+		if (need > capacity - op) {
+			return 0;
+		}
+		unsigned char *token = out + op++;
+		*token = static_cast<unsigned char>((literals < RUN_MASK ? literals : static_cast<size_t>(RUN_MASK)) << 4);
+		if (literals >= RUN_MASK) {
+			op = WriteLength(out, op, literals);
+		}
+		::memcpy(out + op, literal, literals);
+		op += literals;
+		out[op++] = static_cast<unsigned char>(offset & 0xff);
+		out[op++] = static_cast<unsigned char>(offset >> 8);
+		*token |= static_cast<unsigned char>(matchLength < ML_MASK ? matchLength : static_cast<size_t>(ML_MASK));
+		if (matchLength >= ML_MASK) {
+			op = WriteLength(out, op, matchLength);
+		}
+		return op;
+	}
+
+	static size_t WriteLastLiterals(unsigned char *out, size_t op, size_t capacity,
+		const unsigned char *literal, size_t literals)
+	{
+		size_t need = 1 + LengthBytes(literals) + literals;
+		if (need > capacity - op) {
+			return 0;
+		}
+		out[op++] = static_cast<unsigned char>((literals < RUN_MASK ? literals : static_cast<size_t>(RUN_MASK)) << 4);
+		if (literals >= RUN_MASK) {
+			op = WriteLength(out, op, literals);
+		}
+		::memcpy(out + op, literal, literals);
+		return op + literals;
+	}
+};
+}
+#endif
@@ -9,14 +9,22 @@
 #define __PICO_IPC_MESSAGE_QUEUE__
 
 #include <mqueue.h>
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+#include <cstring>
 #include <string>
 #include <vector>
 #include "Error.h"
+#include "ErrorCode.h"
+#include "StopToken.h"
 #include "ByteBuffer.h"
+#include "Timespec.h"
 
 namespace PicoIPC {
 
 class MessageQueue;
+template <size_t N> class StaticByteBuffer;
 
 ///////////////////////////////////////////////////////////
 /// @class	INotifyMessage
@@ -187,6 +195,108 @@ public:
 	///////////////////////////////////////////////////////////
 	Error TimedSend(const ByteBuffer &message, unsigned long millisec);
 
+	///////////////////////////////////////////////////////////
+	/// @brief		メッセージキューに固定長バッファのメッセージを送信する
+	/// @param[in]	message メッセージ
+	/// @return		Error 失敗したときエラー内容がErrorに設定される
+	/// @note		Send(const ByteBuffer &)と同じ。ヒープを確保しない
+	/// @note		オーバーフローしたバッファは送信せずエラーとなる
+	///////////////////////////////////////////////////////////
+	template <size_t N>
+	Error Send(const StaticByteBuffer<N> &message)
+	{
+		return TimedSend(message, 0);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		タイムアウト付きでメッセージキューに固定長バッファのメッセージを送信する
+	/// @param[in]	message メッセージ
+	/// @param[in]	millisec ミリ秒
+	/// @return		Error 失敗したときエラー内容がErrorに設定される
+	/// @note		TimedSend(const ByteBuffer &, unsigned long)と同じ。ヒープを確保しない
+	/// @note		オーバーフローしたバッファは送信せずエラーとなる
+	///////////////////////////////////////////////////////////
+	template <size_t N>
+	Error TimedSend(const StaticByteBuffer<N> &message, unsigned long millisec)
+	{
+		if (message.IsOverflow()) {
+			return Error::createError("message queue send error [%s]", "buffer overflow");
+		}
+		return TimedSendCode(message.Data(), message.Size(), millisec).ToError();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		タイムアウト付きでメッセージキューにメッセージを送信する
+	/// @param[in]	message メッセージ
+	/// @param[in]	millisec ミリ秒
+	/// @return		ErrorCode 失敗したときerrnoが設定される
+	/// @note		TimedSend()と同じ。成功時もタイムアウト時もヒープを確保しない
+	/// @note		millisecが0のときは送信できるまでブロックする
+	///////////////////////////////////////////////////////////
+	ErrorCode TimedSendCode(const ByteBuffer &message, unsigned long millisec)
+	{
+		const std::string &data = message.Data();
+		return TimedSendCode(data.data(), data.size(), millisec);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		タイムアウト付きでメッセージキューにメッセージを送信する
+	/// @param[in]	message メッセージ
+	/// @param[in]	millisec ミリ秒
+	/// @return		ErrorCode 失敗したときerrnoが設定される
+	/// @note		オーバーフローしたメッセージはEMSGSIZEとなる
+	///////////////////////////////////////////////////////////
+	template <size_t N>
+	ErrorCode TimedSendCode(const StaticByteBuffer<N> &message, unsigned long millisec)
+	{
+		if (message.IsOverflow()) {
+			return ErrorCode::createError(ErrorCode::MESSAGE_QUEUE, ErrorCode::SEND, EMSGSIZE);
+		}
+		return TimedSendCode(message.Data(), message.Size(), millisec);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		タイムアウト付きでメッセージキューにデータを送信する
+	/// @param[in]	data データ
+	/// @param[in]	size データサイズ
+	/// @param[in]	millisec ミリ秒
+	/// @return		ErrorCode 失敗したときerrnoが設定される
+	/// @note		millisecが0のときは送信できるまでブロックする
+	///////////////////////////////////////////////////////////
+	ErrorCode TimedSendCode(const char *data, size_t size, unsigned long millisec)
+	{
+		if (millisec == 0) {
+			return SendCode(data, size, NULL);
+		}
+		timespec abs = Timespec::After(CLOCK_REALTIME, millisec);
+		return SendCode(data, size, &abs);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		停止要求で中断できるタイムアウト付きのメッセージ送信
+	/// @param[in]	message メッセージ
+	/// @param[in]	millisec ミリ秒(0のときは送信できるか停止要求されるまでブロックする)
+	/// @param[in]	token 停止要求
+	/// @return		ErrorCode 失敗したときerrnoが設定される(停止要求はECANCELED)
+	/// @note		メッセージキューのディスクリプタをpoll()で待つ(Linuxのみ)
+	///////////////////////////////////////////////////////////
+	ErrorCode TimedSendCode(const ByteBuffer &message, unsigned long millisec, const StopToken &token)
+	{
+		const std::string &data = message.Data();
+		timespec expired = { 0, 0 };
+		StopWait wait(millisec);
+		while (true) {
+			ErrorCode code = SendCode(data.data(), data.size(), &expired);
+			if (!code.IsTimeout()) {
+				return code;
+			}
+			ErrorCode waited = wait.Poll(token, mMessageQueue, POLLOUT, ErrorCode::SEND);
+			if (waited) {
+				return waited;
+			}
+		}
+	}
+
 	///////////////////////////////////////////////////////////
 	/// @brief		メッセージキューからメッセージを受信する
 	/// @param[out]	outMessage メッセージ
@@ -207,6 +317,49 @@ public:
 	///////////////////////////////////////////////////////////
 	Error TimedReceive(ByteBuffer &outMessage, unsigned long millisec);
 
+	///////////////////////////////////////////////////////////
+	/// @brief		タイムアウト付きでメッセージキューからメッセージを受信する
+	/// @param[out]	outMessage メッセージ
+	/// @param[in]	millisec ミリ秒
+	/// @return		ErrorCode 失敗したときerrnoが設定される(タイムアウトはETIMEDOUT)
+	/// @note		スレッドごとの受信領域(最初の受信で確保する)に受信し、メッセージ長分だけoutMessageにコピーする<br/>
+	///				同じByteBufferを使い回すと成功時もタイムアウト時もヒープを確保しない
+	/// @note		millisecが0のときは取得できるまでブロックする
+	/// @note		失敗したときoutMessageは空になる
+	///////////////////////////////////////////////////////////
+	ErrorCode TimedReceiveCode(ByteBuffer &outMessage, unsigned long millisec)
+	{
+		if (millisec == 0) {
+			return ReceiveCode(outMessage, NULL);
+		}
+		timespec abs = Timespec::After(CLOCK_REALTIME, millisec);
+		return ReceiveCode(outMessage, &abs);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		停止要求で中断できるタイムアウト付きのメッセージ受信
+	/// @param[out]	outMessage メッセージ
+	/// @param[in]	millisec ミリ秒(0のときは取得できるか停止要求されるまでブロックする)
+	/// @param[in]	token 停止要求
+	/// @return		ErrorCode 失敗したときerrnoが設定される(タイムアウトはETIMEDOUT, 停止要求はECANCELED)
+	/// @note		メッセージキューのディスクリプタをpoll()で待つ(Linuxのみ)
+	///////////////////////////////////////////////////////////
+	ErrorCode TimedReceiveCode(ByteBuffer &outMessage, unsigned long millisec, const StopToken &token)
+	{
+		timespec expired = { 0, 0 };
+		StopWait wait(millisec);
+		while (true) {
+			ErrorCode code = ReceiveCode(outMessage, &expired);
+			if (!code.IsTimeout()) {
+				return code;
+			}
+			ErrorCode waited = wait.Poll(token, mMessageQueue, POLLIN, ErrorCode::RECEIVE);
+			if (waited) {
+				return waited;
+			}
+		}
+	}
+
 	///////////////////////////////////////////////////////////
 	/// @brief		メッセージキューに溜まっているすべてのメッセージを受信する
 	/// @param[out]	outMessages メッセージ一覧
@@ -248,6 +401,131 @@ public:
 	/// @param[in]	maxMessageSize 最大メッセージ長
 	///////////////////////////////////////////////////////////
 	void Init(long maxMessageCount, long maxMessageSize);
+
+private:
+	///////////////////////////////////////////////////////////
+	/// @brief	送信する
+	/// @param[in]	data データ
+	/// @param[in]	size データサイズ
+	/// @param[in]	abs タイムアウトの絶対時刻(NULLのときブロックする)
+	///////////////////////////////////////////////////////////
+	ErrorCode SendCode(const char *data, size_t size, const timespec *abs)
+	{
+		int ret = (abs == NULL) ? ::mq_send(mMessageQueue, data, size, 0)
+			: ::mq_timedsend(mMessageQueue, data, size, 0, abs);
+		if (ret != 0) {
+			return ErrorCode::createError(ErrorCode::MESSAGE_QUEUE, ErrorCode::SEND, errno);
+		}
+		return ErrorCode::createNoError();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief	outMessageの内部バッファに直接受信する
+	/// @param[out]	outMessage メッセージ
+	/// @param[in]	abs タイムアウトの絶対時刻(NULLのときブロックする)
+	///////////////////////////////////////////////////////////
+	ErrorCode ReceiveCode(ByteBuffer &outMessage, const timespec *abs)
+	{
+		long msgsize = (mAttribute.mq_msgsize > 0) ? mAttribute.mq_msgsize : MaxMessageSize();
+		size_t capacity = (msgsize > 0) ? static_cast<size_t>(msgsize) : 1;
+		char *area = ReceiveArea(capacity);
+		std::string &buffer = outMessage.mBuffer;
+		outMessage.mPosition = 0;
+
+		ssize_t size = (abs == NULL) ? ::mq_receive(mMessageQueue, area, capacity, NULL)
+			: ::mq_timedreceive(mMessageQueue, area, capacity, NULL, abs);
+		if (size < 0) {
+			int number = errno;
+			buffer.clear();
+			return ErrorCode::createError(ErrorCode::MESSAGE_QUEUE, ErrorCode::RECEIVE, number);
+		}
+		// outMessageをmsgsizeまで広げる(ゼロ埋めする)と毎回msgsize分を書き込むため、受信した長さのみコピーする
+		buffer.assign(area, static_cast<size_t>(size));
+		return ErrorCode::createNoError();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief	スレッドごとの受信領域を取得する
+	/// @param[in]	capacity 必要なサイズ
+	/// @return		受信領域(スレッドの終了時に開放する)
+	/// @note		最初の受信で確保し、より大きい領域が必要なときのみ確保し直す
+	///////////////////////////////////////////////////////////
+	static char *ReceiveArea(size_t capacity)
+	{
+		static pthread_once_t once = PTHREAD_ONCE_INIT;
+		::pthread_once(&once, CreateReceiveAreaKey);
+		std::vector<char> *area = static_cast<std::vector<char> *>(::pthread_getspecific(ReceiveAreaKey()));
+		if (area == NULL) {
+			area = new std::vector<char>();
+			::pthread_setspecific(ReceiveAreaKey(), area);
+		}
+		if (area->size() < capacity) {
+			area->resize(capacity);
+		}
+		return &(*area)[0];
+	}
+
+	static pthread_key_t &ReceiveAreaKey()
+	{
+		static pthread_key_t key;
+		return key;
+	}
+
+	static void CreateReceiveAreaKey()
+	{
+		::pthread_key_create(&ReceiveAreaKey(), DeleteReceiveArea);
+	}
+
+	static void DeleteReceiveArea(void *area)
+	{
+		delete static_cast<std::vector<char> *>(area);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @class	StopWait
+	/// @brief	停止要求で中断できる待機の残り時間
+	///////////////////////////////////////////////////////////
+	class StopWait
+	{
+	public:
+		explicit StopWait(unsigned long millisec)
+			: mIsInfinite(millisec == 0)
+			, mDeadline(Now() + millisec)
+		{
+		}
+
+		///////////////////////////////////////////////////////////
+		/// @brief	ディスクリプタが準備できるまで待機する
+		/// @return	待機を続けられるときエラーなし、タイムアウト(ETIMEDOUT)または停止要求(ECANCELED)のときエラー
+		///////////////////////////////////////////////////////////
+		ErrorCode Poll(const StopToken &token, mqd_t mq, short events, ErrorCode::SourceType source)
+		{
+			int timeout = -1;
+			if (!mIsInfinite) {
+				unsigned long long now = Now();
+				if (now >= mDeadline) {
+					return ErrorCode::createError(ErrorCode::MESSAGE_QUEUE, source, ETIMEDOUT);
+				}
+				timeout = static_cast<int>(mDeadline - now);
+			}
+			StopToken::WaitResult result = token.Poll(static_cast<int>(mq), events, timeout);
+			if (result == StopToken::WAIT_STOPPED) {
+				return ErrorCode::createError(ErrorCode::MESSAGE_QUEUE, source, ECANCELED);
+			}
+			return ErrorCode::createNoError();
+		}
+
+	private:
+		bool               mIsInfinite; ///< 無期限のときtrue
+		unsigned long long mDeadline;   ///< タイムアウト時刻(CLOCK_MONOTONICのミリ秒)
+
+		static unsigned long long Now()
+		{
+			timespec ts;
+			::clock_gettime(CLOCK_MONOTONIC, &ts);
+			return static_cast<unsigned long long>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+		}
+	};
 };
 }
 #endif
@@ -0,0 +1,161 @@
+///////////////////////////////////////////////////////////
+/// @file	MessageSchema.h
+/// @brief	固定レイアウトのメッセージ定義
+/// @author	shuji-morimoto
+/// Copyright (C) 2013- Mamezou. All rights reserved.
+///////////////////////////////////////////////////////////
+
+#ifndef __PICO_IPC_MESSAGE_SCHEMA__
+#define __PICO_IPC_MESSAGE_SCHEMA__
+
+#include <cstring>
+#include "SerializedView.h"
+
+///////////////////////////////////////////////////////////
+/// メッセージ定義
+///
+/// - フィールドの並びをマクロで定義し、PICO_MESSAGE()/PICO_MESSAGE_ID()で
+///   メッセージの構造体を生成する
+/// - 生成した構造体はフィールドをByteBuffer::Append()した順と同じ形式
+///   (パディングなし)のWire構造体を持ち、各フィールドの位置はコンパイル時に決まる
+/// - AppendTo()はWire構造体へ固定位置で書き込んでから1回のAppend()で追加し、
+///   ValueFrom()は1回のValue()で取り出してから各フィールドに展開する
+///   (フィールドごとのAppend()/Value()の呼び出しがない)
+/// - フィールドは固定長の型(プリミティブ型、プリミティブ型のみで構成された構造体)
+///   とその配列のみ。std::string等の可変長の型はコンパイルエラーとなる
+/// - PICO_MESSAGE_ID()はメッセージIDをint型で先頭に付与する
+///   (受信側はPeekMessageId()でIDを確認してから対応する構造体で取り出す)
+///
+/// 使い方
+///   #define AXIS_FRAME_FIELDS(FIELD, ARRAY)  FIELD(int, counter) ARRAY(double, axis, 33)
+///   PICO_MESSAGE(AxisFrame, AXIS_FRAME_FIELDS)
+///
+///   AxisFrame frame;
+///   frame.counter = 1;
+///   frame.AppendTo(bb);      // ByteBuffer, StaticByteBuffer
+///   frame.ValueFrom(bb);
+///
+///////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////
+/// @brief		コンパイル時に条件を確認する
+/// @param[in]	cond 条件
+/// @param[in]	name 条件が偽のときのエラーメッセージに含まれる名前
+///////////////////////////////////////////////////////////
+#define PICO_STATIC_ASSERT(cond, name) \
+	typedef char pico_static_assert_##name[(cond) ? 1 : -1] __attribute__((unused))
+
+///////////////////////////////////////////////////////////
+/// @brief		メッセージが指定サイズに収まることをコンパイル時に確認する
+/// @param[in]	Name メッセージ名
+/// @param[in]	size 最大サイズ 例) MessageQueueの最大メッセージ長
+///////////////////////////////////////////////////////////
+#define PICO_MESSAGE_ASSERT_SIZE(Name, size) \
+	PICO_STATIC_ASSERT(static_cast<size_t>(Name::WIRE_SIZE) <= static_cast<size_t>(size), Name##_too_big)
+
+///////////////////////////////////////////////////////////
+/// @brief		メッセージIDなしのメッセージを定義する
+/// @param[in]	Name メッセージ名
+/// @param[in]	FIELDS フィールド定義マクロ FIELDS(FIELD, ARRAY)
+///////////////////////////////////////////////////////////
+#define PICO_MESSAGE(Name, FIELDS) \
+	PICO_MESSAGE_DEFINE(Name, -1, FIELDS, PICO_MESSAGE_NO_ID_MEMBER, PICO_MESSAGE_NO_ID_ENCODE, PICO_MESSAGE_NO_ID_CHECK)
+
+///////////////////////////////////////////////////////////
+/// @brief		メッセージIDを先頭に付与するメッセージを定義する
+/// @param[in]	Name メッセージ名
+/// @param[in]	id メッセージID(int)
+/// @param[in]	FIELDS フィールド定義マクロ FIELDS(FIELD, ARRAY)
+///////////////////////////////////////////////////////////
+#define PICO_MESSAGE_ID(Name, id, FIELDS) \
+	PICO_MESSAGE_DEFINE(Name, id, FIELDS, PICO_MESSAGE_ID_MEMBER, PICO_MESSAGE_ID_ENCODE, PICO_MESSAGE_ID_CHECK)
+
+// 以下は内部で利用するマクロ
+
+#define PICO_MESSAGE_MEMBER(type, name) type name;
+#define PICO_MESSAGE_ARRAY_MEMBER(type, name, count) type name[count];
+
+#define PICO_MESSAGE_CHECK(type, name) \
+	PICO_STATIC_ASSERT(PicoIPC::SerializedTraits<type>::FIXED_SIZE, name##_must_be_fixed_size);
+#define PICO_MESSAGE_ARRAY_CHECK(type, name, count) PICO_MESSAGE_CHECK(type, name)
+
+#define PICO_MESSAGE_ENCODE(type, name) _wire.name = name;
+#define PICO_MESSAGE_ARRAY_ENCODE(type, name, count) ::memcpy(_wire.name, name, sizeof(name));
+
+#define PICO_MESSAGE_DECODE(type, name) name = _wire.name;
+#define PICO_MESSAGE_ARRAY_DECODE(type, name, count) ::memcpy(name, _wire.name, sizeof(name));
+
+#define PICO_MESSAGE_NO_ID_MEMBER()
+#define PICO_MESSAGE_NO_ID_ENCODE()
+#define PICO_MESSAGE_NO_ID_CHECK() true
+
+#define PICO_MESSAGE_ID_MEMBER() int messageId;
+#define PICO_MESSAGE_ID_ENCODE() _wire.messageId = MESSAGE_ID;
+#define PICO_MESSAGE_ID_CHECK() (_wire.messageId == MESSAGE_ID)
+
+#define PICO_MESSAGE_DEFINE(Name, id, FIELDS, ID_MEMBER, ID_ENCODE, ID_CHECK) \
+	struct Name \
+	{ \
+		enum { MESSAGE_ID = id }; \
+		FIELDS(PICO_MESSAGE_MEMBER, PICO_MESSAGE_ARRAY_MEMBER) \
+		\
+		struct Wire \
+		{ \
+			ID_MEMBER() \
+			FIELDS(PICO_MESSAGE_MEMBER, PICO_MESSAGE_ARRAY_MEMBER) \
+		} __attribute__((__packed__)); \
+		\
+		enum { WIRE_SIZE = sizeof(Wire) }; \
+		\
+		void Encode(Wire &_wire) const \
+		{ \
+			FIELDS(PICO_MESSAGE_CHECK, PICO_MESSAGE_ARRAY_CHECK) \
+			ID_ENCODE() \
+			FIELDS(PICO_MESSAGE_ENCODE, PICO_MESSAGE_ARRAY_ENCODE) \
+		} \
+		\
+		bool Decode(const Wire &_wire) \
+		{ \
+			if (!ID_CHECK()) { \
+				return false; \
+			} \
+			FIELDS(PICO_MESSAGE_DECODE, PICO_MESSAGE_ARRAY_DECODE) \
+			return true; \
+		} \
+		\
+		template <class Buffer> \
+		void AppendTo(Buffer &_buffer) const \
+		{ \
+			Wire _wire; \
+			Encode(_wire); \
+			_buffer.Append(_wire); \
+		} \
+		\
+		template <class Buffer> \
+		bool ValueFrom(Buffer &_buffer) \
+		{ \
+			Wire _wire; \
+			_buffer.Value(_wire); \
+			return Decode(_wire); \
+		} \
+	}
+
+namespace PicoIPC {
+
+///////////////////////////////////////////////////////////
+/// @brief		データポインタを進めずに先頭のメッセージIDを取得する
+/// @param[in]	buffer ByteBuffer, ByteBufferView, StaticByteBuffer
+/// @return		メッセージID
+/// @note		PICO_MESSAGE_ID()で定義したメッセージの振り分けに利用する
+///////////////////////////////////////////////////////////
+template <class Buffer>
+inline int PeekMessageId(Buffer &buffer)
+{
+	unsigned int position = buffer.Position();
+	int id = 0;
+	buffer.Value(id);
+	buffer.SetPosition(position);
+	return id;
+}
+}
+#endif
@@ -9,6 +9,11 @@
 #define __PICO_IPC_MUTEX__
 
 #include <pthread.h>
+#include <time.h>
+#include <errno.h>
+#include <cstdio>
+#include <cstdlib>
+#include "Timespec.h"
 
 namespace PicoIPC {
 
@@ -23,12 +28,103 @@ namespace PicoIPC {
 class Mutex
 {
 public:
+	/// 生成時に指定する属性(ビットORで組み合わせる)
+	enum Attribute {
+		/// デフォルト(PTHREAD_MUTEX_DEFAULT)
+		ATTRIBUTE_DEFAULT        = 0,
+		/// 優先度継承(PTHREAD_PRIO_INHERIT)<br/>
+		/// ロック中のスレッドの優先度を待機中の最高優先度まで引き上げ、優先度逆転を防ぐ
+		ATTRIBUTE_PRIO_INHERIT   = 1 << 0,
+		/// 適応スピン(PTHREAD_MUTEX_ADAPTIVE_NP)<br/>
+		/// 競合したときすぐにfutexで待機せず、少しスピンしてから待機する(マルチコアの短いクリティカルセクション向け)<br/>
+		/// ATTRIBUTE_PRIO_INHERITと組み合わせたときはスピンしない
+		ATTRIBUTE_ADAPTIVE_SPIN  = 1 << 1,
+		/// プロセス間共有(PTHREAD_PROCESS_SHARED)<br/>
+		/// 共有メモリ上にplacement newで1回だけ生成し、他のプロセスはポインタで利用すること
+		ATTRIBUTE_PROCESS_SHARED = 1 << 2,
+		/// ロバスト(PTHREAD_MUTEX_ROBUST)<br/>
+		/// ロックしたままスレッド(プロセス)が終了しても、次にロックしたスレッドが回復できる。LockConsistent()でロックすること
+		ATTRIBUTE_ROBUST         = 1 << 3,
+		/// エラーチェック(PTHREAD_MUTEX_ERRORCHECK)<br/>
+		/// 同じスレッドからの二重ロックや所有していないスレッドからのUnlock()をエラーにする(ATTRIBUTE_ADAPTIVE_SPINより優先する)
+		ATTRIBUTE_ERROR_CHECK    = 1 << 4
+	};
+
+	/// LockConsistent()の結果
+	enum LockState {
+		LOCK_ACQUIRED,   ///< ロックした
+		LOCK_OWNER_DEAD, ///< 前の所有者がロックしたまま終了していた(保護するデータを修復すること)
+		LOCK_FAILED      ///< ロックできなかった(ENOTRECOVERABLE, EDEADLKなど。Unlock()しないこと)
+	};
+
 	///////////////////////////////////////////////////////////
 	/// @brief		コンストラクタ
 	/// @param[in]	なし
 	///////////////////////////////////////////////////////////
 	Mutex();
 
+	///////////////////////////////////////////////////////////
+	/// @brief		属性を指定するコンストラクタ
+	/// @param[in]	attributes Attributeのビットの組み合わせ
+	/// @note		ATTRIBUTE_PRIO_INHERIT, ATTRIBUTE_ADAPTIVE_SPINは環境が対応していないとき無視する<br/>
+	///				ATTRIBUTE_PROCESS_SHARED, ATTRIBUTE_ROBUSTは環境が対応していないときabort()する
+	///				(共有メモリ上のMutexがプロセス内のMutexとして動作すると排他されないため)<br/>
+	///				事前にIsSupported()で確認すること
+	/// @note		ATTRIBUTE_PROCESS_SHAREDのときは条件変数もプロセス間共有となる
+	///////////////////////////////////////////////////////////
+	explicit Mutex(unsigned int attributes)
+	{
+		unsigned int required = attributes & (ATTRIBUTE_PROCESS_SHARED | ATTRIBUTE_ROBUST);
+		pthread_mutexattr_t attr;
+		::pthread_mutexattr_init(&attr);
+		SetAttributes(attr, attributes);
+		int ret = ::pthread_mutex_init(&mMutex, &attr);
+		::pthread_mutexattr_destroy(&attr);
+		if (ret != 0) {
+			// 組み合わせに対応していないときは、必須の属性のみで生成する
+			::pthread_mutexattr_init(&attr);
+			bool isSupported = SetAttributes(attr, required);
+			ret = ::pthread_mutex_init(&mMutex, &attr);
+			::pthread_mutexattr_destroy(&attr);
+			if (!isSupported || ret != 0) {
+				Abort("mutex", attributes);
+			}
+		} else if (required != 0 && !IsSupported(required)) {
+			Abort("mutex", attributes);
+		}
+
+		pthread_condattr_t condAttr;
+		::pthread_condattr_init(&condAttr);
+		if (attributes & ATTRIBUTE_PROCESS_SHARED) {
+			if (::pthread_condattr_setpshared(&condAttr, PTHREAD_PROCESS_SHARED) != 0) {
+				Abort("condition", attributes);
+			}
+		}
+		::pthread_cond_init(&mCondition, &condAttr);
+		::pthread_condattr_destroy(&condAttr);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		属性の組み合わせに対応しているか確認する
+	/// @param[in]	attributes Attributeのビットの組み合わせ
+	/// @return		すべての属性を設定できるときtrue
+	///////////////////////////////////////////////////////////
+	static bool IsSupported(unsigned int attributes)
+	{
+		pthread_mutexattr_t attr;
+		::pthread_mutexattr_init(&attr);
+		bool isSupported = SetAttributes(attr, attributes);
+		if (isSupported) {
+			pthread_mutex_t mutex;
+			isSupported = (::pthread_mutex_init(&mutex, &attr) == 0);
+			if (isSupported) {
+				::pthread_mutex_destroy(&mutex);
+			}
+		}
+		::pthread_mutexattr_destroy(&attr);
+		return isSupported;
+	}
+
 	///////////////////////////////////////////////////////////
 	/// @brief		デストラクタ
 	///////////////////////////////////////////////////////////
@@ -50,6 +146,27 @@ public:
 	///////////////////////////////////////////////////////////
 	void Unlock();
 
+	///////////////////////////////////////////////////////////
+	/// @brief		ロックを獲得するまで待ち、前の所有者が終了していたときは回復する
+	/// @return		LOCK_ACQUIRED, LOCK_OWNER_DEAD, LOCK_FAILED
+	/// @note		ATTRIBUTE_ROBUSTで生成したMutexはLock()ではなくこちらでロックすること<br/>
+	///				LOCK_OWNER_DEADのときもロックは獲得されており、Mutexは次から通常どおり利用できる<br/>
+	///				LOCK_FAILEDのときはロックしていない(Lock()で回復せずにUnlock()したロバストMutexはENOTRECOVERABLEとなる)
+	///////////////////////////////////////////////////////////
+	LockState LockConsistent()
+	{
+		int ret = ::pthread_mutex_lock(&mMutex);
+#if defined(__GLIBC_PREREQ)
+#if __GLIBC_PREREQ(2, 12)
+		if (ret == EOWNERDEAD) {
+			::pthread_mutex_consistent(&mMutex);
+			return LOCK_OWNER_DEAD;
+		}
+#endif
+#endif
+		return (ret == 0) ? LOCK_ACQUIRED : LOCK_FAILED;
+	}
+
 	///////////////////////////////////////////////////////////
 	/// @brief		このクラスが保持する条件変数を利用して呼び出したスレッドを待機する
     ///              等待利用该班保持的条件变量来调用的线程
@@ -63,6 +180,21 @@ public:
 	///////////////////////////////////////////////////////////
 	void ConditionWait();
 
+	///////////////////////////////////////////////////////////
+	/// @brief		このクラスが保持する条件変数を利用してタイムアウト付きで呼び出したスレッドを待機する
+	/// @param[in]	millisec ミリ秒
+	/// @return		起こされたときtrue、タイムアウトしたときfalse
+	/// @note		このクラスのロックを獲得している(Lock()する)必要がある<br/>
+	///				ConditionWait()と同様に、戻ったときはMutexのロックが獲得された状態となる
+	/// @note		この条件変数はCLOCK_REALTIMEで計時するため、時刻を変更すると待機時間がずれる<br/>
+	///				時刻変更の影響を受けない待機はConditionVariableを利用すること
+	///////////////////////////////////////////////////////////
+	bool ConditionTimedWait(unsigned long millisec)
+	{
+		timespec abs = Timespec::After(CLOCK_REALTIME, millisec);
+		return ::pthread_cond_timedwait(&mCondition, &mMutex, &abs) != ETIMEDOUT;
+	}
+
 	///////////////////////////////////////////////////////////
 	/// @brief		このクラスが保持する条件変数で待機しているスレッドを起こす(シグナル送信する)
 	/// @param[in]	なし
@@ -82,6 +214,46 @@ public:
 	void ConditionBroadcast();
 
 private:
+	friend class ConditionVariable;
+
+	static bool SetAttributes(pthread_mutexattr_t &attr, unsigned int attributes)
+	{
+		bool isSupported = true;
+		if (attributes & ATTRIBUTE_ADAPTIVE_SPIN) {
+#if defined(PTHREAD_ADAPTIVE_MUTEX_INITIALIZER_NP)
+			isSupported = (::pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_ADAPTIVE_NP) == 0) && isSupported;
+#else
+			isSupported = false;
+#endif
+		}
+		if (attributes & ATTRIBUTE_PRIO_INHERIT) {
+			isSupported = (::pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_INHERIT) == 0) && isSupported;
+		}
+		if (attributes & ATTRIBUTE_PROCESS_SHARED) {
+			isSupported = (::pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED) == 0) && isSupported;
+		}
+		if (attributes & ATTRIBUTE_ROBUST) {
+			// pthread_mutexattr_setrobust()はglibc 2.12以降
+			bool isRobust = false;
+#if defined(__GLIBC_PREREQ)
+#if __GLIBC_PREREQ(2, 12)
+			isRobust = (::pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST) == 0);
+#endif
+#endif
+			isSupported = isRobust && isSupported;
+		}
+		if (attributes & ATTRIBUTE_ERROR_CHECK) {
+			isSupported = (::pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_ERRORCHECK) == 0) && isSupported;
+		}
+		return isSupported;
+	}
+
+	static void Abort(const char *target, unsigned int attributes)
+	{
+		::fprintf(stderr, "%s attribute not supported [0x%x]\n", target, attributes);
+		::abort();
+	}
+
 	::pthread_mutex_t mMutex;	  ///< POSIX Mutex
 	::pthread_cond_t  mCondition; ///< 条件変数
 };
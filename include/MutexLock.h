@@ -36,6 +36,27 @@ public:
 	///////////////////////////////////////////////////////////
 	MutexLock(Mutex *mutex, bool isYieldEnd);
 
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @param[in]	mutex Mutex*(Mutex::ATTRIBUTE_ROBUSTで生成したもの)
+	/// @param[out]	state ロックの結果(Mutex::LockConsistent()の戻り値)
+	/// @note		前の所有者がロックしたまま終了していたときはMutexを回復してロックし、
+	///				stateにMutex::LOCK_OWNER_DEADを設定する
+	/// @note		ロックできなかったときはstateにMutex::LOCK_FAILEDを設定し、デストラクタでUnlock()しない<br/>
+	///				このときWait(), Signal()などは呼び出さないこと
+	///////////////////////////////////////////////////////////
+	MutexLock(Mutex *mutex, Mutex::LockState *state)
+		: mMutex(mutex)
+		, mIsYieldEnd(false)
+	{
+		*state = mMutex->LockConsistent();
+		if (*state == Mutex::LOCK_FAILED) {
+			// デストラクタは常にUnlock()するため、誰もロックしないエラーチェックのMutexに付け替える
+			// (所有していないUnlock()はEPERMとなり何もしない)
+			mMutex = &UnownedMutex();
+		}
+	}
+
 	///////////////////////////////////////////////////////////
 	/// @brief		デストラクタ
 	///////////////////////////////////////////////////////////
@@ -50,6 +71,17 @@ public:
 	///////////////////////////////////////////////////////////
 	void Wait();
 
+	///////////////////////////////////////////////////////////
+	/// @brief		呼び出したスレッドがタイムアウト付きでロックを待機する
+	/// @param[in]	millisec ミリ秒
+	/// @return		起こされたときtrue、タイムアウトしたときfalse
+	/// @note		Mutex::ConditionTimedWait()と同じ
+	///////////////////////////////////////////////////////////
+	bool TimedWait(unsigned long millisec)
+	{
+		return mMutex->ConditionTimedWait(millisec);
+	}
+
 	///////////////////////////////////////////////////////////
 	/// @brief		待機中のスレッドの１つを起こす
 	/// @param[in]	なし
@@ -67,6 +99,12 @@ public:
 	void Broadcast();
 
 private:
+	static Mutex &UnownedMutex()
+	{
+		static Mutex mutex(Mutex::ATTRIBUTE_ERROR_CHECK);
+		return mutex;
+	}
+
 	Mutex *mMutex;		///< Mutex
 	bool   mIsYieldEnd; ///< デストラクタ後に呼び出したスレッドがCPU使用権を手放すかどうか
 };
@@ -0,0 +1,297 @@
+///////////////////////////////////////////////////////////
+/// @file	PeriodicThread.h
+/// @brief	一定周期で処理を実行するスレッド
+/// @author	shuji-morimoto
+/// Copyright (C) 2013- Mamezou. All rights reserved.
+///////////////////////////////////////////////////////////
+
+#ifndef __PICO_IPC_PERIODIC_THREAD__
+#define __PICO_IPC_PERIODIC_THREAD__
+
+#include <time.h>
+#include <errno.h>
+#include "ScheduledThread.h"
+#include "LatencyHistogram.h"
+
+namespace PicoIPC {
+
+///////////////////////////////////////////////////////////
+/// @class	IPeriodicRunnable
+/// @brief	周期処理インタフェース
+///////////////////////////////////////////////////////////
+class IPeriodicRunnable
+{
+public:
+	///////////////////////////////////////////////////////////
+	/// @brief		デストラクタ
+	///////////////////////////////////////////////////////////
+	virtual ~IPeriodicRunnable() {};
+
+	///////////////////////////////////////////////////////////
+	/// @brief		1周期分の処理を実装する
+	/// @param[in]	cycle 周期の番号(0～, スキップした周期も数える)
+	/// @return		継続するときtrue、falseを返すとスレッドが終了する
+	/// @note		周期内に終えること
+	///////////////////////////////////////////////////////////
+	virtual bool RunCycle(unsigned long long cycle) = 0;
+
+	///////////////////////////////////////////////////////////
+	/// @brief		周期内に処理が終わらなかったときに呼び出される
+	/// @param[in]	missed 開始時刻を過ぎた周期の数(1以上)
+	/// @note		デフォルトは何もしない
+	///////////////////////////////////////////////////////////
+	virtual void Overrun(unsigned long long missed) {};
+
+	///////////////////////////////////////////////////////////
+	/// @brief		スレッド終了後またはキャンセル後に実施する処理を実装する
+	/// @note		デフォルトは何もしない
+	///////////////////////////////////////////////////////////
+	virtual void Cleanup() {};
+};
+
+///////////////////////////////////////////////////////////
+/// @class	PeriodicThread
+/// @brief	clock_nanosleep(TIMER_ABSTIME)で一定周期ごとにIPeriodicRunnable::RunCycle()を実行するスレッド
+///
+/// - 次の開始時刻は前回の開始時刻 + 周期で決まるため、処理時間や起床遅延が周期に累積しない
+///   (MilliSleep()で待つループは周期 + 処理時間 + 起床遅延となりずれていく)
+/// - 処理が次の開始時刻を過ぎたときはオーバーランとして数え、CatchUpPolicyに従って再開する
+/// - 起床遅延(開始予定時刻からの遅れ)と処理時間をLatencyHistogramに記録する<br/>
+///   実行中に別のスレッドから参照できる
+/// - ScheduledThreadを継承しているため、Start()前にCPUアフィニティやSCHED_FIFOを設定できる
+///
+/// 使い方
+///   PeriodicThread t(&worker, 10000);   // 10ms周期
+///   t.SetSchedPolicy(SCHED_FIFO, 50);
+///   t.Start();
+///   ...
+///   t.WakeJitter().Print("jitter");
+///   t.Stop();
+///   t.Join();
+///
+///////////////////////////////////////////////////////////
+class PeriodicThread : public ScheduledThread
+{
+public:
+	/// オーバーランしたときの再開方法
+	enum CatchUpPolicy {
+		/// 過ぎた周期を飛ばし、次の周期の開始時刻から再開する(位相を保つ)
+		CATCH_UP_SKIP,
+		/// 過ぎた周期を待たずに続けて実行して追いつく(実行回数を保つ)
+		CATCH_UP_RUN_ALL,
+		/// 処理を終えた時刻から周期を数え直す(位相は保たない)
+		CATCH_UP_RESTART
+	};
+
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @param[in]	runnable 周期処理
+	/// @param[in]	periodMicrosec 周期(マイクロ秒, 0のときは1マイクロ秒)
+	/// @param[in]	policy オーバーランしたときの再開方法
+	/// @param[in]	param パラメータ(Thread::Parameter())
+	///////////////////////////////////////////////////////////
+	PeriodicThread(IPeriodicRunnable *runnable, unsigned long periodMicrosec,
+		CatchUpPolicy policy = CATCH_UP_SKIP, void *param = NULL)
+		: ScheduledThread(&mLoop, param)
+		, mLoop(this)
+		, mRunnable(runnable)
+		, mPeriod(static_cast<unsigned long long>((periodMicrosec == 0) ? 1 : periodMicrosec) * 1000)
+		, mPolicy(policy)
+		, mIsStopRequested(false)
+		, mCycleCount(0)
+		, mOverrunCount(0)
+		, mSkippedCount(0)
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		デストラクタ
+	///////////////////////////////////////////////////////////
+	virtual ~PeriodicThread()
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		周期を取得する
+	/// @return		周期(マイクロ秒)
+	///////////////////////////////////////////////////////////
+	unsigned long PeriodMicrosec() const
+	{
+		return static_cast<unsigned long>(mPeriod / 1000);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		スレッドを開始する
+	/// @note		統計はクリアされる。開始済みのときは何もしない
+	///////////////////////////////////////////////////////////
+	void Start()
+	{
+		if (IsActive()) {
+			return;
+		}
+		mIsStopRequested = false;
+		mCycleCount = 0;
+		mOverrunCount = 0;
+		mSkippedCount = 0;
+		mWakeJitter.Clear();
+		mExecutionTime.Clear();
+		ScheduledThread::Start();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		スレッドの終了を要求する
+	/// @note		実行中の周期を終えてから終了する。終了を待つにはJoin()すること
+	///////////////////////////////////////////////////////////
+	void Stop()
+	{
+		mIsStopRequested = true;
+		__sync_synchronize();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		起床遅延のヒストグラムを取得する
+	/// @return		開始予定時刻から起床するまでの遅れ(ナノ秒)
+	///////////////////////////////////////////////////////////
+	const LatencyHistogram &WakeJitter() const
+	{
+		return mWakeJitter;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		処理時間のヒストグラムを取得する
+	/// @return		RunCycle()の処理時間(ナノ秒)
+	///////////////////////////////////////////////////////////
+	const LatencyHistogram &ExecutionTime() const
+	{
+		return mExecutionTime;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		実行した周期の数を取得する
+	/// @return		RunCycle()を呼び出した回数
+	/// @note		32bitターゲットでは2^32で一周する
+	///////////////////////////////////////////////////////////
+	unsigned long CycleCount() const
+	{
+		return __sync_fetch_and_add(const_cast<volatile unsigned long *>(&mCycleCount), 0);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		オーバーランした回数を取得する
+	/// @return		処理が次の開始時刻を過ぎた回数
+	/// @note		32bitターゲットでは2^32で一周する
+	///////////////////////////////////////////////////////////
+	unsigned long OverrunCount() const
+	{
+		return __sync_fetch_and_add(const_cast<volatile unsigned long *>(&mOverrunCount), 0);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		飛ばした周期の数を取得する
+	/// @return		CATCH_UP_SKIP, CATCH_UP_RESTARTで実行しなかった周期の数
+	/// @note		32bitターゲットでは2^32で一周する
+	///////////////////////////////////////////////////////////
+	unsigned long SkippedCount() const
+	{
+		return __sync_fetch_and_add(const_cast<volatile unsigned long *>(&mSkippedCount), 0);
+	}
+
+private:
+	///////////////////////////////////////////////////////////
+	/// @class	Loop
+	/// @brief	周期ループ(ScheduledThreadが設定を適用してから実行する)
+	///////////////////////////////////////////////////////////
+	class Loop : public IRunnable
+	{
+	public:
+		explicit Loop(PeriodicThread *owner)
+			: mOwner(owner)
+		{
+		}
+
+		void Run()
+		{
+			mOwner->RunLoop();
+		}
+
+		void Cleanup()
+		{
+			mOwner->mRunnable->Cleanup();
+		}
+
+	private:
+		PeriodicThread *mOwner; ///< 所有するPeriodicThread
+	};
+
+	Loop                        mLoop;            ///< 周期ループ
+	IPeriodicRunnable          *mRunnable;        ///< 周期処理
+	unsigned long long          mPeriod;          ///< 周期(ナノ秒)
+	CatchUpPolicy               mPolicy;          ///< オーバーランしたときの再開方法
+	volatile bool               mIsStopRequested; ///< 終了を要求したときtrue
+	// 64bitのアトミック操作はARMv7(GCC 4.7未満)でリンクできないため、カウンターはlongとする
+	volatile unsigned long      mCycleCount;      ///< 実行した周期の数
+	volatile unsigned long      mOverrunCount;    ///< オーバーランした回数
+	volatile unsigned long      mSkippedCount;    ///< 飛ばした周期の数
+	LatencyHistogram            mWakeJitter;      ///< 起床遅延
+	LatencyHistogram            mExecutionTime;   ///< 処理時間
+
+	static unsigned long long Now()
+	{
+		timespec ts;
+		::clock_gettime(CLOCK_MONOTONIC, &ts);
+		return static_cast<unsigned long long>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+	}
+
+	static void SleepUntil(unsigned long long deadline)
+	{
+		timespec ts;
+		ts.tv_sec = static_cast<time_t>(deadline / 1000000000ULL);
+		ts.tv_nsec = static_cast<long>(deadline % 1000000000ULL);
+		// シグナルで中断されても絶対時刻なのでそのまま再開できる
+		while (::clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+		}
+	}
+
+	void RunLoop()
+	{
+		unsigned long long cycle = 0;
+		unsigned long long next = Now() + mPeriod;
+		while (!mIsStopRequested) {
+			SleepUntil(next);
+			unsigned long long wake = Now();
+			mWakeJitter.Record((wake > next) ? wake - next : 0);
+
+			bool isContinue = mRunnable->RunCycle(cycle);
+			unsigned long long end = Now();
+			mExecutionTime.Record(end - wake);
+			__sync_fetch_and_add(&mCycleCount, 1);
+			cycle++;
+			next += mPeriod;
+
+			if (end >= next) {
+				unsigned long long missed = (end - next) / mPeriod + 1;
+				__sync_fetch_and_add(&mOverrunCount, 1);
+				mRunnable->Overrun(missed);
+				if (mPolicy == CATCH_UP_SKIP) {
+					next += missed * mPeriod;
+					cycle += missed;
+					__sync_fetch_and_add(&mSkippedCount, static_cast<unsigned long>(missed));
+				} else if (mPolicy == CATCH_UP_RESTART) {
+					next = end + mPeriod;
+					cycle += missed;
+					__sync_fetch_and_add(&mSkippedCount, static_cast<unsigned long>(missed));
+				}
+			}
+			if (!isContinue) {
+				break;
+			}
+		}
+	}
+
+	/// コピー禁止
+	PeriodicThread(const PeriodicThread &);
+	/// 代入禁止
+	PeriodicThread &operator=(const PeriodicThread &);
+};
+}
+#endif
@@ -0,0 +1,300 @@
+///////////////////////////////////////////////////////////
+/// @file	ScheduledThread.h
+/// @brief	CPUアフィニティとスケジューリングポリシーを指定するスレッド
+/// @author	shuji-morimoto
+/// Copyright (C) 2013- Mamezou. All rights reserved.
+///////////////////////////////////////////////////////////
+
+#ifndef __PICO_IPC_SCHEDULED_THREAD__
+#define __PICO_IPC_SCHEDULED_THREAD__
+
+#include <pthread.h>
+#include <sched.h>
+#include <limits.h>
+#include <errno.h>
+#include <cstring>
+#include <string>
+#include "Error.h"
+#include "Thread.h"
+#include "Event.h"
+
+namespace PicoIPC {
+
+///////////////////////////////////////////////////////////
+/// @class	ScheduledThread
+/// @brief	Start()前に指定したCPUアフィニティ, スケジューリングポリシーで動作するスレッド
+///
+/// - 設定はStart()で生成したスレッド自身がExecute()の先頭で適用し、Start()は適用が終わるまで待機する
+/// - Applied*()はStart()後に実際に適用された値を返す
+/// - SCHED_FIFO/SCHED_RRの権限(CAP_SYS_NICE, RLIMIT_RTPRIO)がないときはSCHED_OTHERのまま動作し、
+///   AttributeError()に理由が設定される(スレッドは起動する)
+/// - Thread::Start()は属性を指定できないため、スタックサイズは変更できない(デフォルトはRLIMIT_STACK)<br/>
+///   SetStackSize()の値は必要なサイズとして確認し、足りないときはAttributeError()に理由が設定される
+/// - Start()はThread::Start()を隠蔽するため、ScheduledThreadとして呼び出すこと
+///
+/// 使い方
+///   ScheduledThread t(&worker, &mq);
+///   t.SetAffinity(1);                  // CPU1のみで実行
+///   t.SetSchedPolicy(SCHED_FIFO, 50);
+///   t.SetStackSize(256 * 1024);
+///   t.Start();
+///   if (t.AttributeError()) { ... }     // 権限がなくSCHED_OTHERで動作している
+///
+///////////////////////////////////////////////////////////
+class ScheduledThread : public Thread
+{
+public:
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @note		Threadを継承してExecute()を実装するとき
+	///////////////////////////////////////////////////////////
+	ScheduledThread()
+		: Thread()
+	{
+		Init();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @param[in]	runnable スレッド処理
+	/// @param[in]	param パラメータ
+	///////////////////////////////////////////////////////////
+	ScheduledThread(IRunnable *runnable, void *param)
+		: Thread(runnable, param)
+	{
+		Init();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		デストラクタ
+	///////////////////////////////////////////////////////////
+	virtual ~ScheduledThread()
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		実行するCPUを設定する
+	/// @param[in]	cpuset CPUの集合
+	///////////////////////////////////////////////////////////
+	void SetAffinity(const cpu_set_t &cpuset)
+	{
+		mAffinity = cpuset;
+		mHasAffinity = true;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		実行するCPUを1つ設定する
+	/// @param[in]	cpu CPU番号(0～)
+	///////////////////////////////////////////////////////////
+	void SetAffinity(int cpu)
+	{
+		cpu_set_t cpuset;
+		CPU_ZERO(&cpuset);
+		CPU_SET(cpu, &cpuset);
+		SetAffinity(cpuset);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		スケジューリングポリシーを設定する
+	/// @param[in]	policy SCHED_FIFO, SCHED_RR, SCHED_OTHER
+	/// @param[in]	priority 優先度(SCHED_FIFO/SCHED_RRは1～99, SCHED_OTHERは0)
+	/// @note		優先度はポリシーの範囲に丸める
+	///////////////////////////////////////////////////////////
+	void SetSchedPolicy(int policy, int priority)
+	{
+		mPolicy = policy;
+		mPriority = priority;
+		mHasPolicy = true;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		必要なスタックサイズを設定する
+	/// @param[in]	size スタックサイズ(byte)
+	/// @note		スタックサイズは変更しない。Start()したスレッドのスタックが小さいときはAttributeError()に理由が設定される
+	/// @note		PTHREAD_STACK_MIN未満のときはPTHREAD_STACK_MINとなる
+	///////////////////////////////////////////////////////////
+	void SetStackSize(size_t size)
+	{
+		mStackSize = (size < static_cast<size_t>(PTHREAD_STACK_MIN)) ? static_cast<size_t>(PTHREAD_STACK_MIN) : size;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		スレッドを開始する
+	/// @note		設定を適用するまで待機する。開始済みのときは何もしない
+	///////////////////////////////////////////////////////////
+	void Start()
+	{
+		if (IsActive()) {
+			return;
+		}
+		mApplied.Reset();
+		Thread::Start();
+		if (IsActive()) {
+			mApplied.Wait();
+		}
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		適用された実行するCPUの集合を取得する
+	/// @return		CPUの集合
+	///////////////////////////////////////////////////////////
+	const cpu_set_t &AppliedAffinity() const
+	{
+		return mAppliedAffinity;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		適用されたスケジューリングポリシーを取得する
+	/// @return		SCHED_FIFO, SCHED_RR, SCHED_OTHER
+	///////////////////////////////////////////////////////////
+	int AppliedSchedPolicy() const
+	{
+		return mAppliedPolicy;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		適用された優先度を取得する
+	/// @return		優先度
+	///////////////////////////////////////////////////////////
+	int AppliedSchedPriority() const
+	{
+		return mAppliedPriority;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		適用されたスタックサイズを取得する
+	/// @return		スタックサイズ(byte)
+	///////////////////////////////////////////////////////////
+	size_t AppliedStackSize() const
+	{
+		return mAppliedStackSize;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		設定を適用できなかった理由を取得する
+	/// @return		Error 適用できなかった設定があるときエラー内容がErrorに設定される
+	///////////////////////////////////////////////////////////
+	const Error &AttributeError() const
+	{
+		return mError;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		設定を適用してからスレッド処理を実行する
+	/// @note		継承するときはScheduledThread::Execute()を呼び出すこと
+	///////////////////////////////////////////////////////////
+	virtual void Execute()
+	{
+		Apply();
+		Thread::Execute();
+	}
+
+private:
+	cpu_set_t mAffinity;         ///< 実行するCPU
+	bool      mHasAffinity;      ///< 実行するCPUを設定したときtrue
+	int       mPolicy;           ///< スケジューリングポリシー
+	int       mPriority;         ///< 優先度
+	bool      mHasPolicy;        ///< スケジューリングポリシーを設定したときtrue
+	size_t    mStackSize;        ///< スタックサイズ(0のときデフォルト)
+	cpu_set_t mAppliedAffinity;  ///< 適用された実行するCPU
+	int       mAppliedPolicy;    ///< 適用されたスケジューリングポリシー
+	int       mAppliedPriority;  ///< 適用された優先度
+	size_t    mAppliedStackSize; ///< 適用されたスタックサイズ
+	Error     mError;            ///< 適用できなかった理由
+	Event     mApplied;          ///< 適用したとき設定される
+
+	void Init()
+	{
+		CPU_ZERO(&mAffinity);
+		mHasAffinity = false;
+		mPolicy = SCHED_OTHER;
+		mPriority = 0;
+		mHasPolicy = false;
+		mStackSize = 0;
+		CPU_ZERO(&mAppliedAffinity);
+		mAppliedPolicy = SCHED_OTHER;
+		mAppliedPriority = 0;
+		mAppliedStackSize = 0;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief	生成したスレッド自身に設定を適用する
+	///////////////////////////////////////////////////////////
+	void Apply()
+	{
+		std::string reasons;
+		pthread_t self = ::pthread_self();
+
+		if (mHasAffinity) {
+			int ret = ::pthread_setaffinity_np(self, sizeof(mAffinity), &mAffinity);
+			if (ret != 0) {
+				AddReason(reasons, "affinity", ret);
+			}
+		}
+
+		if (mHasPolicy) {
+			sched_param param;
+			std::memset(&param, 0, sizeof(param));
+			param.sched_priority = ClampPriority(mPolicy, mPriority);
+			int ret = ::pthread_setschedparam(self, mPolicy, &param);
+			if (ret != 0) {
+				// 権限がないときはSCHED_OTHERのまま動作する
+				AddReason(reasons, "sched policy", ret);
+			}
+		}
+
+		cpu_set_t affinity;
+		CPU_ZERO(&affinity);
+		::pthread_getaffinity_np(self, sizeof(affinity), &affinity);
+		int policy = SCHED_OTHER;
+		sched_param param;
+		std::memset(&param, 0, sizeof(param));
+		::pthread_getschedparam(self, &policy, &param);
+		size_t stackSize = 0;
+		pthread_attr_t attr;
+		if (::pthread_getattr_np(self, &attr) == 0) {
+			::pthread_attr_getstacksize(&attr, &stackSize);
+			::pthread_attr_destroy(&attr);
+		}
+		if (mStackSize != 0 && stackSize < mStackSize) {
+			// Thread::Start()は属性を指定できないため、デフォルトのスタックサイズが足りない
+			AddReason(reasons, "stack size", ENOTSUP);
+		}
+
+		mAppliedAffinity = affinity;
+		mAppliedPolicy = policy;
+		mAppliedPriority = param.sched_priority;
+		mAppliedStackSize = stackSize;
+		mError = reasons.empty() ? Error::createNoError() : Error(reasons);
+		mApplied.Set();
+	}
+
+	static int ClampPriority(int policy, int priority)
+	{
+		int min = ::sched_get_priority_min(policy);
+		int max = ::sched_get_priority_max(policy);
+		if (min < 0 || max < 0) {
+			return priority;
+		}
+		return (priority < min) ? min : ((priority > max) ? max : priority);
+	}
+
+	static void AddReason(std::string &reasons, const char *name, int number)
+	{
+		if (!reasons.empty()) {
+			reasons += ", ";
+		}
+		reasons += "thread ";
+		reasons += name;
+		reasons += " error [";
+		reasons += ::strerror(number);
+		reasons += "]";
+	}
+
+	/// コピー禁止
+	ScheduledThread(const ScheduledThread &);
+	/// 代入禁止
+	ScheduledThread &operator=(const ScheduledThread &);
+};
+}
+#endif
@@ -0,0 +1,600 @@
+///////////////////////////////////////////////////////////
+/// @file	SerializedView.h
+/// @brief	シリアライズされたstd::vector/std::mapの参照
+/// @author	shuji-morimoto
+/// Copyright (C) 2013- Mamezou. All rights reserved.
+///////////////////////////////////////////////////////////
+
+#ifndef __PICO_IPC_SERIALIZED_VIEW__
+#define __PICO_IPC_SERIALIZED_VIEW__
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstring>
+
+namespace PicoIPC {
+
+///////////////////////////////////////////////////////////
+/// @struct	SerializedTraits
+/// @brief	ByteBufferでシリアライズされた型Tの読み出し方
+///
+/// - Size() 先頭pから始まるTのシリアライズ後のサイズ
+/// - Read() 先頭pからTを読み出す
+/// - Compare() 先頭pのTとkeyを比較する(<0, 0, >0)。MapViewのキーで利用する
+/// - FIXED_SIZE シリアライズ後のサイズが常にsizeof(T)のときtrue
+///
+/// プリミティブ型またはプリミティブ型のみで構成された構造体はsizeof(T)で
+/// そのまま格納されている
+///////////////////////////////////////////////////////////
+template <class T>
+struct SerializedTraits
+{
+	static const bool FIXED_SIZE = true;
+
+	static size_t Size(const char *p)
+	{
+		return sizeof(T);
+	}
+
+	static void Read(const char *p, T &out)
+	{
+		::memcpy(&out, p, sizeof(T));
+	}
+
+	static int Compare(const char *p, const T &key)
+	{
+		T v;
+		Read(p, v);
+		return (v < key) ? -1 : ((key < v) ? 1 : 0);
+	}
+};
+
+///////////////////////////////////////////////////////////
+/// @brief		size_tはintで格納されている
+///////////////////////////////////////////////////////////
+template <>
+struct SerializedTraits<size_t>
+{
+	static const bool FIXED_SIZE = (sizeof(size_t) == sizeof(int));
+
+	static size_t Size(const char *p)
+	{
+		return sizeof(int);
+	}
+
+	static void Read(const char *p, size_t &out)
+	{
+		int v;
+		::memcpy(&v, p, sizeof(int));
+		out = v;
+	}
+
+	static int Compare(const char *p, const size_t &key)
+	{
+		size_t v;
+		Read(p, v);
+		return (v < key) ? -1 : ((key < v) ? 1 : 0);
+	}
+};
+
+///////////////////////////////////////////////////////////
+/// @brief		std::stringは長さ(int) + 文字列で格納されている
+///////////////////////////////////////////////////////////
+template <>
+struct SerializedTraits<std::string>
+{
+	static const bool FIXED_SIZE = false;
+
+	static size_t Size(const char *p)
+	{
+		int length;
+		::memcpy(&length, p, sizeof(int));
+		return sizeof(int) + length;
+	}
+
+	static void Read(const char *p, std::string &out)
+	{
+		int length;
+		::memcpy(&length, p, sizeof(int));
+		out.assign(p + sizeof(int), length);
+	}
+
+	static int Compare(const char *p, const std::string &key)
+	{
+		// std::string::compare()と同じ順序で比較する(文字列を生成しない)
+		int length;
+		::memcpy(&length, p, sizeof(int));
+		size_t size = length;
+		int ret = ::memcmp(p + sizeof(int), key.data(), (size < key.size()) ? size : key.size());
+		if (ret != 0) {
+			return ret;
+		}
+		return (size < key.size()) ? -1 : ((key.size() < size) ? 1 : 0);
+	}
+};
+
+///////////////////////////////////////////////////////////
+/// @brief		std::vector<T>は要素数(int) + 要素で格納されている
+///////////////////////////////////////////////////////////
+template <class T>
+struct SerializedTraits<std::vector<T> >
+{
+	static const bool FIXED_SIZE = false;
+
+	static size_t Size(const char *p)
+	{
+		int count;
+		::memcpy(&count, p, sizeof(int));
+		if (SerializedTraits<T>::FIXED_SIZE) {
+			return sizeof(int) + count * sizeof(T);
+		}
+		size_t size = sizeof(int);
+		for (int i = 0; i < count; i++) {
+			size += SerializedTraits<T>::Size(p + size);
+		}
+		return size;
+	}
+
+	static void Read(const char *p, std::vector<T> &out)
+	{
+		int count;
+		::memcpy(&count, p, sizeof(int));
+		p += sizeof(int);
+		for (int i = 0; i < count; i++) {
+			T value;
+			SerializedTraits<T>::Read(p, value);
+			p += SerializedTraits<T>::Size(p);
+			out.push_back(value);
+		}
+	}
+};
+
+///////////////////////////////////////////////////////////
+/// @brief		std::map<K,V>は要素数(int) + (キー, 値)で格納されている
+///////////////////////////////////////////////////////////
+template <class K, class V>
+struct SerializedTraits<std::map<K,V> >
+{
+	static const bool FIXED_SIZE = false;
+
+	static size_t Size(const char *p)
+	{
+		int count;
+		::memcpy(&count, p, sizeof(int));
+		if (SerializedTraits<K>::FIXED_SIZE && SerializedTraits<V>::FIXED_SIZE) {
+			return sizeof(int) + count * (sizeof(K) + sizeof(V));
+		}
+		size_t size = sizeof(int);
+		for (int i = 0; i < count; i++) {
+			size += SerializedTraits<K>::Size(p + size);
+			size += SerializedTraits<V>::Size(p + size);
+		}
+		return size;
+	}
+
+	static void Read(const char *p, std::map<K,V> &out)
+	{
+		int count;
+		::memcpy(&count, p, sizeof(int));
+		p += sizeof(int);
+		for (int i = 0; i < count; i++) {
+			K key;
+			SerializedTraits<K>::Read(p, key);
+			p += SerializedTraits<K>::Size(p);
+			V val;
+			SerializedTraits<V>::Read(p, val);
+			p += SerializedTraits<V>::Size(p);
+			out.insert(std::make_pair(key, val));
+		}
+	}
+};
+
+///////////////////////////////////////////////////////////
+/// @class	VectorView
+/// @brief	シリアライズされたstd::vector<T>を展開せずに参照する
+///
+/// - ByteBuffer/ByteBufferViewのValue()で取得する。取得時は要素数を読むだけで
+///   要素は展開しない(参照元のデータポインタは要素の後ろまで進む)
+/// - Next()で先頭から順に、At()で位置を指定して要素を1つずつ読み出す
+/// - Skip()で要素を読み出さずに読み飛ばせる
+/// - Tが固定長のときAt()とSkip()は要素数によらず一定時間で処理する
+/// - 参照先(ByteBuffer等)はVectorViewより長く生存し、変更されないこと
+///
+/// 使い方
+///   VectorView<double> axes;
+///   bb.Value(axes);
+///   double axis;
+///   while (axes.Next(axis)) { ... }
+///
+///////////////////////////////////////////////////////////
+template <class T>
+class VectorView
+{
+public:
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @note		空の参照
+	///////////////////////////////////////////////////////////
+	VectorView()
+		: mBegin(NULL)
+		, mCursor(NULL)
+		, mCount(0)
+		, mIndex(0)
+		, mByteSize(0)
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @param[in]	p シリアライズされたstd::vector<T>の先頭(要素数の位置)
+	///////////////////////////////////////////////////////////
+	explicit VectorView(const char *p)
+	{
+		Reset(p);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		デストラクタ
+	///////////////////////////////////////////////////////////
+	virtual ~VectorView()
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		参照するデータを設定する
+	/// @param[in]	p シリアライズされたstd::vector<T>の先頭(要素数の位置)
+	///////////////////////////////////////////////////////////
+	void Reset(const char *p)
+	{
+		int count;
+		::memcpy(&count, p, sizeof(int));
+		mBegin = p + sizeof(int);
+		mCursor = mBegin;
+		mCount = count;
+		mIndex = 0;
+		mByteSize = SerializedTraits<std::vector<T> >::Size(p);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		要素数を取得する
+	/// @return		要素数
+	///////////////////////////////////////////////////////////
+	size_t Size() const
+	{
+		return mCount;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		要素がないか確認する
+	/// @return		要素がないときtrue
+	///////////////////////////////////////////////////////////
+	bool IsEmpty() const
+	{
+		return mCount == 0;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		要素数を含むシリアライズ後のサイズを取得する
+	/// @return		サイズ
+	///////////////////////////////////////////////////////////
+	size_t ByteSize() const
+	{
+		return mByteSize;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		次に読み出す要素の位置を取得する
+	/// @return		位置(0〜Size())
+	///////////////////////////////////////////////////////////
+	size_t Index() const
+	{
+		return mIndex;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		次の要素を読み出す
+	/// @param[out]	out 要素
+	/// @return		読み出したときtrue、最後まで読み出したときfalse
+	///////////////////////////////////////////////////////////
+	bool Next(T &out)
+	{
+		if (mIndex >= mCount) {
+			return false;
+		}
+		SerializedTraits<T>::Read(mCursor, out);
+		mCursor += SerializedTraits<T>::Size(mCursor);
+		mIndex++;
+		return true;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		要素を読み出さずに読み飛ばす
+	/// @param[in]	count 読み飛ばす要素数
+	/// @return		読み飛ばせたときtrue、要素が足りないときは最後まで進めてfalse
+	///////////////////////////////////////////////////////////
+	bool Skip(size_t count = 1)
+	{
+		bool enough = (mIndex + count <= mCount);
+		size_t n = enough ? count : mCount - mIndex;
+		if (SerializedTraits<T>::FIXED_SIZE) {
+			mCursor += n * sizeof(T);
+		} else {
+			for (size_t i = 0; i < n; i++) {
+				mCursor += SerializedTraits<T>::Size(mCursor);
+			}
+		}
+		mIndex += n;
+		return enough;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		先頭の要素に戻る
+	///////////////////////////////////////////////////////////
+	void Rewind()
+	{
+		mCursor = mBegin;
+		mIndex = 0;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		位置を指定して要素を読み出す
+	/// @param[in]	index 位置
+	/// @param[out]	out 要素
+	/// @return		読み出したときtrue、範囲外のときfalse
+	/// @note		読み出し後はindexの次の要素に位置する
+	///////////////////////////////////////////////////////////
+	bool At(size_t index, T &out)
+	{
+		if (index >= mCount) {
+			return false;
+		}
+		if (index < mIndex) {
+			Rewind();
+		}
+		Skip(index - mIndex);
+		return Next(out);
+	}
+
+private:
+	const char *mBegin;    ///< 最初の要素
+	const char *mCursor;   ///< 次に読み出す要素
+	size_t      mCount;    ///< 要素数
+	size_t      mIndex;    ///< 次に読み出す要素の位置
+	size_t      mByteSize; ///< シリアライズ後のサイズ
+};
+
+///////////////////////////////////////////////////////////
+/// @class	MapView
+/// @brief	シリアライズされたstd::map<K,V>を展開せずに参照する
+///
+/// - ByteBuffer/ByteBufferViewのValue()で取得する。取得時は要素数を読むだけで
+///   要素は展開しない(参照元のデータポインタは要素の後ろまで進む)
+/// - Find()はキーを展開せずに比較して値を1つだけ読み出す
+///   (std::mapはキーの昇順でシリアライズされるため、KとVが固定長のときは二分探索、
+///   それ以外はキーを超えた時点で探索を打ち切る)
+/// - Next()/NextKey()/Skip()で先頭から順に走査できる
+/// - 参照先(ByteBuffer等)はMapViewより長く生存し、変更されないこと
+///
+/// 使い方
+///   MapView<std::string, int> params;
+///   bb.Value(params);
+///   int timeout;
+///   if (params.Find("timeout", timeout)) { ... }
+///
+///////////////////////////////////////////////////////////
+template <class K, class V>
+class MapView
+{
+public:
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @note		空の参照
+	///////////////////////////////////////////////////////////
+	MapView()
+		: mBegin(NULL)
+		, mCursor(NULL)
+		, mCount(0)
+		, mIndex(0)
+		, mByteSize(0)
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @param[in]	p シリアライズされたstd::map<K,V>の先頭(要素数の位置)
+	///////////////////////////////////////////////////////////
+	explicit MapView(const char *p)
+	{
+		Reset(p);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		デストラクタ
+	///////////////////////////////////////////////////////////
+	virtual ~MapView()
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		参照するデータを設定する
+	/// @param[in]	p シリアライズされたstd::map<K,V>の先頭(要素数の位置)
+	///////////////////////////////////////////////////////////
+	void Reset(const char *p)
+	{
+		int count;
+		::memcpy(&count, p, sizeof(int));
+		mBegin = p + sizeof(int);
+		mCursor = mBegin;
+		mCount = count;
+		mIndex = 0;
+		mByteSize = SerializedTraits<std::map<K,V> >::Size(p);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		要素数を取得する
+	/// @return		要素数
+	///////////////////////////////////////////////////////////
+	size_t Size() const
+	{
+		return mCount;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		要素がないか確認する
+	/// @return		要素がないときtrue
+	///////////////////////////////////////////////////////////
+	bool IsEmpty() const
+	{
+		return mCount == 0;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		要素数を含むシリアライズ後のサイズを取得する
+	/// @return		サイズ
+	///////////////////////////////////////////////////////////
+	size_t ByteSize() const
+	{
+		return mByteSize;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		次のキーと値を読み出す
+	/// @param[out]	outKey キー
+	/// @param[out]	outValue 値
+	/// @return		読み出したときtrue、最後まで読み出したときfalse
+	///////////////////////////////////////////////////////////
+	bool Next(K &outKey, V &outValue)
+	{
+		if (!NextKey(outKey)) {
+			return false;
+		}
+		SerializedTraits<V>::Read(mCursor, outValue);
+		mCursor += SerializedTraits<V>::Size(mCursor);
+		return true;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		次のキーを読み出し、値は読み飛ばす
+	/// @param[out]	outKey キー
+	/// @return		読み出したときtrue、最後まで読み出したときfalse
+	///////////////////////////////////////////////////////////
+	bool NextKey(K &outKey)
+	{
+		if (mIndex >= mCount) {
+			return false;
+		}
+		SerializedTraits<K>::Read(mCursor, outKey);
+		mCursor += SerializedTraits<K>::Size(mCursor);
+		mIndex++;
+		return true;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		要素を読み出さずに読み飛ばす
+	/// @param[in]	count 読み飛ばす要素数
+	/// @return		読み飛ばせたときtrue、要素が足りないときは最後まで進めてfalse
+	///////////////////////////////////////////////////////////
+	bool Skip(size_t count = 1)
+	{
+		bool enough = (mIndex + count <= mCount);
+		size_t n = enough ? count : mCount - mIndex;
+		if (IsFixedSize()) {
+			mCursor += n * (sizeof(K) + sizeof(V));
+		} else {
+			for (size_t i = 0; i < n; i++) {
+				mCursor += SerializedTraits<K>::Size(mCursor);
+				mCursor += SerializedTraits<V>::Size(mCursor);
+			}
+		}
+		mIndex += n;
+		return enough;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		先頭の要素に戻る
+	///////////////////////////////////////////////////////////
+	void Rewind()
+	{
+		mCursor = mBegin;
+		mIndex = 0;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		キーを検索して値を読み出す
+	/// @param[in]	key キー
+	/// @param[out]	outValue 値
+	/// @return		見つかったときtrue
+	/// @note		Next()の位置は変わらない
+	///////////////////////////////////////////////////////////
+	bool Find(const K &key, V &outValue) const
+	{
+		const char *p = Lookup(key);
+		if (p == NULL) {
+			return false;
+		}
+		SerializedTraits<V>::Read(p, outValue);
+		return true;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		キーが存在するか確認する
+	/// @param[in]	key キー
+	/// @return		存在するときtrue
+	///////////////////////////////////////////////////////////
+	bool Contains(const K &key) const
+	{
+		return Lookup(key) != NULL;
+	}
+
+private:
+	const char *mBegin;    ///< 最初の要素
+	const char *mCursor;   ///< 次に読み出す要素
+	size_t      mCount;    ///< 要素数
+	size_t      mIndex;    ///< 次に読み出す要素の位置
+	size_t      mByteSize; ///< シリアライズ後のサイズ
+
+	static bool IsFixedSize()
+	{
+		return SerializedTraits<K>::FIXED_SIZE && SerializedTraits<V>::FIXED_SIZE;
+	}
+
+	// キーに対応する値の位置を返す(見つからないときNULL)
+	const char *Lookup(const K &key) const
+	{
+		if (IsFixedSize()) {
+			const size_t stride = sizeof(K) + sizeof(V);
+			size_t low = 0;
+			size_t high = mCount;
+			while (low < high) {
+				size_t middle = low + (high - low) / 2;
+				const char *p = mBegin + middle * stride;
+				int ret = SerializedTraits<K>::Compare(p, key);
+				if (ret == 0) {
+					return p + sizeof(K);
+				}
+				if (ret < 0) {
+					low = middle + 1;
+				} else {
+					high = middle;
+				}
+			}
+			return NULL;
+		}
+		const char *p = mBegin;
+		for (size_t i = 0; i < mCount; i++) {
+			int ret = SerializedTraits<K>::Compare(p, key);
+			if (ret > 0) {
+				return NULL;
+			}
+			p += SerializedTraits<K>::Size(p);
+			if (ret == 0) {
+				return p;
+			}
+			p += SerializedTraits<V>::Size(p);
+		}
+		return NULL;
+	}
+};
+}
+#endif
@@ -0,0 +1,410 @@
+///////////////////////////////////////////////////////////
+/// @file	SlabMessageQueue.h
+/// @brief	共有メモリースラブを利用する大容量メッセージキュー
+/// @author	shuji-morimoto
+/// Copyright (C) 2013- Mamezou. All rights reserved.
+///////////////////////////////////////////////////////////
+
+#ifndef __PICO_IPC_SLAB_MESSAGE_QUEUE__
+#define __PICO_IPC_SLAB_MESSAGE_QUEUE__
+
+#include <mqueue.h>
+#include <time.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "Error.h"
+#include "ByteBuffer.h"
+#include "ByteBufferView.h"
+#include "MessageQueue.h"
+#include "SharedMemory.h"
+#include "Timespec.h"
+
+namespace PicoIPC {
+
+///////////////////////////////////////////////////////////
+/// @struct	SlabHandle
+/// @brief	スラブに配置したメッセージのハンドル
+///
+/// スラブに配置したメッセージの代わりにメッセージキューで送信される
+///
+///////////////////////////////////////////////////////////
+struct SlabHandle
+{
+	unsigned int magic;      ///< SlabMessageQueue::HANDLE_MAGIC(検証用)
+	unsigned int offset;     ///< スラブ先頭からのオフセット
+	unsigned int length;     ///< メッセージ長
+	unsigned int generation; ///< スロットの世代(再利用されたスロットの検出用)
+};
+
+///////////////////////////////////////////////////////////
+/// @class	SlabMessageQueue
+/// @brief	閾値を超えるメッセージを共有メモリースラブ経由で送受信する
+///
+/// - POSIXメッセージキューのメッセージ長は/proc/sys/fs/mqueue/msgsize_maxで
+///   制限され、送受信でカーネルを経由して2回コピーされる
+/// - 閾値を超えるメッセージはメッセージキュー名 + "_slab" の共有メモリーに
+///   確保した固定長スロットに配置し、メッセージキューにはSlabHandleのみ送信する
+/// - 受信側はスラブ上のメッセージをByteBufferViewでコピーせずに参照する
+/// - 閾値以下のメッセージはそのままメッセージキューで送信する
+/// - メッセージキュー上でsizeof(SlabHandle)byteのメッセージはハンドルのみとする(内容で判別しない)<br/>
+///   同じ長さのメッセージは閾値以下でもスラブに配置する(スラブが利用できないときはエラー)
+/// - 送信側と受信側はともにSlabMessageQueueを利用し、同じslotSize, slotCountを
+///   指定すること。スラブの共有メモリーはMessageQueueの所有者が作成/削除する
+///
+/// 受信したByteBufferViewは次のReceive()/TimedReceive()またはRelease()を
+/// コールするまで有効。スロットはそのときに開放される
+///
+/// 受信されずに破棄されたハンドル(MessageQueue::Clear()など)のスロットや、
+/// 受信したプロセスが異常終了して開放されなかったスロットはClear()/Reclaim()で回収する
+///
+/// 使い方
+///   MessageQueue mq("/mq_cloud", 10, 256);
+///   SlabMessageQueue q(&mq, 64 * 1024, 16, 256);
+///   q.Send(bb);
+///
+///   ByteBufferView view;
+///   q.Receive(view);
+///   view.Value(...);
+///   q.Release();
+///
+///////////////////////////////////////////////////////////
+class SlabMessageQueue
+{
+public:
+	/// SlabHandle::magic(ハンドルの検証用。ハンドルかどうかはメッセージ長で判別する)
+	static const unsigned int HANDLE_MAGIC = 0x534c4142;
+
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @param[in]	mq 対象のMessageQueue
+	/// @param[in]	slotSize スロット長(スラブに配置できる最大メッセージ長)
+	/// @param[in]	slotCount スロット数(同時にスラブに配置できるメッセージ数)
+	/// @param[in]	threshold このサイズを超えるメッセージをスラブに配置する
+	/// @note		mqはSlabMessageQueueより長く生存すること
+	/// @note		thresholdはsizeof(SlabHandle)以上とし、mq->MaxMessageSize()以下であること
+	///////////////////////////////////////////////////////////
+	SlabMessageQueue(MessageQueue *mq, size_t slotSize, size_t slotCount, size_t threshold)
+		: mQueue(mq)
+		, mSlabMemory(NULL)
+		, mSlab(NULL)
+		, mSlotSize(slotSize)
+		, mSlotCount(slotCount)
+		, mThreshold(threshold)
+		, mHeldSlot(-1)
+		, mReceiveBuffer(mq->MaxMessageSize() > 0 ? mq->MaxMessageSize() : 1)
+	{
+		std::string name = mq->Name() + "_slab";
+		size_t size = DataOffset() + mSlotSize * mSlotCount;
+		if (mq->mIsOwner) {
+			mSlabMemory = new SharedMemory(name, size, true);
+			mSlab = mSlabMemory->Data<char>();
+			Header()->slotSize = mSlotSize;
+			Header()->slotCount = mSlotCount;
+			Header()->hint = 0;
+		} else if (!SharedMemory::Exist(name)) {
+			mSlabMemory = new SharedMemory(name, size, false);
+			mSlab = mSlabMemory->Data<char>();
+			if (Header()->slotSize != mSlotSize || Header()->slotCount != mSlotCount) {
+				// 作成側と設定が異なるスラブは利用しない
+				mSlab = NULL;
+			}
+		}
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		デストラクタ
+	/// @note		受信中のスロットは開放される
+	///////////////////////////////////////////////////////////
+	virtual ~SlabMessageQueue()
+	{
+		Release();
+		delete mSlabMemory;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		対象のMessageQueueを取得する
+	/// @return		MessageQueue
+	///////////////////////////////////////////////////////////
+	MessageQueue *Queue()
+	{
+		return mQueue;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		スラブに配置する閾値を取得する
+	/// @return		閾値
+	///////////////////////////////////////////////////////////
+	size_t Threshold() const
+	{
+		return mThreshold;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		スラブが利用可能か確認する
+	/// @return		利用可能なときtrue
+	/// @note		スラブの共有メモリーが存在しないか、設定が異なるときfalse
+	///////////////////////////////////////////////////////////
+	bool IsSlabAvailable() const
+	{
+		return mSlab != NULL;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		メッセージキューにメッセージを送信する
+	/// @param[in]	message メッセージ
+	/// @return		Error 失敗したときエラー内容がErrorに設定される
+	/// @note		メッセージキューに空きがない時、空きができるまでブロックする
+	/// @note		空きスロットがないときはブロックせずエラーとなる
+	/// @note		sizeof(SlabHandle)byteのメッセージはスラブに配置する
+	///////////////////////////////////////////////////////////
+	Error Send(const ByteBuffer &message)
+	{
+		return TimedSend(message, 0);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		タイムアウト付きでメッセージキューにメッセージを送信する
+	/// @param[in]	message メッセージ
+	/// @param[in]	millisec ミリ秒
+	/// @return		Error 失敗したときエラー内容がErrorに設定される
+	/// @note		millisecが0のときは送信できるまでブロックする
+	/// @note		空きスロットがないときはブロックせずエラーとなる
+	///////////////////////////////////////////////////////////
+	Error TimedSend(const ByteBuffer &message, unsigned long millisec)
+	{
+		if (message.Size() <= mThreshold && message.Size() != sizeof(SlabHandle)) {
+			return mQueue->TimedSend(message, millisec);
+		}
+		if (mSlab == NULL) {
+			return Error::createError("slab message queue send error [%s]", "slab not available");
+		}
+		if (message.Size() > mSlotSize) {
+			return Error::createError("slab message queue send error [size over %lu > %lu]",
+				static_cast<unsigned long>(message.Size()), static_cast<unsigned long>(mSlotSize));
+		}
+		long slot = Allocate();
+		if (slot < 0) {
+			return Error::createError("slab message queue send error [%s]", "no free slot");
+		}
+		SlabHandle handle;
+		handle.magic = HANDLE_MAGIC;
+		handle.offset = DataOffset() + mSlotSize * slot;
+		handle.length = message.Size();
+		handle.generation = Slots()[slot].generation;
+		::memcpy(mSlab + handle.offset, message.Data().data(), handle.length);
+
+		int ret;
+		if (millisec == 0) {
+			ret = ::mq_send(mQueue->mMessageQueue, reinterpret_cast<const char *>(&handle), sizeof(handle), 0);
+		} else {
+			timespec abs = Timespec::After(CLOCK_REALTIME, millisec);
+			ret = ::mq_timedsend(mQueue->mMessageQueue, reinterpret_cast<const char *>(&handle), sizeof(handle), 0, &abs);
+		}
+		if (ret != 0) {
+			int e = errno;
+			Free(slot);
+			return Error::createError("message queue send error [%s]", ::strerror(e));
+		}
+		return Error::createNoError();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		メッセージキューからメッセージを受信する
+	/// @param[out]	outMessage メッセージの参照
+	/// @return		Error 失敗したときエラー内容がErrorに設定される
+	/// @note		メッセージキューが空の時、新規に追加されたメッセージを取得できるまでブロックする
+	/// @note		前回受信したメッセージのスロットは開放される
+	///////////////////////////////////////////////////////////
+	Error Receive(ByteBufferView &outMessage)
+	{
+		return TimedReceive(outMessage, 0);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		タイムアウト付きでメッセージキューからメッセージを受信する
+	/// @param[out]	outMessage メッセージの参照
+	/// @param[in]	millisec ミリ秒
+	/// @return		Error 失敗したときエラー内容がErrorに設定される
+	/// @note		millisecが0のときは取得できるまでブロックする
+	/// @note		前回受信したメッセージのスロットは開放される
+	///////////////////////////////////////////////////////////
+	Error TimedReceive(ByteBufferView &outMessage, unsigned long millisec)
+	{
+		Release();
+
+		ssize_t size;
+		if (millisec == 0) {
+			size = ::mq_receive(mQueue->mMessageQueue, &mReceiveBuffer[0], mReceiveBuffer.size(), NULL);
+		} else {
+			timespec abs = Timespec::After(CLOCK_REALTIME, millisec);
+			size = ::mq_timedreceive(mQueue->mMessageQueue, &mReceiveBuffer[0], mReceiveBuffer.size(), NULL, &abs);
+		}
+		if (size < 0) {
+			return Error::createError("message queue receive error [%s]", ::strerror(errno));
+		}
+
+		SlabHandle handle;
+		if (size != sizeof(handle)) {
+			outMessage.Reset(&mReceiveBuffer[0], size);
+			return Error::createNoError();
+		}
+		// この長さのメッセージは常にハンドル
+		::memcpy(&handle, &mReceiveBuffer[0], sizeof(handle));
+		if (handle.magic != HANDLE_MAGIC) {
+			return Error::createError("slab message queue receive error [%s]", "invalid handle");
+		}
+		if (mSlab == NULL) {
+			return Error::createError("slab message queue receive error [%s]", "slab not available");
+		}
+		// オフセットはスロットの先頭であること(スロットの途中やヘッダーを指すハンドルは受け付けない)
+		if (handle.offset < DataOffset() || (handle.offset - DataOffset()) % mSlotSize != 0) {
+			return Error::createError("slab message queue receive error [%s]", "invalid handle");
+		}
+		size_t slot = (handle.offset - DataOffset()) / mSlotSize;
+		if (slot >= mSlotCount || handle.length > mSlotSize
+			|| Slots()[slot].generation != handle.generation) {
+			return Error::createError("slab message queue receive error [%s]", "invalid handle");
+		}
+		Slots()[slot].holder = ::getpid();
+		mHeldSlot = static_cast<long>(slot);
+		outMessage.Reset(mSlab + handle.offset, handle.length);
+		return Error::createNoError();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		メッセージキューをクリアし、受信されていないメッセージのスロットを回収する
+	/// @note		送信中のスレッドがないときに呼び出すこと<br/>
+	///				生存しているプロセスが受信中のスロットは回収しない
+	///////////////////////////////////////////////////////////
+	void Clear()
+	{
+		mQueue->Clear();
+		if (mSlab == NULL) {
+			return;
+		}
+		SlabSlot *slots = Slots();
+		for (size_t slot = 0; slot < mSlotCount; slot++) {
+			if (slots[slot].used != 0 && slots[slot].holder == 0) {
+				Free(slot);
+			}
+		}
+		Reclaim();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		受信したプロセスが終了して開放されなかったスロットを回収する
+	/// @return		回収したスロット数
+	/// @note		受信側の異常終了後に、スロットが不足したときなどに呼び出す
+	///////////////////////////////////////////////////////////
+	size_t Reclaim()
+	{
+		if (mSlab == NULL) {
+			return 0;
+		}
+		size_t count = 0;
+		SlabSlot *slots = Slots();
+		for (size_t slot = 0; slot < mSlotCount; slot++) {
+			pid_t holder = slots[slot].holder;
+			if (slots[slot].used != 0 && holder != 0 && ::kill(holder, 0) != 0 && errno == ESRCH) {
+				Free(slot);
+				count++;
+			}
+		}
+		return count;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		受信中のメッセージのスロットを開放する
+	/// @note		開放後は受信したByteBufferViewを参照してはいけない
+	///////////////////////////////////////////////////////////
+	void Release()
+	{
+		if (mHeldSlot >= 0) {
+			Free(mHeldSlot);
+			mHeldSlot = -1;
+		}
+	}
+
+private:
+	///////////////////////////////////////////////////////////
+	/// @brief		コピーコンストラクタ
+	/// @note		コピー禁止
+	///////////////////////////////////////////////////////////
+	SlabMessageQueue(const SlabMessageQueue &src);
+
+	///////////////////////////////////////////////////////////
+	/// @brief		代入オペレータ
+	/// @note		代入禁止
+	///////////////////////////////////////////////////////////
+	SlabMessageQueue &operator =(const SlabMessageQueue &src);
+
+	/// スラブ先頭のヘッダー
+	struct SlabHeader
+	{
+		unsigned int slotSize;  ///< スロット長
+		unsigned int slotCount; ///< スロット数
+		unsigned int hint;      ///< 次に確保を試みるスロット
+	};
+
+	/// スロットの状態
+	struct SlabSlot
+	{
+		unsigned int used;       ///< 使用中のとき1
+		unsigned int generation; ///< 確保するたびに加算される世代
+		pid_t        holder;     ///< 受信したプロセス(受信前は0)
+	};
+
+	MessageQueue      *mQueue;         ///< 対象のMessageQueue
+	SharedMemory      *mSlabMemory;    ///< スラブの共有メモリー
+	char              *mSlab;          ///< スラブの先頭(利用できないときNULL)
+	size_t             mSlotSize;      ///< スロット長
+	size_t             mSlotCount;     ///< スロット数
+	size_t             mThreshold;     ///< スラブに配置する閾値
+	long               mHeldSlot;      ///< 受信中のスロット(なしのとき-1)
+	std::vector<char>  mReceiveBuffer; ///< メッセージキューの受信領域
+
+	SlabHeader *Header()
+	{
+		return reinterpret_cast<SlabHeader *>(mSlab);
+	}
+
+	SlabSlot *Slots()
+	{
+		return reinterpret_cast<SlabSlot *>(mSlab + sizeof(SlabHeader));
+	}
+
+	size_t DataOffset() const
+	{
+		// データ領域はキャッシュライン境界から開始する
+		size_t offset = sizeof(SlabHeader) + sizeof(SlabSlot) * mSlotCount;
+		return (offset + 63) & ~static_cast<size_t>(63);
+	}
+
+	long Allocate()
+	{
+		SlabSlot *slots = Slots();
+		unsigned int start = Header()->hint;
+		for (size_t i = 0; i < mSlotCount; i++) {
+			long slot = (start + i) % mSlotCount;
+			if (__sync_bool_compare_and_swap(&slots[slot].used, 0, 1)) {
+				__sync_fetch_and_add(&slots[slot].generation, 1);
+				Header()->hint = (slot + 1) % mSlotCount;
+				return slot;
+			}
+		}
+		return -1;
+	}
+
+	void Free(long slot)
+	{
+		Slots()[slot].holder = 0;
+		__sync_synchronize();
+		Slots()[slot].used = 0;
+	}
+};
+}
+#endif
@@ -0,0 +1,157 @@
+///////////////////////////////////////////////////////////
+/// @file	SpinPolicy.h
+/// @brief	スピン待機ポリシー
+/// @author	shuji-morimoto
+/// Copyright (C) 2013- Mamezou. All rights reserved.
+///////////////////////////////////////////////////////////
+
+#ifndef __PICO_IPC_SPIN_POLICY__
+#define __PICO_IPC_SPIN_POLICY__
+
+#include <time.h>
+
+namespace PicoIPC {
+
+///////////////////////////////////////////////////////////
+/// @brief		スピン待機中にCPUへ待機中であることを通知する
+/// @note		x86ではpause、ARMv7以降ではyield命令を実行する
+///////////////////////////////////////////////////////////
+inline void CpuRelax()
+{
+#if defined(__i386__) || defined(__x86_64__)
+	__asm__ __volatile__("pause" ::: "memory");
+#elif defined(__ARM_ARCH_7A__) || defined(__ARM_ARCH_7__) || defined(__aarch64__)
+	__asm__ __volatile__("yield" ::: "memory");
+#else
+	__asm__ __volatile__("" ::: "memory");
+#endif
+}
+
+///////////////////////////////////////////////////////////
+/// @class	SpinPolicy
+/// @brief	スピンしてからブロックする待機方式の設定と統計
+///
+/// - 受信待ちでスリープ/起床にかかる時間(数十µs)を避けるため、指定した時間
+///   (スピン予算)だけポーリングしてから通常のブロック待機に移行する
+/// - スピン予算が0のときはスピンせずにすぐブロック待機する(デフォルト)
+/// - スピン予算を大きくすると遅延は小さくなるがCPU使用率は上がる
+/// - スピン中に受信できた回数とブロック待機に移行した回数を記録する
+///
+///////////////////////////////////////////////////////////
+class SpinPolicy
+{
+public:
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @param[in]	spinMicrosec スピン予算(マイクロ秒)
+	///////////////////////////////////////////////////////////
+	SpinPolicy(unsigned long spinMicrosec = 0)
+		: mSpinMicrosec(spinMicrosec)
+		, mSpinHitCount(0)
+		, mBlockCount(0)
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		スピン予算を設定する
+	/// @param[in]	microsec スピン予算(マイクロ秒)
+	/// @note		0のときスピンしない
+	///////////////////////////////////////////////////////////
+	void SetSpinBudget(unsigned long microsec)
+	{
+		mSpinMicrosec = microsec;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		スピン予算を取得する
+	/// @return		スピン予算(マイクロ秒)
+	///////////////////////////////////////////////////////////
+	unsigned long SpinBudget() const
+	{
+		return mSpinMicrosec;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		スピン中に受信できた回数を取得する
+	/// @return		回数
+	///////////////////////////////////////////////////////////
+	unsigned long SpinHitCount() const
+	{
+		return mSpinHitCount;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		ブロック待機に移行した回数を取得する
+	/// @return		回数
+	///////////////////////////////////////////////////////////
+	unsigned long BlockCount() const
+	{
+		return mBlockCount;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		スピン中に受信できた割合を取得する
+	/// @return		0.0〜1.0 (待機していないときは0.0)
+	/// @note		割合が低い場合はスピン予算を減らすとCPU使用率を下げられる
+	///////////////////////////////////////////////////////////
+	double SpinHitRatio() const
+	{
+		unsigned long total = mSpinHitCount + mBlockCount;
+		return (total == 0) ? 0.0 : static_cast<double>(mSpinHitCount) / total;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		統計をクリアする
+	///////////////////////////////////////////////////////////
+	void ClearStatistics()
+	{
+		mSpinHitCount = 0;
+		mBlockCount = 0;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		スピン予算の範囲でpoll()がtrueを返すまでポーリングする
+	/// @param[in]	poll bool operator()()を持つ関数オブジェクト
+	/// @return		スピン中にpoll()がtrueを返したときtrue
+	/// @note		trueのときSpinHitCount()、falseのときBlockCount()を加算する
+	/// @note		falseのとき呼び出し側はブロック待機に移行すること
+	///////////////////////////////////////////////////////////
+	template <class Poll>
+	bool Spin(Poll &poll)
+	{
+		if (mSpinMicrosec == 0) {
+			mBlockCount++;
+			return false;
+		}
+		timespec start;
+		::clock_gettime(CLOCK_MONOTONIC, &start);
+		for (unsigned int i = 0; ; i++) {
+			if (poll()) {
+				mSpinHitCount++;
+				return true;
+			}
+			CpuRelax();
+			// 時刻の取得は一定回数ごとに行う
+			if ((i & (CLOCK_CHECK_INTERVAL - 1)) == 0) {
+				timespec now;
+				::clock_gettime(CLOCK_MONOTONIC, &now);
+				unsigned long elapsed = (now.tv_sec - start.tv_sec) * 1000000 + (now.tv_nsec - start.tv_nsec) / 1000;
+				if (elapsed >= mSpinMicrosec) {
+					break;
+				}
+			}
+		}
+		mBlockCount++;
+		return false;
+	}
+
+private:
+	/// 時刻を確認するポーリング回数(2のべき乗)
+	static const unsigned int CLOCK_CHECK_INTERVAL = 16;
+
+	unsigned long mSpinMicrosec; ///< スピン予算(マイクロ秒)
+	unsigned long mSpinHitCount; ///< スピン中に受信できた回数
+	unsigned long mBlockCount;   ///< ブロック待機に移行した回数
+};
+}
+#endif
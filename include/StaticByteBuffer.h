@@ -0,0 +1,575 @@
+///////////////////////////////////////////////////////////
+/// @file	StaticByteBuffer.h
+/// @brief	固定長Byteバッファ
+/// @author	shuji-morimoto
+/// Copyright (C) 2013- Mamezou. All rights reserved.
+///////////////////////////////////////////////////////////
+
+#ifndef __PICO_IPC_STATIC_BYTE_BUFFER_
+#define __PICO_IPC_STATIC_BYTE_BUFFER_
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdio>
+#include <cstdarg>
+#include <cstring>
+#include "Error.h"
+#include "ByteBuffer.h"
+#include "SerializedView.h"
+
+namespace PicoIPC {
+
+template <size_t N> class StaticByteBufferText;
+
+///////////////////////////////////////////////////////////
+/// @class StaticByteBuffer
+/// @brief	固定長Byteバッファ
+/// @note ByteBufferと同じ形式でシリアライズするが、領域をオブジェクト内部の
+///       固定長配列(Nbyte)に持つため、スタックに置けばヒープを確保しない<br />
+/// @note 周期処理で毎回生成してもmalloc/freeが発生しない<br />
+/// @note 容量を超えるAppend()は領域を拡張せずにErrorを返し、以降IsOverflow()がtrueとなる。
+///       オーバーフローしたバッファはMessageQueue/UnixDomainSocketで送信できない<br />
+/// @note MessageQueue::Send()/TimedSend()、UnixDomainSocket::Send()にそのまま渡せる<br />
+///
+/// 使い方
+///   StaticByteBuffer<512> bb;
+///   bb.Append(counter);
+///   Error err = mq.TimedSend(bb, 10);
+///
+///////////////////////////////////////////////////////////
+template <size_t N>
+class StaticByteBuffer {
+public:
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @return		なし
+	/// @note		空のバッファ
+	///////////////////////////////////////////////////////////
+	StaticByteBuffer()
+		: mSize(0)
+		, mPosition(0)
+		, mOverflow(false)
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @param[in]	_data 初期データ
+	/// @param[in]	_size データサイズ
+	/// @return		なし
+	/// @note		_sizeがNを超えるときはIsOverflow()がtrueの空のバッファとなる
+	///////////////////////////////////////////////////////////
+	StaticByteBuffer(const char *_data, size_t _size)
+		: mSize(0)
+		, mPosition(0)
+		, mOverflow(false)
+	{
+		Write(_data, _size);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		デストラクタ
+	/// @return		なし
+	/// @note
+	///////////////////////////////////////////////////////////
+	virtual ~StaticByteBuffer()
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		容量を取得する
+	/// @return		容量(N)
+	///////////////////////////////////////////////////////////
+	static size_t Capacity()
+	{
+		return N;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		バッファサイズを取得する
+	/// @return		サイズ
+	/// @note
+	///////////////////////////////////////////////////////////
+	size_t Size() const
+	{
+		return mSize;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		バッファの先頭を取得する
+	/// @return		シリアライズされた生データ
+	/// @note
+	///////////////////////////////////////////////////////////
+	const char *Data() const
+	{
+		return mBuffer;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		容量を超えるAppend()があったか確認する
+	/// @return		オーバーフローしたときtrue
+	/// @note		Clear()するまでtrueのまま
+	///////////////////////////////////////////////////////////
+	bool IsOverflow() const
+	{
+		return mOverflow;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		バッファ内容をクリアする
+	/// @note		データポインタの位置とオーバーフローの状態もクリアする
+	///////////////////////////////////////////////////////////
+	void Clear()
+	{
+		mSize = 0;
+		mPosition = 0;
+		mOverflow = false;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		ByteBufferに変換する
+	/// @return		ByteBuffer
+	/// @note		ヒープを確保してコピーするため周期処理では使わないこと
+	///////////////////////////////////////////////////////////
+	ByteBuffer ToByteBuffer() const
+	{
+		return ByteBuffer(mBuffer, mSize);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		ByteBufferを追加する
+	/// @param[in]	_data 書き込むデータ
+	/// @return		Error 容量を超えるときエラー内容がErrorに設定される
+	///////////////////////////////////////////////////////////
+	Error Append(const ByteBuffer &_data)
+	{
+		return AppendSized(_data.Data().data(), _data.Size());
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		文字列(std::string)を追加する
+	/// @param[in]	_data 書き込むデータ
+	/// @return		Error 容量を超えるときエラー内容がErrorに設定される
+	///////////////////////////////////////////////////////////
+	Error Append(const std::string &_data)
+	{
+		return AppendSized(_data.data(), _data.size());
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		文字列(StringView)を追加する
+	/// @param[in]	_data 書き込むデータ
+	/// @return		Error 容量を超えるときエラー内容がErrorに設定される
+	///////////////////////////////////////////////////////////
+	Error Append(const StringView &_data)
+	{
+		return AppendSized(_data.Data(), _data.Size());
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		文字列(const char *)を追加する
+	/// @param[in]	_data 書き込むデータ
+	/// @return		Error 容量を超えるときエラー内容がErrorに設定される
+	/// @note		null('\0')ターミネートしていること
+	///////////////////////////////////////////////////////////
+	Error Append(char *_data)
+	{
+		return AppendSized(_data, ::strlen(_data));
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		フォーマットされた文字列を追加する
+	/// @param[in]	_format フォーマット
+	/// @param[in]	_args 可変長引数
+	/// @return		Error 容量を超えるときエラー内容がErrorに設定される
+	/// @note		ex) buf.Append("[%04d] %s", lineNo, message.c_str());
+	/// @note		バッファの空き領域に直接書式化する
+	///////////////////////////////////////////////////////////
+	Error Append(const char *_format, ...)
+	{
+		size_t head = mSize + sizeof(int);
+		if (mOverflow || head > N) {
+			return Overflow(sizeof(int));
+		}
+		va_list args;
+		va_start(args, _format);
+		int length = ::vsnprintf(mBuffer + head, N - head + 1, _format, args);
+		va_end(args);
+		if (length < 0 || head + length > N) {
+			return Overflow(sizeof(int) + (length < 0 ? 0 : length));
+		}
+		::memcpy(mBuffer + mSize, &length, sizeof(int));
+		mSize = head + length;
+		return Error::createNoError();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		size_tを追加する
+	/// @param[in]	_data 書き込むデータ
+	/// @return		Error 容量を超えるときエラー内容がErrorに設定される
+	/// @note		データはsizeof(int)に収まる値であること
+	///////////////////////////////////////////////////////////
+	Error Append(size_t _data)
+	{
+		int v = _data;
+		return Write(&v, sizeof(v));
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		std::vector<T>を追加する
+	/// @param[in]	_data 書き込むデータ
+	/// @return		Error 容量を超えるときエラー内容がErrorに設定される
+	/// @note
+	/// 要素Tはプリミティブ型またはプリミティブ型のみで構成された構造体のみサポート
+	///////////////////////////////////////////////////////////
+	template <class T>
+	Error Append(const std::vector<T> &_data)
+	{
+		int v = _data.size();
+		Error err = Append(v);
+		for (int i = 0; !err && i < v; i++) {
+			err = Append(_data.at(i));
+		}
+		return err;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		std::map<K,V>を追加する
+	/// @param[in]	_data 書き込むデータ
+	/// @return		Error 容量を超えるときエラー内容がErrorに設定される
+	/// キーK,要素Vはプリミティブ型またはプリミティブ型のみで構成された構造体のみサポート
+	///////////////////////////////////////////////////////////
+	template <class K, class V>
+	Error Append(const std::map<K,V> &_data)
+	{
+		int v = _data.size();
+		Error err = Append(v);
+		typename std::map<K,V>::const_iterator ite = _data.begin();
+		typename std::map<K,V>::const_iterator end = _data.end();
+		for (; !err && ite != end; ite++) {
+			err = Append(ite->first);
+			if (!err) {
+				err = Append(ite->second);
+			}
+		}
+		return err;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		データ型Tを追加する
+	/// @param[in]	_data 書き込むデータ
+	/// @return		Error 容量を超えるときエラー内容がErrorに設定される
+	/// @note
+	/// プリミティブ型 または 要素がプリミティブ型で構成された構造体 のみ利用すること<br />
+	///////////////////////////////////////////////////////////
+	template <class T>
+	Error Append(T _data)
+	{
+		return Write(&_data, sizeof(_data));
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		ByteBufferを取得する
+	/// @param[out]	_out データ
+	/// @note		Append()した順で取り出すこと <br />
+	/// @note		_outにはデータがコピーされる
+	///////////////////////////////////////////////////////////
+	void Value(ByteBuffer &_out)
+	{
+		int size = 0;
+		Value(size);
+		_out = ByteBuffer(mBuffer + mPosition, static_cast<size_t>(size));
+		mPosition += size;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		文字列(std::string)を取得する
+	/// @param[out]	_out データ
+	/// @note		Append()した順で取り出すこと <br />
+	///////////////////////////////////////////////////////////
+	void Value(std::string &_out)
+	{
+		int size = 0;
+		Value(size);
+		_out.assign(mBuffer + mPosition, size);
+		mPosition += size;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		文字列(char *)を取得する
+	/// @param[out]	_out データ
+	/// @note		Append()した順で取り出すこと <br />
+	///////////////////////////////////////////////////////////
+	void Value(char *_out)
+	{
+		int size = 0;
+		Value(size);
+		::memcpy(_out, mBuffer + mPosition, size);
+		_out[size] = '\0';
+		mPosition += size;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		文字列をコピーせずに参照する
+	/// @param[out]	_out バッファ内の文字列の参照
+	/// @note		Append()した順で取り出すこと <br />
+	/// @note		ヒープを確保しない。参照はバッファを変更するまで有効
+	///////////////////////////////////////////////////////////
+	void Value(StringView &_out)
+	{
+		SerializedTraits<StringView>::Read(mBuffer + mPosition, _out);
+		mPosition += sizeof(int) + _out.Size();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		size_t型で値を取得する
+	/// @param[out]	_out データ
+	/// @note		Append()した順で取り出すこと <br />
+	///////////////////////////////////////////////////////////
+	void Value(size_t &_out)
+	{
+		int v = 0;
+		Value(v);
+		_out = v;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		std::vector<T>を取得する
+	/// @param[out]	_out データ
+	/// @note		Append()した順で取り出すこと <br />
+	///////////////////////////////////////////////////////////
+	template <class T>
+	void Value(std::vector<T> &_out)
+	{
+		int size = 0;
+		Value(size);
+		for (int i = 0; i < size; i++) {
+			T value;
+			Value(value);
+			_out.push_back(value);
+		}
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		std::map<K,V>を取得する
+	/// @param[out]	_out データ
+	/// @note		Append()した順で取り出すこと <br />
+	///////////////////////////////////////////////////////////
+	template <class K, class V>
+	void Value(std::map<K,V> &_out)
+	{
+		int size = 0;
+		Value(size);
+		for (int i = 0; i < size; i++) {
+			K key;
+			Value(key);
+			V val;
+			Value(val);
+			_out.insert(std::make_pair(key,val));
+		}
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		std::vector<T>を展開せずに参照する
+	/// @param[out]	_out 参照
+	/// @note		Append()した順で取り出すこと <br />
+	/// @note		データポインタはvectorの後ろまで進む。参照はバッファを変更するまで有効
+	///////////////////////////////////////////////////////////
+	template <class T>
+	void Value(VectorView<T> &_out)
+	{
+		_out.Reset(mBuffer + mPosition);
+		mPosition += _out.ByteSize();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		std::map<K,V>を展開せずに参照する
+	/// @param[out]	_out 参照
+	/// @note		Append()した順で取り出すこと <br />
+	/// @note		データポインタはmapの後ろまで進む。参照はバッファを変更するまで有効
+	///////////////////////////////////////////////////////////
+	template <class K, class V>
+	void Value(MapView<K,V> &_out)
+	{
+		_out.Reset(mBuffer + mPosition);
+		mPosition += _out.ByteSize();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		データ型Tを取り出さずに読み飛ばす
+	/// @note		Append()した順で読み飛ばすこと <br />
+	///////////////////////////////////////////////////////////
+	template <class T>
+	void Skip()
+	{
+		mPosition += SerializedTraits<T>::Size(mBuffer + mPosition);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		データ型Tを取得する
+	/// @param[out]	_out データ
+	/// @note		Append()した順で取り出すこと <br />
+	///////////////////////////////////////////////////////////
+	template <class T>
+	void Value(T &_out)
+	{
+		int size = sizeof(_out);
+		::memcpy(&_out, mBuffer + mPosition, size);
+		mPosition += size;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		データポインタの位置を取得する
+	/// @return		データポインタの位置
+	/// @note
+	///////////////////////////////////////////////////////////
+	unsigned int Position() const
+	{
+		return mPosition;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		データポインタの位置を指定した位置に移動する
+	/// @param[int]	pos 位置
+	/// @note
+	///////////////////////////////////////////////////////////
+	void SetPosition(unsigned int pos)
+	{
+		mPosition = pos;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		バッファ全体のCRC32Cを末尾に追加する
+	/// @return		Error 容量を超えるときエラー内容がErrorに設定される
+	/// @note		送信の直前に呼び出す
+	///////////////////////////////////////////////////////////
+	Error AppendChecksum()
+	{
+		unsigned int crc = Crc32c(mBuffer, mSize);
+		return Write(&crc, sizeof(crc));
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		末尾のCRC32Cを確認する
+	/// @return		一致するときtrue
+	/// @note		一致したときは末尾のCRCを取り除く
+	///////////////////////////////////////////////////////////
+	bool VerifyChecksum()
+	{
+		if (mSize < sizeof(unsigned int)) {
+			return false;
+		}
+		size_t size = mSize - sizeof(unsigned int);
+		unsigned int crc;
+		::memcpy(&crc, mBuffer + size, sizeof(crc));
+		if (crc != Crc32c(mBuffer, size)) {
+			return false;
+		}
+		mSize = size;
+		return true;
+	}
+
+private:
+	friend class StaticByteBufferText<N>;
+
+	char          mBuffer[N + 1]; ///< 内部バッファ(vsnprintfの終端文字の分だけ大きい)
+	size_t        mSize;          ///< データサイズ
+	unsigned int  mPosition;      ///< データポインタ位置
+	bool          mOverflow;      ///< オーバーフローしたときtrue
+
+	Error Overflow(size_t size)
+	{
+		mOverflow = true;
+		return Error::createError("byte buffer overflow [%lu + %lu > %lu]",
+			static_cast<unsigned long>(mSize), static_cast<unsigned long>(size), static_cast<unsigned long>(N));
+	}
+
+	Error Write(const void *data, size_t size)
+	{
+		if (mOverflow || mSize + size > N) {
+			return Overflow(size);
+		}
+		::memcpy(mBuffer + mSize, data, size);
+		mSize += size;
+		return Error::createNoError();
+	}
+
+	Error AppendSized(const char *data, size_t size)
+	{
+		if (mOverflow || mSize + sizeof(int) + size > N) {
+			return Overflow(sizeof(int) + size);
+		}
+		int v = size;
+		::memcpy(mBuffer + mSize, &v, sizeof(int));
+		::memcpy(mBuffer + mSize + sizeof(int), data, size);
+		mSize += sizeof(int) + size;
+		return Error::createNoError();
+	}
+};
+
+///////////////////////////////////////////////////////////
+/// @class	StaticByteBufferText
+/// @brief	StaticByteBufferに直接文字列を整形して追加する
+///
+/// - ByteBufferTextと同じ。ヒープを確保しない
+/// - 容量を超えたときは追加した文字列を取り消し、IsOverflow()がtrueとなる
+///
+/// 使い方
+///   StaticByteBufferText<400>(bb) << "axis " << Fixed(axis, 3);
+///
+///////////////////////////////////////////////////////////
+template <size_t N>
+class StaticByteBufferText : public TextStream<StaticByteBufferText<N> >
+{
+public:
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @param[in]	buffer 追加先
+	///////////////////////////////////////////////////////////
+	explicit StaticByteBufferText(StaticByteBuffer<N> &buffer)
+		: mBuffer(buffer)
+		, mOffset(buffer.mSize)
+	{
+		int length = 0;
+		mBuffer.Write(&length, sizeof(length));
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		デストラクタ
+	/// @note		追加した文字列の長さを書き込む
+	///////////////////////////////////////////////////////////
+	~StaticByteBufferText()
+	{
+		if (mBuffer.mOverflow) {
+			if (mBuffer.mSize > mOffset) {
+				mBuffer.mSize = mOffset;
+			}
+			return;
+		}
+		int length = static_cast<int>(mBuffer.mSize - mOffset - sizeof(int));
+		::memcpy(mBuffer.mBuffer + mOffset, &length, sizeof(length));
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		出力先に書き込む
+	/// @param[in]	data データ
+	/// @param[in]	size データサイズ
+	///////////////////////////////////////////////////////////
+	void Write(const char *data, size_t size)
+	{
+		mBuffer.Write(data, size);
+	}
+
+private:
+	StaticByteBuffer<N> &mBuffer; ///< 追加先
+	size_t               mOffset; ///< 長さを書き込む位置
+
+	/// コピー禁止
+	StaticByteBufferText(const StaticByteBufferText &);
+	/// 代入禁止
+	StaticByteBufferText &operator=(const StaticByteBufferText &);
+};
+}
+
+#endif
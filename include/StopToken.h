@@ -0,0 +1,572 @@
+///////////////////////////////////////////////////////////
+/// @file	StopToken.h
+/// @brief	協調的なスレッドの停止要求
+/// @author	shuji-morimoto
+/// Copyright (C) 2013- Mamezou. All rights reserved.
+///////////////////////////////////////////////////////////
+
+#ifndef __PICO_IPC_STOP_TOKEN__
+#define __PICO_IPC_STOP_TOKEN__
+
+#include <poll.h>
+#include <unistd.h>
+#include <time.h>
+#include <errno.h>
+#include <sys/eventfd.h>
+#include <vector>
+#include "Thread.h"
+#include "Mutex.h"
+#include "MutexLock.h"
+#include "ConditionVariable.h"
+
+namespace PicoIPC {
+
+///////////////////////////////////////////////////////////
+/// @class	StopState
+/// @brief	StopSourceとStopTokenが共有する停止要求の状態(参照カウントで共有する)
+///
+/// - 停止要求はフラグとeventfdに通知する。poll()で待つ処理はeventfdで起きる
+/// - ConditionWait()中のMutex(ConditionVariable)を登録しておき、停止要求時にブロードキャストする
+///
+///////////////////////////////////////////////////////////
+class StopState
+{
+public:
+	StopState()
+		: mRefCount(1)
+		, mIsStopRequested(0)
+		, mBroadcasting(0)
+		, mEventFd(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+	{
+	}
+
+	virtual ~StopState()
+	{
+		if (mEventFd >= 0) {
+			::close(mEventFd);
+		}
+	}
+
+	void AddRef()
+	{
+		__sync_fetch_and_add(&mRefCount, 1);
+	}
+
+	void Release()
+	{
+		if (__sync_sub_and_fetch(&mRefCount, 1) == 0) {
+			delete this;
+		}
+	}
+
+	bool IsStopRequested() const
+	{
+		return mIsStopRequested != 0;
+	}
+
+	int EventFd() const
+	{
+		return mEventFd;
+	}
+
+	bool RequestStop()
+	{
+		if (!__sync_bool_compare_and_swap(&mIsStopRequested, 0, 1)) {
+			return false;
+		}
+		__sync_fetch_and_add(&mBroadcasting, 1);
+		if (mEventFd >= 0) {
+			unsigned long long one = 1;
+			ssize_t ret = ::write(mEventFd, &one, sizeof(one));
+			(void)ret;
+		}
+		// 待機中のMutexをロックしている間は登録一覧をロックしない(ConditionWait()とのデッドロック回避)
+		std::vector<Waiter> waiters;
+		{
+			MutexLock lock(&mMutex);
+			waiters = mWaiters;
+		}
+		for (size_t i = 0; i < waiters.size(); i++) {
+			waiters[i].mutex->Lock();
+			if (waiters[i].condition != NULL) {
+				waiters[i].condition->Broadcast();
+			} else {
+				waiters[i].mutex->ConditionBroadcast();
+			}
+			waiters[i].mutex->Unlock();
+		}
+		__sync_fetch_and_sub(&mBroadcasting, 1);
+		return true;
+	}
+
+	bool ConditionWait(Mutex &mutex, ConditionVariable *condition)
+	{
+		Waiter waiter = { &mutex, condition };
+		{
+			MutexLock lock(&mMutex);
+			mWaiters.push_back(waiter);
+		}
+		// 登録してからフラグを確認するため、RequestStop()のブロードキャストを取りこぼさない
+		bool isStopped = IsStopRequested();
+		if (!isStopped) {
+			if (condition != NULL) {
+				condition->Wait();
+			} else {
+				mutex.ConditionWait();
+			}
+			isStopped = IsStopRequested();
+		}
+		{
+			MutexLock lock(&mMutex);
+			for (size_t i = 0; i < mWaiters.size(); i++) {
+				if (mWaiters[i].mutex == waiter.mutex && mWaiters[i].condition == waiter.condition) {
+					mWaiters.erase(mWaiters.begin() + i);
+					break;
+				}
+			}
+		}
+		if (mBroadcasting != 0) {
+			// RequestStop()がmutexを使い終わるまで待つ(戻った後にmutexを破棄できるように)
+			mutex.Unlock();
+			while (mBroadcasting != 0) {
+				Thread::Yield();
+			}
+			mutex.Lock();
+		}
+		return !isStopped;
+	}
+
+private:
+	/// ConditionWait()中の待機先
+	struct Waiter
+	{
+		Mutex             *mutex;     ///< ロックするMutex
+		ConditionVariable *condition; ///< 条件変数(NULLのときMutexの条件変数)
+	};
+
+	volatile int        mRefCount;        ///< 参照カウント
+	volatile int        mIsStopRequested; ///< 停止要求されたとき1
+	volatile int        mBroadcasting;    ///< RequestStop()が待機中のMutexを起こしている数
+	int                 mEventFd;         ///< 停止要求を通知するeventfd
+	Mutex               mMutex;           ///< mWaitersの排他
+	std::vector<Waiter> mWaiters;         ///< ConditionWait()中の待機先
+
+	StopState(const StopState &);
+	StopState &operator=(const StopState &);
+};
+
+///////////////////////////////////////////////////////////
+/// @class	StopToken
+/// @brief	停止要求を確認し、停止要求で中断できる待機を行う
+///
+/// - IsStopRequested()はvolatile変数の読み込みのみで、ループ内で毎回確認できる
+/// - SleepFor(), ConditionWait(), Poll()は停止要求があるとすぐに戻る
+/// - MessageQueue::TimedReceiveCode()/TimedSendCode()にも指定できる
+/// - デフォルトコンストラクタのStopTokenは停止要求されない
+///
+/// pthread_cancel(Thread::Cancel())と異なり、Run()は任意の位置で中断されないため
+/// Mutexのロックが残ったりCleanup()前の処理が途中で終わることがない
+///
+///////////////////////////////////////////////////////////
+class StopToken
+{
+public:
+	/// Poll()の結果
+	enum WaitResult {
+		WAIT_READY,   ///< ファイルディスクリプタが準備できた
+		WAIT_TIMEOUT, ///< タイムアウトした
+		WAIT_STOPPED  ///< 停止要求された
+	};
+
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @note		停止要求されないStopToken
+	///////////////////////////////////////////////////////////
+	StopToken()
+		: mState(NULL)
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @param[in]	state 停止要求の状態(参照を増やす)
+	///////////////////////////////////////////////////////////
+	explicit StopToken(StopState *state)
+		: mState(state)
+	{
+		if (mState != NULL) {
+			mState->AddRef();
+		}
+	}
+
+	StopToken(const StopToken &other)
+		: mState(other.mState)
+	{
+		if (mState != NULL) {
+			mState->AddRef();
+		}
+	}
+
+	StopToken &operator=(const StopToken &other)
+	{
+		if (other.mState != NULL) {
+			other.mState->AddRef();
+		}
+		if (mState != NULL) {
+			mState->Release();
+		}
+		mState = other.mState;
+		return *this;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		デストラクタ
+	///////////////////////////////////////////////////////////
+	virtual ~StopToken()
+	{
+		if (mState != NULL) {
+			mState->Release();
+		}
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		停止要求されたか確認する
+	/// @return		停止要求されたときtrue
+	///////////////////////////////////////////////////////////
+	bool IsStopRequested() const
+	{
+		return mState != NULL && mState->IsStopRequested();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		停止要求されるか指定時間経過するまで待機する
+	/// @param[in]	millisec ミリ秒
+	/// @return		指定時間待機したときtrue、停止要求されたときfalse
+	///////////////////////////////////////////////////////////
+	bool SleepFor(unsigned long millisec) const
+	{
+		return Poll(-1, 0, static_cast<int>(millisec)) != WAIT_STOPPED;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		停止要求で中断できるMutex::ConditionWait()
+	/// @param[in]	mutex ロックしたMutex
+	/// @return		起こされたときtrue、停止要求されたときfalse
+	/// @note		戻ったときmutexはロックされている。停止要求済みのときは待機しない
+	/// @note		停止要求したスレッドはmutexをロックするため、mutexをロックしたまま
+	/// 			StopSource::RequestStop()を呼び出さないこと
+	///////////////////////////////////////////////////////////
+	bool ConditionWait(Mutex &mutex) const
+	{
+		if (mState == NULL) {
+			mutex.ConditionWait();
+			return true;
+		}
+		return mState->ConditionWait(mutex, NULL);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		停止要求で中断できるConditionVariable::Wait()
+	/// @param[in]	condition 条件変数(対応付けたMutexをロックしていること)
+	/// @return		起こされたときtrue、停止要求されたときfalse
+	/// @note		ConditionWait(Mutex &)と同じ
+	///////////////////////////////////////////////////////////
+	bool ConditionWait(ConditionVariable &condition) const
+	{
+		if (mState == NULL) {
+			condition.Wait();
+			return true;
+		}
+		return mState->ConditionWait(condition.GetMutex(), &condition);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		ファイルディスクリプタが準備できるか、停止要求されるまで待機する
+	/// @param[in]	fd ファイルディスクリプタ(負のときは時間待ちのみ)
+	/// @param[in]	events POLLIN, POLLOUT
+	/// @param[in]	timeoutMillisec タイムアウト(ミリ秒, 負のとき無期限)
+	/// @return		WaitResult
+	///////////////////////////////////////////////////////////
+	WaitResult Poll(int fd, short events, int timeoutMillisec) const
+	{
+		if (IsStopRequested()) {
+			return WAIT_STOPPED;
+		}
+		int eventFd = (mState != NULL) ? mState->EventFd() : -1;
+		if (mState != NULL && eventFd < 0) {
+			// eventfdを利用できないときは一定間隔で確認する
+			return PollSliced(fd, events, timeoutMillisec);
+		}
+		pollfd fds[2];
+		fds[0].fd = fd;
+		fds[0].events = events;
+		fds[0].revents = 0;
+		fds[1].fd = eventFd;
+		fds[1].events = POLLIN;
+		fds[1].revents = 0;
+		unsigned long long deadline = Now() + static_cast<unsigned long long>(timeoutMillisec);
+		while (true) {
+			int ret = ::poll(fds, 2, timeoutMillisec);
+			if (fds[1].revents != 0 || IsStopRequested()) {
+				return WAIT_STOPPED;
+			}
+			if (ret > 0) {
+				return WAIT_READY;
+			}
+			if (ret == 0 || errno != EINTR) {
+				return WAIT_TIMEOUT;
+			}
+			if (timeoutMillisec > 0) {
+				unsigned long long now = Now();
+				timeoutMillisec = (now >= deadline) ? 0 : static_cast<int>(deadline - now);
+			}
+		}
+	}
+
+private:
+	StopState *mState; ///< 停止要求の状態
+
+	static unsigned long long Now()
+	{
+		timespec ts;
+		::clock_gettime(CLOCK_MONOTONIC, &ts);
+		return static_cast<unsigned long long>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+	}
+
+	WaitResult PollSliced(int fd, short events, int timeoutMillisec) const
+	{
+		const int SLICE = 10;
+		pollfd pfd;
+		pfd.fd = fd;
+		pfd.events = events;
+		while (true) {
+			int slice = (timeoutMillisec >= 0 && timeoutMillisec < SLICE) ? timeoutMillisec : SLICE;
+			pfd.revents = 0;
+			int ret = ::poll(&pfd, 1, slice);
+			if (IsStopRequested()) {
+				return WAIT_STOPPED;
+			}
+			if (ret > 0) {
+				return WAIT_READY;
+			}
+			if (timeoutMillisec >= 0) {
+				timeoutMillisec -= slice;
+				if (timeoutMillisec <= 0) {
+					return WAIT_TIMEOUT;
+				}
+			}
+		}
+	}
+};
+
+///////////////////////////////////////////////////////////
+/// @class	StopSource
+/// @brief	停止要求を発行する
+///
+/// 使い方
+///   StopSource source;
+///   StopToken token = source.Token();   // 処理するスレッドに渡す
+///   while (!token.IsStopRequested()) {
+///       token.SleepFor(100);
+///   }
+///   source.RequestStop();               // 別のスレッドから
+///
+///////////////////////////////////////////////////////////
+class StopSource
+{
+public:
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	///////////////////////////////////////////////////////////
+	StopSource()
+		: mState(new StopState())
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		デストラクタ
+	///////////////////////////////////////////////////////////
+	virtual ~StopSource()
+	{
+		mState->Release();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		StopTokenを取得する
+	/// @return		StopToken
+	///////////////////////////////////////////////////////////
+	StopToken Token() const
+	{
+		return StopToken(mState);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		停止要求する
+	/// @return		初めて停止要求したときtrue
+	/// @note		待機中のStopToken::SleepFor(), ConditionWait(), Poll()はすぐに戻る
+	///////////////////////////////////////////////////////////
+	bool RequestStop()
+	{
+		return mState->RequestStop();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		停止要求されたか確認する
+	/// @return		停止要求されたときtrue
+	///////////////////////////////////////////////////////////
+	bool IsStopRequested() const
+	{
+		return mState->IsStopRequested();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		新しい停止要求の状態に入れ替える
+	/// @note		取得済みのStopTokenは以前の状態を参照し続ける
+	///////////////////////////////////////////////////////////
+	void Reset()
+	{
+		StopState *state = new StopState();
+		mState->Release();
+		mState = state;
+	}
+
+private:
+	StopState *mState; ///< 停止要求の状態
+
+	/// コピー禁止
+	StopSource(const StopSource &);
+	/// 代入禁止
+	StopSource &operator=(const StopSource &);
+};
+
+///////////////////////////////////////////////////////////
+/// @class	StoppableThread
+/// @brief	Cancel()の代わりにStopTokenで停止するスレッド
+///
+/// - Run()はStoppableThread::CurrentToken()で取得したStopTokenを確認してループを抜ける
+/// - Stop()は停止要求してからJoin()する(Run()が戻ったあとCleanup()が呼び出される)
+/// - 再度Start()すると新しい停止要求の状態で開始する
+/// - Start()はThread::Start()を隠蔽するため、StoppableThreadとして呼び出すこと
+///
+/// 使い方
+///   void Run() {
+///       StopToken token = StoppableThread::CurrentToken();
+///       while (!token.IsStopRequested()) {
+///           ErrorCode e = mq.TimedReceiveCode(bb, 500, token);
+///           ...
+///       }
+///   }
+///   ...
+///   t.Stop();   // t.Cancel(); t.Join(); の代わり
+///
+///////////////////////////////////////////////////////////
+class StoppableThread : public Thread
+{
+public:
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @note		Threadを継承してExecute()を実装するとき
+	///////////////////////////////////////////////////////////
+	StoppableThread()
+		: Thread()
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @param[in]	runnable スレッド処理
+	/// @param[in]	param パラメータ
+	///////////////////////////////////////////////////////////
+	StoppableThread(IRunnable *runnable, void *param)
+		: Thread(runnable, param)
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		デストラクタ
+	/// @note		実行中のときは停止してから破棄する
+	///////////////////////////////////////////////////////////
+	virtual ~StoppableThread()
+	{
+		Stop();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		呼び出したスレッドのStopTokenを取得する
+	/// @return		StopToken(StoppableThread以外のスレッドでは停止要求されないStopToken)
+	///////////////////////////////////////////////////////////
+	static StopToken CurrentToken()
+	{
+		StoppableThread *thread = Current();
+		return (thread != NULL) ? thread->Token() : StopToken();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		StopTokenを取得する
+	/// @return		StopToken
+	///////////////////////////////////////////////////////////
+	StopToken Token() const
+	{
+		return mSource.Token();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		スレッドを開始する
+	/// @note		停止要求済みのときは新しい停止要求の状態で開始する
+	///////////////////////////////////////////////////////////
+	void Start()
+	{
+		if (IsActive()) {
+			return;
+		}
+		if (mSource.IsStopRequested()) {
+			mSource.Reset();
+		}
+		Thread::Start();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		停止要求する
+	/// @note		終了を待たない
+	///////////////////////////////////////////////////////////
+	void RequestStop()
+	{
+		mSource.RequestStop();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		停止要求してスレッドの終了を待つ
+	///////////////////////////////////////////////////////////
+	void Stop()
+	{
+		RequestStop();
+		Join();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		CurrentToken()で参照できるようにしてからスレッド処理を実行する
+	/// @note		継承するときはStoppableThread::Execute()を呼び出すこと
+	///////////////////////////////////////////////////////////
+	virtual void Execute()
+	{
+		Current() = this;
+		Thread::Execute();
+		Current() = NULL;
+	}
+
+private:
+	StopSource mSource; ///< 停止要求
+
+	static StoppableThread *&Current()
+	{
+		static __thread StoppableThread *current = NULL;
+		return current;
+	}
+
+	/// コピー禁止
+	StoppableThread(const StoppableThread &);
+	/// 代入禁止
+	StoppableThread &operator=(const StoppableThread &);
+};
+}
+#endif
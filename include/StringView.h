@@ -0,0 +1,215 @@
+///////////////////////////////////////////////////////////
+/// @file	StringView.h
+/// @brief	コピーしない文字列の参照
+/// @author	shuji-morimoto
+/// Copyright (C) 2013- Mamezou. All rights reserved.
+///////////////////////////////////////////////////////////
+
+#ifndef __PICO_IPC_STRING_VIEW__
+#define __PICO_IPC_STRING_VIEW__
+
+#include <string>
+#include <cstring>
+#include "SerializedView.h"
+
+namespace PicoIPC {
+
+///////////////////////////////////////////////////////////
+/// @class	StringView
+/// @brief	文字列を先頭ポインタと長さで参照する(std::string_viewの代わり)
+///
+/// - ByteBuffer::Value(StringView &)で取り出すとバッファ内の文字列を直接参照する
+///   (ヒープを確保せず、コピーもしない)
+/// - 参照先のバッファを変更(Append(), Clear(), 破棄)するまで有効
+/// - null('\0')ターミネートしていないため、C文字列が必要なときはToString()すること
+///
+/// 使い方
+///   StringView command;
+///   bb.Value(command);
+///   if (command == "start") { ... }
+///
+///////////////////////////////////////////////////////////
+class StringView
+{
+public:
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @note		空の文字列
+	///////////////////////////////////////////////////////////
+	StringView()
+		: mData("")
+		, mSize(0)
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @param[in]	data 文字列の先頭
+	/// @param[in]	size 文字列の長さ
+	///////////////////////////////////////////////////////////
+	StringView(const char *data, size_t size)
+		: mData(data)
+		, mSize(size)
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @param[in]	data null('\0')ターミネートした文字列
+	///////////////////////////////////////////////////////////
+	StringView(const char *data)
+		: mData(data)
+		, mSize(::strlen(data))
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @param[in]	data 文字列
+	/// @note		dataを変更または破棄するまで有効
+	///////////////////////////////////////////////////////////
+	StringView(const std::string &data)
+		: mData(data.data())
+		, mSize(data.size())
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		文字列の先頭を取得する
+	/// @return		文字列の先頭(null('\0')ターミネートしていない)
+	///////////////////////////////////////////////////////////
+	const char *Data() const
+	{
+		return mData;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		文字列の長さを取得する
+	/// @return		文字列の長さ
+	///////////////////////////////////////////////////////////
+	size_t Size() const
+	{
+		return mSize;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		空の文字列か確認する
+	/// @return		空のときtrue
+	///////////////////////////////////////////////////////////
+	bool IsEmpty() const
+	{
+		return mSize == 0;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		指定した位置の文字を取得する
+	/// @param[in]	index 位置
+	/// @return		文字
+	///////////////////////////////////////////////////////////
+	char operator[](size_t index) const
+	{
+		return mData[index];
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		std::stringにコピーする
+	/// @return		std::string
+	///////////////////////////////////////////////////////////
+	std::string ToString() const
+	{
+		return std::string(mData, mSize);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		比較する
+	/// @param[in]	other 比較する文字列
+	/// @return		<0, 0, >0 (std::string::compare()と同じ順序)
+	///////////////////////////////////////////////////////////
+	int Compare(const StringView &other) const
+	{
+		int ret = ::memcmp(mData, other.mData, (mSize < other.mSize) ? mSize : other.mSize);
+		if (ret != 0) {
+			return ret;
+		}
+		return (mSize < other.mSize) ? -1 : ((other.mSize < mSize) ? 1 : 0);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		指定した文字列で始まるか確認する
+	/// @param[in]	prefix 文字列
+	/// @return		始まるときtrue
+	///////////////////////////////////////////////////////////
+	bool StartsWith(const StringView &prefix) const
+	{
+		return prefix.mSize <= mSize && ::memcmp(mData, prefix.mData, prefix.mSize) == 0;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		ハッシュ値を取得する(FNV-1a)
+	/// @return		ハッシュ値
+	/// @note		文字列によるswitchやハッシュテーブルのキーに利用する
+	///////////////////////////////////////////////////////////
+	unsigned int Hash() const
+	{
+		unsigned int hash = 2166136261U;
+		for (size_t i = 0; i < mSize; i++) {
+			hash ^= static_cast<unsigned char>(mData[i]);
+			hash *= 16777619U;
+		}
+		return hash;
+	}
+
+private:
+	const char *mData; ///< 文字列の先頭
+	size_t      mSize; ///< 文字列の長さ
+};
+
+///////////////////////////////////////////////////////////
+/// @brief		StringView, std::string, const char *を比較する
+///////////////////////////////////////////////////////////
+inline bool operator==(const StringView &a, const StringView &b)
+{
+	return a.Size() == b.Size() && ::memcmp(a.Data(), b.Data(), a.Size()) == 0;
+}
+
+inline bool operator!=(const StringView &a, const StringView &b)
+{
+	return !(a == b);
+}
+
+inline bool operator<(const StringView &a, const StringView &b)
+{
+	return a.Compare(b) < 0;
+}
+
+///////////////////////////////////////////////////////////
+/// @brief		StringViewはstd::stringと同じく長さ(int) + 文字列で格納されている
+/// @note		Read()はシリアライズされた文字列を直接参照する<br/>
+/// 			VectorView<StringView>, MapView<StringView, V>で文字列を生成せずに参照できる
+///////////////////////////////////////////////////////////
+template <>
+struct SerializedTraits<StringView>
+{
+	static const bool FIXED_SIZE = false;
+
+	static size_t Size(const char *p)
+	{
+		return SerializedTraits<std::string>::Size(p);
+	}
+
+	static void Read(const char *p, StringView &out)
+	{
+		int length;
+		::memcpy(&length, p, sizeof(int));
+		out = StringView(p + sizeof(int), static_cast<size_t>(length));
+	}
+
+	static int Compare(const char *p, const StringView &key)
+	{
+		StringView v;
+		Read(p, v);
+		return v.Compare(key);
+	}
+};
+}
+#endif
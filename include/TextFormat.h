@@ -0,0 +1,445 @@
+///////////////////////////////////////////////////////////
+/// @file	TextFormat.h
+/// @brief	型安全な文字列整形
+/// @author	shuji-morimoto
+/// Copyright (C) 2013- Mamezou. All rights reserved.
+///////////////////////////////////////////////////////////
+
+#ifndef __PICO_IPC_TEXT_FORMAT__
+#define __PICO_IPC_TEXT_FORMAT__
+
+#include <string>
+#include <cstdio>
+#include <cstring>
+#include "StringView.h"
+
+namespace PicoIPC {
+
+///////////////////////////////////////////////////////////
+/// @class	TextFormat
+/// @brief	数値を文字列に変換する
+/// @note		出力先には MAX_DIGITS byte以上の領域が必要(null('\0')は付与しない)
+///////////////////////////////////////////////////////////
+class TextFormat
+{
+public:
+	/// 変換結果の最大長
+	enum { MAX_DIGITS = 40 };
+
+	/// Double()の最大精度
+	enum { MAX_PRECISION = 9 };
+
+	///////////////////////////////////////////////////////////
+	/// @brief		符号なし整数を10進数に変換する
+	/// @param[out]	out 出力先
+	/// @param[in]	value 値
+	/// @return		変換後の長さ
+	///////////////////////////////////////////////////////////
+	static size_t UInt(char *out, unsigned long long value)
+	{
+		char buf[24];
+		char *p = buf + sizeof(buf);
+		// 2桁ずつ変換する
+		while (value >= 100) {
+			unsigned int pair = static_cast<unsigned int>(value % 100) * 2;
+			value /= 100;
+			*--p = Digits()[pair + 1];
+			*--p = Digits()[pair];
+		}
+		if (value >= 10) {
+			unsigned int pair = static_cast<unsigned int>(value) * 2;
+			*--p = Digits()[pair + 1];
+			*--p = Digits()[pair];
+		} else {
+			*--p = static_cast<char>('0' + value);
+		}
+		size_t length = buf + sizeof(buf) - p;
+		::memcpy(out, p, length);
+		return length;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		符号付き整数を10進数に変換する
+	/// @param[out]	out 出力先
+	/// @param[in]	value 値
+	/// @return		変換後の長さ
+	///////////////////////////////////////////////////////////
+	static size_t Int(char *out, long long value)
+	{
+		if (value < 0) {
+			*out = '-';
+			return 1 + UInt(out + 1, 0ULL - static_cast<unsigned long long>(value));
+		}
+		return UInt(out, static_cast<unsigned long long>(value));
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		整数を16進数(小文字)に変換する
+	/// @param[out]	out 出力先
+	/// @param[in]	value 値
+	/// @param[in]	width 最小桁数(不足分は'0'で埋める)
+	/// @return		変換後の長さ
+	///////////////////////////////////////////////////////////
+	static size_t Hex(char *out, unsigned long long value, unsigned int width = 0)
+	{
+		char buf[16];
+		size_t length = 0;
+		do {
+			buf[length++] = "0123456789abcdef"[value & 0xf];
+			value >>= 4;
+		} while (value != 0);
+		while (length < width && length < sizeof(buf)) {
+			buf[length++] = '0';
+		}
+		for (size_t i = 0; i < length; i++) {
+			out[i] = buf[length - 1 - i];
+		}
+		return length;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		浮動小数点数を固定小数点表記(%.nf)に変換する
+	/// @param[out]	out 出力先
+	/// @param[in]	value 値
+	/// @param[in]	precision 小数点以下の桁数(0～MAX_PRECISION)
+	/// @return		変換後の長さ
+	/// @note		整数部が2^64以上のときはsnprintf("%.*g")で変換する<br/>
+	///				端数が丸めの境界(0.5)に近く乗算の誤差で丸め方が決まらないときはsnprintf("%.*f")で変換する
+	///////////////////////////////////////////////////////////
+	static size_t Double(char *out, double value, unsigned int precision = 6)
+	{
+		if (precision > MAX_PRECISION) {
+			precision = MAX_PRECISION;
+		}
+		if (value != value) {
+			::memcpy(out, "nan", 3);
+			return 3;
+		}
+		size_t length = 0;
+		if (value < 0 || (value == 0 && 1 / value < 0)) {
+			out[length++] = '-';
+			value = -value;
+		}
+		if (value >= 18446744073709551616.0) {
+			if (value > 1.7976931348623157e308) {
+				::memcpy(out + length, "inf", 3);
+				return length + 3;
+			}
+			int n = ::snprintf(out + length, MAX_DIGITS - length, "%.*g", static_cast<int>(precision), value);
+			return length + static_cast<size_t>(n);
+		}
+
+		// 整数部と小数部に分ける(小数部の抽出は誤差なし)
+		unsigned long long integer = static_cast<unsigned long long>(value);
+		double scale = Pow10(precision);
+		double scaled = (value - static_cast<double>(integer)) * scale;
+		unsigned long long fraction = static_cast<unsigned long long>(scaled);
+		double rest = scaled - static_cast<double>(fraction);
+		// 乗算の誤差(最大0.5ulp)で0.5との大小が決まらないときはprintfに任せる
+		// ex) 1.85は1.8500000000000000888...のため"%.1f"は"1.9"だが、乗算の結果は8.5になる
+		double bound = (scaled + 1) * RoundingError();
+		if (rest - 0.5 <= bound && 0.5 - rest <= bound) {
+			int n = ::snprintf(out + length, MAX_DIGITS - length, "%.*f", static_cast<int>(precision), value);
+			return length + static_cast<size_t>(n);
+		}
+		if (rest > 0.5) {
+			fraction++;
+		}
+		if (fraction >= static_cast<unsigned long long>(scale)) {
+			fraction -= static_cast<unsigned long long>(scale);
+			integer++;
+		}
+
+		length += UInt(out + length, integer);
+		if (precision > 0) {
+			out[length++] = '.';
+			char *p = out + length + precision;
+			for (unsigned int i = 0; i < precision; i++) {
+				*--p = static_cast<char>('0' + fraction % 10);
+				fraction /= 10;
+			}
+			length += precision;
+		}
+		return length;
+	}
+
+private:
+	TextFormat();
+
+	static const char *Digits()
+	{
+		return
+			"00010203040506070809"
+			"10111213141516171819"
+			"20212223242526272829"
+			"30313233343536373839"
+			"40414243444546474849"
+			"50515253545556575859"
+			"60616263646566676869"
+			"70717273747576777879"
+			"80818283848586878889"
+			"90919293949596979899";
+	}
+
+	// Double()の乗算の相対誤差の上限(2^-53に余裕を持たせた値)
+	static double RoundingError()
+	{
+		return 1e-15;
+	}
+
+	static double Pow10(unsigned int n)
+	{
+		double v = 1;
+		while (n-- > 0) {
+			v *= 10;
+		}
+		return v;
+	}
+};
+
+///////////////////////////////////////////////////////////
+/// @struct	FixedFormat
+/// @brief	浮動小数点数の小数点以下の桁数を指定する
+/// @note		Fixed()で生成する
+///////////////////////////////////////////////////////////
+struct FixedFormat
+{
+	double       value;     ///< 値
+	unsigned int precision; ///< 小数点以下の桁数
+};
+
+///////////////////////////////////////////////////////////
+/// @struct	HexFormat
+/// @brief	16進数で出力する
+/// @note		Hex()で生成する
+///////////////////////////////////////////////////////////
+struct HexFormat
+{
+	unsigned long long value; ///< 値
+	unsigned int       width; ///< 最小桁数
+};
+
+///////////////////////////////////////////////////////////
+/// @struct	PadFormat
+/// @brief	整数を指定した桁数で右寄せする
+/// @note		Pad()で生成する
+///////////////////////////////////////////////////////////
+struct PadFormat
+{
+	long long    value; ///< 値
+	unsigned int width; ///< 最小桁数
+	char         fill;  ///< 埋める文字
+};
+
+///////////////////////////////////////////////////////////
+/// @brief		小数点以下の桁数を指定する ex) Fixed(axis, 3) は "%.3f" と同じ
+///////////////////////////////////////////////////////////
+inline FixedFormat Fixed(double value, unsigned int precision)
+{
+	FixedFormat f = { value, precision };
+	return f;
+}
+
+///////////////////////////////////////////////////////////
+/// @brief		16進数で出力する ex) Hex(v, 8) は "%08llx" と同じ
+///////////////////////////////////////////////////////////
+inline HexFormat Hex(unsigned long long value, unsigned int width = 0)
+{
+	HexFormat f = { value, width };
+	return f;
+}
+
+///////////////////////////////////////////////////////////
+/// @brief		整数を右寄せする ex) Pad(lineNo, 4, '0') は "%04d" と同じ
+///////////////////////////////////////////////////////////
+inline PadFormat Pad(long long value, unsigned int width, char fill = ' ')
+{
+	PadFormat f = { value, width, fill };
+	return f;
+}
+
+///////////////////////////////////////////////////////////
+/// @class	TextStream
+/// @brief	operator<<で値を文字列にして出力先に書き込む
+///
+/// - 出力先(Derived)はWrite(const char *, size_t)を実装する
+/// - 書式文字列を実行時に解析しない(引数の型ごとに変換関数がコンパイル時に決まる)
+/// - doubleはFixed()を指定しないとき"%g"ではなく"%.6f"と同じ形式となる
+///
+///////////////////////////////////////////////////////////
+template <class Derived>
+class TextStream
+{
+public:
+	Derived &operator<<(const char *value)
+	{
+		return Put(value, ::strlen(value));
+	}
+
+	Derived &operator<<(const std::string &value)
+	{
+		return Put(value.data(), value.size());
+	}
+
+	Derived &operator<<(const StringView &value)
+	{
+		return Put(value.Data(), value.Size());
+	}
+
+	Derived &operator<<(char value)
+	{
+		return Put(&value, 1);
+	}
+
+	Derived &operator<<(bool value)
+	{
+		return value ? Put("true", 4) : Put("false", 5);
+	}
+
+	Derived &operator<<(int value)
+	{
+		return Integer(value);
+	}
+
+	Derived &operator<<(unsigned int value)
+	{
+		return Unsigned(value);
+	}
+
+	Derived &operator<<(long value)
+	{
+		return Integer(value);
+	}
+
+	Derived &operator<<(unsigned long value)
+	{
+		return Unsigned(value);
+	}
+
+	Derived &operator<<(long long value)
+	{
+		return Integer(value);
+	}
+
+	Derived &operator<<(unsigned long long value)
+	{
+		return Unsigned(value);
+	}
+
+	Derived &operator<<(double value)
+	{
+		char buf[TextFormat::MAX_DIGITS];
+		return Put(buf, TextFormat::Double(buf, value));
+	}
+
+	Derived &operator<<(const FixedFormat &value)
+	{
+		char buf[TextFormat::MAX_DIGITS];
+		return Put(buf, TextFormat::Double(buf, value.value, value.precision));
+	}
+
+	Derived &operator<<(const HexFormat &value)
+	{
+		char buf[TextFormat::MAX_DIGITS];
+		return Put(buf, TextFormat::Hex(buf, value.value, value.width));
+	}
+
+	Derived &operator<<(const PadFormat &value)
+	{
+		char buf[TextFormat::MAX_DIGITS];
+		size_t length = TextFormat::Int(buf, value.value);
+		const char *digits = buf;
+		size_t digitsLength = length;
+		if (value.fill == '0' && buf[0] == '-') {
+			// '0'で埋めるときは符号の後ろを埋める("%04d"と同じ)
+			Put(buf, 1);
+			digits++;
+			digitsLength--;
+		}
+		for (size_t i = length; i < value.width; i++) {
+			Put(&value.fill, 1);
+		}
+		return Put(digits, digitsLength);
+	}
+
+protected:
+	TextStream()
+	{
+	}
+
+	~TextStream()
+	{
+	}
+
+private:
+	Derived &Put(const char *data, size_t size)
+	{
+		Derived &self = static_cast<Derived &>(*this);
+		self.Write(data, size);
+		return self;
+	}
+
+	Derived &Integer(long long value)
+	{
+		char buf[TextFormat::MAX_DIGITS];
+		return Put(buf, TextFormat::Int(buf, value));
+	}
+
+	Derived &Unsigned(unsigned long long value)
+	{
+		char buf[TextFormat::MAX_DIGITS];
+		return Put(buf, TextFormat::UInt(buf, value));
+	}
+};
+
+///////////////////////////////////////////////////////////
+/// @class	Text
+/// @brief	std::stringに整形する
+///
+/// 使い方
+///   return Error(Text() << "send error [" << name << ":" << size << "]");
+///
+///////////////////////////////////////////////////////////
+class Text : public TextStream<Text>
+{
+public:
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	///////////////////////////////////////////////////////////
+	Text()
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		整形した文字列を取得する
+	/// @return		文字列
+	///////////////////////////////////////////////////////////
+	const std::string &Str() const
+	{
+		return mText;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		整形した文字列を取得する
+	/// @note		Error(const std::string &)に直接渡せる
+	///////////////////////////////////////////////////////////
+	operator const std::string &() const
+	{
+		return mText;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		出力先に書き込む
+	/// @param[in]	data データ
+	/// @param[in]	size データサイズ
+	///////////////////////////////////////////////////////////
+	void Write(const char *data, size_t size)
+	{
+		mText.append(data, size);
+	}
+
+private:
+	std::string mText; ///< 整形した文字列
+};
+}
+#endif
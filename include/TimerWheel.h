@@ -0,0 +1,554 @@
+///////////////////////////////////////////////////////////
+/// @file	TimerWheel.h
+/// @brief	多数のタイムアウトを1つのスレッドで管理する階層タイマーホイール
+/// @author	shuji-morimoto
+/// Copyright (C) 2013- Mamezou. All rights reserved.
+///////////////////////////////////////////////////////////
+
+#ifndef __PICO_IPC_TIMER_WHEEL__
+#define __PICO_IPC_TIMER_WHEEL__
+
+#include <pthread.h>
+#include <poll.h>
+#include <unistd.h>
+#include <time.h>
+#include <errno.h>
+#include <cstring>
+#include <sys/timerfd.h>
+#include "Error.h"
+#include "Thread.h"
+#include "Mutex.h"
+#include "MutexLock.h"
+#include "ConditionVariable.h"
+#include "StopToken.h"
+
+namespace PicoIPC {
+
+class Timer;
+class TimerWheel;
+
+///////////////////////////////////////////////////////////
+/// @class	ITimerHandler
+/// @brief	タイマーの期限切れ処理インタフェース
+///////////////////////////////////////////////////////////
+class ITimerHandler
+{
+public:
+	///////////////////////////////////////////////////////////
+	/// @brief		デストラクタ
+	///////////////////////////////////////////////////////////
+	virtual ~ITimerHandler() {};
+
+	///////////////////////////////////////////////////////////
+	/// @brief		期限切れになったときの処理を実装する
+	/// @param[in]	timer 期限切れになったタイマー
+	/// @note		TimerWheelのスレッドから呼び出される。すべてのタイマーで共有するため短時間で終えること<br/>
+	///				この中でtimerを再登録(周期タイマー)したり、他のタイマーを登録/取り消しできる
+	///////////////////////////////////////////////////////////
+	virtual void Expired(Timer &timer) = 0;
+};
+
+///////////////////////////////////////////////////////////
+/// @class	Timer
+/// @brief	TimerWheelに登録するタイマー(利用者が所有する)
+///
+/// - 登録/取り消しのためのリンクを持つため、TimerWheelはメモリを確保しない
+/// - 登録中に破棄すると取り消してから破棄する。登録したTimerWheelより先に破棄すること
+///
+///////////////////////////////////////////////////////////
+class Timer
+{
+public:
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @param[in]	handler 期限切れ処理
+	/// @param[in]	param パラメータ
+	///////////////////////////////////////////////////////////
+	Timer(ITimerHandler *handler, void *param = NULL)
+		: mNext(NULL)
+		, mPprev(NULL)
+		, mExpires(0)
+		, mWheel(NULL)
+		, mHandler(handler)
+		, mParam(param)
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		デストラクタ
+	/// @note		登録中のときは取り消す。期限切れ処理の実行中のときは終わるまで待機する
+	///////////////////////////////////////////////////////////
+	virtual ~Timer();
+
+	///////////////////////////////////////////////////////////
+	/// @brief		パラメータを取得する
+	/// @return		パラメータ
+	///////////////////////////////////////////////////////////
+	void *Parameter() const
+	{
+		return mParam;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		登録中か確認する
+	/// @return		期限切れ処理の実行前のときtrue
+	///////////////////////////////////////////////////////////
+	bool IsScheduled() const
+	{
+		return mPprev != NULL;
+	}
+
+private:
+	friend class TimerWheel;
+
+	Timer              *mNext;    ///< 同じスロットの次のタイマー
+	Timer             **mPprev;   ///< 前のタイマーのmNext(登録していないときNULL)
+	unsigned long long  mExpires; ///< 期限(ティック)
+	TimerWheel         *mWheel;   ///< 登録したTimerWheel
+	ITimerHandler      *mHandler; ///< 期限切れ処理
+	void               *mParam;   ///< パラメータ
+
+	/// コピー禁止
+	Timer(const Timer &);
+	/// 代入禁止
+	Timer &operator=(const Timer &);
+};
+
+///////////////////////////////////////////////////////////
+/// @class	TimerWheel
+/// @brief	timerfdで駆動する1つのスレッドで多数のタイマーを管理する階層タイマーホイール
+///
+/// - 256スロット x 4階層で、ティック(デフォルト1ms)の2^32倍先まで登録できる
+/// - Schedule()とCancel()はスロットのリストをつなぎ替えるだけのO(1)
+///   上位の階層のタイマーは期限が近づいたときに下位の階層へ移す(カスケード)
+/// - timerfdは次にタイマーがあるスロットまたはカスケードするティックに1回だけ設定する<br/>
+///   ティックごとには起床せず、タイマーが1つもないときはtimerfdを止めてpoll()で待機する
+/// - 期限はティック単位に切り上げるため、指定時間より早く期限切れにならない(1〜2ティック遅れる)
+/// - 要求ごとのタイムアウトのように、多数の期限を個別にカーネルで待たずに1つのスレッドで扱うときに使う<br/>
+///   期限切れ処理でStopSource::RequestStop()すると、StopTokenを指定したMessageQueue::TimedReceiveCode()などを中断できる
+///
+/// 使い方
+///   TimerWheel wheel;
+///   wheel.Start();
+///   Timer timer(&handler, &request);
+///   wheel.Schedule(timer, 500);        // 500ms後にhandler.Expired(timer)
+///   ...
+///   if (wheel.Cancel(timer)) { ... }   // 期限前に応答が届いた
+///
+///////////////////////////////////////////////////////////
+class TimerWheel
+{
+public:
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @param[in]	tickMicrosec ティック(マイクロ秒)
+	///////////////////////////////////////////////////////////
+	explicit TimerWheel(unsigned long tickMicrosec = 1000)
+		: mTick((tickMicrosec == 0) ? 1 : tickMicrosec)
+		, mTimerFd(::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC))
+		, mCreationErrno((mTimerFd < 0) ? errno : 0)
+		, mCurrent(0)
+		, mCount(0)
+		, mArmedTick(0)
+		, mRunning(NULL)
+		, mRunningDone(mMutex)
+		, mExpired(NULL)
+		, mExpiredTail(&mExpired)
+		, mLoop(this)
+		, mThread(&mLoop, NULL)
+	{
+		std::memset(mSlots, 0, sizeof(mSlots));
+		std::memset(&mLoopThread, 0, sizeof(mLoopThread));
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		デストラクタ
+	/// @note		スレッドを停止する。登録中のタイマーは期限切れにならない<br/>
+	///				一度でも登録したTimerはTimerWheelより先に破棄すること
+	///////////////////////////////////////////////////////////
+	virtual ~TimerWheel()
+	{
+		Stop();
+		MutexLock lock(&mMutex);
+		for (int level = 0; level < LEVELS; level++) {
+			for (int slot = 0; slot < SLOTS; slot++) {
+				while (mSlots[level][slot] != NULL) {
+					Timer *timer = mSlots[level][slot];
+					Detach(*timer);
+					timer->mWheel = NULL;
+				}
+			}
+		}
+		while (mExpired != NULL) {
+			Timer *timer = mExpired;
+			Detach(*timer);
+			timer->mWheel = NULL;
+		}
+		if (mTimerFd >= 0) {
+			::close(mTimerFd);
+		}
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		タイマーのスレッドを開始する
+	/// @return		Error timerfdを作成できなかったときエラー内容がErrorに設定される
+	///////////////////////////////////////////////////////////
+	Error Start()
+	{
+		if (mTimerFd < 0) {
+			return Error::createError("timer wheel creation error [%s]", ::strerror(mCreationErrno));
+		}
+		mThread.Start();
+		return Error::createNoError();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		タイマーのスレッドを停止する
+	/// @note		期限切れ処理の実行中のときは終わってから停止する
+	///////////////////////////////////////////////////////////
+	void Stop()
+	{
+		mThread.Stop();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		ティックを取得する
+	/// @return		ティック(マイクロ秒)
+	///////////////////////////////////////////////////////////
+	unsigned long TickMicrosec() const
+	{
+		return mTick;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		登録中のタイマーの数を取得する
+	/// @return		数
+	///////////////////////////////////////////////////////////
+	size_t Count()
+	{
+		MutexLock lock(&mMutex);
+		return mCount;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		タイマーを登録する
+	/// @param[in]	timer タイマー(期限切れになるか取り消すまで破棄しないこと)
+	/// @param[in]	millisec 期限(ミリ秒後)
+	/// @note		登録中のときは期限を変更する
+	///////////////////////////////////////////////////////////
+	void Schedule(Timer &timer, unsigned long millisec)
+	{
+		ScheduleMicrosec(timer, static_cast<unsigned long long>(millisec) * 1000);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		タイマーを登録する
+	/// @param[in]	timer タイマー(期限切れになるか取り消すまで破棄しないこと)
+	/// @param[in]	microsec 期限(マイクロ秒後)
+	/// @note		登録中のときは期限を変更する
+	///////////////////////////////////////////////////////////
+	void ScheduleMicrosec(Timer &timer, unsigned long long microsec)
+	{
+		MutexLock lock(&mMutex);
+		if (timer.mPprev != NULL) {
+			Detach(timer);
+		}
+		unsigned long long now = NowTick();
+		if (mCount == 0) {
+			// 停止していた間のティックを進める(スロットは空のためカスケード不要)
+			mCurrent = now;
+		}
+		// 現在のティックは途中まで経過しているため1ティック加える
+		// (mCurrentは次に起床するまで進まないため、期限は現在時刻から求める)
+		unsigned long long ticks = (microsec + mTick - 1) / mTick + 1;
+		timer.mExpires = now + ticks;
+		timer.mWheel = this;
+		Insert(timer);
+		mCount++;
+		if (mArmedTick == 0 || timer.mExpires < mArmedTick) {
+			Rearm();
+		}
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		タイマーを取り消す
+	/// @param[in]	timer タイマー
+	/// @return		期限切れ処理の実行前に取り消したときtrue
+	/// @note		期限切れ処理の実行中のときは終わるまで待機する(期限切れ処理の中から呼び出したときは待機しない)<br/>
+	///				falseが返った後はtimerを破棄できる
+	///////////////////////////////////////////////////////////
+	bool Cancel(Timer &timer)
+	{
+		MutexLock lock(&mMutex);
+		if (timer.mPprev != NULL) {
+			Detach(timer);
+			return true;
+		}
+		if (!::pthread_equal(::pthread_self(), mLoopThread)) {
+			while (mRunning == &timer) {
+				mRunningDone.Wait();
+			}
+		}
+		return false;
+	}
+
+private:
+	///////////////////////////////////////////////////////////
+	/// @class	Loop
+	/// @brief	timerfdを待って現在のティックまで進めるスレッド処理
+	///////////////////////////////////////////////////////////
+	class Loop : public IRunnable
+	{
+	public:
+		explicit Loop(TimerWheel *owner)
+			: mOwner(owner)
+		{
+		}
+
+		void Run()
+		{
+			mOwner->RunLoop();
+		}
+
+	private:
+		TimerWheel *mOwner; ///< 所有するTimerWheel
+	};
+
+	enum {
+		SLOT_BITS = 8,
+		SLOTS     = 1 << SLOT_BITS,
+		SLOT_MASK = SLOTS - 1,
+		LEVELS    = 4
+	};
+
+	unsigned long       mTick;                  ///< ティック(マイクロ秒)
+	int                 mTimerFd;               ///< ティックを通知するtimerfd
+	int                 mCreationErrno;         ///< timerfdを作成できなかったときのerrno
+	unsigned long long  mCurrent;               ///< 現在のティック
+	size_t              mCount;                 ///< 登録中のタイマーの数
+	unsigned long long  mArmedTick;             ///< timerfdに設定したティック(止めているとき0)
+	Timer              *mSlots[LEVELS][SLOTS];  ///< 階層ごとのスロット
+	Mutex               mMutex;                 ///< ホイールの排他
+	Timer              *mRunning;               ///< 期限切れ処理を実行中のタイマー
+	ConditionVariable   mRunningDone;           ///< 期限切れ処理が終わった
+	Timer              *mExpired;               ///< 期限切れ処理を待つタイマー
+	Timer             **mExpiredTail;           ///< mExpiredの末尾のmNext
+	pthread_t           mLoopThread;            ///< タイマーのスレッド
+	Loop                mLoop;                  ///< スレッド処理
+	StoppableThread     mThread;                ///< タイマーのスレッド
+
+	unsigned long long NowTick() const
+	{
+		timespec ts;
+		::clock_gettime(CLOCK_MONOTONIC, &ts);
+		unsigned long long microsec = static_cast<unsigned long long>(ts.tv_sec) * 1000000ULL + ts.tv_nsec / 1000;
+		return microsec / mTick;
+	}
+
+	// timerfdをティックの時刻に1回だけ設定する(0のとき止める)
+	void Arm(unsigned long long tick)
+	{
+		itimerspec spec;
+		std::memset(&spec, 0, sizeof(spec));
+		if (tick != 0) {
+			unsigned long long microsec = tick * mTick;
+			spec.it_value.tv_sec = static_cast<time_t>(microsec / 1000000);
+			spec.it_value.tv_nsec = static_cast<long>(microsec % 1000000) * 1000;
+		}
+		::timerfd_settime(mTimerFd, TFD_TIMER_ABSTIME, &spec, NULL);
+		mArmedTick = tick;
+	}
+
+	// 次に処理が必要なティックにtimerfdを設定し直す
+	void Rearm()
+	{
+		unsigned long long tick = (mCount == 0) ? 0 : NextTick();
+		if (tick != mArmedTick) {
+			Arm(tick);
+		}
+	}
+
+	// 境界のティックで上位の階層からカスケードするタイマーがあるか確認する
+	bool IsCascading(unsigned long long tick) const
+	{
+		for (int level = 1; level < LEVELS; level++) {
+			if ((tick & ((1ULL << (SLOT_BITS * level)) - 1)) != 0) {
+				break;
+			}
+			if (mSlots[level][(tick >> (SLOT_BITS * level)) & SLOT_MASK] != NULL) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// 次にタイマーがあるスロットまたはカスケードするティックを求める
+	// (見つからないときは下位の階層のSLOTS周先のティック。その間のティックには何もない)
+	unsigned long long NextTick() const
+	{
+		// 最下位の階層のタイマーの期限は現在から1周以内
+		for (unsigned long long tick = mCurrent + 1; tick <= mCurrent + SLOT_MASK; tick++) {
+			if (((tick & SLOT_MASK) == 0 && IsCascading(tick)) || mSlots[0][tick & SLOT_MASK] != NULL) {
+				return tick;
+			}
+		}
+		// それより先は上位の階層からカスケードする境界のみ
+		unsigned long long tick = ((mCurrent + SLOT_MASK) | SLOT_MASK) + 1;
+		for (int i = 0; i < SLOTS; i++, tick += SLOTS) {
+			if (IsCascading(tick)) {
+				break;
+			}
+		}
+		return tick;
+	}
+
+	static void Link(Timer *&head, Timer &timer)
+	{
+		timer.mNext = head;
+		if (head != NULL) {
+			head->mPprev = &timer.mNext;
+		}
+		head = &timer;
+		timer.mPprev = &head;
+	}
+
+	// 期限に応じた階層のスロットにつなぐ
+	void Insert(Timer &timer)
+	{
+		unsigned long long expires = timer.mExpires;
+		if (expires < mCurrent) {
+			expires = mCurrent;
+		}
+		// カスケードでは期限が現在のティックのタイマーもあり、Advance()で続けて期限切れになる
+		unsigned long long delta = expires - mCurrent;
+		int level = 0;
+		while (level < LEVELS - 1 && delta >= (1ULL << (SLOT_BITS * (level + 1)))) {
+			level++;
+		}
+		if (level == LEVELS - 1 && delta >= (1ULL << (SLOT_BITS * LEVELS))) {
+			// 登録できる範囲を超えるときは最も遠いスロットに置き、カスケードのたびに近づける
+			expires = mCurrent + (1ULL << (SLOT_BITS * LEVELS)) - 1;
+		}
+		int slot = static_cast<int>((expires >> (SLOT_BITS * level)) & SLOT_MASK);
+		Link(mSlots[level][slot], timer);
+	}
+
+	// スロットまたは期限切れのリストから外す
+	void Detach(Timer &timer)
+	{
+		if (mExpiredTail == &timer.mNext) {
+			mExpiredTail = timer.mPprev;
+		}
+		*timer.mPprev = timer.mNext;
+		if (timer.mNext != NULL) {
+			timer.mNext->mPprev = timer.mPprev;
+		}
+		timer.mNext = NULL;
+		timer.mPprev = NULL;
+		mCount--;
+	}
+
+	// 上位の階層のスロットのタイマーを登録し直す
+	void Cascade(int level, int slot)
+	{
+		Timer *timer = mSlots[level][slot];
+		mSlots[level][slot] = NULL;
+		while (timer != NULL) {
+			Timer *next = timer->mNext;
+			Insert(*timer);
+			timer = next;
+		}
+	}
+
+	// 1ティック進め、期限になったタイマーを期限切れのリストの末尾へ移す
+	void Advance()
+	{
+		mCurrent++;
+		for (int level = 1; level < LEVELS; level++) {
+			if ((mCurrent & ((1ULL << (SLOT_BITS * level)) - 1)) != 0) {
+				break;
+			}
+			Cascade(level, static_cast<int>((mCurrent >> (SLOT_BITS * level)) & SLOT_MASK));
+		}
+		Timer *&head = mSlots[0][mCurrent & SLOT_MASK];
+		while (head != NULL) {
+			Timer *timer = head;
+			head = timer->mNext;
+			if (head != NULL) {
+				head->mPprev = &head;
+			}
+			timer->mNext = NULL;
+			*mExpiredTail = timer;
+			timer->mPprev = mExpiredTail;
+			mExpiredTail = &timer->mNext;
+		}
+	}
+
+	// ティックまで進める(タイマーのない区間は1ティックずつ進めずに飛ばす)
+	void AdvanceTo(unsigned long long tick)
+	{
+		while (mCurrent < tick) {
+			unsigned long long next = NextTick();
+			if (next > tick) {
+				mCurrent = tick;
+				break;
+			}
+			mCurrent = next - 1;
+			Advance();
+		}
+	}
+
+	// 期限切れのタイマーの処理を1つずつ呼び出す(mMutexをロックして呼び出すこと)
+	void Dispatch()
+	{
+		while (mExpired != NULL) {
+			Timer *timer = mExpired;
+			Detach(*timer);
+			mRunning = timer;
+			mMutex.Unlock();
+			timer->mHandler->Expired(*timer);
+			mMutex.Lock();
+			mRunning = NULL;
+			mRunningDone.Broadcast();
+		}
+	}
+
+	void RunLoop()
+	{
+		{
+			MutexLock lock(&mMutex);
+			mLoopThread = ::pthread_self();
+		}
+		StopToken token = StoppableThread::CurrentToken();
+		while (token.Poll(mTimerFd, POLLIN, -1) == StopToken::WAIT_READY) {
+			unsigned long long expirations = 0;
+			if (::read(mTimerFd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+				continue;
+			}
+			mMutex.Lock();
+			// 1回だけの設定のため、期限切れになったtimerfdは止まっている
+			mArmedTick = 0;
+			if (mCount != 0) {
+				AdvanceTo(NowTick());
+			}
+			Dispatch();
+			Rearm();
+			mMutex.Unlock();
+		}
+	}
+
+	/// コピー禁止
+	TimerWheel(const TimerWheel &);
+	/// 代入禁止
+	TimerWheel &operator=(const TimerWheel &);
+};
+
+inline Timer::~Timer()
+{
+	TimerWheel *wheel = mWheel;
+	if (wheel != NULL) {
+		wheel->Cancel(*this);
+	}
+}
+}
+#endif
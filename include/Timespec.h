@@ -0,0 +1,74 @@
+///////////////////////////////////////////////////////////
+/// @file	Timespec.h
+/// @brief	タイムアウトの時刻計算
+/// @author	shuji-morimoto
+/// Copyright (C) 2013- Mamezou. All rights reserved.
+///////////////////////////////////////////////////////////
+
+#ifndef __PICO_IPC_TIMESPEC__
+#define __PICO_IPC_TIMESPEC__
+
+#include <time.h>
+
+namespace PicoIPC {
+
+///////////////////////////////////////////////////////////
+/// @class	Timespec
+/// @brief	timespecによる期限と残り時間の計算
+///
+/// - 絶対時刻を指定するAPI(mq_timedsend, pthread_cond_timedwaitなど)にはAfter()の結果を渡す
+/// - 相対時間を指定するAPI(futexなど)にはRemaining()の結果を渡す
+/// - clockは待機するAPIと同じ時計を指定すること
+///   (mq_timed*, pthread_mutex_timedlockはCLOCK_REALTIME、futexはCLOCK_MONOTONIC)
+///
+///////////////////////////////////////////////////////////
+class Timespec
+{
+public:
+	/// 1秒のナノ秒
+	enum { NANOSEC_PER_SEC = 1000000000 };
+
+	///////////////////////////////////////////////////////////
+	/// @brief		現在時刻からミリ秒後の絶対時刻を取得する
+	/// @param[in]	clock 時計(CLOCK_REALTIME, CLOCK_MONOTONIC)
+	/// @param[in]	millisec ミリ秒
+	/// @return		絶対時刻
+	///////////////////////////////////////////////////////////
+	static timespec After(clockid_t clock, unsigned long millisec)
+	{
+		timespec abs;
+		::clock_gettime(clock, &abs);
+		abs.tv_sec += millisec / 1000;
+		abs.tv_nsec += (millisec % 1000) * 1000000;
+		if (abs.tv_nsec >= NANOSEC_PER_SEC) {
+			abs.tv_sec++;
+			abs.tv_nsec -= NANOSEC_PER_SEC;
+		}
+		return abs;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		期限までの残り時間を取得する
+	/// @param[in]	clock After()に指定した時計
+	/// @param[in]	deadline After()で取得した期限
+	/// @param[out]	remaining 残り時間
+	/// @return		期限を過ぎたときfalse
+	///////////////////////////////////////////////////////////
+	static bool Remaining(clockid_t clock, const timespec &deadline, timespec &remaining)
+	{
+		timespec now;
+		::clock_gettime(clock, &now);
+		remaining.tv_sec = deadline.tv_sec - now.tv_sec;
+		remaining.tv_nsec = deadline.tv_nsec - now.tv_nsec;
+		if (remaining.tv_nsec < 0) {
+			remaining.tv_sec--;
+			remaining.tv_nsec += NANOSEC_PER_SEC;
+		}
+		return remaining.tv_sec >= 0;
+	}
+
+private:
+	Timespec();
+};
+}
+#endif
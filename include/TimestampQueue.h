@@ -0,0 +1,218 @@
+///////////////////////////////////////////////////////////
+/// @file	TimestampQueue.h
+/// @brief	送信時刻付きメッセージキュー
+/// @author	shuji-morimoto
+/// Copyright (C) 2013- Mamezou. All rights reserved.
+///////////////////////////////////////////////////////////
+
+#ifndef __PICO_IPC_TIMESTAMP_QUEUE__
+#define __PICO_IPC_TIMESTAMP_QUEUE__
+
+#include <mqueue.h>
+#include <time.h>
+#include <errno.h>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "Error.h"
+#include "ByteBuffer.h"
+#include "MessageQueue.h"
+#include "LatencyHistogram.h"
+#include "Timespec.h"
+
+namespace PicoIPC {
+
+///////////////////////////////////////////////////////////
+/// @class	TimestampQueue
+/// @brief	メッセージに送信時刻を付与し、受信側でキュー内の滞留時間を計測する
+///
+/// - 送信時にCLOCK_MONOTONICの時刻(ナノ秒, 8byte)をメッセージの先頭に付与する
+/// - 受信時に時刻を取り除き、送信から受信までの時間をLatency()に記録する
+/// - CLOCK_MONOTONICはシステム共通のため、プロセス間でも計測できる
+/// - 送信側と受信側はともにTimestampQueueを利用すること
+///   (MessageQueueの最大メッセージ長は時刻の8byte分大きくすること)
+///
+/// 使い方
+///   MessageQueue mq("/mq1");
+///   TimestampQueue q(&mq);
+///   q.TimedSend(bb, 10);           // 送信側
+///
+///   q.Receive(bb);                 // 受信側
+///   q.Latency().Print("/mq1");
+///
+///////////////////////////////////////////////////////////
+class TimestampQueue
+{
+public:
+	/// メッセージの先頭に付与する時刻のサイズ
+	static const size_t TIMESTAMP_SIZE = sizeof(unsigned long long);
+
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @param[in]	mq 対象のMessageQueue
+	/// @note		mqはTimestampQueueより長く生存すること
+	///////////////////////////////////////////////////////////
+	TimestampQueue(MessageQueue *mq)
+		: mQueue(mq)
+		, mReceiveBuffer(mq->MaxMessageSize() > 0 ? mq->MaxMessageSize() : 1)
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		デストラクタ
+	///////////////////////////////////////////////////////////
+	virtual ~TimestampQueue()
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		現在の時刻を取得する
+	/// @return		CLOCK_MONOTONICの時刻(ナノ秒)
+	///////////////////////////////////////////////////////////
+	static unsigned long long Now()
+	{
+		timespec now;
+		::clock_gettime(CLOCK_MONOTONIC, &now);
+		return static_cast<unsigned long long>(now.tv_sec) * 1000000000ULL + now.tv_nsec;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		受信側で記録した遅延時間のヒストグラムを取得する
+	/// @return		LatencyHistogram
+	/// @note		Clear()で記録をクリアできる
+	///////////////////////////////////////////////////////////
+	LatencyHistogram &Latency()
+	{
+		return mLatency;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		送信時刻を付与してメッセージを送信する
+	/// @param[in]	message メッセージ
+	/// @return		Error 失敗したときエラー内容がErrorに設定される
+	/// @note		メッセージキューに空きがない時、空きができるまでブロックする
+	///////////////////////////////////////////////////////////
+	Error Send(const ByteBuffer &message)
+	{
+		return TimedSend(message, 0);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		タイムアウト付きで送信時刻を付与してメッセージを送信する
+	/// @param[in]	message メッセージ
+	/// @param[in]	millisec ミリ秒
+	/// @return		Error 失敗したときエラー内容がErrorに設定される
+	/// @note		millisecが0のときは送信できるまでブロックする
+	/// @note		付与する時刻は送信を開始した時刻(キューの空き待ち時間も遅延に含まれる)
+	///////////////////////////////////////////////////////////
+	Error TimedSend(const ByteBuffer &message, unsigned long millisec)
+	{
+		unsigned long long stamp = Now();
+		mSendBuffer.assign(reinterpret_cast<const char *>(&stamp), TIMESTAMP_SIZE);
+		mSendBuffer.append(message.Data());
+
+		int ret;
+		if (millisec == 0) {
+			ret = ::mq_send(mQueue->mMessageQueue, mSendBuffer.data(), mSendBuffer.size(), 0);
+		} else {
+			timespec abs = Timespec::After(CLOCK_REALTIME, millisec);
+			ret = ::mq_timedsend(mQueue->mMessageQueue, mSendBuffer.data(), mSendBuffer.size(), 0, &abs);
+		}
+		if (ret != 0) {
+			return Error::createError("message queue send error [%s]", ::strerror(errno));
+		}
+		return Error::createNoError();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		メッセージを受信し遅延時間を記録する
+	/// @param[out]	outMessage 時刻を取り除いたメッセージ
+	/// @return		Error 失敗したときエラー内容がErrorに設定される
+	/// @note		メッセージキューが空の時、新規に追加されたメッセージを取得できるまでブロックする
+	///////////////////////////////////////////////////////////
+	Error Receive(ByteBuffer &outMessage)
+	{
+		return TimedReceive(outMessage, 0);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		タイムアウト付きでメッセージを受信し遅延時間を記録する
+	/// @param[out]	outMessage 時刻を取り除いたメッセージ
+	/// @param[in]	millisec ミリ秒
+	/// @return		Error 失敗したときエラー内容がErrorに設定される
+	/// @note		millisecが0のときは取得できるまでブロックする
+	///////////////////////////////////////////////////////////
+	Error TimedReceive(ByteBuffer &outMessage, unsigned long millisec)
+	{
+		ssize_t size;
+		if (millisec == 0) {
+			size = ::mq_receive(mQueue->mMessageQueue, &mReceiveBuffer[0], mReceiveBuffer.size(), NULL);
+		} else {
+			timespec abs = Timespec::After(CLOCK_REALTIME, millisec);
+			size = ::mq_timedreceive(mQueue->mMessageQueue, &mReceiveBuffer[0], mReceiveBuffer.size(), NULL, &abs);
+		}
+		if (size < 0) {
+			return Error::createError("message queue receive error [%s]", ::strerror(errno));
+		}
+		return Received(outMessage, size);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		メッセージキューに溜まっているすべてのメッセージを受信し遅延時間を記録する
+	/// @param[out]	outMessages 時刻を取り除いたメッセージ一覧
+	/// @return		Error 失敗したときエラー内容がErrorに設定される
+	/// @note		メッセージがないときはErrorは成功で返り、outMessagesサイズは0となる
+	///////////////////////////////////////////////////////////
+	Error Receive(std::vector<ByteBuffer> &outMessages)
+	{
+		const timespec expired = {0, 0};
+		while (true) {
+			ssize_t size = ::mq_timedreceive(mQueue->mMessageQueue, &mReceiveBuffer[0], mReceiveBuffer.size(), NULL, &expired);
+			if (size < 0) {
+				if (errno == ETIMEDOUT || errno == EAGAIN) {
+					return Error::createNoError();
+				}
+				return Error::createError("message queue receive error [%s]", ::strerror(errno));
+			}
+			outMessages.push_back(ByteBuffer());
+			Error err = Received(outMessages.back(), size);
+			if (err) {
+				outMessages.pop_back();
+				return err;
+			}
+		}
+	}
+
+private:
+	///////////////////////////////////////////////////////////
+	/// @brief		コピーコンストラクタ
+	/// @note		コピー禁止
+	///////////////////////////////////////////////////////////
+	TimestampQueue(const TimestampQueue &src);
+
+	///////////////////////////////////////////////////////////
+	/// @brief		代入オペレータ
+	/// @note		代入禁止
+	///////////////////////////////////////////////////////////
+	TimestampQueue &operator =(const TimestampQueue &src);
+
+	MessageQueue      *mQueue;         ///< 対象のMessageQueue
+	LatencyHistogram   mLatency;       ///< 遅延時間のヒストグラム
+	std::string        mSendBuffer;    ///< 時刻を付与したメッセージ
+	std::vector<char>  mReceiveBuffer; ///< メッセージキューの受信領域
+
+	Error Received(ByteBuffer &outMessage, ssize_t size)
+	{
+		unsigned long long now = Now();
+		if (size < static_cast<ssize_t>(TIMESTAMP_SIZE)) {
+			return Error::createError("message queue receive error [%s]", "no timestamp");
+		}
+		unsigned long long stamp;
+		::memcpy(&stamp, &mReceiveBuffer[0], TIMESTAMP_SIZE);
+		mLatency.Record(now > stamp ? now - stamp : 0);
+		outMessage = ByteBuffer(&mReceiveBuffer[TIMESTAMP_SIZE], static_cast<size_t>(size - TIMESTAMP_SIZE));
+		return Error::createNoError();
+	}
+};
+}
+#endif
@@ -0,0 +1,337 @@
+///////////////////////////////////////////////////////////
+/// @file	TopicBus.h
+/// @brief	共有メモリー上の1対多トピックバス
+/// @author	shuji-morimoto
+/// Copyright (C) 2013- Mamezou. All rights reserved.
+///////////////////////////////////////////////////////////
+
+#ifndef __PICO_IPC_TOPIC_BUS__
+#define __PICO_IPC_TOPIC_BUS__
+
+#include <string>
+#include <cstring>
+#include <time.h>
+#include "Error.h"
+#include "ByteBuffer.h"
+#include "SharedMemoryContext.h"
+#include "SpinPolicy.h"
+#include "Futex.h"
+#include "Timespec.h"
+
+namespace PicoIPC {
+
+///////////////////////////////////////////////////////////
+/// @class	TopicBus
+/// @brief	共有メモリー上のリングバッファを利用した1対多のメッセージ配信
+///
+/// - MessageQueueはメッセージを1つの受信者にしか配信できないが、TopicBusは
+///   1回のPublish()ですべての購読者にメッセージを配信する
+/// - 送信者はリングバッファに1回だけ書き込み、購読者はそれぞれ自身の読み出し
+///   位置を持つため、配信コストは購読者数に依存しない
+/// - 購読者の読み出しが遅れてリングバッファを一周された場合は、読めなかった
+///   メッセージ数をLostCount()に加算して読み出し可能な最も古いメッセージから再開する
+/// - 送信者は1つ(1スレッド)であること。購読者の数に制限はない
+/// - 各スロットはシーケンスロックで保護され、書き込み中や上書きされたスロットは
+///   読み出し時に検出される
+/// - TimedReceive()はSetSpinBudget()で指定した時間だけスロットをスピンで
+///   ポーリングしてから、writeSequenceのfutexで配信を待機する<br/>
+///   送信者は待機している購読者がいるときのみ起こす(いなければシステムコールなし)
+///
+/// テンプレートパラメータ
+///   SlotCount リングバッファのスロット数
+///   SlotSize  1メッセージの最大サイズ
+///
+/// 使い方
+///   SharedMemoryContext context;
+///   TopicBus<64, 512> bus(&context, "/topic_axis", true);   // 送信者
+///   bus.Publish(bb);
+///
+///   TopicBus<64, 512> bus(&context, "/topic_axis", false);  // 購読者
+///   ByteBuffer bb;
+///   Error err = bus.TimedReceive(bb, 100);
+///
+///////////////////////////////////////////////////////////
+template <size_t SlotCount, size_t SlotSize>
+class TopicBus
+{
+public:
+	///////////////////////////////////////////////////////////
+	/// @struct	Slot
+	/// @brief	リングバッファのスロット
+	///////////////////////////////////////////////////////////
+	struct Slot
+	{
+		unsigned int version;        ///< 書き込み中は奇数、書き込み後は(シーケンス+1)*2
+		unsigned int length;         ///< メッセージ長
+		char         data[SlotSize]; ///< メッセージ
+	};
+
+	///////////////////////////////////////////////////////////
+	/// @struct	Ring
+	/// @brief	共有メモリーに配置するリングバッファ(POD型)
+	///////////////////////////////////////////////////////////
+	struct Ring
+	{
+		unsigned int writeSequence;   ///< 次に書き込むシーケンス(購読者がfutexで待機する)
+		volatile int waiters;         ///< futexで待機している購読者の数
+		Slot         slots[SlotCount]; ///< スロット
+	};
+
+	///////////////////////////////////////////////////////////
+	/// @brief		コンストラクタ
+	/// @param[in]	context SharedMemoryContext
+	/// @param[in]	name 名前
+	/// @param[in]	isOwner 所有権
+	/// @note		nameは'/'で開始する必要がある。例) "/topic_axis"
+	/// @note		購読者は生成時点以降にPublish()されたメッセージから受信する
+	/// @note		共有メモリーが存在しない場合はIsBound()がfalseとなる
+	///////////////////////////////////////////////////////////
+	TopicBus(SharedMemoryContext *context, const std::string &name, bool isOwner)
+		: mMemory(context->Bind<Ring>(name, isOwner))
+		, mRing(NULL)
+		, mCursor(0)
+		, mLostCount(0)
+		, mSpin(0)
+	{
+		if (mMemory != NULL) {
+			mRing = mMemory->Data<Ring>();
+			mCursor = Load(&mRing->writeSequence);
+		}
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		デストラクタ
+	/// @note		共有メモリーはSharedMemoryContextが開放する
+	///////////////////////////////////////////////////////////
+	virtual ~TopicBus()
+	{
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		共有メモリーにバインドされているか確認する
+	/// @return		バインドされているときtrue
+	///////////////////////////////////////////////////////////
+	bool IsBound() const
+	{
+		return mRing != NULL;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		すべての購読者にメッセージを配信する
+	/// @param[in]	message メッセージ
+	/// @return		Error 失敗したときエラー内容がErrorに設定される
+	/// @note		ブロックしない。最も古いスロットを上書きする
+	/// @note		送信者は1つ(1スレッド)であること
+	///////////////////////////////////////////////////////////
+	Error Publish(const ByteBuffer &message)
+	{
+		if (mRing == NULL) {
+			return Error::createError("topic bus publish error [%s]", "not bound");
+		}
+		if (message.Size() > SlotSize) {
+			return Error::createError("topic bus publish error [size over %lu > %lu]",
+				static_cast<unsigned long>(message.Size()), static_cast<unsigned long>(SlotSize));
+		}
+		unsigned int sequence = mRing->writeSequence;
+		Slot &slot = mRing->slots[sequence % SlotCount];
+
+		slot.version = sequence * 2 + 1;
+		__sync_synchronize();
+		slot.length = message.Size();
+		::memcpy(slot.data, message.Data().data(), message.Size());
+		__sync_synchronize();
+		slot.version = sequence * 2 + 2;
+		__sync_synchronize();
+		mRing->writeSequence = sequence + 1;
+		// 購読者がwaitersを加算してからwriteSequenceを確認する順序と対になる
+		__sync_synchronize();
+		if (mRing->waiters != 0) {
+			Futex::WakeAll(WriteSequenceWord(), true);
+		}
+		return Error::createNoError();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		メッセージがあれば受信する
+	/// @param[out]	outMessage メッセージ
+	/// @return		受信したときtrue
+	/// @note		ブロックしない
+	///////////////////////////////////////////////////////////
+	bool TryReceive(ByteBuffer &outMessage)
+	{
+		if (mRing == NULL) {
+			return false;
+		}
+		while (true) {
+			unsigned int write = Load(&mRing->writeSequence);
+			if (write == mCursor) {
+				return false;
+			}
+			if (write - mCursor > SlotCount) {
+				// 一周以上遅れたので読み出し可能な最も古いメッセージへ進める
+				mLostCount += write - mCursor - SlotCount;
+				mCursor = write - SlotCount;
+			}
+			Slot &slot = mRing->slots[mCursor % SlotCount];
+			unsigned int expected = mCursor * 2 + 2;
+			if (Load(&slot.version) != expected) {
+				// 読み出し前に上書きが始まった
+				mLostCount++;
+				mCursor++;
+				continue;
+			}
+			unsigned int length = slot.length;
+			if (length > SlotSize) {
+				length = SlotSize;
+			}
+			ByteBuffer received(slot.data, static_cast<size_t>(length));
+			// データの読み出しをversionの再確認より前に完了させる(Load()の後の障壁では順序を保証しない)
+			__sync_synchronize();
+			if (Load(&slot.version) != expected) {
+				// 読み出し中に上書きされた
+				mLostCount++;
+				mCursor++;
+				continue;
+			}
+			outMessage = received;
+			mCursor++;
+			return true;
+		}
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		タイムアウト付きでメッセージを受信する
+	/// @param[out]	outMessage メッセージ
+	/// @param[in]	millisec ミリ秒
+	/// @return		Error 失敗したときエラー内容がErrorに設定される
+	/// @note		millisecが0のときは受信できるまで待機する
+	/// @note		スピン予算の間はスピンでポーリングし、その後はfutexで配信を待機する<br/>
+	///				スピンした時間もmillisecに含む
+	///////////////////////////////////////////////////////////
+	Error TimedReceive(ByteBuffer &outMessage, unsigned long millisec)
+	{
+		if (mRing == NULL) {
+			return Error::createError("topic bus receive error [%s]", "not bound");
+		}
+		timespec deadline = Timespec::After(CLOCK_MONOTONIC, millisec);
+		Poll poll(this, outMessage);
+		if (mSpin.Spin(poll)) {
+			return Error::createNoError();
+		}
+		while (!TryReceive(outMessage)) {
+			timespec remaining;
+			if (millisec != 0 && !Timespec::Remaining(CLOCK_MONOTONIC, deadline, remaining)) {
+				return Error::createError("topic bus receive error [%s]", "timeout");
+			}
+			// TryReceive()が失敗したときwriteSequenceはmCursorと等しい
+			// 待機する前に配信されたときはFutex::Wait()がすぐに戻る
+			__sync_fetch_and_add(&mRing->waiters, 1);
+			Futex::Wait(WriteSequenceWord(), static_cast<int>(mCursor), true, (millisec != 0) ? &remaining : NULL);
+			__sync_fetch_and_sub(&mRing->waiters, 1);
+		}
+		return Error::createNoError();
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		TimedReceive()のスピン予算を設定する
+	/// @param[in]	microsec スピン予算(マイクロ秒)
+	/// @note		0のときスピンしない(デフォルト)
+	///////////////////////////////////////////////////////////
+	void SetSpinBudget(unsigned long microsec)
+	{
+		mSpin.SetSpinBudget(microsec);
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		スピン待機の設定と統計を取得する
+	/// @return		SpinPolicy
+	///////////////////////////////////////////////////////////
+	const SpinPolicy &Spin() const
+	{
+		return mSpin;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		まだ受信していないメッセージ数を取得する
+	/// @return		未受信のメッセージ数
+	/// @note		SlotCountを超える場合は次の受信で取りこぼしが発生する
+	///////////////////////////////////////////////////////////
+	unsigned int Lag()
+	{
+		if (mRing == NULL) {
+			return 0;
+		}
+		return Load(&mRing->writeSequence) - mCursor;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		読み出しの遅れにより取りこぼしたメッセージ数の累計を取得する
+	/// @return		取りこぼしたメッセージ数
+	///////////////////////////////////////////////////////////
+	unsigned long LostCount() const
+	{
+		return mLostCount;
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		未受信のメッセージを読み飛ばして最新の位置から受信する
+	/// @note		読み飛ばしたメッセージはLostCount()に加算しない
+	///////////////////////////////////////////////////////////
+	void SeekLatest()
+	{
+		if (mRing != NULL) {
+			mCursor = Load(&mRing->writeSequence);
+		}
+	}
+
+private:
+	///////////////////////////////////////////////////////////
+	/// @brief		コピーコンストラクタ
+	/// @note		コピー禁止
+	///////////////////////////////////////////////////////////
+	TopicBus(const TopicBus &src);
+
+	///////////////////////////////////////////////////////////
+	/// @brief		代入オペレータ
+	/// @note		代入禁止
+	///////////////////////////////////////////////////////////
+	TopicBus &operator =(const TopicBus &src);
+
+	/// スピン中のポーリング
+	struct Poll
+	{
+		TopicBus   *mBus;
+		ByteBuffer &mMessage;
+
+		Poll(TopicBus *bus, ByteBuffer &message)
+			: mBus(bus)
+			, mMessage(message)
+		{
+		}
+
+		bool operator()()
+		{
+			return mBus->TryReceive(mMessage);
+		}
+	};
+
+	SharedMemory  *mMemory;    ///< 共有メモリー
+	Ring          *mRing;      ///< リングバッファ
+	unsigned int   mCursor;    ///< 次に読み出すシーケンス
+	unsigned long  mLostCount; ///< 取りこぼしたメッセージ数
+	SpinPolicy     mSpin;      ///< TimedReceive()のスピン待機の設定と統計
+
+	volatile int *WriteSequenceWord()
+	{
+		return reinterpret_cast<volatile int *>(&mRing->writeSequence);
+	}
+
+	static unsigned int Load(unsigned int *value)
+	{
+		unsigned int v = *const_cast<volatile unsigned int *>(value);
+		__sync_synchronize();
+		return v;
+	}
+};
+}
+#endif
@@ -12,11 +12,15 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/un.h>
+#include <errno.h>
+#include <cstring>
 #include "ByteBuffer.h"
 #include "Error.h"
 
 namespace PicoIPC {
 
+template <size_t N> class StaticByteBuffer;
+
 ///////////////////////////////////////////////////////////
 /// @class UnixDomainSocket
 /// @brief	UNIXドメインソケットでデータグラムを利用する
@@ -87,6 +91,65 @@ public:
 	///////////////////////////////////////////////////////////
 	Error Send(const ByteBuffer &header, const ByteBuffer &body);
 
+	///////////////////////////////////////////////////////////
+	/// @brief		接続相手に固定長バッファのデータを送信する
+	/// @param[in]	header ヘッダーデータ
+	/// @param[in]	body  ボディーデータ
+	/// @return		Error 失敗したときエラー内容がErrorに設定される
+	/// @note		Send(const ByteBuffer &, const ByteBuffer &)と同じ。ヒープを確保しない
+	/// @note		オーバーフローしたバッファは送信せずエラーとなる
+	///////////////////////////////////////////////////////////
+	template <size_t H, size_t B>
+	Error Send(const StaticByteBuffer<H> &header, const StaticByteBuffer<B> &body)
+	{
+		if (header.IsOverflow() || body.IsOverflow()) {
+			return Error::createError("send socket error [%s]", "buffer overflow");
+		}
+		return Send(header.Data(), header.Size(), body.Data(), body.Size());
+	}
+
+	///////////////////////////////////////////////////////////
+	/// @brief		接続相手にバイト列のデータを送信する
+	/// @param[in]	header ヘッダーデータ
+	/// @param[in]	headerSize ヘッダーデータのサイズ
+	/// @param[in]	body  ボディーデータ
+	/// @param[in]	bodySize ボディーデータのサイズ
+	/// @return		Error 失敗したときエラー内容がErrorに設定される
+	/// @note		Send(const ByteBuffer &, const ByteBuffer &)と同じ形式で送信する<br/>
+	/// 			(プロトコルヘッダー[0xDEADC0DE, ボディーサイズ] + ヘッダー + ボディー)
+	///////////////////////////////////////////////////////////
+	Error Send(const char *header, size_t headerSize, const char *body, size_t bodySize)
+	{
+		if (!IsOpend()) {
+			return Error::createError("socket closed");
+		}
+		if (headerSize > HEADER_SIZE_MAX) {
+			return Error::createError("send header error [%s:%lu]", "header too big size", static_cast<unsigned long>(headerSize));
+		}
+		if (mLimitSize != 0 && bodySize > mLimitSize) {
+			return Error::createError("send header error [%s:%lu]", "body too big size", static_cast<unsigned long>(bodySize));
+		}
+		const sockaddr *address = reinterpret_cast<const sockaddr *>(&mTxAddress);
+		unsigned char protocol[8] = {0xde, 0xad, 0xc0, 0xde};
+		unsigned int size = bodySize;
+		::memcpy(protocol + 4, &size, sizeof(size));
+		if (::sendto(mTxSocketFd, protocol, sizeof(protocol), 0, address, sizeof(sockaddr_un)) != sizeof(protocol)) {
+			return Error::createError("send protocol header error [%s]", ::strerror(errno));
+		}
+		if (::sendto(mTxSocketFd, header, headerSize, 0, address, sizeof(sockaddr_un)) != static_cast<ssize_t>(headerSize)) {
+			return Error::createError("send application header error [%s]", ::strerror(errno));
+		}
+		for (size_t sent = 0; sent < bodySize; ) {
+			size_t chunk = (bodySize - sent > BODY_CHUNK_SIZE) ? BODY_CHUNK_SIZE : bodySize - sent;
+			ssize_t ret = ::sendto(mTxSocketFd, body + sent, chunk, 0, address, sizeof(sockaddr_un));
+			if (ret == -1) {
+				return Error::createError("send body error [%s]", ::strerror(errno));
+			}
+			sent += ret;
+		}
+		return Error::createNoError();
+	}
+
 	///////////////////////////////////////////////////////////
 	/// @brief		接続相手からデータを受信する
 	/// @param[out]	header ヘッダーデータ
@@ -110,6 +173,11 @@ public:
 	unsigned int LimitSize();
 
 private:
+	/// ヘッダーデータの最大サイズ
+	static const size_t HEADER_SIZE_MAX = 512;
+	/// ボディーデータを分割して送信するサイズ
+	static const size_t BODY_CHUNK_SIZE = 1024;
+
 	std::string  mPath;       ///< ファイルパス
 	bool         mIsOwner;    ///< データ送受信ファイルパス切替フラグ
 	int          mTxSocketFd; ///< 送信用ソケットファイルディスクリプタ